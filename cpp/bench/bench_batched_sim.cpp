@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "bench_common.hpp"
+#include "replay.hpp"
+#include "sim.hpp"
+#include "sim_batched.hpp"
+
+// Env-steps/s for N small environments: N MarketSimulator objects stepped in a
+// loop versus one lockstep BatchedSimulator. Every env runs the same quoting
+// policy (re-quote one lot at the touch on each side every kRequoteEvery
+// records), so both variants do identical matching work.
+// Arg: number of environments.
+//
+// File: MSRL_BENCH_SNAP, else the first .snap under DATA_PROCESSED_ROOT.
+
+namespace
+{
+  using msrl::bench::select_bench_snap;
+
+  constexpr std::size_t kSlots = 4;
+  constexpr std::size_t kRequoteEvery = 64;
+  constexpr std::size_t kRecords = 4096; // episode length
+
+  std::vector<md::l2::Record> g_records;
+
+  const std::vector<md::l2::Record>* records_or_skip(benchmark::State& state)
+  {
+    if ( g_records.empty() ) {
+      try {
+        md::l2::ReplayKernel k(select_bench_snap());
+        for ( const md::l2::Record* r = k.next(); r && g_records.size() < kRecords;
+              r = k.next() ) {
+          if ( md::l2::record_has_top_of_book(*r) )
+            g_records.push_back(*r);
+        }
+      }
+      catch ( const std::exception& e ) {
+        state.SkipWithError(e.what());
+        return nullptr;
+      }
+    }
+    if ( g_records.empty() ) {
+      state.SkipWithError("No records with a top of book in the .snap file");
+      return nullptr;
+    }
+    return &g_records;
+  }
+
+  sim::SimulatorParams bench_params()
+  {
+    sim::SimulatorParams p{};
+    p.max_orders = 2 * (kRecords / kRequoteEvery + 1);
+    p.max_events = 4 * p.max_orders;
+    p.alpha_ppm = 500'000;
+    p.outbound_latency = sim::Ns{1'000'000};
+    p.stp = sim::StpPolicy::CancelResting;
+    return p;
+  }
+
+  sim::Ledger bench_ledger()
+  {
+    sim::Ledger l{};
+    l.cash_q = 1'000'000'000'000'000'000;
+    l.position_qty_q = 1'000'000'000'000;
+    return l;
+  }
+
+  sim::LimitOrderRequest quote(const md::l2::Record& r, sim::Side side)
+  {
+    sim::LimitOrderRequest q{};
+    q.side = side;
+    q.price_q = (side == sim::Side::Buy) ? r.bids[0].price_q : r.asks[0].price_q;
+    q.qty_q = md::l2::kQtyScale / 1000;
+    return q;
+  }
+} // namespace
+
+// -------------------------
+// Benchmarks
+// -------------------------
+static void BM_Envs_Scalar(benchmark::State& state)
+{
+  const auto* recs = records_or_skip(state);
+  if ( !recs )
+    return;
+  const std::size_t envs = static_cast<std::size_t>(state.range(0));
+
+  std::vector<std::unique_ptr<sim::MarketSimulator>> sims;
+  std::vector<sim::u64> ids(envs * 2, 0);
+  for ( std::size_t e = 0; e < envs; ++e ) {
+    sims.push_back(std::make_unique<sim::MarketSimulator>(bench_params()));
+    sims.back()->reset(sim::Ns{0}, bench_ledger());
+  }
+
+  std::size_t t = 0;
+  std::uint64_t env_steps = 0;
+  for ( auto _ : state ) {
+    const md::l2::Record& r = (*recs)[t];
+    if ( t % kRequoteEvery == 0 ) {
+      for ( std::size_t e = 0; e < envs; ++e ) {
+        sim::MarketSimulator& s = *sims[e];
+        (void)s.cancel(ids[2 * e]);
+        (void)s.cancel(ids[2 * e + 1]);
+        ids[2 * e] = s.place_limit(quote(r, sim::Side::Buy));
+        ids[2 * e + 1] = s.place_limit(quote(r, sim::Side::Sell));
+      }
+    }
+    for ( std::size_t e = 0; e < envs; ++e )
+      sims[e]->step(r);
+    env_steps += envs;
+    if ( ++t == recs->size() ) {
+      // max_orders is a lifetime cap: start a fresh episode
+      t = 0;
+      for ( std::size_t e = 0; e < envs; ++e )
+        sims[e]->reset(sim::Ns{0}, bench_ledger());
+      std::fill(ids.begin(), ids.end(), 0);
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(env_steps));
+}
+
+static void BM_Envs_Batched(benchmark::State& state)
+{
+  const auto* recs = records_or_skip(state);
+  if ( !recs )
+    return;
+  const std::size_t envs = static_cast<std::size_t>(state.range(0));
+
+  sim::BatchedSimulator batch(bench_params(), envs, kSlots);
+  batch.reset(sim::Ns{0}, bench_ledger());
+  std::vector<sim::u64> ids(envs * 2, 0);
+
+  std::size_t t = 0;
+  std::uint64_t env_steps = 0;
+  for ( auto _ : state ) {
+    const md::l2::Record& r = (*recs)[t];
+    if ( t % kRequoteEvery == 0 ) {
+      for ( std::size_t e = 0; e < envs; ++e ) {
+        (void)batch.cancel(e, ids[2 * e]);
+        (void)batch.cancel(e, ids[2 * e + 1]);
+        ids[2 * e] = batch.place_limit(e, quote(r, sim::Side::Buy));
+        ids[2 * e + 1] = batch.place_limit(e, quote(r, sim::Side::Sell));
+      }
+    }
+    batch.step(r);
+    env_steps += envs;
+    if ( ++t == recs->size() ) {
+      t = 0;
+      batch.reset(sim::Ns{0}, bench_ledger());
+      std::fill(ids.begin(), ids.end(), 0);
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(env_steps));
+}
+
+BENCHMARK(BM_Envs_Scalar)->RangeMultiplier(8)->Range(8, 4096);
+BENCHMARK(BM_Envs_Batched)->RangeMultiplier(8)->Range(8, 4096);
+
+BENCHMARK_MAIN();
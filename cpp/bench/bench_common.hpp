@@ -0,0 +1,77 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Shared helpers for the benchmark executables (dataset discovery from the environment).
+namespace msrl::bench
+{
+  namespace fs = std::filesystem;
+
+  // -------------------------
+  // Env helpers (MSVC-safe)
+  // -------------------------
+  inline std::string get_env_str(const char* key)
+  {
+#ifdef _WIN32
+    char* buf = nullptr;
+    size_t len = 0;
+    if ( _dupenv_s(&buf, &len, key) != 0 || !buf ) {
+      return {};
+    }
+    std::string val(buf);
+    free(buf);
+    return val;
+#else
+    if ( const char* v = std::getenv(key); v && *v ) {
+      return std::string(v);
+    }
+    return {};
+#endif
+  }
+
+  // -------------------------
+  // Dataset discovery
+  // -------------------------
+  inline std::vector<std::string> discover_snaps_from_processed_root()
+  {
+    const auto root = get_env_str("DATA_PROCESSED_ROOT");
+    if ( root.empty() ) {
+      throw std::runtime_error("DATA_PROCESSED_ROOT not set. Load .env or export it in the shell.");
+    }
+
+    fs::path dir(root);
+    if ( !fs::exists(dir) || !fs::is_directory(dir) ) {
+      throw std::runtime_error("DATA_PROCESSED_ROOT is not a directory: " + root);
+    }
+
+    std::vector<std::string> out;
+    for ( const auto& ent : fs::recursive_directory_iterator(dir) ) {
+      if ( !ent.is_regular_file() )
+        continue;
+      if ( ent.path().extension() == ".snap" ) {
+        out.push_back(ent.path().string());
+      }
+    }
+
+    if ( out.empty() ) {
+      throw std::runtime_error("No .snap files found under DATA_PROCESSED_ROOT");
+    }
+
+    std::sort(out.begin(), out.end());
+    return out;
+  }
+
+  // Single file for per-call benchmarks: MSRL_BENCH_SNAP if set, else the first
+  // .snap under DATA_PROCESSED_ROOT (same file the Python binding suite should use).
+  inline std::string select_bench_snap()
+  {
+    if ( auto p = get_env_str("MSRL_BENCH_SNAP"); !p.empty() )
+      return p;
+    return discover_snaps_from_processed_root().front();
+  }
+} // namespace msrl::bench
@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_common.hpp"
+#include "md_bus.hpp"
+#include "replay.hpp"
+
+// Fan-out of one replay publisher to 1..32 consumers over the shared-memory md bus.
+// Consumers run as threads in this process but attach by name and map the file
+// themselves, exactly like separate processes would.
+//
+// Per run: items/s = publisher throughput; delivered/s = records read by all
+// consumers; lat_* = publish -> consumer latency (steady clock, sampled 1 in 16).
+//
+// File: MSRL_BENCH_SNAP, else the first .snap under DATA_PROCESSED_ROOT.
+
+namespace
+{
+  using msrl::bench::select_bench_snap;
+
+  constexpr std::size_t kCapacity = 4096;
+  constexpr std::uint64_t kSampleMask = 15;
+
+  std::string g_snap;
+  std::atomic<std::uint64_t> g_run{0};
+
+  struct ConsumerStats
+  {
+    std::uint64_t records = 0;
+    std::uint64_t dropped = 0;
+    std::vector<std::int64_t> lat_ns;
+  };
+
+  void consume(md::l2::BusConsumer& c, ConsumerStats& st)
+  {
+    while ( const md::l2::Record* r = c.next() ) {
+      benchmark::DoNotOptimize(r->bids[0].price_q);
+      benchmark::DoNotOptimize(r->asks[0].price_q);
+      if ( (c.seq() & kSampleMask) == 0 )
+        st.lat_ns.push_back(md::l2::bus_clock_ns() - c.publish_ns());
+      ++st.records;
+    }
+    st.dropped = c.dropped();
+  }
+
+  double percentile(std::vector<std::int64_t>& v, double q)
+  {
+    if ( v.empty() )
+      return 0.0;
+    const std::size_t k = static_cast<std::size_t>(q * static_cast<double>(v.size() - 1));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return static_cast<double>(v[k]);
+  }
+
+  void RunFanOut(benchmark::State& state, md::l2::BusMode mode)
+  {
+    if ( g_snap.empty() ) {
+      try {
+        g_snap = select_bench_snap();
+      }
+      catch ( const std::exception& e ) {
+        state.SkipWithError(e.what());
+        return;
+      }
+    }
+
+    const std::size_t n_consumers = static_cast<std::size_t>(state.range(0));
+    const std::string bus = "bench_" + std::to_string(g_run.fetch_add(1));
+
+    md::l2::BusPublisher pub(bus, g_snap, kCapacity);
+    const std::size_t n_records = pub.kernel().size();
+    if ( n_records == 0 ) {
+      state.SkipWithError("Encountered an empty .snap file");
+      return;
+    }
+
+    // Attach everyone before the first publish so each consumer sees the whole run
+    std::vector<std::unique_ptr<md::l2::BusConsumer>> consumers;
+    for ( std::size_t i = 0; i < n_consumers; ++i )
+      consumers.push_back(std::make_unique<md::l2::BusConsumer>(bus, mode));
+    std::vector<ConsumerStats> stats(n_consumers);
+    std::vector<std::thread> threads;
+    for ( std::size_t i = 0; i < n_consumers; ++i )
+      threads.emplace_back(consume, std::ref(*consumers[i]), std::ref(stats[i]));
+
+    std::size_t idx = 0;
+    for ( auto _ : state ) {
+      pub.publish(idx);
+      if ( ++idx == n_records )
+        idx = 0;
+    }
+    pub.close();
+    for ( std::thread& t : threads )
+      t.join();
+
+    std::uint64_t delivered = 0;
+    std::uint64_t dropped = 0;
+    std::vector<std::int64_t> lat;
+    for ( ConsumerStats& st : stats ) {
+      delivered += st.records;
+      dropped += st.dropped;
+      lat.insert(lat.end(), st.lat_ns.begin(), st.lat_ns.end());
+    }
+    double lat_sum = 0.0;
+    for ( const std::int64_t v : lat )
+      lat_sum += static_cast<double>(v);
+
+    state.SetItemsProcessed(static_cast<int64_t>(pub.published()));
+    state.counters["consumers"] = static_cast<double>(n_consumers);
+    state.counters["delivered/s"] =
+        benchmark::Counter(static_cast<double>(delivered), benchmark::Counter::kIsRate);
+    state.counters["dropped"] = static_cast<double>(dropped);
+    state.counters["lat_mean_ns"] = lat.empty() ? 0.0 : lat_sum / static_cast<double>(lat.size());
+    state.counters["lat_p50_ns"] = percentile(lat, 0.50);
+    state.counters["lat_p99_ns"] = percentile(lat, 0.99);
+    state.counters["lat_max_ns"] = percentile(lat, 1.0);
+  }
+
+} // namespace
+
+// -------------------------
+// Benchmarks
+// -------------------------
+static void BM_Bus_FanOut_Backpressure(benchmark::State& state)
+{
+  RunFanOut(state, md::l2::BusMode::Backpressure);
+}
+
+static void BM_Bus_FanOut_FreeRun(benchmark::State& state)
+{
+  RunFanOut(state, md::l2::BusMode::FreeRun);
+}
+
+BENCHMARK(BM_Bus_FanOut_Backpressure)->RangeMultiplier(2)->Range(1, 32)->UseRealTime();
+BENCHMARK(BM_Bus_FanOut_FreeRun)->RangeMultiplier(2)->Range(1, 32)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "bench_common.hpp"
+#include "numa.hpp"
+#include "replay.hpp"
+#include "sim.hpp"
+
+// Parallel simulator steps/s with workers pinned per NUMA node, by node count
+// and record placement (0 = Shared mapping, 1 = Interleaved, 2 = Replicated).
+// Each worker steps its own MarketSimulator through kChunk records per
+// iteration, starting at a different offset so workers do not share lines.
+// Args: {nodes used, placement}; workers per node = fewest cpus on those nodes.
+//
+// File: MSRL_BENCH_SNAP, else the first .snap under DATA_PROCESSED_ROOT.
+
+namespace
+{
+  using msrl::bench::select_bench_snap;
+
+  constexpr std::size_t kChunk = 4096;
+
+  std::unique_ptr<md::l2::ReplayKernel> g_kernel;
+
+  md::l2::ReplayKernel* kernel_or_skip(benchmark::State& state)
+  {
+    if ( !g_kernel ) {
+      try {
+        g_kernel = std::make_unique<md::l2::ReplayKernel>(select_bench_snap());
+      }
+      catch ( const std::exception& e ) {
+        state.SkipWithError(e.what());
+        return nullptr;
+      }
+    }
+    if ( g_kernel->size() == 0 ) {
+      state.SkipWithError("Encountered an empty .snap file");
+      return nullptr;
+    }
+    return g_kernel.get();
+  }
+
+  const std::vector<md::l2::NumaNode>& host_nodes()
+  {
+    static const std::vector<md::l2::NumaNode> nodes = md::l2::numa_nodes();
+    return nodes;
+  }
+
+  // {1, 2, 4, ..., all nodes} x {Shared, Interleaved, Replicated}
+  void numa_args(benchmark::internal::Benchmark* b)
+  {
+    const auto total = static_cast<int64_t>(host_nodes().size());
+    for ( int64_t n = 1;; n = std::min(n * 2, total) ) {
+      for ( int64_t p = 0; p <= 2; ++p )
+        b->Args({n, p});
+      if ( n == total )
+        break;
+    }
+  }
+
+  sim::SimulatorParams bench_params()
+  {
+    sim::SimulatorParams p{};
+    p.max_orders = 4096;
+    p.max_events = 1u << 16;
+    return p;
+  }
+
+  sim::Ledger bench_ledger()
+  {
+    sim::Ledger l{};
+    l.cash_q = 1'000'000'000'000'000'000;
+    l.position_qty_q = 1'000'000'000'000;
+    return l;
+  }
+} // namespace
+
+// -------------------------
+// Benchmarks
+// -------------------------
+static void BM_Numa_Step(benchmark::State& state)
+{
+  auto* k = kernel_or_skip(state);
+  if ( !k )
+    return;
+  const std::vector<md::l2::NumaNode> nodes(
+      host_nodes().begin(),
+      host_nodes().begin() + state.range(0));
+  const auto placement = static_cast<md::l2::NumaPlacement>(state.range(1));
+
+  std::uint32_t per_node = UINT32_MAX;
+  for ( const md::l2::NumaNode& n : nodes )
+    per_node = std::min(per_node, std::max<std::uint32_t>(n.cpus, 1));
+
+  const md::l2::NumaRecordSet set(*k, placement, nodes);
+  md::l2::NumaWorkerPool pool(nodes, per_node);
+
+  std::vector<std::unique_ptr<sim::MarketSimulator>> sims;
+  std::vector<std::size_t> pos(pool.size());
+  for ( std::size_t w = 0; w < pool.size(); ++w ) {
+    sims.push_back(std::make_unique<sim::MarketSimulator>(bench_params()));
+    sims.back()->reset(sim::Ns{0}, bench_ledger());
+    pos[w] = w * set.size() / pool.size();
+  }
+
+  const md::l2::NumaWorkerPool::Job job = [&](const md::l2::NumaWorkerPool::Worker& w) {
+    const auto recs = set.records(w.node_slot);
+    sim::MarketSimulator& ex = *sims[w.index];
+    std::size_t p = pos[w.index];
+    for ( std::size_t i = 0; i < kChunk; ++i ) {
+      if ( p == recs.size() )
+        p = 0;
+      ex.step(recs[p++]);
+    }
+    pos[w.index] = p;
+  };
+
+  for ( auto _ : state )
+    pool.run(job);
+
+  std::size_t pinned = 0;
+  for ( std::size_t w = 0; w < pool.size(); ++w )
+    pinned += pool.worker(w).pinned ? 1 : 0;
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * pool.size() * kChunk));
+  state.counters["workers"] = static_cast<double>(pool.size());
+  state.counters["pinned"] = static_cast<double>(pinned);
+  state.counters["private_MiB"] = static_cast<double>(set.bytes_allocated()) / (1024.0 * 1024.0);
+}
+
+BENCHMARK(BM_Numa_Step)->Apply(numa_args)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,140 @@
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "depth_recorder.hpp"
+#include "order_book.hpp"
+
+// Diff-stream order book throughput on synthetic data (no dataset needed).
+// - BM_Ladder_Set: OrderBook::set() on a book of Arg levels per side, updates
+//   concentrated near the top (geometric distance from the best), ~1/4 removals.
+// - BM_Builder_Diffs: BookBuilder on in-sequence diffs of 8 levels, 100 ms
+//   cadence, depth 20 emission; items = level updates.
+// - BM_Parse_DepthUpdate: parse_depth_update() on a 10-level diff payload.
+
+namespace
+{
+  constexpr std::int64_t kMid = 10'000'000;
+  constexpr std::size_t kUpdates = 1u << 20;
+
+  struct Op
+  {
+    md::l2::BookSide side;
+    std::int64_t price_q;
+    std::int64_t qty_q;
+  };
+
+  std::vector<Op> make_ops(std::size_t n, std::uint64_t seed)
+  {
+    std::mt19937_64 rng(seed);
+    std::geometric_distribution<std::int64_t> dist(0.15);
+    std::vector<Op> ops(n);
+    for ( Op& op : ops ) {
+      const bool bid = (rng() & 1) != 0;
+      const std::int64_t off = 1 + dist(rng);
+      op.side = bid ? md::l2::BookSide::Bid : md::l2::BookSide::Ask;
+      op.price_q = bid ? kMid - off : kMid + off;
+      op.qty_q = (rng() % 4 == 0) ? 0 : static_cast<std::int64_t>(1 + rng() % 1000);
+    }
+    return ops;
+  }
+
+  void preload(md::l2::OrderBook& book, std::size_t levels)
+  {
+    for ( std::size_t i = 1; i <= levels; ++i ) {
+      book.set(md::l2::BookSide::Bid, kMid - static_cast<std::int64_t>(i), 1);
+      book.set(md::l2::BookSide::Ask, kMid + static_cast<std::int64_t>(i), 1);
+    }
+  }
+} // namespace
+
+// -------------------------
+// Benchmarks
+// -------------------------
+static void BM_Ladder_Set(benchmark::State& state)
+{
+  const std::vector<Op> ops = make_ops(kUpdates, 1);
+  md::l2::OrderBook book;
+  preload(book, static_cast<std::size_t>(state.range(0)));
+  std::size_t i = 0;
+  for ( auto _ : state ) {
+    const Op& op = ops[i++ & (kUpdates - 1)];
+    book.set(op.side, op.price_q, op.qty_q);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.counters["bid_levels"] = static_cast<double>(book.levels(md::l2::BookSide::Bid));
+}
+
+static void BM_Builder_Diffs(benchmark::State& state)
+{
+  constexpr std::size_t kDiffs = 1u << 16;
+  constexpr std::size_t kLevelsPerDiff = 8;
+  const std::vector<Op> ops = make_ops(kDiffs * kLevelsPerDiff, 2);
+
+  md::l2::DepthUpdate snap;
+  snap.snapshot = true;
+  for ( std::int64_t i = 1; i <= 1000; ++i ) {
+    snap.bids.push_back(md::l2::Level{kMid - i, 1});
+    snap.asks.push_back(md::l2::Level{kMid + i, 1});
+  }
+
+  std::vector<md::l2::DepthUpdate> diffs(kDiffs);
+  for ( std::size_t d = 0; d < kDiffs; ++d ) {
+    for ( std::size_t k = 0; k < kLevelsPerDiff; ++k ) {
+      const Op& op = ops[d * kLevelsPerDiff + k];
+      auto& side = op.side == md::l2::BookSide::Bid ? diffs[d].bids : diffs[d].asks;
+      side.push_back(md::l2::Level{op.price_q, op.qty_q});
+    }
+  }
+
+  std::uint64_t records = 0;
+  std::uint64_t id = 0;
+  std::int64_t ts = 0;
+  for ( auto _ : state ) {
+    state.PauseTiming();
+    md::l2::BookBuilderConfig cfg{};
+    cfg.cadence_ns = 100'000'000;
+    md::l2::BookBuilder builder(cfg, [&](const md::l2::Record&) { ++records; });
+    snap.last_update_id = id;
+    snap.ts_recv_ns = ts;
+    builder.on_update(snap);
+    state.ResumeTiming();
+
+    for ( md::l2::DepthUpdate& u : diffs ) {
+      u.first_update_id = u.last_update_id = ++id;
+      u.ts_recv_ns = (ts += 1'000'000); // 1 ms apart
+      builder.on_update(u);
+    }
+    builder.finish();
+    benchmark::DoNotOptimize(records);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kDiffs * kLevelsPerDiff));
+  state.counters["records"] = static_cast<double>(records);
+}
+
+static void BM_Parse_DepthUpdate(benchmark::State& state)
+{
+  std::string json = R"({"e":"depthUpdate","E":1700000000123,"s":"BTCUSDT","U":157,"u":160,"b":[)";
+  for ( int i = 0; i < 5; ++i )
+    json += (i ? "," : "") + ("[\"4321" + std::to_string(i) + ".12000000\",\"0.01234000\"]");
+  json += R"(],"a":[)";
+  for ( int i = 0; i < 5; ++i )
+    json += (i ? "," : "") + ("[\"4322" + std::to_string(i) + ".12000000\",\"0.00000000\"]");
+  json += "]}";
+
+  md::l2::DepthUpdate u;
+  for ( auto _ : state ) {
+    const bool ok = md::l2::parse_depth_update(json, 1, u);
+    benchmark::DoNotOptimize(ok);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * json.size()));
+}
+
+BENCHMARK(BM_Ladder_Set)->Arg(100)->Arg(1000)->Arg(10000);
+BENCHMARK(BM_Builder_Diffs)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Parse_DepthUpdate);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "bench_common.hpp"
+#include "replay.hpp"
+#include "replay_pipeline.hpp"
+#include "sim.hpp"
+
+// End-to-end steps/s with the record source inline on the simulator thread versus
+// on a producer thread behind ReplayPipeline.
+//
+// Source = copy out of the mapping + `decode passes`: each pass folds every 8-byte
+// word of the record into a checksum, a stand-in for decompression / merge cost.
+// Args: {batch_records, decode passes}.
+//
+// File: MSRL_BENCH_SNAP, else the first .snap under DATA_PROCESSED_ROOT.
+
+namespace
+{
+  using msrl::bench::select_bench_snap;
+
+  constexpr std::size_t kDepth = 8;
+
+  std::unique_ptr<md::l2::ReplayKernel> g_kernel;
+
+  md::l2::ReplayKernel* kernel_or_skip(benchmark::State& state)
+  {
+    if ( !g_kernel ) {
+      try {
+        g_kernel = std::make_unique<md::l2::ReplayKernel>(select_bench_snap());
+      }
+      catch ( const std::exception& e ) {
+        state.SkipWithError(e.what());
+        return nullptr;
+      }
+    }
+    if ( g_kernel->size() == 0 ) {
+      state.SkipWithError("Encountered an empty .snap file");
+      return nullptr;
+    }
+    return g_kernel.get();
+  }
+
+  // Endless source over the kernel (wraps at end-of-file), with synthetic decode work
+  struct DecodingSource
+  {
+    const md::l2::ReplayKernel* rk = nullptr;
+    std::size_t passes = 0;
+    std::size_t pos = 0;
+
+    std::size_t operator()(std::span<md::l2::Record> out)
+    {
+      std::size_t n = 0;
+      while ( n < out.size() ) {
+        if ( pos == rk->size() )
+          pos = 0;
+        const std::size_t k = std::min(out.size() - n, rk->size() - pos);
+        std::memcpy(out.data() + n, rk->begin() + pos, k * sizeof(md::l2::Record));
+        pos += k;
+        n += k;
+      }
+      for ( std::size_t p = 0; p < passes; ++p ) {
+        for ( const md::l2::Record& r : out ) {
+          const auto* w = reinterpret_cast<const std::uint64_t*>(&r);
+          std::uint64_t h = 0;
+          for ( std::size_t i = 0; i < sizeof(md::l2::Record) / 8; ++i )
+            h = (h ^ w[i]) * 0x9E3779B97F4A7C15ull;
+          benchmark::DoNotOptimize(h);
+        }
+      }
+      return n;
+    }
+  };
+
+  sim::SimulatorParams bench_params()
+  {
+    sim::SimulatorParams p{};
+    p.max_orders = 4096;
+    p.max_events = 1u << 16;
+    return p;
+  }
+
+  sim::Ledger bench_ledger()
+  {
+    sim::Ledger l{};
+    l.cash_q = 1'000'000'000'000'000'000;
+    l.position_qty_q = 1'000'000'000'000;
+    return l;
+  }
+} // namespace
+
+// -------------------------
+// Benchmarks
+// -------------------------
+static void BM_Pipeline_Inline(benchmark::State& state)
+{
+  auto* k = kernel_or_skip(state);
+  if ( !k )
+    return;
+  const std::size_t batch = static_cast<std::size_t>(state.range(0));
+  DecodingSource src{k, static_cast<std::size_t>(state.range(1))};
+  std::vector<md::l2::Record> buf(batch);
+
+  sim::MarketSimulator ex(bench_params());
+  ex.reset(sim::Ns{0}, bench_ledger());
+  std::uint64_t steps = 0;
+  for ( auto _ : state ) {
+    const std::size_t n = src(buf);
+    for ( std::size_t i = 0; i < n; ++i )
+      ex.step(buf[i]);
+    steps += n;
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(steps));
+}
+
+static void BM_Pipeline_Pipelined(benchmark::State& state)
+{
+  auto* k = kernel_or_skip(state);
+  if ( !k )
+    return;
+  const std::size_t batch = static_cast<std::size_t>(state.range(0));
+  md::l2::ReplayPipeline pipe(
+      DecodingSource{k, static_cast<std::size_t>(state.range(1))},
+      batch,
+      kDepth);
+
+  sim::MarketSimulator ex(bench_params());
+  ex.reset(sim::Ns{0}, bench_ledger());
+  std::uint64_t steps = 0;
+  for ( auto _ : state ) {
+    const std::span<const md::l2::Record> b = pipe.next_batch();
+    for ( const md::l2::Record& r : b )
+      ex.step(r);
+    steps += b.size();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(steps));
+}
+
+BENCHMARK(BM_Pipeline_Inline)
+    ->ArgsProduct({{64, 256, 1024}, {0, 1, 4}})
+    ->UseRealTime();
+BENCHMARK(BM_Pipeline_Pipelined)
+    ->ArgsProduct({{64, 256, 1024}, {0, 1, 4}})
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,236 @@
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench_common.hpp"
+#include "replay.hpp"
+#include "sim.hpp"
+
+// Native baselines for the Python binding-overhead suite (scripts/bench_bindings.py).
+// Each benchmark mirrors one Python loop on the same file; per-call Python cost minus
+// the matching BM_Native_* time is the binding crossing overhead.
+//
+// File: MSRL_BENCH_SNAP, else the first .snap under DATA_PROCESSED_ROOT.
+// JSON:  bench_sim --benchmark_format=json --benchmark_out=native.json
+
+namespace
+{
+  using msrl::bench::select_bench_snap;
+
+  constexpr std::size_t kMaxOrders = 4096;
+  constexpr std::size_t kMaxEvents = 1u << 16;
+  constexpr std::size_t kFillsForSnapshot = 256;
+
+  std::unique_ptr<md::l2::ReplayKernel> g_kernel;
+
+  md::l2::ReplayKernel* kernel_or_skip(benchmark::State& state)
+  {
+    if ( !g_kernel ) {
+      try {
+        g_kernel = std::make_unique<md::l2::ReplayKernel>(select_bench_snap());
+      }
+      catch ( const std::exception& e ) {
+        state.SkipWithError(e.what());
+        return nullptr;
+      }
+    }
+    if ( g_kernel->size() == 0 ) {
+      state.SkipWithError("Encountered an empty .snap file");
+      return nullptr;
+    }
+    g_kernel->reset();
+    return g_kernel.get();
+  }
+
+  // Next record, wrapping to the start at end-of-stream.
+  inline const md::l2::Record* next_wrap(md::l2::ReplayKernel& k)
+  {
+    const md::l2::Record* r = k.next();
+    if ( !r ) {
+      k.reset();
+      r = k.next();
+    }
+    return r;
+  }
+
+  sim::SimulatorParams bench_params()
+  {
+    sim::SimulatorParams p{};
+    p.max_orders = kMaxOrders;
+    p.max_events = kMaxEvents;
+    return p;
+  }
+
+  sim::Ledger bench_ledger()
+  {
+    sim::Ledger l{};
+    l.cash_q = 1'000'000'000'000'000'000;
+    l.position_qty_q = 1'000'000'000'000;
+    return l;
+  }
+
+  // Passive bid one tick below the touch, so it rests without filling.
+  sim::LimitOrderRequest passive_bid(const md::l2::Record& r)
+  {
+    sim::LimitOrderRequest req{};
+    req.side = sim::Side::Buy;
+    req.price_q = r.bids[0].price_q > 1 ? r.bids[0].price_q - 1 : 1;
+    req.qty_q = 1;
+    return req;
+  }
+} // namespace
+
+// -------------------------
+// Replay
+// -------------------------
+static void BM_Native_ReplayNext(benchmark::State& state)
+{
+  auto* k = kernel_or_skip(state);
+  if ( !k )
+    return;
+  for ( auto _ : state ) {
+    benchmark::DoNotOptimize(next_wrap(*k));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// RecordView.ts_recv_ns / best_bid_price_q / best_ask_price_q
+static void BM_Native_RecordFieldAccess(benchmark::State& state)
+{
+  auto* k = kernel_or_skip(state);
+  if ( !k )
+    return;
+  const md::l2::Record* r = next_wrap(*k);
+  for ( auto _ : state ) {
+    benchmark::DoNotOptimize(r->ts_recv_ns);
+    benchmark::DoNotOptimize(r->best_bid_price_q());
+    benchmark::DoNotOptimize(r->best_ask_price_q());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// RecordView.bids(): native equivalent is taking the level pointer and reading TOB
+static void BM_Native_BidsView(benchmark::State& state)
+{
+  auto* k = kernel_or_skip(state);
+  if ( !k )
+    return;
+  const md::l2::Record* r = next_wrap(*k);
+  for ( auto _ : state ) {
+    const md::l2::Level* lv = r->bids.data();
+    benchmark::DoNotOptimize(lv);
+    benchmark::DoNotOptimize(lv[0].qty_q);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// -------------------------
+// Simulator
+// -------------------------
+static void BM_Native_SimStep(benchmark::State& state)
+{
+  auto* k = kernel_or_skip(state);
+  if ( !k )
+    return;
+  sim::MarketSimulator ex(bench_params());
+  ex.reset(sim::Ns{0}, bench_ledger());
+  for ( auto _ : state ) {
+    ex.step(*next_wrap(*k));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// place_limit in batches of (kMaxOrders - 1); reset between batches is untimed
+static void BM_Native_PlaceLimit(benchmark::State& state)
+{
+  auto* k = kernel_or_skip(state);
+  if ( !k )
+    return;
+  const md::l2::Record& r0 = *next_wrap(*k);
+  const sim::LimitOrderRequest req = passive_bid(r0);
+  sim::MarketSimulator ex(bench_params());
+  std::size_t placed = kMaxOrders - 1; // forces the initial reset
+  for ( auto _ : state ) {
+    if ( placed == kMaxOrders - 1 ) {
+      state.PauseTiming();
+      ex.reset(sim::Ns{0}, bench_ledger());
+      ex.step(r0);
+      placed = 0;
+      state.ResumeTiming();
+    }
+    benchmark::DoNotOptimize(ex.place_limit(req));
+    ++placed;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// cancel of a resting order; each batch of orders is placed and activated untimed
+static void BM_Native_Cancel(benchmark::State& state)
+{
+  auto* k = kernel_or_skip(state);
+  if ( !k )
+    return;
+  const md::l2::Record& r0 = *next_wrap(*k);
+  const sim::LimitOrderRequest req = passive_bid(r0);
+  sim::MarketSimulator ex(bench_params());
+  std::vector<sim::u64> ids;
+  ids.reserve(kMaxOrders);
+  std::size_t next = 0;
+  for ( auto _ : state ) {
+    if ( next == ids.size() ) {
+      state.PauseTiming();
+      ex.reset(sim::Ns{0}, bench_ledger());
+      ex.step(r0);
+      ids.clear();
+      for ( std::size_t i = 0; i + 1 < kMaxOrders; ++i )
+        ids.push_back(ex.place_limit(req));
+      ex.step(r0); // activate
+      next = 0;
+      state.ResumeTiming();
+    }
+    benchmark::DoNotOptimize(ex.cancel(ids[next++]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// fills() snapshot: the binding copies the fill log into a new vector per call
+static void BM_Native_FillsSnapshot(benchmark::State& state)
+{
+  auto* k = kernel_or_skip(state);
+  if ( !k )
+    return;
+  sim::MarketSimulator ex(bench_params());
+  ex.reset(sim::Ns{0}, bench_ledger());
+  // Marketable 1-lot buys at the touch (market orders are rejected by the engine)
+  const md::l2::Record* r = next_wrap(*k);
+  ex.step(*r);
+  for ( std::size_t i = 0; i < kFillsForSnapshot; ++i ) {
+    sim::LimitOrderRequest take{};
+    take.side = sim::Side::Buy;
+    take.price_q = r->asks[0].price_q;
+    take.qty_q = 1;
+    (void)ex.place_limit(take);
+    r = next_wrap(*k);
+    ex.step(*r);
+    r = next_wrap(*k);
+    ex.step(*r);
+  }
+  for ( auto _ : state ) {
+    std::vector<sim::FillEvent> copy(ex.fills().begin(), ex.fills().end());
+    benchmark::DoNotOptimize(copy.data());
+  }
+  state.counters["n_fills"] = static_cast<double>(ex.fills().size());
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_Native_ReplayNext);
+BENCHMARK(BM_Native_RecordFieldAccess);
+BENCHMARK(BM_Native_BidsView);
+BENCHMARK(BM_Native_SimStep);
+BENCHMARK(BM_Native_PlaceLimit);
+BENCHMARK(BM_Native_Cancel);
+BENCHMARK(BM_Native_FillsSnapshot);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "bench_common.hpp"
+#include "replay.hpp"
+#include "zone_map.hpp"
+
+// Predicate scan over one file: a serial record-by-record filter vs zone_scan()
+// (block skipping + parallel filter), Arg = threads. The query is "spread wider
+// than the file's tightest spread, within the middle 10% of the file's time
+// range", i.e. a selective research-style filter.
+//
+// File: MSRL_BENCH_SNAP, else the first .snap under DATA_PROCESSED_ROOT.
+
+namespace
+{
+  using msrl::bench::select_bench_snap;
+
+  struct Fixture
+  {
+    std::unique_ptr<md::l2::ReplayKernel> rk;
+    md::l2::ZoneMap zm;
+    std::vector<md::l2::ZonePredicate> preds;
+  };
+
+  std::unique_ptr<Fixture> g_fixture;
+
+  const Fixture* fixture_or_skip(benchmark::State& state)
+  {
+    if ( !g_fixture ) {
+      try {
+        auto f = std::make_unique<Fixture>();
+        f->rk = std::make_unique<md::l2::ReplayKernel>(select_bench_snap());
+        if ( f->rk->size() == 0 ) {
+          state.SkipWithError("Encountered an empty .snap file");
+          return nullptr;
+        }
+        f->zm = md::l2::ZoneMap::build(*f->rk);
+
+        const auto spread = static_cast<std::size_t>(md::l2::ZoneField::Spread);
+        std::int64_t tightest = INT64_MAX;
+        for ( const md::l2::Zone& z : f->zm.zones() )
+          tightest = std::min(tightest, z.lo[spread]);
+        const std::int64_t t0 = (*f->rk)[0].ts_recv_ns;
+        const std::int64_t span = (*f->rk)[f->rk->size() - 1].ts_recv_ns - t0;
+        f->preds = {
+            {md::l2::ZoneField::TsRecvNs, t0 + span * 45 / 100, t0 + span * 55 / 100},
+            {md::l2::ZoneField::Spread, tightest + 1, INT64_MAX}};
+        g_fixture = std::move(f);
+      }
+      catch ( const std::exception& e ) {
+        state.SkipWithError(e.what());
+        return nullptr;
+      }
+    }
+    return g_fixture.get();
+  }
+} // namespace
+
+// -------------------------
+// Benchmarks
+// -------------------------
+static void BM_FullScan_Serial(benchmark::State& state)
+{
+  const Fixture* f = fixture_or_skip(state);
+  if ( !f )
+    return;
+  for ( auto _ : state ) {
+    std::vector<std::uint64_t> out;
+    for ( std::size_t i = 0; i < f->rk->size(); ++i ) {
+      bool ok = true;
+      for ( const md::l2::ZonePredicate& p : f->preds ) {
+        std::int64_t v = 0;
+        ok = ok && md::l2::zone_value((*f->rk)[i], p.field, v) && v >= p.lo && v <= p.hi;
+      }
+      if ( ok )
+        out.push_back(i);
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * f->rk->size()));
+}
+
+static void BM_ZoneScan(benchmark::State& state)
+{
+  const Fixture* f = fixture_or_skip(state);
+  if ( !f )
+    return;
+  const auto threads = static_cast<unsigned>(state.range(0));
+  md::l2::ZoneScanStats st{};
+  for ( auto _ : state ) {
+    auto out = md::l2::zone_scan(*f->rk, f->zm, f->preds, threads, &st);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * f->rk->size()));
+  state.counters["blocks_scanned"] = static_cast<double>(st.blocks_scanned);
+  state.counters["blocks"] = static_cast<double>(st.blocks);
+  state.counters["matched"] = static_cast<double>(st.matched);
+}
+
+BENCHMARK(BM_FullScan_Serial)->UseRealTime();
+BENCHMARK(BM_ZoneScan)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -1,18 +1,40 @@
+#include <algorithm>
 #include <array>
+#include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <initializer_list>
 #include <memory>
 #include <nanobind/nanobind.h>
 #include <nanobind/ndarray.h>
 #include <nanobind/stl/optional.h>
+#include <nanobind/stl/pair.h>
 #include <nanobind/stl/shared_ptr.h>
 #include <nanobind/stl/string.h>
+#include <nanobind/stl/tuple.h>
 #include <nanobind/stl/vector.h>
 #include <optional>
+#include <span>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "action_log.hpp"
+#include "episode_sampler.hpp"
+#include "level_deltas.hpp"
+#include "md_bus.hpp"
+#include "numa.hpp"
+#include "paced_replay.hpp"
 #include "replay.hpp"
+#include "scenario_runner.hpp"
 #include "schema.hpp"
 #include "sim.hpp"
+#include "sim_rng.hpp"
+#include "snap_catalog.hpp"
+#include "snap_stats.hpp"
+#include "zone_map.hpp"
 
 namespace nb = nanobind;
 
@@ -27,6 +49,49 @@ static std::vector<T> snapshot_vec(const std::vector<T>& v)
 namespace
 {
 
+  // Element strides (nanobind strides are in elements, not bytes)
+  constexpr std::int64_t kRecordStrideI64 =
+      (std::int64_t)(sizeof(md::l2::Record) / sizeof(std::int64_t));
+  constexpr std::int64_t kLevelStrideI64 =
+      (std::int64_t)(sizeof(md::l2::Level) / sizeof(std::int64_t));
+  constexpr std::int64_t kSideStrideI64 =
+      (std::int64_t)(offsetof(md::l2::Record, asks) - offsetof(md::l2::Record, bids)) /
+      (std::int64_t)sizeof(std::int64_t);
+
+  static_assert(sizeof(md::l2::Record) % sizeof(std::int64_t) == 0);
+
+  using I64View = nb::ndarray<const std::int64_t, nb::numpy>;
+
+  // (n, 2, depth, 2) view of [side][level][price_q, qty_q]; side 0 = bids, 1 = asks
+  I64View levels_view(const md::l2::Record* first, std::size_t n, nb::handle owner)
+  {
+    const auto* ptr = first ? reinterpret_cast<const std::int64_t*>(first->bids.data()) : nullptr;
+    return I64View(
+        ptr,
+        {n, (std::size_t)2, (std::size_t)md::l2::kDepth, (std::size_t)2},
+        owner,
+        {kRecordStrideI64, kSideStrideI64, kLevelStrideI64, (std::int64_t)1});
+  }
+
+  // (n,) view of one int64 field at element offset `field` within each Record
+  I64View
+  field_view(const md::l2::Record* first, std::size_t n, std::size_t field, nb::handle owner)
+  {
+    const auto* ptr = first ? reinterpret_cast<const std::int64_t*>(first) + field : nullptr;
+    return I64View(ptr, {n}, owner, {kRecordStrideI64});
+  }
+
+  // (n, record_size/8) raw int64 view; `.view(record_dtype(depth))` on the Python
+  // side reinterprets it as the structured .snap dtype without copying.
+  I64View raw_view(const md::l2::Record* first, std::size_t n, nb::handle owner)
+  {
+    return I64View(
+        reinterpret_cast<const std::int64_t*>(first),
+        {n, (std::size_t)kRecordStrideI64},
+        owner,
+        {kRecordStrideI64, (std::int64_t)1});
+  }
+
   // Read-only view over a memory-mapped Record that keeps the ReplayKernel alive
   struct RecordView
   {
@@ -39,28 +104,146 @@ namespace
     std::int64_t best_bid_price_q() const noexcept { return rec->best_bid_price_q(); }
     std::int64_t best_ask_price_q() const noexcept { return rec->best_ask_price_q(); }
 
-    nb::ndarray<const std::int64_t, nb::numpy> bids() const
+    I64View bids() const
     {
       const auto* ptr = reinterpret_cast<const std::int64_t*>(rec->bids.data());
       // Expose (kDepth, 2) int64 view: [price_q, qty_q] for each level
-      return nb::ndarray<const std::int64_t, nb::numpy>(
+      return I64View(
           ptr,
           {(std::size_t)md::l2::kDepth, (std::size_t)2},
           owner, // handle to Python object
-          {(std::int64_t)sizeof(md::l2::Level), (std::int64_t)sizeof(std::int64_t)});
+          {kLevelStrideI64, (std::int64_t)1});
     }
 
-    nb::ndarray<const std::int64_t, nb::numpy> asks() const
+    I64View asks() const
     {
       const auto* ptr = reinterpret_cast<const std::int64_t*>(rec->asks.data());
-      return nb::ndarray<const std::int64_t, nb::numpy>(
+      return I64View(
           ptr,
           {(std::size_t)md::l2::kDepth, (std::size_t)2},
           owner,
-          {(std::int64_t)sizeof(md::l2::Level), (std::int64_t)sizeof(std::int64_t)});
+          {kLevelStrideI64, (std::int64_t)1});
+    }
+  };
+
+  // Contiguous run of mapped Records [start, start+size) that keeps the ReplayKernel alive.
+  // All accessors are zero-copy views over the mapping.
+  struct RecordBatch
+  {
+    nb::object owner;
+    const md::l2::Record* first{nullptr};
+    std::size_t start{0};
+    std::size_t size{0};
+
+    I64View levels() const { return levels_view(first, size, owner); }
+    I64View ts_recv_ns() const
+    {
+      return field_view(first, size, offsetof(md::l2::Record, ts_recv_ns) / 8, owner);
+    }
+    I64View ts_event_ms() const
+    {
+      return field_view(first, size, offsetof(md::l2::Record, ts_event_ms) / 8, owner);
+    }
+    I64View raw() const { return raw_view(first, size, owner); }
+
+    RecordView at(std::size_t i) const
+    {
+      if ( i >= size )
+        throw nb::index_error("RecordBatch index out of range");
+      return RecordView{owner, first + i};
     }
   };
 
+  // Clamp [start, stop) to the kernel and return the first record pointer.
+  const md::l2::Record* checked_range(
+      const md::l2::ReplayKernel& rk,
+      std::size_t start,
+      std::optional<std::size_t>& stop)
+  {
+    const std::size_t end = stop ? (std::min)(*stop, rk.size()) : rk.size();
+    if ( start > end )
+      throw nb::index_error("start > stop");
+    stop = end;
+    return start < end ? rk.begin() + start : nullptr;
+  }
+
+  // Owned per-level delta stream (see level_deltas.hpp); arrays are views into it
+  struct LevelDeltaStream
+  {
+    std::vector<md::l2::LevelDeltaRecord> data;
+
+    std::size_t size() const noexcept { return data.size(); }
+
+    static constexpr std::int64_t kRecStrideI64 =
+        (std::int64_t)(sizeof(md::l2::LevelDeltaRecord) / sizeof(std::int64_t));
+    static constexpr std::int64_t kRecStrideU32 =
+        (std::int64_t)(sizeof(md::l2::LevelDeltaRecord) / sizeof(std::uint32_t));
+
+    nb::ndarray<const std::int64_t, nb::numpy> dqty_(bool bids, nb::handle owner) const
+    {
+      const std::int64_t* ptr = nullptr;
+      if ( !data.empty() )
+        ptr = bids ? data[0].bids.dqty_q.data() : data[0].asks.dqty_q.data();
+      // (n, kDepth) signed qty delta at the price of each level; strides in elements
+      return nb::ndarray<const std::int64_t, nb::numpy>(
+          ptr,
+          {data.size(), (std::size_t)md::l2::kDepth},
+          owner,
+          {kRecStrideI64, (std::int64_t)1});
+    }
+
+    nb::ndarray<const std::uint32_t, nb::numpy>
+    mask_(const std::uint32_t* first, nb::handle owner) const
+    {
+      return nb::ndarray<const std::uint32_t, nb::numpy>(
+          data.empty() ? nullptr : first, {data.size()}, owner, {kRecStrideU32});
+    }
+  };
+
+  static_assert(sizeof(md::l2::LevelDeltaRecord) % sizeof(std::int64_t) == 0);
+
+  // Field layout of an engine POD, used by the Python side to build a numpy
+  // structured dtype that matches the C++ struct exactly (names/offsets/itemsize).
+  struct FieldDesc
+  {
+    const char* name;
+    std::size_t offset;
+    const char* format; // numpy format string
+  };
+
+  nb::tuple layout_tuple(std::initializer_list<FieldDesc> fields, std::size_t itemsize)
+  {
+    nb::list l;
+    for ( const FieldDesc& f : fields )
+      l.append(nb::make_tuple(f.name, f.offset, f.format));
+    return nb::make_tuple(l, itemsize);
+  }
+
+  // Read-only (n, sizeof(T)) byte view over a simulator storage vector.
+  // Valid only while MarketSimulator::storage_version() is unchanged.
+  template <class T>
+  nb::ndarray<const std::uint8_t, nb::numpy> bytes_view(const std::vector<T>& v, nb::handle owner)
+  {
+    static_assert(std::is_standard_layout_v<T> && std::is_trivially_copyable_v<T>);
+    return nb::ndarray<const std::uint8_t, nb::numpy>(
+        v.empty() ? nullptr : reinterpret_cast<const std::uint8_t*>(v.data()),
+        {v.size(), sizeof(T)},
+        owner);
+  }
+
+  // Owning (n,) uint64 array; the ids are moved into a heap vector freed by the capsule.
+  nb::ndarray<std::uint64_t, nb::numpy> owned_u64(std::vector<sim::u64>&& ids)
+  {
+    auto* v = new std::vector<sim::u64>(std::move(ids));
+    nb::capsule owner(v, [](void* p) noexcept { delete static_cast<std::vector<sim::u64>*>(p); });
+    return nb::ndarray<std::uint64_t, nb::numpy>(v->data(), {v->size()}, owner);
+  }
+
+  // (n, 2) int64 [price_q, qty_q] rows have QuoteLevel's layout
+  static_assert(sizeof(sim::QuoteLevel) == 2 * sizeof(std::int64_t));
+  using QuoteArray =
+      nb::ndarray<const std::int64_t, nb::shape<-1, 2>, nb::c_contig, nb::device::cpu>;
+
 } // namespace
 
 NB_MODULE(_core, m)
@@ -73,7 +256,11 @@ NB_MODULE(_core, m)
   nb::module_ mdl2 = m.def_submodule("md_l2", "Market data (L2) types");
 
   nb::class_<md::l2::ReplayKernel>(mdl2, "ReplayKernel")
-      .def(nb::init<const std::string&>(), nb::arg("snap_path"))
+      // Opening/mapping the file can block on I/O: drop the GIL
+      .def(
+          nb::init<const std::string&>(),
+          nb::arg("snap_path"),
+          nb::call_guard<nb::gil_scoped_release>())
       .def("size", &md::l2::ReplayKernel::size)
       .def("pos", &md::l2::ReplayKernel::pos)
       .def("reset", &md::l2::ReplayKernel::reset)
@@ -84,10 +271,128 @@ NB_MODULE(_core, m)
             if ( !r )
               return nb::none();
             // Keep Python-side ReplayKernel alive inside RecordView
-            RecordView v{nb::cast(&self, nb::rv_policy::reference), r};
+            RecordView v{nb::find(self), r};
             return nb::cast(v);
           },
-          "Return next RecordView or None at end-of-stream");
+          "Return next RecordView or None at end-of-stream")
+      .def(
+          "next_batch",
+          [](md::l2::ReplayKernel& self, std::size_t n) -> nb::object {
+            const std::size_t start = self.pos();
+            const auto span = self.next_batch(n);
+            if ( span.empty() )
+              return nb::none();
+            return nb::cast(RecordBatch{nb::find(self), span.data(), start, span.size()});
+          },
+          nb::arg("n"),
+          "Advance by up to n records; return a zero-copy RecordBatch or None at end-of-stream")
+      .def(
+          "window",
+          [](const md::l2::ReplayKernel& self, std::size_t k) {
+            const auto span = self.window(k);
+            return RecordBatch{
+                nb::find(self),
+                span.empty() ? nullptr : span.data(),
+                self.pos() - span.size(),
+                span.size()};
+          },
+          nb::arg("k"),
+          "Lookback RecordBatch of the last (up to) k records before the cursor; does not advance")
+      .def(
+          "view",
+          [](const md::l2::ReplayKernel& self, std::size_t start, std::optional<std::size_t> stop) {
+            const md::l2::Record* first = checked_range(self, start, stop);
+            return levels_view(first, *stop - start, nb::find(self));
+          },
+          nb::arg("start") = 0,
+          nb::arg("stop") = nb::none(),
+          "Return (n,2,depth,2) int64 view of [side][level][price_q, qty_q] for [start, stop)")
+      .def(
+          "batch",
+          [](const md::l2::ReplayKernel& self, std::size_t start, std::optional<std::size_t> stop) {
+            const md::l2::Record* first = checked_range(self, start, stop);
+            return RecordBatch{nb::find(self), first, start, *stop - start};
+          },
+          nb::arg("start") = 0,
+          nb::arg("stop") = nb::none(),
+          "Return a zero-copy RecordBatch for records [start, stop) without moving the cursor");
+
+  nb::class_<RecordBatch>(mdl2, "RecordBatch")
+      .def_ro("start", &RecordBatch::start)
+      .def("__len__", [](const RecordBatch& b) { return b.size; })
+      .def("__getitem__", &RecordBatch::at, nb::arg("i"))
+      .def(
+          "levels",
+          &RecordBatch::levels,
+          "Return (n,2,depth,2) int64 view of [side][level][price_q, qty_q]")
+      .def("ts_recv_ns", &RecordBatch::ts_recv_ns, "Return (n,) int64 view")
+      .def("ts_event_ms", &RecordBatch::ts_event_ms, "Return (n,) int64 view")
+      .def(
+          "raw",
+          &RecordBatch::raw,
+          "Return (n, record_size/8) int64 view; .view(record_dtype) gives structured records");
+
+  nb::class_<LevelDeltaStream>(mdl2, "LevelDeltaStream")
+      .def("size", &LevelDeltaStream::size)
+      .def("__len__", &LevelDeltaStream::size)
+      .def(
+          "bid_dqty_q",
+          [](nb::handle_t<LevelDeltaStream> self) {
+            return nb::cast<const LevelDeltaStream&>(self).dqty_(true, self);
+          },
+          "Return (n,depth) int64 view: qty change at each bid level's price vs previous record")
+      .def(
+          "ask_dqty_q",
+          [](nb::handle_t<LevelDeltaStream> self) {
+            return nb::cast<const LevelDeltaStream&>(self).dqty_(false, self);
+          },
+          "Return (n,depth) int64 view: qty change at each ask level's price vs previous record")
+      .def(
+          "bid_appear_mask",
+          [](nb::handle_t<LevelDeltaStream> self) {
+            const auto& s = nb::cast<const LevelDeltaStream&>(self);
+            return s.mask_(s.data.empty() ? nullptr : &s.data[0].bids.appear_mask, self);
+          })
+      .def(
+          "bid_vanish_mask",
+          [](nb::handle_t<LevelDeltaStream> self) {
+            const auto& s = nb::cast<const LevelDeltaStream&>(self);
+            return s.mask_(s.data.empty() ? nullptr : &s.data[0].bids.vanish_mask, self);
+          })
+      .def(
+          "ask_appear_mask",
+          [](nb::handle_t<LevelDeltaStream> self) {
+            const auto& s = nb::cast<const LevelDeltaStream&>(self);
+            return s.mask_(s.data.empty() ? nullptr : &s.data[0].asks.appear_mask, self);
+          })
+      .def(
+          "ask_vanish_mask",
+          [](nb::handle_t<LevelDeltaStream> self) {
+            const auto& s = nb::cast<const LevelDeltaStream&>(self);
+            return s.mask_(s.data.empty() ? nullptr : &s.data[0].asks.vanish_mask, self);
+          });
+
+  mdl2.def(
+      "build_level_deltas",
+      [](const md::l2::ReplayKernel& rk, std::size_t start, std::optional<std::size_t> stop) {
+        checked_range(rk, start, stop);
+        const std::size_t end = *stop;
+        LevelDeltaStream out;
+        {
+          nb::gil_scoped_release nogil;
+          out.data.resize(end - start);
+          md::l2::build_level_deltas(
+              rk.begin() + start,
+              rk.begin() + end,
+              start > 0 ? rk.begin() + (start - 1) : nullptr,
+              out.data.data());
+        }
+        return out;
+      },
+      nb::arg("kernel"),
+      nb::arg("start") = 0,
+      nb::arg("stop") = nb::none(),
+      "Build the per-level quantity-delta stream for records [start, stop) in one pass");
 
   nb::class_<RecordView>(mdl2, "RecordView")
       .def_prop_ro("ts_event_ms", &RecordView::ts_event_ms)
@@ -97,6 +402,420 @@ NB_MODULE(_core, m)
       .def("bids", &RecordView::bids, "Return (depth,2) ndarray view of [price_q, qty_q]")
       .def("asks", &RecordView::asks, "Return (depth,2) ndarray view of [price_q, qty_q]");
 
+  // Shared-memory md bus (one publisher process, many consumer processes)
+  nb::enum_<md::l2::BusMode>(mdl2, "BusMode")
+      .value("Backpressure", md::l2::BusMode::Backpressure)
+      .value("FreeRun", md::l2::BusMode::FreeRun);
+
+  // Publishing blocks on Backpressure consumers: every call that can wait drops the GIL
+  nb::class_<md::l2::BusPublisher>(mdl2, "BusPublisher")
+      .def(
+          nb::init<const std::string&, const std::string&, std::size_t>(),
+          nb::arg("bus_name"),
+          nb::arg("snap_path"),
+          nb::arg("capacity") = 4096,
+          nb::call_guard<nb::gil_scoped_release>())
+      .def(
+          "publish",
+          &md::l2::BusPublisher::publish,
+          nb::arg("record_index"),
+          nb::call_guard<nb::gil_scoped_release>(),
+          "Publish record `record_index`; blocks while a Backpressure consumer is a ring behind. "
+          "Returns the sequence number")
+      .def(
+          "try_publish",
+          &md::l2::BusPublisher::try_publish,
+          nb::arg("record_index"),
+          "Publish without blocking; False if a Backpressure consumer would be overrun")
+      .def(
+          "publish_batch",
+          &md::l2::BusPublisher::publish_batch,
+          nb::arg("n"),
+          nb::call_guard<nb::gil_scoped_release>(),
+          "Publish up to n records from the replay cursor; returns the number published")
+      .def("close", &md::l2::BusPublisher::close, "Mark end-of-stream")
+      .def("consumers", &md::l2::BusPublisher::consumers)
+      .def("published", &md::l2::BusPublisher::published)
+      .def("pos", [](const md::l2::BusPublisher& self) { return self.kernel().pos(); })
+      .def("size", [](const md::l2::BusPublisher& self) { return self.kernel().size(); })
+      .def_prop_ro("capacity", &md::l2::BusPublisher::capacity)
+      .def_prop_ro("name", &md::l2::BusPublisher::name);
+
+  nb::class_<md::l2::BusConsumer>(mdl2, "BusConsumer")
+      .def(
+          nb::init<const std::string&, md::l2::BusMode>(),
+          nb::arg("bus_name"),
+          nb::arg("mode") = md::l2::BusMode::Backpressure,
+          nb::call_guard<nb::gil_scoped_release>())
+      .def(
+          "next",
+          [](md::l2::BusConsumer& self) -> nb::object {
+            const md::l2::Record* r = nullptr;
+            {
+              nb::gil_scoped_release nogil;
+              r = self.next();
+            }
+            if ( !r )
+              return nb::none();
+            // Points into this consumer's own mapping of the file
+            return nb::cast(RecordView{nb::find(self), r});
+          },
+          "Wait for the next RecordView; None once the publisher closed and the ring is drained")
+      .def(
+          "try_next",
+          [](md::l2::BusConsumer& self) -> nb::object {
+            const md::l2::Record* r = self.try_next();
+            if ( !r )
+              return nb::none();
+            return nb::cast(RecordView{nb::find(self), r});
+          },
+          "Next RecordView if one is available now, else None (see finished())")
+      .def("finished", &md::l2::BusConsumer::finished)
+      .def("lag", &md::l2::BusConsumer::lag)
+      .def("size", [](const md::l2::BusConsumer& self) { return self.kernel().size(); })
+      .def_prop_ro("seq", &md::l2::BusConsumer::seq)
+      .def_prop_ro("record_index", &md::l2::BusConsumer::record_index)
+      .def_prop_ro("publish_ns", &md::l2::BusConsumer::publish_ns)
+      .def_prop_ro("dropped", &md::l2::BusConsumer::dropped)
+      .def_prop_ro("mode", &md::l2::BusConsumer::mode);
+
+  mdl2.def("bus_clock_ns", &md::l2::bus_clock_ns, "Steady clock (ns) that publish_ns is taken on");
+
+  // Wall-clock paced replay
+  nb::class_<md::l2::PacedReplayConfig>(mdl2, "PacedReplayConfig")
+      .def(nb::init<>())
+      .def_rw("speed", &md::l2::PacedReplayConfig::speed)
+      .def_rw("spin_ns", &md::l2::PacedReplayConfig::spin_ns)
+      .def_rw("max_gap_ns", &md::l2::PacedReplayConfig::max_gap_ns);
+
+  nb::class_<md::l2::PacedReplayStats>(mdl2, "PacedReplayStats")
+      .def_ro("delivered", &md::l2::PacedReplayStats::delivered)
+      .def_ro("lag_min_ns", &md::l2::PacedReplayStats::lag_min_ns)
+      .def_ro("lag_max_ns", &md::l2::PacedReplayStats::lag_max_ns)
+      .def_ro("lag_mean_ns", &md::l2::PacedReplayStats::lag_mean_ns)
+      .def_ro("wall_ns", &md::l2::PacedReplayStats::wall_ns)
+      .def_ro("schedule_ns", &md::l2::PacedReplayStats::schedule_ns)
+      .def_prop_ro(
+          "lag_hist",
+          [](const md::l2::PacedReplayStats& s) {
+            return std::vector<std::uint64_t>(s.lag_hist.begin(), s.lag_hist.end());
+          },
+          "Counts per bucket: [0] lag <= 0, [k] lag in [2^(k-1), 2^k) ns")
+      .def("lag_quantile_ns", &md::l2::PacedReplayStats::lag_quantile_ns, nb::arg("q"));
+
+  mdl2.def(
+      "paced_replay",
+      [](const md::l2::ReplayKernel& rk,
+         nb::callable sink,
+         const md::l2::PacedReplayConfig& cfg,
+         std::size_t start,
+         std::optional<std::size_t> stop) {
+        const md::l2::Record* first = checked_range(rk, start, stop);
+        const std::span<const md::l2::Record> span(first, *stop - start);
+        nb::object owner = nb::find(rk);
+        // Wait without the GIL; take it only for the hand-off
+        nb::gil_scoped_release nogil;
+        return md::l2::paced_replay(span, cfg, [&](std::size_t i, const md::l2::Record& r) {
+          nb::gil_scoped_acquire gil;
+          sink(start + i, RecordView{owner, &r});
+        });
+      },
+      nb::arg("kernel"),
+      nb::arg("sink"),
+      nb::arg("config") = md::l2::PacedReplayConfig{},
+      nb::arg("start") = 0,
+      nb::arg("stop") = nb::none(),
+      "Call sink(index, RecordView) for records [start, stop) at their recorded ts_recv_ns "
+      "offsets (scaled by config.speed); returns PacedReplayStats");
+
+  mdl2.def(
+      "paced_replay",
+      [](md::l2::BusPublisher& bus, const md::l2::PacedReplayConfig& cfg) {
+        return md::l2::paced_replay(bus, cfg);
+      },
+      nb::arg("bus"),
+      nb::arg("config") = md::l2::PacedReplayConfig{},
+      nb::call_guard<nb::gil_scoped_release>(),
+      "Publish the rest of the bus's file in real time; returns PacedReplayStats");
+
+  // NUMA topology / pinning (for Python worker threads)
+  nb::class_<md::l2::NumaNode>(mdl2, "NumaNode")
+      .def_ro("id", &md::l2::NumaNode::id)
+      .def_ro("group", &md::l2::NumaNode::group)
+      .def_ro("mask", &md::l2::NumaNode::mask)
+      .def_ro("cpus", &md::l2::NumaNode::cpus);
+
+  mdl2.def("numa_nodes", &md::l2::numa_nodes, "NUMA nodes with processors (never empty)");
+  mdl2.def(
+      "pin_current_thread",
+      &md::l2::pin_current_thread,
+      nb::arg("node"),
+      "Restrict the calling thread to node's processors; False on failure");
+
+  // Dataset catalog
+  nb::class_<md::l2::CatalogEntry>(mdl2, "CatalogEntry")
+      .def_ro("record_count", &md::l2::CatalogEntry::record_count)
+      .def_ro("first_ts_recv_ns", &md::l2::CatalogEntry::first_ts_recv_ns)
+      .def_ro("last_ts_recv_ns", &md::l2::CatalogEntry::last_ts_recv_ns)
+      .def_ro("file_size", &md::l2::CatalogEntry::file_size)
+      .def_ro("write_time", &md::l2::CatalogEntry::write_time)
+      .def_ro("digest", &md::l2::CatalogEntry::digest)
+      .def_ro("no_top_of_book", &md::l2::CatalogEntry::no_top_of_book)
+      .def_ro("crossed", &md::l2::CatalogEntry::crossed)
+      .def_ro("ts_regressions", &md::l2::CatalogEntry::ts_regressions)
+      .def_ro("max_gap_ns", &md::l2::CatalogEntry::max_gap_ns)
+      .def_ro("min_best_bid_q", &md::l2::CatalogEntry::min_best_bid_q)
+      .def_ro("max_best_bid_q", &md::l2::CatalogEntry::max_best_bid_q)
+      .def_ro("min_spread_q", &md::l2::CatalogEntry::min_spread_q)
+      .def_ro("max_spread_q", &md::l2::CatalogEntry::max_spread_q);
+
+  mdl2.def(
+      "scan_snap",
+      &md::l2::scan_snap,
+      nb::arg("snap_path"),
+      nb::call_guard<nb::gil_scoped_release>(),
+      "CatalogEntry for one .snap (reads the whole file)");
+
+  nb::class_<md::l2::SnapCatalog>(mdl2, "SnapCatalog")
+      .def(
+          nb::init<std::string>(),
+          nb::arg("root"),
+          nb::call_guard<nb::gil_scoped_release>(),
+          "Catalog of root: loads <root>/catalog.snapidx if present, else empty")
+      .def(
+          "refresh",
+          &md::l2::SnapCatalog::refresh,
+          nb::arg("threads") = 0,
+          nb::call_guard<nb::gil_scoped_release>(),
+          "Rescan root for new or changed .snap files; returns the number scanned")
+      .def(
+          "upsert",
+          &md::l2::SnapCatalog::upsert,
+          nb::arg("snap_path"),
+          nb::call_guard<nb::gil_scoped_release>())
+      .def("save", &md::l2::SnapCatalog::save, nb::call_guard<nb::gil_scoped_release>())
+      .def_prop_ro("root", &md::l2::SnapCatalog::root)
+      .def_prop_ro("file", &md::l2::SnapCatalog::file)
+      .def("__len__", &md::l2::SnapCatalog::size)
+      .def(
+          "entry",
+          [](const md::l2::SnapCatalog& c, std::size_t i) {
+            if ( i >= c.size() )
+              throw nb::index_error("catalog index out of range");
+            return c.entry(i);
+          },
+          nb::arg("i"))
+      .def(
+          "path",
+          [](const md::l2::SnapCatalog& c, std::size_t i) {
+            if ( i >= c.size() )
+              throw nb::index_error("catalog index out of range");
+            return c.path(i);
+          },
+          nb::arg("i"))
+      .def(
+          "overlapping",
+          &md::l2::SnapCatalog::overlapping,
+          nb::arg("t0"),
+          nb::arg("t1"),
+          "Indices of files with records in [t0, t1] (ts_recv_ns), in time order")
+      .def(
+          "files_overlapping",
+          [](const md::l2::SnapCatalog& c, std::int64_t t0, std::int64_t t1) {
+            std::vector<std::string> out;
+            for ( const std::size_t i : c.overlapping(t0, t1) )
+              out.push_back(c.path(i));
+            return out;
+          },
+          nb::arg("t0"),
+          nb::arg("t1"),
+          "Paths of files with records in [t0, t1] (ts_recv_ns), in time order");
+
+  // Block zone maps (predicate pushdown)
+  nb::enum_<md::l2::ZoneField>(mdl2, "ZoneField")
+      .value("TsRecvNs", md::l2::ZoneField::TsRecvNs)
+      .value("BestBid", md::l2::ZoneField::BestBid)
+      .value("BestAsk", md::l2::ZoneField::BestAsk)
+      .value("Spread", md::l2::ZoneField::Spread)
+      .value("BidQty", md::l2::ZoneField::BidQty)
+      .value("AskQty", md::l2::ZoneField::AskQty);
+
+  nb::class_<md::l2::ZonePredicate>(mdl2, "ZonePredicate")
+      .def(
+          "__init__",
+          [](md::l2::ZonePredicate* p, md::l2::ZoneField field, std::int64_t lo, std::int64_t hi) {
+            new (p) md::l2::ZonePredicate{field, lo, hi};
+          },
+          nb::arg("field"),
+          nb::arg("lo") = INT64_MIN,
+          nb::arg("hi") = INT64_MAX,
+          "lo <= field <= hi (inclusive)")
+      .def_rw("field", &md::l2::ZonePredicate::field)
+      .def_rw("lo", &md::l2::ZonePredicate::lo)
+      .def_rw("hi", &md::l2::ZonePredicate::hi);
+
+  nb::class_<md::l2::ZoneScanStats>(mdl2, "ZoneScanStats")
+      .def_ro("blocks", &md::l2::ZoneScanStats::blocks)
+      .def_ro("blocks_scanned", &md::l2::ZoneScanStats::blocks_scanned)
+      .def_ro("matched", &md::l2::ZoneScanStats::matched);
+
+  nb::class_<md::l2::ZoneMap>(mdl2, "ZoneMap")
+      .def_static(
+          "build",
+          &md::l2::ZoneMap::build,
+          nb::arg("kernel"),
+          nb::arg("block_records") = md::l2::kZoneBlockRecords,
+          nb::arg("threads") = 0,
+          nb::call_guard<nb::gil_scoped_release>())
+      .def_static(
+          "load",
+          &md::l2::ZoneMap::load,
+          nb::arg("path"),
+          nb::call_guard<nb::gil_scoped_release>())
+      .def_static(
+          "load_or_build",
+          &md::l2::ZoneMap::load_or_build,
+          nb::arg("snap_path"),
+          nb::arg("kernel"),
+          nb::call_guard<nb::gil_scoped_release>(),
+          "Load <snap_path>.zmap if it matches the kernel and the file's size and write time, "
+          "else build (and save) it")
+      .def("stamp", &md::l2::ZoneMap::stamp, nb::arg("snap_path"))
+      .def("save", &md::l2::ZoneMap::save, nb::arg("path"))
+      .def_prop_ro("block_records", &md::l2::ZoneMap::block_records)
+      .def_prop_ro("record_count", &md::l2::ZoneMap::record_count)
+      .def("__len__", &md::l2::ZoneMap::size)
+      .def("describes", &md::l2::ZoneMap::describes, nb::arg("kernel"))
+      .def(
+          "describes_file",
+          &md::l2::ZoneMap::describes_file,
+          nb::arg("snap_path"),
+          nb::arg("kernel"));
+
+  mdl2.def("zone_map_path", &md::l2::zone_map_path, nb::arg("snap_path"));
+  mdl2.def(
+      "zone_scan",
+      [](const md::l2::ReplayKernel& rk,
+         const md::l2::ZoneMap& zm,
+         const std::vector<md::l2::ZonePredicate>& preds,
+         unsigned threads) {
+        md::l2::ZoneScanStats st{};
+        std::vector<std::uint64_t> idx;
+        {
+          nb::gil_scoped_release nogil;
+          idx = md::l2::zone_scan(rk, zm, preds, threads, &st);
+        }
+        return std::make_pair(owned_u64(std::move(idx)), st);
+      },
+      nb::arg("kernel"),
+      nb::arg("zone_map"),
+      nb::arg("predicates"),
+      nb::arg("threads") = 0,
+      "(indices, ZoneScanStats): sorted uint64 indices of the records matching every predicate, "
+      "usable as a numpy index into the kernel's views");
+
+  // Per-file data-quality stats (sidecars, mergeable across a date range)
+  nb::class_<md::l2::SnapStats>(mdl2, "SnapStats")
+      .def(nb::init<>())
+      .def_ro("files", &md::l2::SnapStats::files)
+      .def_ro("records", &md::l2::SnapStats::records)
+      .def_ro("first_ts_recv_ns", &md::l2::SnapStats::first_ts_recv_ns)
+      .def_ro("last_ts_recv_ns", &md::l2::SnapStats::last_ts_recv_ns)
+      .def_ro("ts_regressions", &md::l2::SnapStats::ts_regressions)
+      .def_ro("ts_event_missing", &md::l2::SnapStats::ts_event_missing)
+      .def_ro("max_gap_ns", &md::l2::SnapStats::max_gap_ns)
+      .def_ro("top_of_book", &md::l2::SnapStats::top_of_book)
+      .def_ro("bid_only", &md::l2::SnapStats::bid_only)
+      .def_ro("ask_only", &md::l2::SnapStats::ask_only)
+      .def_ro("empty_book", &md::l2::SnapStats::empty_book)
+      .def_ro("crossed", &md::l2::SnapStats::crossed)
+      .def_ro("locked", &md::l2::SnapStats::locked)
+      .def_ro("min_spread_q", &md::l2::SnapStats::min_spread_q)
+      .def_ro("max_spread_q", &md::l2::SnapStats::max_spread_q)
+      .def_prop_ro(
+          "empty_bid_levels",
+          [](const md::l2::SnapStats& s) {
+            return std::vector<std::uint64_t>(s.empty_bid_levels.begin(), s.empty_bid_levels.end());
+          })
+      .def_prop_ro(
+          "empty_ask_levels",
+          [](const md::l2::SnapStats& s) {
+            return std::vector<std::uint64_t>(s.empty_ask_levels.begin(), s.empty_ask_levels.end());
+          })
+      .def_prop_ro(
+          "gap_hist",
+          [](const md::l2::SnapStats& s) {
+            return std::vector<std::uint64_t>(s.gap_hist.begin(), s.gap_hist.end());
+          },
+          "Counts per bucket: [0] v <= 0, [k] v in [2^(k-1), 2^k)")
+      .def_prop_ro(
+          "spread_hist",
+          [](const md::l2::SnapStats& s) {
+            return std::vector<std::uint64_t>(s.spread_hist.begin(), s.spread_hist.end());
+          })
+      .def_prop_ro(
+          "top_qty_hist",
+          [](const md::l2::SnapStats& s) {
+            return std::vector<std::uint64_t>(s.top_qty_hist.begin(), s.top_qty_hist.end());
+          })
+      .def_prop_ro(
+          "level_qty_hist",
+          [](const md::l2::SnapStats& s) {
+            return std::vector<std::uint64_t>(s.level_qty_hist.begin(), s.level_qty_hist.end());
+          })
+      .def("merge", &md::l2::SnapStats::merge, nb::arg("other"));
+
+  mdl2.def(
+      "hist_quantile",
+      [](const std::vector<std::uint64_t>& hist, double q) {
+        if ( hist.size() != md::l2::kStatsHistBuckets )
+          throw nb::value_error("histogram must have 64 buckets");
+        md::l2::Log2Hist h{};
+        std::copy(hist.begin(), hist.end(), h.begin());
+        return md::l2::hist_quantile(h, q);
+      },
+      nb::arg("hist"),
+      nb::arg("q"),
+      "Upper edge of the bucket holding quantile q of a SnapStats histogram");
+
+  mdl2.def(
+      "compute_stats",
+      [](const md::l2::ReplayKernel& rk, std::size_t start, std::optional<std::size_t> stop) {
+        const md::l2::Record* first = checked_range(rk, start, stop);
+        nb::gil_scoped_release nogil;
+        return md::l2::compute_stats(std::span<const md::l2::Record>(first, *stop - start));
+      },
+      nb::arg("kernel"),
+      nb::arg("start") = 0,
+      nb::arg("stop") = nb::none(),
+      "One stats pass over records [start, stop)");
+
+  mdl2.def("stats_path", &md::l2::stats_path, nb::arg("snap_path"));
+  mdl2.def("load_stats", &md::l2::load_stats, nb::arg("path"));
+  mdl2.def("save_stats", &md::l2::save_stats, nb::arg("path"), nb::arg("stats"));
+  mdl2.def(
+      "load_or_compute_stats",
+      &md::l2::load_or_compute_stats,
+      nb::arg("snap_path"),
+      nb::call_guard<nb::gil_scoped_release>(),
+      "The file's stats sidecar if current, else computed (and written back)");
+  mdl2.def(
+      "stats_for_files",
+      &md::l2::stats_for_files,
+      nb::arg("snap_paths"),
+      nb::arg("threads") = 0,
+      nb::call_guard<nb::gil_scoped_release>(),
+      "load_or_compute_stats() for every file, in parallel");
+  mdl2.def(
+      "aggregate_stats",
+      &md::l2::aggregate_stats,
+      nb::arg("catalog"),
+      nb::arg("t0"),
+      nb::arg("t1"),
+      nb::arg("threads") = 0,
+      nb::call_guard<nb::gil_scoped_release>(),
+      "Merged SnapStats of the catalog's files with records in [t0, t1] (from sidecars)");
+
   // ---------------------------
   // sim
   // ---------------------------
@@ -184,6 +903,16 @@ NB_MODULE(_core, m)
       .def_rw("stp", &sim::SimulatorParams::stp)
       .def_rw("fees", &sim::SimulatorParams::fees)
       .def_rw("risk", &sim::SimulatorParams::risk)
+      .def_rw("digest_every_steps", &sim::SimulatorParams::digest_every_steps)
+      .def_rw("rng_seed", &sim::SimulatorParams::rng_seed)
+      .def_rw("rng_stream", &sim::SimulatorParams::rng_stream)
+      .def_rw("stochastic_depletion", &sim::SimulatorParams::stochastic_depletion)
+      .def_prop_rw(
+          "outbound_latency_jitter_ns",
+          [](const sim::SimulatorParams& p) {
+            return static_cast<sim::u64>(p.outbound_latency_jitter.value);
+          },
+          [](sim::SimulatorParams& p, sim::u64 v) { p.outbound_latency_jitter = sim::Ns{v}; })
       .def_prop_rw(
           "outbound_latency_ns",
           [](const sim::SimulatorParams& p) {
@@ -256,6 +985,100 @@ NB_MODULE(_core, m)
       .def_prop_ro("notional_cash_q", [](const sim::FillEvent& e) { return e.notional_cash_q; })
       .def_prop_ro("fee_cash_q", [](const sim::FillEvent& e) { return e.fee_cash_q; });
 
+  // Struct layouts for zero-copy structured views: ([(name, offset, format)], itemsize)
+  msim.def("order_layout", []() {
+    using sim::Order;
+    return layout_tuple(
+        {{"id", offsetof(Order, id), "<u8"},
+         {"client_order_id", offsetof(Order, client_order_id), "<u8"},
+         {"type", offsetof(Order, type), "u1"},
+         {"side", offsetof(Order, side), "u1"},
+         {"price_q", offsetof(Order, price_q), "<i8"},
+         {"qty_q", offsetof(Order, qty_q), "<i8"},
+         {"filled_qty_q", offsetof(Order, filled_qty_q), "<i8"},
+         {"qty_ahead_q", offsetof(Order, qty_ahead_q), "<i8"},
+         {"last_level_qty_q", offsetof(Order, last_level_qty_q), "<i8"},
+         {"last_level_idx", offsetof(Order, last_level_idx), "<i2"},
+         {"visibility", offsetof(Order, visibility), "u1"},
+         {"submit_ts_ns", offsetof(Order, submit_ts), "<u8"},
+         {"activate_ts_ns", offsetof(Order, activate_ts), "<u8"},
+         {"state", offsetof(Order, state), "u1"},
+         {"reject_reason", offsetof(Order, reject_reason), "u1"}},
+        sizeof(Order));
+  });
+
+  msim.def("event_layout", []() {
+    using sim::Event;
+    return layout_tuple(
+        {{"ts", offsetof(Event, ts), "<u8"},
+         {"order_id", offsetof(Event, order_id), "<u8"},
+         {"type", offsetof(Event, type), "u1"},
+         {"state", offsetof(Event, state), "u1"},
+         {"reject_reason", offsetof(Event, reject_reason), "u1"}},
+        sizeof(Event));
+  });
+
+  msim.def("fill_layout", []() {
+    using sim::FillEvent;
+    return layout_tuple(
+        {{"ts", offsetof(FillEvent, ts), "<u8"},
+         {"order_id", offsetof(FillEvent, order_id), "<u8"},
+         {"side", offsetof(FillEvent, side), "u1"},
+         {"price_q", offsetof(FillEvent, price_q), "<i8"},
+         {"qty_q", offsetof(FillEvent, qty_q), "<i8"},
+         {"liq", offsetof(FillEvent, liq), "u1"},
+         {"notional_cash_q", offsetof(FillEvent, notional_cash_q), "<i8"},
+         {"fee_cash_q", offsetof(FillEvent, fee_cash_q), "<i8"}},
+        sizeof(FillEvent));
+  });
+
+  nb::class_<sim::DigestCheckpoint>(msim, "DigestCheckpoint")
+      .def_ro("step", &sim::DigestCheckpoint::step)
+      .def_prop_ro("ts_ns", [](const sim::DigestCheckpoint& c) { return c.ts.value; })
+      .def_ro("digest", &sim::DigestCheckpoint::digest)
+      .def("__repr__", [](const sim::DigestCheckpoint& c) {
+        char buf[96];
+        std::snprintf(
+            buf,
+            sizeof(buf),
+            "DigestCheckpoint(step=%llu, digest=%016llx)",
+            static_cast<unsigned long long>(c.step),
+            static_cast<unsigned long long>(c.digest));
+        return std::string(buf);
+      });
+
+  msim.def(
+      "first_divergence",
+      [](const std::vector<sim::DigestCheckpoint>& a, const std::vector<sim::DigestCheckpoint>& b) {
+        return sim::first_divergence(a, b);
+      },
+      nb::arg("a"),
+      nb::arg("b"),
+      "Index of the first differing checkpoint of two digest trails (len of the shorter if "
+      "they agree); the divergent step is in (a[i-1].step, a[i].step]");
+
+  // Counter-based RNG (same draws as the simulator's stochastic paths)
+  msim.def(
+      "rng_draw",
+      [](sim::u64 seed, sim::u64 env, sim::u32 stream, sim::u64 id, sim::u64 step) {
+        return sim::rng::draw_u64(seed, env, static_cast<sim::rng::Stream>(stream), id, step);
+      },
+      nb::arg("seed"),
+      nb::arg("env"),
+      nb::arg("stream"),
+      nb::arg("id"),
+      nb::arg("step"),
+      "64 random bits, a pure function of (seed, env, stream, id, step)");
+  msim.def(
+      "episode_start",
+      &sim::rng::episode_start,
+      nb::arg("seed"),
+      nb::arg("env"),
+      nb::arg("episode"),
+      nb::arg("records"),
+      nb::arg("length"),
+      "Reproducible random start index in [0, records - length] for an episode");
+
   nb::class_<sim::MarketSimulator>(msim, "MarketSimulator")
       .def(nb::init<const sim::SimulatorParams&>(), nb::arg("params"))
 
@@ -274,14 +1097,97 @@ NB_MODULE(_core, m)
           nb::arg("initial_ledger"),
           "Reset simulator with start timestamp in nanoseconds (Python int).")
 
-      // step takes a RecordView (zero-copy) and calls into the engine with *rec
+      // step takes a RecordView (zero-copy) and calls into the engine with *rec.
+      // The RecordView argument keeps the mapping alive, so the GIL can be dropped.
       .def(
           "step",
           [](sim::MarketSimulator& ex, const RecordView& v) { ex.step(*v.rec); },
-          nb::arg("record"))
+          nb::arg("record"),
+          nb::call_guard<nb::gil_scoped_release>())
+      // step with the precomputed delta-stream entry for this record
+      .def(
+          "step",
+          [](sim::MarketSimulator& ex,
+             const RecordView& v,
+             const LevelDeltaStream& deltas,
+             std::size_t index) {
+            if ( index >= deltas.data.size() )
+              throw nb::index_error("delta index out of range");
+            ex.step(*v.rec, deltas.data[index]);
+          },
+          nb::arg("record"),
+          nb::arg("deltas"),
+          nb::arg("index"),
+          nb::call_guard<nb::gil_scoped_release>())
+      // Batched stepping over kernel records [start, stop) with the GIL released for the
+      // whole run; does not move the kernel cursor.
+      .def(
+          "step_range",
+          [](sim::MarketSimulator& ex,
+             const md::l2::ReplayKernel& rk,
+             std::size_t start,
+             std::optional<std::size_t> stop,
+             const LevelDeltaStream* deltas) {
+            const md::l2::Record* first = checked_range(rk, start, stop);
+            const std::size_t n = *stop - start;
+            if ( deltas && deltas->data.size() < *stop )
+              throw nb::index_error("delta stream shorter than stop");
+            nb::gil_scoped_release nogil;
+            for ( std::size_t i = 0; i < n; ++i ) {
+              if ( deltas )
+                ex.step(first[i], deltas->data[start + i]);
+              else
+                ex.step(first[i]);
+            }
+            return n;
+          },
+          nb::arg("kernel"),
+          nb::arg("start") = 0,
+          nb::arg("stop") = nb::none(),
+          nb::arg("deltas").none() = nb::none(),
+          "Step over kernel records [start, stop) natively (GIL released); returns steps taken. "
+          "deltas, if given, must be build_level_deltas(kernel) (indexed by record position)")
       .def("place_limit", &sim::MarketSimulator::place_limit, nb::arg("req"))
       .def("place_market", &sim::MarketSimulator::place_market, nb::arg("req"))
       .def("cancel", &sim::MarketSimulator::cancel, nb::arg("order_id"))
+      // Declarative ladder reconciliation: one crossing per side instead of N cancels/places
+      .def(
+          "set_quotes",
+          [](sim::MarketSimulator& ex,
+             sim::Side side,
+             const std::vector<std::pair<sim::i64, sim::i64>>& levels) {
+            std::vector<sim::QuoteLevel> ladder;
+            ladder.reserve(levels.size());
+            for ( const auto& [price_q, qty_q] : levels )
+              ladder.push_back(sim::QuoteLevel{price_q, qty_q});
+            return owned_u64(ex.set_quotes(side, ladder));
+          },
+          nb::arg("side"),
+          nb::arg("levels"),
+          "Reconcile resting/pending orders on `side` to [(price_q, qty_q), ...]; returns "
+          "uint64 order ids aligned with levels (0 where nothing rests)")
+      .def(
+          "set_quotes",
+          [](sim::MarketSimulator& ex, sim::Side side, QuoteArray levels) {
+            const auto* first = reinterpret_cast<const sim::QuoteLevel*>(levels.data());
+            return owned_u64(ex.set_quotes(side, {first, levels.shape(0)}));
+          },
+          nb::arg("side"),
+          nb::arg("levels"),
+          "Same as above with an (n, 2) int64 array of [price_q, qty_q] rows")
+      // Action recording: the simulator keeps a raw pointer, so the log is kept alive
+      .def(
+          "set_action_log",
+          [](sim::MarketSimulator& ex, sim::ActionLog* log) { ex.set_action_log(log); },
+          nb::arg("log").none(),
+          nb::keep_alive<1, 2>(),
+          "Record actions into `log` (None detaches); attach before reset()")
+      .def_prop_ro("step_count", &sim::MarketSimulator::step_count)
+      // Rolling determinism digest; trail cadence is SimulatorParams.digest_every_steps
+      .def_prop_ro("state_digest", &sim::MarketSimulator::state_digest)
+      .def("digest_trail", [](const sim::MarketSimulator& ex) {
+        return snapshot_vec(ex.digest_trail());
+      })
       .def_prop_ro("now", [](const sim::MarketSimulator& ex) { return ex.now().value; })
       .def_prop_ro("ledger", &sim::MarketSimulator::ledger, nb::rv_policy::reference_internal)
 
@@ -290,16 +1196,252 @@ NB_MODULE(_core, m)
       // Safe copies for Python analytics/audit (no reference lifetimes)
       .def("events", [](const sim::MarketSimulator& ex) { return snapshot_vec(ex.events()); })
       .def("orders", [](const sim::MarketSimulator& ex) { return snapshot_vec(ex.orders()); })
-      // TODO: 
-      // Convenience: O(N) lookup (safe). For production O(1), add a C++ method using id_to_index_
+
+      // Zero-copy byte views; see microstructure_rl.views for the structured wrappers
+      .def_prop_ro("storage_version", &sim::MarketSimulator::storage_version)
+      .def(
+          "orders_buffer",
+          [](const sim::MarketSimulator& ex) { return bytes_view(ex.orders(), nb::find(ex)); },
+          "Read-only (n, sizeof(Order)) uint8 view; valid while storage_version is unchanged")
+      .def(
+          "events_buffer",
+          [](const sim::MarketSimulator& ex) { return bytes_view(ex.events(), nb::find(ex)); },
+          "Read-only (n, sizeof(Event)) uint8 view; valid while storage_version is unchanged")
+      .def(
+          "fills_buffer",
+          [](const sim::MarketSimulator& ex) { return bytes_view(ex.fills(), nb::find(ex)); },
+          "Read-only (n, sizeof(FillEvent)) uint8 view; valid while storage_version is unchanged")
+
+      // O(1) lookups via id_to_index_
+      .def(
+          "order_index",
+          [](const sim::MarketSimulator& ex, sim::u64 order_id) -> std::optional<sim::u64> {
+            const sim::u64 idx = ex.order_index(order_id);
+            if ( idx == sim::kInvalidIndex )
+              return std::nullopt;
+            return idx;
+          },
+          nb::arg("order_id"))
       .def(
           "get_order",
           [](const sim::MarketSimulator& ex, sim::u64 order_id) -> std::optional<sim::Order> {
-            for ( const auto& o : ex.orders() ) {
-              if ( o.id == order_id )
-                return o;
-            }
+            if ( const sim::Order* o = ex.find_order(order_id) )
+              return *o;
             return std::nullopt;
           },
           nb::arg("order_id"));
-}
\ No newline at end of file
+
+  // -------------------------
+  // Native scenario loop (microstructure_rl.runner drives this and writes artifacts)
+  // -------------------------
+  nb::class_<sim::ScenarioConfig>(msim, "ScenarioConfig")
+      .def(nb::init<>())
+      .def_rw("params", &sim::ScenarioConfig::params)
+      .def_rw("initial_ledger", &sim::ScenarioConfig::initial_ledger)
+      .def_prop_rw(
+          "start_ts_ns",
+          [](const sim::ScenarioConfig& c) { return c.start_ts.value; },
+          [](sim::ScenarioConfig& c, sim::u64 v) { c.start_ts = sim::Ns{v}; })
+      .def_rw("max_steps", &sim::ScenarioConfig::max_steps)
+      .def_rw("warmup_steps", &sim::ScenarioConfig::warmup_steps)
+      .def_rw("order_every_steps", &sim::ScenarioConfig::order_every_steps)
+      .def_rw("check_every_steps", &sim::ScenarioConfig::check_every_steps)
+      .def_rw("conservation_every_steps", &sim::ScenarioConfig::conservation_every_steps)
+      .def_rw("qty_q", &sim::ScenarioConfig::qty_q)
+      .def_rw("tick_q", &sim::ScenarioConfig::tick_q)
+      .def_rw("cash_residual_tolerance_q", &sim::ScenarioConfig::cash_residual_tolerance_q)
+      .def_rw("pos_residual_tolerance_q", &sim::ScenarioConfig::pos_residual_tolerance_q)
+      .def_rw("strict", &sim::ScenarioConfig::strict)
+      .def_rw("enable_markout", &sim::ScenarioConfig::enable_markout)
+      .def_rw("markout_horizons_steps", &sim::ScenarioConfig::markout_horizons_steps);
+
+  nb::enum_<sim::LogLevel>(msim, "LogLevel")
+      .value("Info", sim::LogLevel::Info)
+      .value("Warning", sim::LogLevel::Warning)
+      .value("Error", sim::LogLevel::Error);
+
+  nb::class_<sim::LogLine>(msim, "LogLine")
+      .def_ro("level", &sim::LogLine::level)
+      .def_ro("text", &sim::LogLine::text);
+
+  nb::class_<sim::AuditRow>(msim, "AuditRow")
+      .def_ro("step", &sim::AuditRow::step)
+      .def_ro("cash_q", &sim::AuditRow::cash_q)
+      .def_ro("locked_cash_q", &sim::AuditRow::locked_cash_q)
+      .def_ro("cash_total_q", &sim::AuditRow::cash_total_q)
+      .def_ro("expected_cash_q", &sim::AuditRow::expected_cash_q)
+      .def_ro("cash_residual_q", &sim::AuditRow::cash_residual_q)
+      .def_ro("cash_residual_bound_q", &sim::AuditRow::cash_residual_bound_q)
+      .def_ro("inferred_price_scale", &sim::AuditRow::inferred_price_scale)
+      .def_ro("overflow_risk_flag", &sim::AuditRow::overflow_risk_flag)
+      .def_ro("mid_q", &sim::AuditRow::mid_q)
+      .def_ro("wealth_mtm_q", &sim::AuditRow::wealth_mtm_q)
+      .def_ro("passed", &sim::AuditRow::pass)
+      .def_ro("ts_ns", &sim::AuditRow::ts_ns);
+
+  nb::class_<sim::MarkoutRow>(msim, "MarkoutRow")
+      .def_ro("fill_idx", &sim::MarkoutRow::fill_idx)
+      .def_ro("fill_ts_ns", &sim::MarkoutRow::fill_ts_ns)
+      .def_ro("order_id", &sim::MarkoutRow::order_id)
+      .def_ro("liq", &sim::MarkoutRow::liq)
+      .def_ro("side", &sim::MarkoutRow::side)
+      .def_ro("qty_q", &sim::MarkoutRow::qty_q)
+      .def_ro("fill_price_q", &sim::MarkoutRow::fill_price_q)
+      .def_ro("mid0_q", &sim::MarkoutRow::mid0_q)
+      .def_ro("step0", &sim::MarkoutRow::step0)
+      .def_ro("markout_price_q", &sim::MarkoutRow::markout_price_q);
+
+  nb::class_<sim::AccountingSummary>(msim, "AccountingSummary")
+      .def_ro("fills_seen", &sim::AccountingSummary::fills_seen)
+      .def_ro("expected_cash_q", &sim::AccountingSummary::expected_cash_q)
+      .def_ro("expected_fee_cash_q", &sim::AccountingSummary::expected_fee_cash_q)
+      .def_ro("max_cash_residual_q", &sim::AccountingSummary::max_cash_residual_q)
+      .def_ro("max_cash_bound_q", &sim::AccountingSummary::max_cash_bound_q)
+      .def_ro("inferred_price_scale", &sim::AccountingSummary::inferred_price_scale)
+      .def_ro("overflow_risk_flag", &sim::AccountingSummary::overflow_risk_flag);
+
+  nb::class_<sim::ScenarioCheckpoint>(msim, "ScenarioCheckpoint")
+      .def_ro("step", &sim::ScenarioCheckpoint::step)
+      .def_ro("fills_begin", &sim::ScenarioCheckpoint::fills_begin)
+      .def_ro("fills_end", &sim::ScenarioCheckpoint::fills_end)
+      .def_ro("events_begin", &sim::ScenarioCheckpoint::events_begin)
+      .def_ro("events_end", &sim::ScenarioCheckpoint::events_end)
+      .def_ro("audit", &sim::ScenarioCheckpoint::audit);
+
+  nb::class_<sim::ScenarioRunner>(msim, "ScenarioRunner")
+      // Runs over the kernel's whole mapping; the kernel is kept alive by the runner.
+      .def(
+          "__init__",
+          [](sim::ScenarioRunner* self,
+             const sim::ScenarioConfig& cfg,
+             const md::l2::ReplayKernel& rk) {
+            new (self) sim::ScenarioRunner(cfg, {rk.begin(), rk.size()});
+          },
+          nb::arg("config"),
+          nb::arg("kernel"),
+          nb::keep_alive<1, 3>())
+      .def(
+          "advance",
+          &sim::ScenarioRunner::advance,
+          nb::call_guard<nb::gil_scoped_release>(),
+          "Run natively (GIL released) to the next checkpoint; False once the run is finished")
+      .def_prop_ro("done", &sim::ScenarioRunner::done)
+      .def_prop_ro(
+          "checkpoint", &sim::ScenarioRunner::checkpoint, nb::rv_policy::reference_internal)
+      // Copies of the fills/events covered by the current checkpoint
+      .def(
+          "new_fills",
+          [](const sim::ScenarioRunner& r) {
+            const auto& cp = r.checkpoint();
+            const auto& v = r.simulator().fills();
+            return std::vector<sim::FillEvent>(
+                v.begin() + static_cast<std::ptrdiff_t>(cp.fills_begin),
+                v.begin() + static_cast<std::ptrdiff_t>(cp.fills_end));
+          })
+      .def(
+          "new_events",
+          [](const sim::ScenarioRunner& r) {
+            const auto& cp = r.checkpoint();
+            const auto& v = r.simulator().events();
+            return std::vector<sim::Event>(
+                v.begin() + static_cast<std::ptrdiff_t>(cp.events_begin),
+                v.begin() + static_cast<std::ptrdiff_t>(cp.events_end));
+          })
+      .def("take_logs", &sim::ScenarioRunner::take_logs)
+      .def_prop_ro(
+          "simulator", &sim::ScenarioRunner::simulator, nb::rv_policy::reference_internal)
+      .def_prop_ro("steps", &sim::ScenarioRunner::steps)
+      .def_prop_ro("placed_orders", &sim::ScenarioRunner::placed_orders)
+      .def_prop_ro("failures", &sim::ScenarioRunner::failures)
+      .def_prop_ro("fills_seen", &sim::ScenarioRunner::fills_seen)
+      .def_prop_ro("events_seen", &sim::ScenarioRunner::events_seen)
+      .def_prop_ro(
+          "accounting", &sim::ScenarioRunner::accounting, nb::rv_policy::reference_internal)
+      .def_prop_ro("markout_horizons", &sim::ScenarioRunner::markout_horizons)
+      .def_prop_ro("markout_rows", &sim::ScenarioRunner::markout_rows);
+
+  // -------------------------
+  // Action log record / native replay
+  // -------------------------
+  nb::class_<sim::ActionLog>(msim, "ActionLog")
+      .def(nb::init<>())
+      .def_static("load", &sim::ActionLog::load, nb::arg("path"))
+      .def("save", &sim::ActionLog::save, nb::arg("path"))
+      .def("params", &sim::ActionLog::params, "SimulatorParams of the recorded run")
+      .def("initial_ledger", &sim::ActionLog::initial_ledger)
+      .def_prop_ro("start_ts_ns", [](const sim::ActionLog& l) { return l.start_ts().value; })
+      .def_prop_ro("steps", [](const sim::ActionLog& l) { return l.header().steps; })
+      .def_prop_ro(
+          "first_record_ts_ns",
+          [](const sim::ActionLog& l) { return l.header().first_record_ts_ns; })
+      .def("__len__", [](const sim::ActionLog& l) { return l.records().size(); });
+
+  nb::class_<sim::ActionReplayStats>(msim, "ActionReplayStats")
+      .def_ro("steps", &sim::ActionReplayStats::steps)
+      .def_ro("actions", &sim::ActionReplayStats::actions)
+      .def_ro("places_diverged", &sim::ActionReplayStats::places_diverged)
+      .def_ro("cancels_skipped", &sim::ActionReplayStats::cancels_skipped);
+
+  msim.def(
+      "replay_actions",
+      [](sim::MarketSimulator& ex,
+         const sim::ActionLog& log,
+         const md::l2::ReplayKernel& rk,
+         std::size_t start) {
+        std::optional<std::size_t> stop;
+        const md::l2::Record* first = checked_range(rk, start, stop);
+        nb::gil_scoped_release nogil;
+        return sim::replay_actions(ex, log, {first, *stop - start});
+      },
+      nb::arg("sim"),
+      nb::arg("log"),
+      nb::arg("kernel"),
+      nb::arg("start") = 0,
+      "Re-execute `log` natively (GIL released) over kernel records from `start` (the "
+      "recorded run's first step). `sim` keeps its own params: pass different ones for a "
+      "counterfactual run");
+
+  // -------------------------
+  // Episode sampler
+  // -------------------------
+  nb::class_<sim::EpisodeSamplerConfig>(msim, "EpisodeSamplerConfig")
+      .def(nb::init<>())
+      .def_rw("episode_records", &sim::EpisodeSamplerConfig::episode_records)
+      .def_rw("lookahead", &sim::EpisodeSamplerConfig::lookahead)
+      .def_rw("prefetch", &sim::EpisodeSamplerConfig::prefetch)
+      .def_rw("seed", &sim::EpisodeSamplerConfig::seed)
+      .def_rw("stream", &sim::EpisodeSamplerConfig::stream);
+
+  nb::class_<sim::EpisodeSamplerStats>(msim, "EpisodeSamplerStats")
+      .def_ro("delivered", &sim::EpisodeSamplerStats::delivered)
+      .def_ro("warm", &sim::EpisodeSamplerStats::warm)
+      .def_ro("batches", &sim::EpisodeSamplerStats::batches)
+      .def_ro("prefetched", &sim::EpisodeSamplerStats::prefetched)
+      .def_ro("pages_touched", &sim::EpisodeSamplerStats::pages_touched);
+
+  nb::class_<sim::EpisodeSampler>(msim, "EpisodeSampler")
+      .def(
+          nb::init<const std::vector<std::string>&, const sim::EpisodeSamplerConfig&>(),
+          nb::arg("snap_paths"),
+          nb::arg("config"))
+      .def(
+          "next",
+          [](sim::EpisodeSampler& s) {
+            const sim::EpisodeWindow w = s.next();
+            return std::make_tuple(w.file, w.start, w.start + w.records.size(), w.episode);
+          },
+          nb::call_guard<nb::gil_scoped_release>(),
+          "(file, start, stop, episode) of the next window: records [start, stop) of "
+          "kernel(file)")
+      .def(
+          "kernel",
+          [](const sim::EpisodeSampler& s, std::size_t file) -> const md::l2::ReplayKernel& {
+            if ( file >= s.files() )
+              throw nb::index_error("file index out of range");
+            return s.kernel(file);
+          },
+          nb::arg("file"),
+          nb::rv_policy::reference_internal)
+      .def_prop_ro("files", &sim::EpisodeSampler::files)
+      .def("stats", &sim::EpisodeSampler::stats);
+}
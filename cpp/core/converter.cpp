@@ -3,6 +3,8 @@ CSV.GZ -> mmappable .snap converter for L2 snapshot records.
 
 Key properties:
 - Streams gzip input (zlib) without materialising to disk
+- Inflates BGZF (blocked gzip, as written by the recorder) on all cores; other gzip
+  files (legacy single-member) are inflated serially
 - Robust line reading (no fixed-buffer truncation)
 - Header-driven column mapping (doesn't rely on positional assumptions)
 - Deterministic fixed-point conversion (fast_float, overflow/NaN checks)
@@ -10,6 +12,8 @@ Key properties:
 - Crash-safe output (writes .part then atomic rename)
 - Two-phase header finalise (record_count updated at end)
 - Basic integrity checks (file size vs record count)
+- Writes the block zone map sidecar (<output>.snap.zmap, see zone_map.hpp)
+- Writes the data-quality stats sidecar (<output>.snap.stats, see snap_stats.hpp)
 
 Dependencies:
 - zlib
@@ -17,6 +21,8 @@ Dependencies:
 
 Build usage (example):
   csv_gz_to_snap <input.csv.gz> <output.snap>
+  csv_gz_to_snap --catalog <processed_root>   (refresh <processed_root>/catalog.snapidx)
+  csv_gz_to_snap --stats <processed_root>     (stats sidecars for every .snap, all cores)
 
 Notes:
 - Assumes input CSV columns include:
@@ -35,13 +41,21 @@ ask_q20
 #include <fstream>
 #include <iostream>
 #include <limits>
+#include <optional>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <vector>
 #include <zlib.h>
 
+#include "file_util.hpp"
+#include "parallel_for.hpp"
+#include "replay.hpp"
 #include "schema.hpp"
+#include "snap_catalog.hpp"
+#include "snap_stats.hpp"
+#include "zone_map.hpp"
 
 namespace fs = std::filesystem;
 
@@ -106,6 +120,161 @@ namespace md::l2
       }
     }
 
+    /* -----------------------------
+     * Blocked gzip (BGZF) reader
+     *
+     * The recorder writes BGZF: a chain of independent gzip members, each
+     * carrying its compressed size in a "BC" extra subfield and its
+     * uncompressed size (ISIZE) in its trailer. The chain is the block index:
+     * walking it gives every member's offsets without inflating anything, so
+     * batches of members are inflated in parallel (raw deflate, CRC checked)
+     * straight into their slice of one text buffer. Lines may span members.
+     *
+     * Any other gzip (a single gzip.open() member, legacy files) fails the
+     * walk and is read serially through GzFile instead.
+     * ----------------------------- */
+    class BgzfReader
+    {
+    public:
+      explicit BgzfReader(const fs::path& path, unsigned threads = 0) : threads_(threads)
+      {
+        std::ifstream in(path, std::ios::binary);
+        if ( !in )
+          throw std::runtime_error("Could not open input: " + path.string());
+
+        // Only load the file if it starts with a BGZF member
+        data_.resize(kHeaderSize);
+        in.read(reinterpret_cast<char*>(data_.data()), kHeaderSize);
+        if ( !in || !is_bgzf_header(data_.data()) ) {
+          data_ = {};
+          return;
+        }
+        data_.resize(static_cast<std::size_t>(fs::file_size(path)));
+        in.read(
+            reinterpret_cast<char*>(data_.data() + kHeaderSize),
+            static_cast<std::streamsize>(data_.size() - kHeaderSize));
+        if ( !in )
+          throw std::runtime_error("Read failure for: " + path.string());
+        if ( !index_blocks() ) {
+          blocks_.clear();
+          data_ = {};
+        }
+      }
+
+      /// True if the whole file is a BGZF block chain.
+      bool blocked() const noexcept { return !blocks_.empty(); }
+      std::size_t blocks() const noexcept { return blocks_.size(); }
+
+      /// As gz_readline().
+      bool readline(std::string& out)
+      {
+        while ( true ) {
+          const std::size_t nl = text_.find('\n', pos_);
+          if ( nl != std::string::npos ) {
+            out.assign(text_, pos_, nl - pos_);
+            pos_ = nl + 1;
+            while ( !out.empty() && out.back() == '\r' )
+              out.pop_back();
+            return true;
+          }
+          if ( next_ == blocks_.size() ) {
+            out.assign(text_, pos_, std::string::npos);
+            pos_ = text_.size();
+            return !out.empty();
+          }
+          text_.erase(0, pos_);
+          pos_ = 0;
+          inflate_batch();
+        }
+      }
+
+    private:
+      struct Block
+      {
+        std::size_t offset; // of the member in data_
+        std::size_t size;   // compressed member size (header + deflate + trailer)
+        std::uint32_t isize;
+      };
+
+      static constexpr std::size_t kHeaderSize = 18; // gzip header + 6-byte "BC" extra field
+      static constexpr std::size_t kTrailerSize = 8; // CRC32 + ISIZE
+      static constexpr std::size_t kBatchBlocks = 256; // ~16 MiB of text per batch
+
+      static std::uint32_t le32(const unsigned char* p) noexcept
+      {
+        return std::uint32_t{p[0]} | (std::uint32_t{p[1]} << 8) | (std::uint32_t{p[2]} << 16) |
+               (std::uint32_t{p[3]} << 24);
+      }
+
+      // ID1 ID2, CM = deflate, FLG = FEXTRA, XLEN = 6, SI1 SI2 = "BC", SLEN = 2
+      static bool is_bgzf_header(const unsigned char* h) noexcept
+      {
+        return h[0] == 0x1f && h[1] == 0x8b && h[2] == 8 && h[3] == 4 && h[10] == 6 &&
+               h[11] == 0 && h[12] == 'B' && h[13] == 'C' && h[14] == 2 && h[15] == 0;
+      }
+
+      bool index_blocks()
+      {
+        std::size_t off = 0;
+        while ( off < data_.size() ) {
+          if ( data_.size() - off < kHeaderSize + kTrailerSize )
+            return false;
+          const unsigned char* h = data_.data() + off;
+          if ( !is_bgzf_header(h) )
+            return false;
+          const std::size_t size = (std::size_t{h[16]} | (std::size_t{h[17]} << 8)) + 1;
+          if ( size < kHeaderSize + kTrailerSize || size > data_.size() - off )
+            return false;
+          blocks_.push_back(Block{off, size, le32(h + size - 4)});
+          off += size;
+        }
+        return !blocks_.empty();
+      }
+
+      void inflate_batch()
+      {
+        const std::size_t first = next_;
+        const std::size_t last = std::min(blocks_.size(), first + kBatchBlocks);
+        std::vector<std::size_t> at(last - first);
+        std::size_t total = text_.size();
+        for ( std::size_t b = first; b < last; ++b ) {
+          at[b - first] = total;
+          total += blocks_[b].isize;
+        }
+        text_.resize(total);
+
+        parallel_for(last - first, threads_, [&](std::size_t k) {
+          const Block& blk = blocks_[first + k];
+          char* dst = text_.data() + at[k];
+          z_stream zs{};
+          if ( inflateInit2(&zs, -MAX_WBITS) != Z_OK )
+            throw std::runtime_error("inflateInit2 failed");
+          zs.next_in = const_cast<Bytef*>(data_.data() + blk.offset + kHeaderSize);
+          zs.avail_in = static_cast<uInt>(blk.size - kHeaderSize - kTrailerSize);
+          zs.next_out = reinterpret_cast<Bytef*>(dst);
+          zs.avail_out = static_cast<uInt>(blk.isize);
+          const int rc = inflate(&zs, Z_FINISH);
+          const uLong produced = zs.total_out;
+          inflateEnd(&zs);
+
+          const unsigned char* trailer = data_.data() + blk.offset + blk.size - kTrailerSize;
+          const uLong crc =
+              crc32(0L, reinterpret_cast<const Bytef*>(dst), static_cast<uInt>(produced));
+          if ( rc != Z_STREAM_END || produced != blk.isize || crc != le32(trailer) )
+            throw std::runtime_error(
+                "Corrupt BGZF block at offset " + std::to_string(blk.offset));
+        });
+        next_ = last;
+      }
+
+      unsigned threads_{0};
+      std::vector<unsigned char> data_; // whole compressed file
+      std::vector<Block> blocks_;
+      std::size_t next_{0}; // first block not yet inflated
+      std::string text_;    // inflated, not yet consumed from pos_
+      std::size_t pos_{0};
+    };
+
     /* -----------------------------
      * CSV tokenizer (no allocations for tokens)
      * Returns string_views pointing into `line` memory.
@@ -327,15 +496,7 @@ namespace md::l2
             "Failed to create output directory: " + final.parent_path().string());
       }
 
-      // On Windows, rename over existing may fail; remove existing first.
-      fs::remove(final, ec);
-      ec.clear();
-      fs::rename(tmp, final, ec);
-      if ( ec ) {
-        throw std::runtime_error(
-            "Failed to rename tmp->final: " + tmp.string() + " -> " + final.string() + " : " +
-            ec.message());
-      }
+      replace_file(tmp, final, "tmp->final");
     }
 
   } // namespace
@@ -354,8 +515,14 @@ namespace md::l2
     }
     fs::create_directories(out.parent_path().empty() ? fs::current_path() : out.parent_path());
 
-    // Open gzip input
-    GzFile gz(in.string().c_str());
+    // Open gzip input: blocked (parallel inflate) or any other gzip (serial)
+    BgzfReader bgzf(in);
+    std::optional<GzFile> gz;
+    if ( !bgzf.blocked() )
+      gz.emplace(in.string().c_str());
+    const auto readline = [&](std::string& l) {
+      return gz ? gz_readline(gz->f, l) : bgzf.readline(l);
+    };
 
     // Open output temp file
     std::ofstream b_out(tmp, std::ios::binary | std::ios::trunc);
@@ -382,7 +549,7 @@ namespace md::l2
     // 2) Read CSV header row and build a column map
     std::string line;
     std::vector<std::string_view> fields;
-    if ( !gz_readline(gz.f, line) ) {
+    if ( !readline(line) ) {
       throw std::runtime_error("Input appears empty (no CSV header): " + in.string());
     }
     split_csv_views(line, fields);
@@ -395,7 +562,7 @@ namespace md::l2
     Record rec{};
     const std::uint64_t log_every = 1'000'000;
 
-    while ( gz_readline(gz.f, line) ) {
+    while ( readline(line) ) {
       split_csv_views(line, fields);
 
       // Basic sanity: tolerate extra columns, but require at least what we map.
@@ -451,8 +618,21 @@ namespace md::l2
     // 6) Atomic finalise
     atomic_rename(tmp, out);
 
+    // 7) Sidecars: zone map (block min/max for predicate pushdown) and stats
+    {
+      const ReplayKernel rk(out.string());
+      ZoneMap zm = ZoneMap::build(rk);
+      zm.stamp(out.string());
+      zm.save(zone_map_path(out.string()));
+      save_stats(
+          stats_path(out.string()),
+          compute_stats(std::span<const Record>(rk.begin(), rk.size())));
+    }
+
+    const std::string source =
+        gz ? std::string("serial gzip") : std::to_string(bgzf.blocks()) + " BGZF blocks";
     std::cerr << "[OK] Converted " << count << " records"
-              << " (bad_rows=" << bad_rows << ") -> " << out.string() << "\n";
+              << " (bad_rows=" << bad_rows << ", " << source << ") -> " << out.string() << "\n";
   }
 
 } // namespace md::l2
@@ -463,8 +643,28 @@ namespace md::l2
 int main(int argc, char** argv)
 {
   try {
+    if ( argc == 3 && std::string_view(argv[1]) == "--catalog" ) {
+      md::l2::SnapCatalog catalog(argv[2]);
+      const std::size_t scanned = catalog.refresh();
+      catalog.save();
+      std::cerr << "[OK] Catalog " << catalog.file() << ": " << catalog.size() << " files ("
+                << scanned << " scanned)\n";
+      return 0;
+    }
+    if ( argc == 3 && std::string_view(argv[1]) == "--stats" ) {
+      std::vector<std::string> snaps;
+      for ( const auto& ent : fs::recursive_directory_iterator(argv[2]) ) {
+        if ( ent.is_regular_file() && ent.path().extension() == ".snap" )
+          snaps.push_back(ent.path().string());
+      }
+      (void)md::l2::stats_for_files(snaps);
+      std::cerr << "[OK] Stats sidecars current for " << snaps.size() << " files\n";
+      return 0;
+    }
     if ( argc != 3 ) {
-      std::cerr << "Usage: csv_gz_to_snap <input.csv.gz> <output.snap>\n";
+      std::cerr << "Usage: csv_gz_to_snap <input.csv.gz> <output.snap>\n"
+                << "       csv_gz_to_snap --catalog <processed_root>\n"
+                << "       csv_gz_to_snap --stats <processed_root>\n";
       return 2;
     }
     md::l2::convert(argv[1], argv[2]);
@@ -0,0 +1,607 @@
+// Native depth-stream recorder (see depth_recorder.hpp).
+// - Parse: one forward scan per payload, strings located with memchr, no allocation.
+// - Write: .part with a provisional header, finalised (count + rename + sidecars) per hour.
+
+#include "depth_recorder.hpp"
+
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "file_util.hpp"
+#include "replay.hpp"
+#include "snap_stats.hpp"
+#include "zone_map.hpp"
+
+namespace fs = std::filesystem;
+
+namespace md::l2
+{
+
+  namespace
+  {
+
+    constexpr std::int64_t kNsPerHour = 3'600'000'000'000LL;
+    constexpr int kMaxNesting = 32;
+
+    constexpr std::array<std::uint64_t, 19> kPow10 = [] {
+      std::array<std::uint64_t, 19> p{};
+      std::uint64_t v = 1;
+      for ( std::uint64_t& x : p ) {
+        x = v;
+        v *= 10;
+      }
+      return p;
+    }();
+
+    std::int64_t floor_div(std::int64_t a, std::int64_t b) noexcept
+    {
+      const std::int64_t q = a / b;
+      return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+    }
+
+    bool parse_i64(std::string_view sv, std::int64_t& out) noexcept
+    {
+      const char* e = sv.data() + sv.size();
+      const auto res = std::from_chars(sv.data(), e, out, 10);
+      return !sv.empty() && res.ec == std::errc{} && res.ptr == e;
+    }
+
+    // -------------------------
+    // JSON scanning
+    // -------------------------
+    struct Cursor
+    {
+      const char* p;
+      const char* e;
+    };
+
+    void skip_ws(Cursor& c) noexcept
+    {
+      while ( c.p < c.e && (*c.p == ' ' || *c.p == '\t' || *c.p == '\n' || *c.p == '\r') )
+        ++c.p;
+    }
+
+    bool eat(Cursor& c, char ch) noexcept
+    {
+      skip_ws(c);
+      if ( c.p == c.e || *c.p != ch )
+        return false;
+      ++c.p;
+      return true;
+    }
+
+    // At '"': raw contents (escapes left as is) up to the closing quote.
+    bool read_string(Cursor& c, std::string_view& out) noexcept
+    {
+      const char* start = ++c.p;
+      while ( true ) {
+        const auto* q = static_cast<const char*>(
+            std::memchr(c.p, '"', static_cast<std::size_t>(c.e - c.p)));
+        if ( !q )
+          return false;
+        const char* b = q;
+        while ( b > start && b[-1] == '\\' )
+          --b;
+        c.p = q + 1;
+        if ( (q - b) % 2 == 0 ) { // not an escaped quote
+          out = std::string_view(start, static_cast<std::size_t>(q - start));
+          return true;
+        }
+      }
+    }
+
+    // String contents or a bare number / literal token.
+    bool read_scalar(Cursor& c, std::string_view& out) noexcept
+    {
+      skip_ws(c);
+      if ( c.p == c.e )
+        return false;
+      if ( *c.p == '"' )
+        return read_string(c, out);
+      const char* start = c.p;
+      while ( c.p < c.e && *c.p != ',' && *c.p != ']' && *c.p != '}' && *c.p != ' ' &&
+              *c.p != '\t' && *c.p != '\n' && *c.p != '\r' )
+        ++c.p;
+      out = std::string_view(start, static_cast<std::size_t>(c.p - start));
+      return c.p > start && *start != '[' && *start != '{';
+    }
+
+    bool skip_value(Cursor& c, int depth) noexcept
+    {
+      skip_ws(c);
+      if ( c.p == c.e || depth > kMaxNesting )
+        return false;
+      const char open = *c.p;
+      if ( open != '{' && open != '[' ) {
+        std::string_view sv;
+        return read_scalar(c, sv);
+      }
+      const char close = open == '{' ? '}' : ']';
+      ++c.p;
+      if ( eat(c, close) )
+        return true;
+      do {
+        if ( open == '{' ) {
+          std::string_view key;
+          skip_ws(c);
+          if ( c.p == c.e || *c.p != '"' || !read_string(c, key) || !eat(c, ':') )
+            return false;
+        }
+        if ( !skip_value(c, depth + 1) )
+          return false;
+      } while ( eat(c, ',') );
+      return eat(c, close);
+    }
+
+    // [[price, qty, ...], ...]: fn(price_text, qty_text) per entry, false stops.
+    template <class Fn>
+    bool read_pairs(Cursor& c, Fn&& fn) noexcept
+    {
+      if ( !eat(c, '[') )
+        return false;
+      if ( eat(c, ']') )
+        return true;
+      do {
+        std::string_view p, q;
+        if ( !eat(c, '[') || !read_scalar(c, p) || !eat(c, ',') || !read_scalar(c, q) )
+          return false;
+        while ( eat(c, ',') ) {
+          if ( !skip_value(c, 2) )
+            return false;
+        }
+        if ( !eat(c, ']') || !fn(p, q) )
+          return false;
+      } while ( eat(c, ',') );
+      return eat(c, ']');
+    }
+
+    // Snapshot levels into levels[0, kDepth); bid selects the null sentinel check.
+    bool read_levels(Cursor& c, std::array<Level, kDepth>& levels, bool bid) noexcept
+    {
+      std::size_t i = 0;
+      return read_pairs(c, [&](std::string_view p, std::string_view q) {
+        std::int64_t px = 0, qy = 0;
+        if ( i < kDepth && parse_decimal_fixed(p, kPriceScale, px) &&
+             parse_decimal_fixed(q, kQtyScale, qy) && px > 0 && qy > 0 &&
+             (bid || px != kAskNullPriceQ) )
+          levels[i] = Level{px, qy};
+        ++i;
+        return true;
+      });
+    }
+
+    // Diff levels: every entry must parse (qty 0 = remove the price).
+    bool read_updates(Cursor& c, std::vector<Level>& out) noexcept
+    {
+      out.clear();
+      return read_pairs(c, [&](std::string_view p, std::string_view q) {
+        Level l{};
+        if ( !parse_decimal_fixed(p, kPriceScale, l.price_q) ||
+             !parse_decimal_fixed(q, kQtyScale, l.qty_q) || l.price_q <= 0 || l.qty_q < 0 )
+          return false;
+        out.push_back(l);
+        return true;
+      });
+    }
+
+    bool read_u64(Cursor& c, std::uint64_t& out) noexcept
+    {
+      std::string_view v;
+      if ( !read_scalar(c, v) )
+        return false;
+      const char* e = v.data() + v.size();
+      const auto res = std::from_chars(v.data(), e, out, 10);
+      return !v.empty() && res.ec == std::errc{} && res.ptr == e;
+    }
+
+    // {"key": value, ...}: on_value(key, c, depth) consumes each value (the
+    // cursor is at its first byte); a "data" object (combined stream wrapper
+    // {"stream": ..., "data": {payload}}) is descended into instead.
+    template <class Fn>
+    bool read_object(Cursor& c, Fn& on_value, int depth) noexcept
+    {
+      if ( depth > kMaxNesting || !eat(c, '{') )
+        return false;
+      if ( eat(c, '}') )
+        return true;
+      do {
+        std::string_view key;
+        skip_ws(c);
+        if ( c.p == c.e || *c.p != '"' || !read_string(c, key) || !eat(c, ':') )
+          return false;
+        skip_ws(c);
+
+        const bool ok = (key == "data" && c.p < c.e && *c.p == '{')
+                            ? read_object(c, on_value, depth + 1)
+                            : on_value(key, c, depth);
+        if ( !ok )
+          return false;
+      } while ( eat(c, ',') );
+      return eat(c, '}');
+    }
+
+    // Whole payload is one object (trailing whitespace only).
+    template <class Fn>
+    bool read_payload(std::string_view json, Fn&& on_value) noexcept
+    {
+      Cursor c{json.data(), json.data() + json.size()};
+      if ( !read_object(c, on_value, 0) )
+        return false;
+      skip_ws(c);
+      return c.p == c.e;
+    }
+
+    bool read_event_time(Cursor& c, std::int64_t& ts_event_ms) noexcept
+    {
+      std::string_view v;
+      std::int64_t t = 0;
+      if ( !read_scalar(c, v) )
+        return false;
+      if ( parse_i64(v, t) )
+        ts_event_ms = t;
+      return true;
+    }
+
+    // -------------------------
+    // Files
+    // -------------------------
+    FileHeader snap_header(std::uint64_t record_count) noexcept
+    {
+      FileHeader h{};
+      h.magic = kMagic;
+      h.version = kVersion;
+      h.depth = kDepth;
+      h.record_size = static_cast<std::uint32_t>(sizeof(Record));
+      h.endian_check = kEndianCheck;
+      h.price_scale = kPriceScale;
+      h.qty_scale = kQtyScale;
+      h.record_count = record_count;
+      return h;
+    }
+
+    // Validate a .part header, drop a partial trailing record; returns the record count.
+    std::uint64_t trim_part(const fs::path& part)
+    {
+      std::ifstream in(part, std::ios::binary);
+      FileHeader h{};
+      in.read(reinterpret_cast<char*>(&h), sizeof(h));
+      if ( !in || h.magic != kMagic || h.version != kVersion || h.depth != kDepth ||
+           h.record_size != sizeof(Record) || h.endian_check != kEndianCheck )
+        throw std::runtime_error("Not a resumable .snap part: " + part.string());
+      in.close();
+
+      const std::uint64_t payload = fs::file_size(part) - sizeof(FileHeader);
+      const std::uint64_t n = payload / sizeof(Record);
+      if ( payload % sizeof(Record) != 0 )
+        fs::resize_file(part, sizeof(FileHeader) + n * sizeof(Record));
+      return n;
+    }
+
+    void write_header(const fs::path& part, std::uint64_t record_count)
+    {
+      std::fstream io(part, std::ios::binary | std::ios::in | std::ios::out);
+      const FileHeader h = snap_header(record_count);
+      io.write(reinterpret_cast<const char*>(&h), sizeof(h));
+      io.flush();
+      if ( !io )
+        throw std::runtime_error("Failed to write header for: " + part.string());
+    }
+
+  } // namespace
+
+  // -------------------------
+  // Parsing
+  // -------------------------
+  bool parse_decimal_fixed(std::string_view s, std::int64_t scale, std::int64_t& out) noexcept
+  {
+    int decimals = 0;
+    while ( decimals < 19 && static_cast<std::int64_t>(kPow10[decimals]) != scale )
+      ++decimals;
+    if ( decimals == 19 )
+      return false;
+
+    const char* p = s.data();
+    const char* e = p + s.size();
+    const bool neg = p < e && *p == '-';
+    p += neg ? 1 : 0;
+    const char* start = p;
+    while ( p < e && *p == '0' ) // leading zeros use no precision
+      ++p;
+
+    std::uint64_t ip = 0; // integer part
+    int ni = 0;
+    for ( ; p < e && static_cast<unsigned>(*p - '0') < 10; ++p, ++ni ) {
+      if ( ni == 19 )
+        return false;
+      ip = ip * 10 + static_cast<unsigned>(*p - '0');
+    }
+    bool any = p > start;
+
+    std::uint64_t fp = 0; // first `decimals` fraction digits
+    int nf = 0;
+    bool round_up = false;
+    if ( p < e && *p == '.' ) {
+      const char* frac = ++p;
+      for ( ; p < e && static_cast<unsigned>(*p - '0') < 10 && nf < decimals; ++p, ++nf )
+        fp = fp * 10 + static_cast<unsigned>(*p - '0');
+      round_up = p < e && *p >= '5' && *p <= '9';
+      while ( p < e && static_cast<unsigned>(*p - '0') < 10 )
+        ++p;
+      any = any || p > frac;
+    }
+    if ( p != e || !any )
+      return false;
+
+    // ip * 10^decimals + fraction (+ 1): at most 18 digits cannot overflow
+    const std::uint64_t low = fp * kPow10[decimals - nf] + (round_up ? 1 : 0);
+    constexpr std::uint64_t kLimit = static_cast<std::uint64_t>(INT64_MAX);
+    if ( ni + decimals > 18 && (low > kLimit || ip > (kLimit - low) / kPow10[decimals]) )
+      return false;
+    const std::uint64_t v = ip * kPow10[decimals] + low;
+    out = neg ? -static_cast<std::int64_t>(v) : static_cast<std::int64_t>(v);
+    return true;
+  }
+
+  bool parse_depth_message(std::string_view json, std::int64_t ts_recv_ns, Record& out) noexcept
+  {
+    out.ts_event_ms = 0;
+    out.ts_recv_ns = ts_recv_ns;
+    out.bids.fill(Level{kBidNullPriceQ, kNullQtyQ});
+    out.asks.fill(Level{kAskNullPriceQ, kNullQtyQ});
+
+    bool any_side = false;
+    auto on_value = [&](std::string_view key, Cursor& c, int depth) {
+      if ( key == "b" || key == "bids" )
+        return (any_side = true) && read_levels(c, out.bids, true);
+      if ( key == "a" || key == "asks" )
+        return (any_side = true) && read_levels(c, out.asks, false);
+      if ( key == "E" || key == "eventTime" )
+        return read_event_time(c, out.ts_event_ms);
+      return skip_value(c, depth + 1);
+    };
+    return read_payload(json, on_value) && any_side;
+  }
+
+  bool parse_depth_update(
+      std::string_view json,
+      std::int64_t ts_recv_ns,
+      DepthUpdate& out) noexcept
+  {
+    out.snapshot = false;
+    out.ts_recv_ns = ts_recv_ns;
+    out.ts_event_ms = 0;
+    out.first_update_id = 0;
+    out.last_update_id = 0;
+    out.prev_update_id = 0;
+    out.bids.clear();
+    out.asks.clear();
+
+    bool any_side = false, first = false, last = false;
+    auto on_value = [&](std::string_view key, Cursor& c, int depth) {
+      if ( key == "b" || key == "bids" )
+        return (any_side = true) && read_updates(c, out.bids);
+      if ( key == "a" || key == "asks" )
+        return (any_side = true) && read_updates(c, out.asks);
+      if ( key == "E" || key == "eventTime" )
+        return read_event_time(c, out.ts_event_ms);
+      if ( key == "U" )
+        return (first = true) && read_u64(c, out.first_update_id);
+      if ( key == "u" )
+        return (last = true) && read_u64(c, out.last_update_id);
+      if ( key == "pu" )
+        return read_u64(c, out.prev_update_id);
+      if ( key == "lastUpdateId" ) {
+        out.snapshot = first = last = true;
+        return read_u64(c, out.last_update_id);
+      }
+      return skip_value(c, depth + 1);
+    };
+    if ( !read_payload(json, on_value) || !any_side || !first || !last )
+      return false;
+    if ( out.snapshot )
+      out.first_update_id = out.last_update_id;
+    return out.first_update_id <= out.last_update_id;
+  }
+
+  // -------------------------
+  // Transport
+  // -------------------------
+  StreamTransport::StreamTransport(const std::string& path)
+    : file_(std::make_unique<std::ifstream>(path, std::ios::binary))
+  {
+    if ( !*file_ )
+      throw std::runtime_error("Could not open recorder input: " + path);
+    in_ = file_.get();
+  }
+
+  bool StreamTransport::next(std::string& payload, std::int64_t& ts_recv_ns)
+  {
+    while ( std::getline(*in_, line_) ) {
+      while ( !line_.empty() && (line_.back() == '\r' || line_.back() == '\n') )
+        line_.pop_back();
+      if ( line_.empty() )
+        continue;
+
+      const std::size_t tab = line_.find('\t');
+      const std::string_view prefix = std::string_view(line_).substr(0, tab);
+      if ( tab != std::string::npos && parse_i64(prefix, ts_recv_ns) ) {
+        payload.assign(line_, tab + 1, std::string::npos);
+      }
+      else {
+        ts_recv_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+        payload.swap(line_);
+      }
+      return true;
+    }
+    return false;
+  }
+
+  // -------------------------
+  // Writer
+  // -------------------------
+  std::uint64_t finalise_snap_part(const fs::path& part)
+  {
+    const std::string name = part.string();
+    if ( part.extension() != ".part" )
+      throw std::runtime_error("Not a .part file: " + name);
+    const fs::path final_path = name.substr(0, name.size() - 5);
+
+    const std::uint64_t n = trim_part(part);
+    write_header(part, n);
+    replace_file(part, final_path);
+
+    const ReplayKernel rk(final_path.string());
+    ZoneMap zm = ZoneMap::build(rk);
+    zm.stamp(final_path.string());
+    zm.save(zone_map_path(final_path.string()));
+    save_stats(
+        stats_path(final_path.string()),
+        compute_stats(std::span<const Record>(rk.begin(), rk.size())));
+    return n;
+  }
+
+  RollingSnapWriter::RollingSnapWriter(std::string root, std::string symbol)
+    : root_(std::move(root)), symbol_(std::move(symbol))
+  {
+  }
+
+  RollingSnapWriter::~RollingSnapWriter()
+  {
+    try {
+      close();
+    }
+    catch ( ... ) {
+      // the .part is left for recover_parts()
+    }
+  }
+
+  fs::path RollingSnapWriter::path_for(std::int64_t ts_recv_ns) const
+  {
+    using namespace std::chrono;
+    const std::int64_t hour = floor_div(ts_recv_ns, kNsPerHour);
+    const year_month_day ymd{sys_days{days{floor_div(hour, 24)}}};
+    char day[16];
+    std::snprintf(
+        day, sizeof(day), "%04d-%02u-%02u", static_cast<int>(ymd.year()),
+        static_cast<unsigned>(ymd.month()), static_cast<unsigned>(ymd.day()));
+    char hh[12];
+    std::snprintf(hh, sizeof(hh), "%02d", static_cast<int>(hour - floor_div(hour, 24) * 24));
+    return root_ / day /
+           (symbol_ + "_depth" + std::to_string(kDepth) + "_" + day + "_" + hh + ".snap");
+  }
+
+  void RollingSnapWriter::open_hour_(std::int64_t hour, std::int64_t ts_recv_ns)
+  {
+    final_ = path_for(ts_recv_ns);
+    part_ = final_.string() + ".part";
+    fs::create_directories(final_.parent_path());
+
+    // A clean restart within the hour reopens its finalised file
+    if ( !fs::exists(part_) && fs::exists(final_) )
+      replace_file(final_, part_);
+
+    if ( fs::exists(part_) ) {
+      records_ = trim_part(part_);
+      write_header(part_, 0); // provisional again while appending
+      out_.open(part_, std::ios::binary | std::ios::app);
+    }
+    else {
+      records_ = 0;
+      out_.open(part_, std::ios::binary | std::ios::trunc);
+      const FileHeader h = snap_header(0); // provisional: count unknown until close
+      out_.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    }
+    if ( !out_ )
+      throw std::runtime_error("Could not open recorder output: " + part_.string());
+    hour_ = hour;
+  }
+
+  void RollingSnapWriter::append(const Record& r)
+  {
+    const std::int64_t hour = floor_div(r.ts_recv_ns, kNsPerHour);
+    if ( hour_ < 0 || hour > hour_ ) {
+      close();
+      open_hour_(hour, r.ts_recv_ns);
+    }
+    out_.write(reinterpret_cast<const char*>(&r), sizeof(Record));
+    if ( !out_ )
+      throw std::runtime_error("Write failure for: " + part_.string());
+    ++records_;
+  }
+
+  void RollingSnapWriter::flush()
+  {
+    if ( out_.is_open() && !out_.flush() )
+      throw std::runtime_error("Flush failure for: " + part_.string());
+  }
+
+  void RollingSnapWriter::close()
+  {
+    if ( !out_.is_open() )
+      return;
+    out_.close();
+    hour_ = -1;
+    records_ = 0;
+    if ( out_.fail() )
+      throw std::runtime_error("Close failure for: " + part_.string());
+    finalise_snap_part(part_);
+    ++files_finalised_;
+  }
+
+  std::size_t RollingSnapWriter::recover_parts()
+  {
+    if ( !fs::exists(root_) )
+      return 0;
+    const std::string prefix = symbol_ + "_depth" + std::to_string(kDepth) + "_";
+    std::vector<fs::path> parts;
+    for ( const auto& ent : fs::recursive_directory_iterator(root_) ) {
+      const std::string name = ent.path().filename().string();
+      if ( ent.is_regular_file() && name.starts_with(prefix) && name.ends_with(".snap.part") &&
+           !(out_.is_open() && ent.path() == part_) )
+        parts.push_back(ent.path());
+    }
+    for ( const fs::path& p : parts )
+      finalise_snap_part(p);
+    files_finalised_ += parts.size();
+    return parts.size();
+  }
+
+  // -------------------------
+  // Recorder loop
+  // -------------------------
+  RecorderStats record_depth(
+      DepthTransport& transport,
+      RollingSnapWriter& writer,
+      const std::atomic<bool>& stop,
+      std::uint64_t flush_every)
+  {
+    RecorderStats st{};
+    std::string payload;
+    std::int64_t ts_recv_ns = 0;
+    Record rec{};
+    while ( !stop.load(std::memory_order_relaxed) && transport.next(payload, ts_recv_ns) ) {
+      ++st.messages;
+      if ( !parse_depth_message(payload, ts_recv_ns, rec) ) {
+        ++st.bad_messages;
+        continue;
+      }
+      writer.append(rec);
+      ++st.records;
+      if ( flush_every > 0 && st.records % flush_every == 0 )
+        writer.flush();
+    }
+    writer.close();
+    return st;
+  }
+
+} // namespace md::l2
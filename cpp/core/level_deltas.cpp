@@ -0,0 +1,113 @@
+// Per-level quantity-delta stream builder.
+// - Matches levels of consecutive Records by price (sorted merge, O(kDepth) per side).
+// - Emits signed qty deltas, appear/vanish masks and prev->current index links.
+
+#include "level_deltas.hpp"
+
+#include <cstddef>
+
+namespace md::l2
+{
+
+  namespace
+  {
+
+    inline bool bid_price_valid(std::int64_t p) noexcept { return p != kBidNullPriceQ; }
+    inline bool ask_price_valid(std::int64_t p) noexcept { return p != kAskNullPriceQ; }
+
+    // Number of leading levels with a valid price (levels are contiguous by contract).
+    template <class Valid>
+    inline int visible_count(const std::array<Level, kDepth>& lv, Valid valid) noexcept
+    {
+      int n = 0;
+      while ( n < static_cast<int>(kDepth) && valid(lv[n].price_q) )
+        ++n;
+      return n;
+    }
+
+    // Merge two price-sorted level arrays. `Better(a, b)` is true iff price a sorts
+    // before price b on this side (bids: a > b, asks: a < b).
+    template <class Valid, class Better>
+    inline void merge_side(
+        const std::array<Level, kDepth>* prev,
+        const std::array<Level, kDepth>& cur,
+        LevelDeltaSide& out,
+        Valid valid,
+        Better better) noexcept
+    {
+      out.dqty_q.fill(0);
+      out.next_idx.fill(-1);
+      out.appear_mask = 0;
+      out.vanish_mask = 0;
+
+      const int n_cur = visible_count(cur, valid);
+      const int n_prev = prev ? visible_count(*prev, valid) : 0;
+
+      int i = 0;
+      int j = 0;
+      while ( i < n_cur && j < n_prev ) {
+        const std::int64_t pc = cur[i].price_q;
+        const std::int64_t pp = (*prev)[j].price_q;
+        if ( pc == pp ) {
+          out.dqty_q[i] = cur[i].qty_q - (*prev)[j].qty_q;
+          out.next_idx[j] = static_cast<std::int8_t>(i);
+          ++i;
+          ++j;
+        }
+        else if ( better(pc, pp) ) {
+          out.dqty_q[i] = cur[i].qty_q;
+          out.appear_mask |= (1u << i);
+          ++i;
+        }
+        else {
+          out.vanish_mask |= (1u << j);
+          ++j;
+        }
+      }
+      for ( ; i < n_cur; ++i ) {
+        out.dqty_q[i] = cur[i].qty_q;
+        out.appear_mask |= (1u << i);
+      }
+      for ( ; j < n_prev; ++j )
+        out.vanish_mask |= (1u << j);
+    }
+
+  } // namespace
+
+  void compute_level_deltas(const Record* prev, const Record& cur, LevelDeltaRecord& out) noexcept
+  {
+    merge_side(
+        prev ? &prev->bids : nullptr,
+        cur.bids,
+        out.bids,
+        bid_price_valid,
+        [](std::int64_t a, std::int64_t b) { return a > b; });
+    merge_side(
+        prev ? &prev->asks : nullptr,
+        cur.asks,
+        out.asks,
+        ask_price_valid,
+        [](std::int64_t a, std::int64_t b) { return a < b; });
+  }
+
+  void build_level_deltas(
+      const Record* first,
+      const Record* last,
+      const Record* prev_of_first,
+      LevelDeltaRecord* out) noexcept
+  {
+    const Record* prev = prev_of_first;
+    for ( const Record* p = first; p != last; ++p, ++out ) {
+      compute_level_deltas(prev, *p, *out);
+      prev = p;
+    }
+  }
+
+  std::vector<LevelDeltaRecord> build_level_deltas(const Record* first, const Record* last)
+  {
+    std::vector<LevelDeltaRecord> out(static_cast<std::size_t>(last - first));
+    build_level_deltas(first, last, nullptr, out.data());
+    return out;
+  }
+
+} // namespace md::l2
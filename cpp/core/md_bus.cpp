@@ -0,0 +1,423 @@
+// Shared-memory market-data bus (Windows named mapping).
+// - BusPublisher creates `Local\msrl_md_bus_<name>` backed by the page file.
+// - BusConsumer opens it by name and maps the published .snap itself.
+// - Slots are seqlock-style: a reader validates the slot sequence before and
+//   after reading the payload, so FreeRun readers can detect being lapped.
+
+#include "md_bus.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#define NOMINMAX
+#include <windows.h>
+
+namespace md::l2
+{
+
+  // -------------------------
+  // Shared layout
+  // -------------------------
+  struct alignas(64) BusCursor
+  {
+    std::atomic<std::uint64_t> next_seq{0}; // next sequence number this consumer reads
+    std::atomic<std::uint32_t> mode{0};     // 0 = free slot, kBusClaiming, or a BusMode
+  };
+
+  struct BusSlot
+  {
+    std::atomic<std::uint64_t> seq{0}; // published sequence + 1 (0 = never written / rewriting)
+    std::atomic<std::uint64_t> record_index{0};
+    std::atomic<std::int64_t> publish_ns{0};
+    std::uint64_t reserved{0};
+  };
+
+  struct BusControl
+  {
+    std::atomic<std::uint32_t> magic{0}; // stored last by the publisher
+    std::uint16_t version{kBusVersion};
+    std::uint16_t reserved0{0};
+    std::uint64_t capacity{0};
+    std::uint64_t record_count{0};
+    char snap_path[kBusMaxPath]{}; // absolute, NUL-terminated
+
+    alignas(64) std::atomic<std::uint64_t> head{0}; // records published
+    std::atomic<std::uint32_t> closed{0};
+
+    BusCursor cursors[kBusMaxConsumers];
+
+    BusSlot* ring() noexcept { return reinterpret_cast<BusSlot*>(this + 1); }
+  };
+
+  static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+  static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+  static_assert(sizeof(BusSlot) == 32);
+  static_assert(sizeof(BusControl) % alignof(BusSlot) == 0);
+
+  namespace
+  {
+
+    constexpr std::uint32_t kBusClaiming = 0xFFFFFFFFu; // slot taken, cursor not set yet
+
+    // Convert UTF-8 std::string -> wide string for WinAPI.
+    std::wstring to_wstring_utf8(const std::string& s)
+    {
+      if ( s.empty() )
+        return std::wstring();
+
+      const int needed = MultiByteToWideChar(CP_UTF8, 0, s.data(), (int)s.size(), nullptr, 0);
+      if ( needed <= 0 )
+        throw std::runtime_error("MultiByteToWideChar failed for bus name");
+
+      std::wstring w;
+      w.resize((std::size_t)needed);
+      MultiByteToWideChar(CP_UTF8, 0, s.data(), (int)s.size(), w.data(), needed);
+      return w;
+    }
+
+    std::wstring bus_object_name(const std::string& bus_name)
+    {
+      if ( bus_name.empty() )
+        throw std::runtime_error("md bus: empty bus name");
+      return to_wstring_utf8("Local\\msrl_md_bus_" + bus_name);
+    }
+
+    [[noreturn]] void throw_last_error(const std::string& what)
+    {
+      const DWORD e = GetLastError();
+      throw std::runtime_error(what + " (GetLastError=" + std::to_string(e) + ")");
+    }
+
+    // Spin briefly, then give up the time slice.
+    struct Backoff
+    {
+      unsigned n = 0;
+
+      void wait() noexcept
+      {
+        if ( ++n < 64 )
+          YieldProcessor();
+        else
+          std::this_thread::yield();
+      }
+    };
+
+  } // namespace
+
+  std::int64_t bus_clock_ns() noexcept
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  detail::BusMapping::~BusMapping()
+  {
+    if ( ctl )
+      UnmapViewOfFile(ctl);
+    if ( handle )
+      CloseHandle(static_cast<HANDLE>(handle));
+  }
+
+  // -------------------------
+  // Publisher
+  // -------------------------
+  BusPublisher::BusPublisher(
+      const std::string& bus_name,
+      const std::string& snap_path,
+      std::size_t capacity)
+      : kernel_(snap_path), name_(bus_name), capacity_(capacity)
+  {
+    if ( capacity < 2 || (capacity & (capacity - 1)) != 0 )
+      throw std::runtime_error("BusPublisher: capacity must be a power of two >= 2");
+
+    // Consumers may run with a different working directory
+    const std::string abs_path = std::filesystem::absolute(snap_path).string();
+    if ( abs_path.size() >= kBusMaxPath )
+      throw std::runtime_error("BusPublisher: snap path too long: " + abs_path);
+
+    const std::uint64_t bytes =
+        sizeof(BusControl) + static_cast<std::uint64_t>(capacity) * sizeof(BusSlot);
+    const std::wstring wname = bus_object_name(bus_name);
+
+    HANDLE h = CreateFileMappingW(
+        INVALID_HANDLE_VALUE,
+        nullptr,
+        PAGE_READWRITE,
+        static_cast<DWORD>(bytes >> 32),
+        static_cast<DWORD>(bytes & 0xFFFFFFFFu),
+        wname.c_str());
+    if ( !h )
+      throw_last_error("CreateFileMappingW failed for bus " + bus_name);
+    if ( GetLastError() == ERROR_ALREADY_EXISTS ) {
+      CloseHandle(h);
+      throw std::runtime_error("BusPublisher: bus already exists: " + bus_name);
+    }
+    map_.handle = h;
+
+    void* view = MapViewOfFile(h, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if ( !view )
+      throw_last_error("MapViewOfFile failed for bus " + bus_name);
+
+    BusControl* ctl = new (view) BusControl{};
+    map_.ctl = ctl;
+    for ( std::size_t i = 0; i < capacity; ++i )
+      new (&ctl->ring()[i]) BusSlot{};
+
+    ctl->capacity = capacity;
+    ctl->record_count = kernel_.size();
+    std::memcpy(ctl->snap_path, abs_path.c_str(), abs_path.size() + 1);
+
+    ctl->magic.store(kBusMagic, std::memory_order_release);
+  }
+
+  BusPublisher::~BusPublisher() { close(); }
+
+  bool BusPublisher::can_publish_() noexcept
+  {
+    // Publishing head_ overwrites sequence head_ - capacity_
+    if ( head_ < capacity_ )
+      return true;
+    const std::uint64_t need = head_ - capacity_ + 1;
+    if ( min_cursor_ >= need )
+      return true;
+
+    // Rescan. A joining consumer publishes cursor 0 before reading head, so the
+    // minimum (capped at head_) stays a valid lower bound until the next rescan.
+    std::uint64_t m = head_;
+    for ( const BusCursor& c : map_.ctl->cursors ) {
+      if ( c.mode.load(std::memory_order_seq_cst) ==
+           static_cast<std::uint32_t>(BusMode::Backpressure) ) {
+        const std::uint64_t cur = c.next_seq.load(std::memory_order_seq_cst);
+        if ( cur < m )
+          m = cur;
+      }
+    }
+    min_cursor_ = m;
+    return m >= need;
+  }
+
+  void BusPublisher::write_slot_(std::size_t record_index) noexcept
+  {
+    BusSlot& s = map_.ctl->ring()[head_ & (capacity_ - 1)];
+    s.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    s.record_index.store(record_index, std::memory_order_relaxed);
+    s.publish_ns.store(bus_clock_ns(), std::memory_order_relaxed);
+    s.seq.store(head_ + 1, std::memory_order_release);
+
+    ++head_;
+    map_.ctl->head.store(head_, std::memory_order_seq_cst);
+  }
+
+  std::uint64_t BusPublisher::publish(std::size_t record_index)
+  {
+    if ( closed_ )
+      throw std::runtime_error("BusPublisher: bus is closed");
+    if ( record_index >= kernel_.size() )
+      throw std::runtime_error("BusPublisher: record index out of range");
+
+    Backoff b;
+    while ( !can_publish_() )
+      b.wait();
+
+    const std::uint64_t seq = head_;
+    write_slot_(record_index);
+    return seq;
+  }
+
+  bool BusPublisher::try_publish(std::size_t record_index)
+  {
+    if ( closed_ )
+      throw std::runtime_error("BusPublisher: bus is closed");
+    if ( record_index >= kernel_.size() )
+      throw std::runtime_error("BusPublisher: record index out of range");
+
+    if ( !can_publish_() )
+      return false;
+    write_slot_(record_index);
+    return true;
+  }
+
+  const Record* BusPublisher::publish_next()
+  {
+    if ( kernel_.pos() >= kernel_.size() )
+      return nullptr;
+    publish(kernel_.pos()); // before advancing: a throw leaves the cursor in place
+    return kernel_.next();
+  }
+
+  std::size_t BusPublisher::publish_batch(std::size_t n)
+  {
+    std::size_t k = 0;
+    while ( k < n && publish_next() )
+      ++k;
+    return k;
+  }
+
+  void BusPublisher::close() noexcept
+  {
+    if ( closed_ || !map_.ctl )
+      return;
+    closed_ = true;
+    map_.ctl->closed.store(1, std::memory_order_seq_cst);
+  }
+
+  std::size_t BusPublisher::consumers() const noexcept
+  {
+    std::size_t n = 0;
+    for ( const BusCursor& c : map_.ctl->cursors ) {
+      const std::uint32_t m = c.mode.load(std::memory_order_acquire);
+      if ( m == static_cast<std::uint32_t>(BusMode::Backpressure) ||
+           m == static_cast<std::uint32_t>(BusMode::FreeRun) )
+        ++n;
+    }
+    return n;
+  }
+
+  // -------------------------
+  // Consumer
+  // -------------------------
+  std::string BusConsumer::attach_(const std::string& bus_name)
+  {
+    const std::wstring wname = bus_object_name(bus_name);
+
+    HANDLE h = OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, wname.c_str());
+    if ( !h )
+      throw_last_error("OpenFileMappingW failed for bus " + bus_name);
+    map_.handle = h;
+
+    void* view = MapViewOfFile(h, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if ( !view )
+      throw_last_error("MapViewOfFile failed for bus " + bus_name);
+    map_.ctl = static_cast<BusControl*>(view);
+
+    const BusControl& ctl = *map_.ctl;
+    if ( ctl.magic.load(std::memory_order_acquire) != kBusMagic )
+      throw std::runtime_error("BusConsumer: bus is not initialised: " + bus_name);
+    if ( ctl.version != kBusVersion )
+      throw std::runtime_error("BusConsumer: unsupported bus version: " + bus_name);
+    return std::string(ctl.snap_path);
+  }
+
+  BusConsumer::BusConsumer(const std::string& bus_name, BusMode mode)
+      : kernel_(attach_(bus_name)), mode_(mode)
+  {
+    if ( mode != BusMode::Backpressure && mode != BusMode::FreeRun )
+      throw std::runtime_error("BusConsumer: invalid mode");
+
+    BusControl& ctl = *map_.ctl;
+    if ( kernel_.size() != ctl.record_count )
+      throw std::runtime_error("BusConsumer: snap file does not match the publisher's");
+
+    bool claimed = false;
+    for ( std::size_t i = 0; i < kBusMaxConsumers && !claimed; ++i ) {
+      std::uint32_t expect = 0;
+      if ( ctl.cursors[i].mode.compare_exchange_strong(expect, kBusClaiming) ) {
+        slot_ = i;
+        claimed = true;
+      }
+    }
+    if ( !claimed )
+      throw std::runtime_error("BusConsumer: all consumer slots are taken on bus " + bus_name);
+
+    // Cursor 0 while joining holds the publisher back until the real start is set.
+    BusCursor& c = ctl.cursors[slot_];
+    c.next_seq.store(0, std::memory_order_seq_cst);
+    c.mode.store(static_cast<std::uint32_t>(mode), std::memory_order_seq_cst);
+    next_ = ctl.head.load(std::memory_order_seq_cst);
+    c.next_seq.store(next_, std::memory_order_seq_cst);
+  }
+
+  BusConsumer::~BusConsumer()
+  {
+    if ( map_.ctl )
+      map_.ctl->cursors[slot_].mode.store(0, std::memory_order_release);
+  }
+
+  BusConsumer::Poll BusConsumer::poll_() noexcept
+  {
+    BusControl& ctl = *map_.ctl;
+    const std::uint64_t capacity = ctl.capacity;
+
+    for ( ;; ) {
+      const std::uint64_t head = ctl.head.load(std::memory_order_acquire);
+      if ( next_ >= head ) {
+        if ( !ctl.closed.load(std::memory_order_acquire) )
+          return Poll::Empty;
+        // closed is stored after the final head
+        if ( ctl.head.load(std::memory_order_acquire) > next_ )
+          continue;
+        return Poll::Closed;
+      }
+
+      const BusSlot& s = ctl.ring()[next_ & (capacity - 1)];
+      const std::uint64_t want = next_ + 1;
+      if ( s.seq.load(std::memory_order_acquire) == want ) {
+        const std::uint64_t idx = s.record_index.load(std::memory_order_relaxed);
+        const std::int64_t ts = s.publish_ns.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if ( s.seq.load(std::memory_order_relaxed) == want ) {
+          seq_ = next_;
+          record_index_ = idx;
+          publish_ns_ = ts;
+          ++next_;
+          ctl.cursors[slot_].next_seq.store(next_, std::memory_order_release);
+          return Poll::Ready;
+        }
+      }
+
+      // Lapped: resume half a ring behind the head. Resuming at the oldest slot
+      // would be overwritten again by the very next publish.
+      const std::uint64_t h = ctl.head.load(std::memory_order_acquire);
+      const std::uint64_t resume = h > capacity / 2 ? h - capacity / 2 : 0;
+      if ( resume > next_ ) {
+        dropped_ += resume - next_;
+        next_ = resume;
+        ctl.cursors[slot_].next_seq.store(next_, std::memory_order_release);
+      }
+    }
+  }
+
+  const Record* BusConsumer::next()
+  {
+    Backoff b;
+    for ( ;; ) {
+      switch ( poll_() ) {
+      case Poll::Ready:
+        return &kernel_[record_index_];
+      case Poll::Closed:
+        return nullptr;
+      case Poll::Empty:
+        b.wait();
+        break;
+      }
+    }
+  }
+
+  const Record* BusConsumer::try_next()
+  {
+    return poll_() == Poll::Ready ? &kernel_[record_index_] : nullptr;
+  }
+
+  bool BusConsumer::finished() const noexcept
+  {
+    const BusControl& ctl = *map_.ctl;
+    return ctl.closed.load(std::memory_order_acquire) &&
+           ctl.head.load(std::memory_order_acquire) <= next_;
+  }
+
+  std::uint64_t BusConsumer::lag() const noexcept
+  {
+    const std::uint64_t head = map_.ctl->head.load(std::memory_order_acquire);
+    return head > next_ ? head - next_ : 0;
+  }
+
+} // namespace md::l2
@@ -0,0 +1,272 @@
+// NUMA topology, thread pinning and node-placed record copies (Windows).
+// - Topology: GetNumaHighestNodeNumber + GetNumaNodeProcessorMaskEx.
+// - Pinning: SetThreadGroupAffinity on the node's group mask.
+// - Replicas: VirtualAllocExNuma on the node, filled by a thread pinned there.
+// - Interleave: one VirtualAlloc block whose stripes are first touched by a
+//   thread on the stripe's node.
+
+#include "numa.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef> // std::byte
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#define NOMINMAX
+#include <windows.h>
+
+namespace md::l2
+{
+
+  namespace
+  {
+
+    // Run fn(slot) on one thread per node, each pinned to its node first.
+    template <class Fn>
+    void on_each_node(std::span<const NumaNode> nodes, Fn&& fn)
+    {
+      std::vector<std::thread> threads;
+      threads.reserve(nodes.size());
+      for ( std::size_t s = 0; s < nodes.size(); ++s ) {
+        threads.emplace_back([&nodes, &fn, s] {
+          (void)pin_current_thread(nodes[s]);
+          fn(s);
+        });
+      }
+      for ( std::thread& t : threads )
+        t.join();
+    }
+
+  } // namespace
+
+  // -------------------------
+  // Topology
+  // -------------------------
+  std::vector<NumaNode> numa_nodes()
+  {
+    std::vector<NumaNode> out;
+
+    ULONG highest = 0;
+    if ( GetNumaHighestNodeNumber(&highest) ) {
+      for ( ULONG n = 0; n <= highest; ++n ) {
+        GROUP_AFFINITY ga{};
+        if ( !GetNumaNodeProcessorMaskEx(static_cast<USHORT>(n), &ga) || ga.Mask == 0 )
+          continue;
+        const std::uint64_t mask = static_cast<std::uint64_t>(ga.Mask);
+        out.push_back(NumaNode{
+            static_cast<std::uint32_t>(n),
+            ga.Group,
+            mask,
+            static_cast<std::uint32_t>(std::popcount(mask))});
+      }
+    }
+
+    if ( out.empty() ) {
+      DWORD_PTR proc = 0;
+      DWORD_PTR sys = 0;
+      if ( !GetProcessAffinityMask(GetCurrentProcess(), &proc, &sys) || proc == 0 )
+        proc = 1;
+      const std::uint64_t mask = static_cast<std::uint64_t>(proc);
+      out.push_back(NumaNode{0, 0, mask, static_cast<std::uint32_t>(std::popcount(mask))});
+    }
+    return out;
+  }
+
+  bool pin_current_thread(const NumaNode& node) noexcept
+  {
+    if ( node.mask == 0 )
+      return false;
+    GROUP_AFFINITY ga{};
+    ga.Mask = static_cast<KAFFINITY>(node.mask);
+    ga.Group = node.group;
+    return SetThreadGroupAffinity(GetCurrentThread(), &ga, nullptr) != 0;
+  }
+
+  // -------------------------
+  // NumaRecordSet
+  // -------------------------
+  NumaRecordSet::NumaRecordSet(
+      const ReplayKernel& rk,
+      NumaPlacement placement,
+      std::span<const NumaNode> nodes,
+      std::size_t start,
+      std::size_t stop)
+      : placement_(placement)
+  {
+    if ( nodes.empty() )
+      throw std::runtime_error("NumaRecordSet: no nodes");
+
+    const std::size_t end = std::min(stop, rk.size());
+    const std::size_t first = std::min(start, end);
+    const std::size_t n = end - first;
+    const Record* src = rk.begin() + first;
+    const std::size_t bytes = n * sizeof(Record);
+
+    if ( placement_ == NumaPlacement::Shared || n == 0 ) {
+      views_.assign(
+          placement_ == NumaPlacement::Replicated ? nodes.size() : 1,
+          std::span<const Record>(src, n));
+      return;
+    }
+
+    if ( placement_ == NumaPlacement::Interleaved ) {
+      void* p = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+      if ( !p )
+        throw std::runtime_error("NumaRecordSet: VirtualAlloc failed");
+      blocks_.push_back(p);
+      bytes_allocated_ = bytes;
+
+      // Stripe k is first touched (and so backed) on node k % nodes
+      const auto* s = reinterpret_cast<const std::byte*>(src);
+      auto* d = static_cast<std::byte*>(p);
+      const std::size_t step = nodes.size() * kNumaStripeBytes;
+      on_each_node(nodes, [&](std::size_t slot) {
+        for ( std::size_t off = slot * kNumaStripeBytes; off < bytes; off += step )
+          std::memcpy(d + off, s + off, std::min(kNumaStripeBytes, bytes - off));
+      });
+      views_.emplace_back(static_cast<const Record*>(p), n);
+      return;
+    }
+
+    // Replicated
+    std::vector<void*> copies(nodes.size(), nullptr);
+    on_each_node(nodes, [&](std::size_t slot) {
+      void* p = VirtualAllocExNuma(
+          GetCurrentProcess(),
+          nullptr,
+          bytes,
+          MEM_RESERVE | MEM_COMMIT,
+          PAGE_READWRITE,
+          nodes[slot].id);
+      if ( p )
+        std::memcpy(p, src, bytes);
+      copies[slot] = p;
+    });
+
+    for ( void* p : copies ) {
+      if ( p ) {
+        blocks_.push_back(p);
+        bytes_allocated_ += bytes;
+      }
+    }
+    if ( blocks_.size() != nodes.size() ) {
+      for ( void* p : blocks_ )
+        VirtualFree(p, 0, MEM_RELEASE);
+      throw std::runtime_error("NumaRecordSet: VirtualAllocExNuma failed");
+    }
+    for ( void* p : copies )
+      views_.emplace_back(static_cast<const Record*>(p), n);
+  }
+
+  NumaRecordSet::~NumaRecordSet()
+  {
+    for ( void* p : blocks_ )
+      VirtualFree(p, 0, MEM_RELEASE);
+  }
+
+  // -------------------------
+  // NumaWorkerPool
+  // -------------------------
+  NumaWorkerPool::NumaWorkerPool(std::span<const NumaNode> nodes, std::size_t workers_per_node)
+      : nodes_(nodes.begin(), nodes.end())
+  {
+    if ( nodes_.empty() || workers_per_node == 0 )
+      throw std::runtime_error("NumaWorkerPool: need at least one node and one worker per node");
+
+    const std::size_t n = nodes_.size() * workers_per_node;
+    workers_.resize(n);
+    for ( std::size_t i = 0; i < n; ++i ) {
+      workers_[i].index = i;
+      workers_[i].node_slot = i % nodes_.size();
+      workers_[i].node_id = nodes_[workers_[i].node_slot].id;
+    }
+
+    threads_.reserve(n);
+    try {
+      for ( std::size_t i = 0; i < n; ++i )
+        threads_.emplace_back([this, i] { loop_(i); });
+    }
+    catch ( ... ) {
+      {
+        std::lock_guard<std::mutex> lk(mu_);
+        stop_ = true;
+      }
+      start_cv_.notify_all();
+      for ( std::thread& t : threads_ )
+        t.join();
+      throw;
+    }
+
+    // Workers report their pinning before the pool is usable
+    std::unique_lock<std::mutex> lk(mu_);
+    done_cv_.wait(lk, [this] { return ready_ == workers_.size(); });
+  }
+
+  NumaWorkerPool::~NumaWorkerPool()
+  {
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      stop_ = true;
+    }
+    start_cv_.notify_all();
+    for ( std::thread& t : threads_ )
+      t.join();
+  }
+
+  void NumaWorkerPool::loop_(std::size_t i)
+  {
+    const bool pinned = pin_current_thread(nodes_[workers_[i].node_slot]);
+    std::uint64_t seen = 0;
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      workers_[i].pinned = pinned;
+      if ( ++ready_ == workers_.size() )
+        done_cv_.notify_all();
+    }
+
+    for ( ;; ) {
+      const Job* job = nullptr;
+      {
+        std::unique_lock<std::mutex> lk(mu_);
+        start_cv_.wait(lk, [&] { return stop_ || generation_ != seen; });
+        if ( stop_ )
+          return;
+        seen = generation_;
+        job = job_;
+      }
+
+      try {
+        (*job)(workers_[i]);
+      }
+      catch ( ... ) {
+        std::lock_guard<std::mutex> lk(mu_);
+        if ( !error_ )
+          error_ = std::current_exception();
+      }
+
+      std::lock_guard<std::mutex> lk(mu_);
+      if ( --running_ == 0 )
+        done_cv_.notify_all();
+    }
+  }
+
+  void NumaWorkerPool::run(const Job& job)
+  {
+    std::unique_lock<std::mutex> lk(mu_);
+    job_ = &job;
+    error_ = nullptr;
+    running_ = workers_.size();
+    ++generation_;
+    start_cv_.notify_all();
+    done_cv_.wait(lk, [this] { return running_ == 0; });
+    job_ = nullptr;
+
+    if ( std::exception_ptr e = std::exchange(error_, nullptr) ) {
+      lk.unlock();
+      std::rethrow_exception(e);
+    }
+  }
+
+} // namespace md::l2
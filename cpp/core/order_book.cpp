@@ -0,0 +1,252 @@
+// Full-depth order book and diff-stream builder (see order_book.hpp).
+// - Ladder: sorted vector per side, best at the back; short back scan, else binary search.
+// - Builder: snapshot / diff synchronisation, gap detection, cadence bucketing.
+
+#include "order_book.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace md::l2
+{
+
+  namespace
+  {
+
+    constexpr std::size_t kBackScan = 8; // levels checked linearly from the top
+
+    std::int64_t floor_div(std::int64_t a, std::int64_t b) noexcept
+    {
+      const std::int64_t q = a / b;
+      return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+    }
+
+    // `worse(a, b)`: price a sorts before (is further from the top than) price b.
+    template <class Worse>
+    void set_level(std::vector<Level>& v, std::int64_t price_q, std::int64_t qty_q, Worse worse)
+    {
+      // j = first index whose price is better than price_q
+      std::size_t j = v.size();
+      const std::size_t floor = j > kBackScan ? j - kBackScan : 0;
+      while ( j > floor && worse(price_q, v[j - 1].price_q) )
+        --j;
+      if ( j == floor && j > 0 && worse(price_q, v[j - 1].price_q) ) {
+        const auto it = std::upper_bound(
+            v.begin(), v.begin() + static_cast<std::ptrdiff_t>(j), price_q,
+            [&](std::int64_t p, const Level& l) { return worse(p, l.price_q); });
+        j = static_cast<std::size_t>(it - v.begin());
+      }
+
+      if ( j > 0 && v[j - 1].price_q == price_q ) {
+        if ( qty_q > 0 )
+          v[j - 1].qty_q = qty_q;
+        else
+          v.erase(v.begin() + static_cast<std::ptrdiff_t>(j - 1));
+      }
+      else if ( qty_q > 0 ) {
+        v.insert(v.begin() + static_cast<std::ptrdiff_t>(j), Level{price_q, qty_q});
+      }
+    }
+
+    constexpr auto kBidWorse = [](std::int64_t a, std::int64_t b) noexcept { return a < b; };
+    constexpr auto kAskWorse = [](std::int64_t a, std::int64_t b) noexcept { return a > b; };
+
+  } // namespace
+
+  // -------------------------
+  // OrderBook
+  // -------------------------
+  void OrderBook::clear() noexcept
+  {
+    bids_.clear();
+    asks_.clear();
+  }
+
+  void OrderBook::set(BookSide side, std::int64_t price_q, std::int64_t qty_q)
+  {
+    if ( side == BookSide::Bid )
+      set_level(bids_, price_q, qty_q, kBidWorse);
+    else
+      set_level(asks_, price_q, qty_q, kAskWorse);
+  }
+
+  std::size_t OrderBook::levels(BookSide side) const noexcept
+  {
+    return side == BookSide::Bid ? bids_.size() : asks_.size();
+  }
+
+  Level OrderBook::level(BookSide side, std::size_t i) const noexcept
+  {
+    const std::vector<Level>& v = side == BookSide::Bid ? bids_ : asks_;
+    return v[v.size() - 1 - i];
+  }
+
+  bool OrderBook::crossed() const noexcept
+  {
+    return !bids_.empty() && !asks_.empty() && bids_.back().price_q >= asks_.back().price_q;
+  }
+
+  void OrderBook::top(Record& rec, std::size_t depth) const noexcept
+  {
+    depth = std::min<std::size_t>(depth, kDepth);
+    const std::size_t nb = std::min(depth, bids_.size());
+    const std::size_t na = std::min(depth, asks_.size());
+    for ( std::size_t i = 0; i < kDepth; ++i ) {
+      rec.bids[i] = i < nb ? bids_[bids_.size() - 1 - i] : Level{kBidNullPriceQ, kNullQtyQ};
+      rec.asks[i] = i < na ? asks_[asks_.size() - 1 - i] : Level{kAskNullPriceQ, kNullQtyQ};
+    }
+  }
+
+  // -------------------------
+  // BookBuilder
+  // -------------------------
+  BookBuilder::BookBuilder(const BookBuilderConfig& cfg, Sink sink)
+    : cfg_(cfg), sink_(std::move(sink))
+  {
+    if ( cfg_.depth == 0 || cfg_.depth > kDepth )
+      throw std::runtime_error(
+          "BookBuilder: depth must be in [1, " + std::to_string(kDepth) + "]");
+    if ( cfg_.cadence_ns < 0 )
+      throw std::runtime_error("BookBuilder: cadence_ns must be >= 0");
+  }
+
+  void BookBuilder::on_update(const DepthUpdate& u)
+  {
+    if ( dirty_ && floor_div(u.ts_recv_ns, cfg_.cadence_ns) != bucket_ )
+      emit_(); // book as of the end of the previous bucket
+
+    if ( u.snapshot ) {
+      if ( synced_ && u.last_update_id <= last_id_ )
+        ++stats_.stale_snapshots; // a REST response that arrived after later diffs
+      else
+        load_snapshot_(u);
+      return;
+    }
+    ++stats_.diffs;
+    if ( synced_ )
+      on_diff_(u);
+    else
+      buffer_(u);
+  }
+
+  void BookBuilder::buffer_(const DepthUpdate& u)
+  {
+    pending_.push_back(u);
+    if ( pending_.size() > cfg_.max_buffered ) {
+      pending_.pop_front();
+      ++stats_.buffer_dropped;
+    }
+  }
+
+  void BookBuilder::load_snapshot_(const DepthUpdate& u)
+  {
+    ++stats_.snapshots;
+    book_.clear();
+    for ( const Level& l : u.bids )
+      book_.set(BookSide::Bid, l.price_q, l.qty_q);
+    for ( const Level& l : u.asks )
+      book_.set(BookSide::Ask, l.price_q, l.qty_q);
+    stats_.level_updates += u.bids.size() + u.asks.size();
+    synced_ = true;
+    first_after_snapshot_ = true;
+    last_id_ = u.last_update_id;
+    applied_(u);
+
+    // Diffs that arrived before the snapshot; stale ones are dropped on the way
+    std::deque<DepthUpdate> pending = std::move(pending_);
+    pending_.clear();
+    for ( const DepthUpdate& d : pending ) {
+      if ( synced_ )
+        on_diff_(d);
+      else
+        buffer_(d); // a gap among them: wait for the next snapshot
+    }
+  }
+
+  void BookBuilder::on_diff_(const DepthUpdate& u)
+  {
+    const bool futures = u.prev_update_id != 0;
+    if ( futures ? u.last_update_id < last_id_ : u.last_update_id <= last_id_ ) {
+      ++stats_.stale;
+      return;
+    }
+
+    const std::uint64_t want = futures ? last_id_ : last_id_ + 1;
+    const bool in_sequence =
+        first_after_snapshot_
+            ? (u.first_update_id <= want && u.last_update_id >= want)
+            : (futures ? u.prev_update_id == last_id_ : u.first_update_id == last_id_ + 1);
+    if ( !in_sequence ) {
+      ++stats_.gaps;
+      if ( dirty_ )
+        emit_(); // the book before the gap is still good
+      book_.clear();
+      synced_ = false;
+      buffer_(u);
+      return;
+    }
+
+    for ( const Level& l : u.bids )
+      book_.set(BookSide::Bid, l.price_q, l.qty_q);
+    for ( const Level& l : u.asks )
+      book_.set(BookSide::Ask, l.price_q, l.qty_q);
+    stats_.level_updates += u.bids.size() + u.asks.size();
+    ++stats_.applied;
+    first_after_snapshot_ = false;
+    last_id_ = u.last_update_id;
+    applied_(u);
+  }
+
+  void BookBuilder::applied_(const DepthUpdate& u)
+  {
+    stats_.max_levels = std::max(
+        {stats_.max_levels, book_.levels(BookSide::Bid), book_.levels(BookSide::Ask)});
+    last_ts_recv_ns_ = u.ts_recv_ns;
+    last_ts_event_ms_ = u.ts_event_ms;
+    if ( cfg_.cadence_ns == 0 ) {
+      emit_();
+      return;
+    }
+    dirty_ = true;
+    bucket_ = floor_div(u.ts_recv_ns, cfg_.cadence_ns);
+  }
+
+  void BookBuilder::emit_()
+  {
+    book_.top(rec_, cfg_.depth);
+    rec_.ts_recv_ns = last_ts_recv_ns_;
+    rec_.ts_event_ms = last_ts_event_ms_;
+    dirty_ = false;
+    ++stats_.records;
+    sink_(rec_);
+  }
+
+  void BookBuilder::finish()
+  {
+    if ( dirty_ )
+      emit_();
+  }
+
+  DiffReplayStats replay_depth_diffs(
+      DepthTransport& transport,
+      BookBuilder& builder,
+      const std::atomic<bool>& stop)
+  {
+    DiffReplayStats st{};
+    std::string payload;
+    std::int64_t ts_recv_ns = 0;
+    DepthUpdate u;
+    while ( !stop.load(std::memory_order_relaxed) && transport.next(payload, ts_recv_ns) ) {
+      ++st.messages;
+      if ( parse_depth_update(payload, ts_recv_ns, u) )
+        builder.on_update(u);
+      else
+        ++st.bad_messages;
+    }
+    builder.finish();
+    return st;
+  }
+
+} // namespace md::l2
@@ -0,0 +1,138 @@
+// Wall-clock paced replay (hybrid sleep-then-spin scheduling).
+
+#include "paced_replay.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+#include "md_bus.hpp"
+#include "replay.hpp"
+
+namespace md::l2
+{
+
+  namespace
+  {
+
+    // Sleeps to within spin_ns (+ observed oversleep) of the deadline, then spins.
+    class PacedClock
+    {
+    public:
+      explicit PacedClock(std::int64_t spin_ns) : spin_ns_(spin_ns) {}
+
+      // Returns the hand-off time (>= deadline_ns).
+      std::int64_t wait_until(std::int64_t deadline_ns)
+      {
+        std::int64_t now = bus_clock_ns();
+        const std::int64_t sleep_ns = deadline_ns - now - spin_ns_ - slack_ns_;
+        if ( sleep_ns > 0 ) {
+          std::this_thread::sleep_for(std::chrono::nanoseconds(sleep_ns));
+          const std::int64_t after = bus_clock_ns();
+          // Track the scheduler's oversleep (timer granularity), decaying slowly
+          const std::int64_t over = std::max<std::int64_t>(0, after - now - sleep_ns);
+          slack_ns_ = std::max(slack_ns_ - slack_ns_ / 8, over);
+          now = after;
+        }
+        while ( now < deadline_ns )
+          now = bus_clock_ns();
+        return now;
+      }
+
+    private:
+      std::int64_t spin_ns_ = 0;
+      std::int64_t slack_ns_ = 0;
+    };
+
+    void record_lag(PacedReplayStats& st, std::int64_t lag_ns, double& lag_sum)
+    {
+      if ( st.delivered == 0 || lag_ns < st.lag_min_ns )
+        st.lag_min_ns = lag_ns;
+      if ( st.delivered == 0 || lag_ns > st.lag_max_ns )
+        st.lag_max_ns = lag_ns;
+      std::size_t b = 0; // lag <= 0
+      if ( lag_ns > 0 )
+        b = static_cast<std::size_t>(std::bit_width(static_cast<std::uint64_t>(lag_ns))); // <= 63
+      ++st.lag_hist[b];
+      lag_sum += static_cast<double>(lag_ns);
+      ++st.delivered;
+    }
+
+  } // namespace
+
+  std::int64_t PacedReplayStats::lag_quantile_ns(double q) const noexcept
+  {
+    if ( delivered == 0 )
+      return 0;
+    q = std::clamp(q, 0.0, 1.0);
+    const double want = std::ceil(q * static_cast<double>(delivered));
+    const std::uint64_t rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(want));
+    std::uint64_t seen = 0;
+    for ( std::size_t k = 0; k < lag_hist.size(); ++k ) {
+      seen += lag_hist[k];
+      if ( seen >= rank ) {
+        if ( k == 0 )
+          return std::min<std::int64_t>(0, lag_max_ns);
+        if ( k >= 63 )
+          return lag_max_ns;
+        return std::min<std::int64_t>(std::int64_t{1} << k, lag_max_ns);
+      }
+    }
+    return lag_max_ns;
+  }
+
+  PacedReplayStats paced_replay(
+      std::span<const Record> records,
+      const PacedReplayConfig& cfg,
+      const PacedSink& sink)
+  {
+    if ( !(cfg.speed > 0.0) || !std::isfinite(cfg.speed) )
+      throw std::runtime_error("paced_replay: speed must be a positive finite number");
+    if ( cfg.spin_ns < 0 || cfg.max_gap_ns < 0 )
+      throw std::runtime_error("paced_replay: spin_ns and max_gap_ns must be >= 0");
+
+    PacedReplayStats st{};
+    if ( records.empty() )
+      return st;
+
+    PacedClock clock(cfg.spin_ns);
+    double lag_sum = 0.0;
+    std::int64_t recorded_off = 0; // gap-capped ts_recv_ns offset from records[0]
+    std::int64_t handoff = 0;
+    const std::int64_t t0 = bus_clock_ns();
+
+    for ( std::size_t i = 0; i < records.size(); ++i ) {
+      if ( i > 0 ) {
+        std::int64_t gap = records[i].ts_recv_ns - records[i - 1].ts_recv_ns;
+        if ( gap < 0 )
+          gap = 0; // out-of-order receive stamps: deliver immediately
+        if ( cfg.max_gap_ns > 0 && gap > cfg.max_gap_ns )
+          gap = cfg.max_gap_ns;
+        recorded_off += gap;
+      }
+      const std::int64_t deadline =
+          t0 + static_cast<std::int64_t>(static_cast<double>(recorded_off) / cfg.speed);
+
+      handoff = clock.wait_until(deadline);
+      record_lag(st, handoff - deadline, lag_sum);
+      sink(i, records[i]);
+    }
+
+    st.lag_mean_ns = lag_sum / static_cast<double>(st.delivered);
+    st.wall_ns = handoff - t0;
+    st.schedule_ns = static_cast<std::int64_t>(static_cast<double>(recorded_off) / cfg.speed);
+    return st;
+  }
+
+  PacedReplayStats paced_replay(BusPublisher& bus, const PacedReplayConfig& cfg)
+  {
+    const ReplayKernel& rk = bus.kernel();
+    const std::span<const Record> rest(rk.begin() + rk.pos(), rk.size() - rk.pos());
+    return paced_replay(
+        rest, cfg, [&bus](std::size_t, const Record&) { (void)bus.publish_next(); });
+  }
+
+} // namespace md::l2
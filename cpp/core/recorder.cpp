@@ -0,0 +1,104 @@
+/*
+Native depth-stream recorder: depth JSON payloads -> hourly .snap files.
+
+Replaces capture_order_book.py + converter for partial-depth streams (see
+depth_recorder.hpp): payloads are parsed straight to fixed point and appended
+to <out_root>/<YYYY-MM-DD>/<SYMBOL>_depth20_<YYYY-MM-DD>_<HH>.snap.part,
+finalised (count, rename, .zmap / .stats sidecars) when the hour rolls or the
+input ends. In both modes, leftover .part files of this symbol are finalised at
+start-up, and SIGINT / SIGTERM stop reading and finalise the open file.
+
+Usage:
+  depth_recorder <SYMBOL> <out_root>                  (payloads on stdin)
+  depth_recorder <SYMBOL> <out_root> <input.jsonl>    (replay a capture)
+  depth_recorder --diffs <SYMBOL> <out_root> <input.jsonl> [<depth> [<cadence_ms>]]
+      (rebuild the full book from a diff-stream capture with REST snapshots
+       interleaved, see order_book.hpp; defaults: depth 20, a record per update)
+
+Input: one payload per line, "<ts_recv_ns>\t<json>" or bare "<json>" (stamped
+on read). A live feed can be piped in from any websocket client, e.g.
+  websocat -t wss://stream.binance.com:9443/ws/btcusdt@depth20@100ms | depth_recorder BTCUSDT <root>
+*/
+
+#include <atomic>
+#include <csignal>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "depth_recorder.hpp"
+#include "order_book.hpp"
+
+namespace
+{
+  std::atomic<bool> g_stop{false};
+
+  extern "C" void on_signal(int) { g_stop.store(true); }
+
+  // Start-up shared by both modes: stop on SIGINT / SIGTERM, and finalise this
+  // symbol's .part files left by an earlier (crashed or killed) run.
+  void start_recording(md::l2::RollingSnapWriter& writer)
+  {
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+    const std::size_t recovered = writer.recover_parts();
+    if ( recovered > 0 )
+      std::cerr << "[INFO] Finalised " << recovered << " leftover .part files\n";
+  }
+
+  int run_diffs(int argc, char** argv)
+  {
+    md::l2::BookBuilderConfig cfg{};
+    if ( argc >= 6 )
+      cfg.depth = std::stoul(argv[5]);
+    if ( argc >= 7 )
+      cfg.cadence_ns = std::stoll(argv[6]) * 1'000'000;
+
+    md::l2::RollingSnapWriter writer(argv[3], argv[2]);
+    start_recording(writer);
+    md::l2::BookBuilder builder(cfg, [&](const md::l2::Record& r) { writer.append(r); });
+    md::l2::StreamTransport transport{std::string(argv[4])};
+    const md::l2::DiffReplayStats rs = md::l2::replay_depth_diffs(transport, builder, g_stop);
+    writer.close();
+
+    const md::l2::BookBuilderStats& st = builder.stats();
+    std::cerr << "[OK] messages=" << rs.messages << " bad_messages=" << rs.bad_messages
+              << " snapshots=" << st.snapshots << " diffs=" << st.diffs
+              << " applied=" << st.applied << " stale=" << st.stale << " gaps=" << st.gaps
+              << " records=" << st.records << " max_levels=" << st.max_levels
+              << " files=" << writer.files_finalised() << "\n";
+    return 0;
+  }
+} // namespace
+
+int main(int argc, char** argv)
+{
+  try {
+    if ( argc >= 5 && argc <= 7 && std::string_view(argv[1]) == "--diffs" )
+      return run_diffs(argc, argv);
+    if ( argc != 3 && argc != 4 ) {
+      std::cerr << "Usage: depth_recorder <SYMBOL> <out_root> [<input.jsonl>]\n"
+                << "       depth_recorder --diffs <SYMBOL> <out_root> <input.jsonl>"
+                << " [<depth> [<cadence_ms>]]\n";
+      return 2;
+    }
+    md::l2::RollingSnapWriter writer(argv[2], argv[1]);
+    start_recording(writer);
+
+    std::unique_ptr<md::l2::StreamTransport> transport =
+        argc == 4 ? std::make_unique<md::l2::StreamTransport>(std::string(argv[3]))
+                  : std::make_unique<md::l2::StreamTransport>(std::cin);
+    const md::l2::RecorderStats st = md::l2::record_depth(*transport, writer, g_stop);
+
+    std::cerr << "[OK] messages=" << st.messages << " records=" << st.records
+              << " bad_messages=" << st.bad_messages << " files=" << writer.files_finalised()
+              << "\n";
+    return 0;
+  }
+  catch ( const std::exception& e ) {
+    std::cerr << "[FAIL] " << e.what() << "\n";
+    return 1;
+  }
+}
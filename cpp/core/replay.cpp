@@ -2,12 +2,15 @@
 // - Maps a .snap file produced by the C++ converter.
 // - Validates FileHeader and file size.
 // - Exposes Record* for zero-copy sequential replay.
+// - Follow mode: tails a file that is still growing, remapping whole records.
 
 #include "replay.hpp"
 
+#include <chrono>
 #include <cstddef> // std::byte
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <utility>
 
 #define NOMINMAX
@@ -54,10 +57,75 @@ namespace md::l2
       throw std::runtime_error(std::string(what) + " (GetLastError=" + std::to_string(e) + ")");
     }
 
+    void check_header(const FileHeader& hdr)
+    {
+      if ( hdr.magic != kMagic )
+        throw std::runtime_error("Bad magic: not a .snap file");
+      if ( hdr.version != kVersion )
+        throw std::runtime_error("Unsupported version");
+      if ( hdr.depth != kDepth )
+        throw std::runtime_error("Depth mismatch");
+      if ( hdr.record_size != sizeof(Record) )
+        throw std::runtime_error("Record size mismatch");
+      if ( hdr.endian_check != kEndianCheck )
+        throw std::runtime_error("Endian check mismatch");
+      if ( hdr.price_scale <= 0 || hdr.qty_scale <= 0 )
+        throw std::runtime_error("Invalid scales in header");
+    }
+
+    // record_count is rewritten by the writer through the file while it is mapped here.
+    std::uint64_t load_record_count(const void* view) noexcept
+    {
+      const FileHeader* hdr = static_cast<const FileHeader*>(view);
+      return *static_cast<const volatile std::uint64_t*>(&hdr->record_count);
+    }
+
+    // One wait for the writer: spin_polls pauses, then poll_ns sleeps.
+    class FollowWait
+    {
+    public:
+      explicit FollowWait(const FollowConfig& cfg)
+        : cfg_(cfg), start_(std::chrono::steady_clock::now())
+      {
+      }
+
+      // Pause before the next check; false once the wait should end instead.
+      bool wait()
+      {
+        if ( cfg_.stop && cfg_.stop->load(std::memory_order_relaxed) )
+          return false;
+        if ( cfg_.idle_timeout_ns > 0 &&
+             std::chrono::steady_clock::now() - start_ >=
+                 std::chrono::nanoseconds(cfg_.idle_timeout_ns) )
+          return false;
+        if ( spins_ < cfg_.spin_polls ) {
+          ++spins_;
+          YieldProcessor();
+        }
+        else {
+          std::this_thread::sleep_for(std::chrono::nanoseconds(cfg_.poll_ns));
+        }
+        return true;
+      }
+
+    private:
+      const FollowConfig& cfg_;
+      std::chrono::steady_clock::time_point start_;
+      std::uint32_t spins_ = 0;
+    };
+
   } // namespace
 
   ReplayKernel::ReplayKernel(const std::string& snap_path) { map_file_(snap_path); }
 
+  ReplayKernel::ReplayKernel(const std::string& snap_path, const FollowConfig& follow)
+    : follow_(true), follow_cfg_(follow)
+  {
+    if ( follow.poll_ns <= 0 || follow.idle_timeout_ns < 0 )
+      throw std::runtime_error("ReplayKernel: poll_ns must be > 0 and idle_timeout_ns >= 0");
+    map_file_(snap_path);
+  }
+
   ReplayKernel::ReplayKernel(ReplayKernel&& other) noexcept { *this = std::move(other); }
 
   ReplayKernel& ReplayKernel::operator=(ReplayKernel&& other) noexcept
@@ -75,25 +143,116 @@ namespace md::l2
     mapping_handle_ = other.mapping_handle_;
     view_ = other.view_;
 
+    follow_ = other.follow_;
+    final_ = other.final_;
+    follow_cfg_ = other.follow_cfg_;
+
     other.data_ = nullptr;
     other.size_ = 0;
     other.pos_ = 0;
     other.file_handle_ = nullptr;
     other.mapping_handle_ = nullptr;
     other.view_ = nullptr;
+    other.follow_ = false;
+    other.final_ = false;
 
     return *this;
   }
 
   ReplayKernel::~ReplayKernel() { unmap_file_(); }
 
-  const Record* ReplayKernel::next() noexcept
+  const Record* ReplayKernel::next()
   {
-    if ( pos_ >= size_ )
+    if ( pos_ >= size_ && !(follow_ && wait_for_records_()) )
       return nullptr;
     return &data_[pos_++];
   }
 
+  std::span<const Record> ReplayKernel::next_batch(std::size_t n)
+  {
+    if ( pos_ >= size_ && follow_ )
+      (void)wait_for_records_();
+    const std::size_t avail = size_ - pos_;
+    const std::size_t k = (n < avail) ? n : avail;
+    const std::span<const Record> out(data_ + pos_, k);
+    pos_ += k;
+    return out;
+  }
+
+  std::span<const Record> ReplayKernel::window(std::size_t k) const noexcept
+  {
+    const std::size_t w = (k < pos_) ? k : pos_;
+    return std::span<const Record>(data_ + (pos_ - w), w);
+  }
+
+  bool ReplayKernel::finished() const noexcept { return pos_ >= size_ && (!follow_ || final_); }
+
+  std::size_t ReplayKernel::poll()
+  {
+    if ( !follow_ || final_ )
+      return 0;
+
+    // Count before size: the writer trims a torn record before writing the count
+    const std::uint64_t count = load_record_count(view_);
+    const std::uint64_t fsz = file_size_u64(static_cast<HANDLE>(file_handle_));
+    std::uint64_t records =
+        fsz >= sizeof(FileHeader) ? (fsz - sizeof(FileHeader)) / sizeof(Record) : 0;
+    if ( count != 0 && count < records )
+      records = count;
+    final_ = count != 0 && records == count;
+
+    if ( records <= size_ )
+      return 0;
+    const std::size_t grown = static_cast<std::size_t>(records) - size_;
+    remap_(static_cast<std::size_t>(records));
+    return grown;
+  }
+
+  bool ReplayKernel::wait_for_records_()
+  {
+    FollowWait w(follow_cfg_);
+    while ( poll() == 0 ) {
+      if ( final_ || !w.wait() )
+        return false;
+    }
+    return true;
+  }
+
+  // Map exactly the header and `records` whole records, replacing the current view only once
+  // the new one exists. The mapping never covers a partial record, so the writer can still
+  // truncate one when it finalises the file.
+  void ReplayKernel::remap_(std::size_t records)
+  {
+    const std::uint64_t bytes =
+        sizeof(FileHeader) + static_cast<std::uint64_t>(records) * sizeof(Record);
+    HANDLE hMap = CreateFileMappingW(
+        static_cast<HANDLE>(file_handle_),
+        nullptr,
+        PAGE_READONLY,
+        static_cast<DWORD>(bytes >> 32),
+        static_cast<DWORD>(bytes & 0xFFFFFFFFu),
+        nullptr);
+    if ( !hMap )
+      throw_last_error("CreateFileMappingW failed");
+
+    void* view = MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+    if ( !view ) {
+      const DWORD e = GetLastError();
+      CloseHandle(hMap);
+      throw std::runtime_error("MapViewOfFile failed (GetLastError=" + std::to_string(e) + ")");
+    }
+
+    if ( view_ )
+      UnmapViewOfFile(view_);
+    if ( mapping_handle_ )
+      CloseHandle(static_cast<HANDLE>(mapping_handle_));
+    view_ = view;
+    mapping_handle_ = hMap;
+    const auto* base = static_cast<const std::byte*>(view);
+    data_ = reinterpret_cast<const Record*>(base + sizeof(FileHeader));
+    size_ = records;
+  }
+
   void ReplayKernel::map_file_(const std::string& path)
   {
     unmap_file_();
@@ -103,7 +262,7 @@ namespace md::l2
     HANDLE hFile = CreateFileW(
         wpath.c_str(),
         GENERIC_READ,
-        FILE_SHARE_READ,
+        follow_ ? (FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE) : FILE_SHARE_READ,
         nullptr,
         OPEN_EXISTING,
         FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
@@ -117,7 +276,23 @@ namespace md::l2
     void* view = nullptr;
 
     try {
-      const std::uint64_t fsz = file_size_u64(hFile);
+      std::uint64_t fsz = file_size_u64(hFile);
+      if ( follow_ ) {
+        FollowWait w(follow_cfg_);
+        while ( fsz < sizeof(FileHeader) ) {
+          if ( !w.wait() )
+            throw std::runtime_error("No .snap header before the follow ended");
+          fsz = file_size_u64(hFile);
+        }
+
+        file_handle_ = hFile;
+        remap_(0);
+        check_header(*static_cast<const FileHeader*>(view_));
+        pos_ = 0;
+        final_ = false;
+        (void)poll();
+        return; // success
+      }
       if ( fsz < sizeof(FileHeader) ) {
         throw std::runtime_error("File too small to contain header");
       }
@@ -140,19 +315,7 @@ namespace md::l2
       const auto* base = static_cast<const std::byte*>(view_);
       const auto* hdr = reinterpret_cast<const FileHeader*>(base);
 
-      // Header validation
-      if ( hdr->magic != kMagic )
-        throw std::runtime_error("Bad magic: not a .snap file");
-      if ( hdr->version != kVersion )
-        throw std::runtime_error("Unsupported version");
-      if ( hdr->depth != kDepth )
-        throw std::runtime_error("Depth mismatch");
-      if ( hdr->record_size != sizeof(Record) )
-        throw std::runtime_error("Record size mismatch");
-      if ( hdr->endian_check != kEndianCheck )
-        throw std::runtime_error("Endian check mismatch");
-      if ( hdr->price_scale <= 0 || hdr->qty_scale <= 0 )
-        throw std::runtime_error("Invalid scales in header");
+      check_header(*hdr);
 
       const std::uint64_t payload = fsz - sizeof(FileHeader);
       if ( payload % sizeof(Record) != 0 )
@@ -0,0 +1,159 @@
+// SPSC pipelined replay: producer thread fills Record batches, consumer steps them.
+
+#include "replay_pipeline.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#if defined(_MSC_VER)
+#  include <intrin.h>
+#endif
+
+namespace md::l2
+{
+
+  namespace
+  {
+
+    constexpr std::size_t kCacheLine = 64;
+    constexpr std::size_t kPrefetchRecords = 4; // head of each batch, ~40 cache lines
+
+    inline void prefetch_records(const Record* first, std::size_t n) noexcept
+    {
+      const char* p = reinterpret_cast<const char*>(first);
+      const char* end = p + n * sizeof(Record);
+      for ( ; p < end; p += kCacheLine ) {
+#if defined(_MSC_VER)
+        _mm_prefetch(p, _MM_HINT_T0);
+#else
+        __builtin_prefetch(p);
+#endif
+      }
+    }
+
+    // Spin briefly, then give up the time slice.
+    struct Backoff
+    {
+      unsigned n = 0;
+
+      void wait() noexcept
+      {
+        if ( ++n > 64 )
+          std::this_thread::yield();
+      }
+    };
+
+  } // namespace
+
+  ReplayPipeline::ReplayPipeline(Source source, std::size_t batch_records, std::size_t depth)
+      : source_(std::move(source)), batch_(batch_records), depth_(depth)
+  {
+    if ( !source_ )
+      throw std::runtime_error("ReplayPipeline: empty source");
+    if ( batch_ < 1 || depth_ < 2 )
+      throw std::runtime_error("ReplayPipeline: need batch_records >= 1 and depth >= 2");
+
+    buf_.resize(batch_ * depth_);
+    counts_.assign(depth_, 0);
+    producer_ = std::thread([this] { produce_(); });
+  }
+
+  ReplayPipeline::~ReplayPipeline()
+  {
+    stop_.store(true, std::memory_order_release);
+    if ( producer_.joinable() )
+      producer_.join();
+  }
+
+  void ReplayPipeline::produce_() noexcept
+  {
+    std::uint64_t head = 0;
+    std::uint64_t tail_cache = 0;
+    try {
+      for ( ;; ) {
+        // Wait for a free slot
+        if ( head - tail_cache == depth_ ) {
+          Backoff b;
+          for ( ;; ) {
+            tail_cache = tail_.load(std::memory_order_acquire);
+            if ( head - tail_cache < depth_ )
+              break;
+            if ( stop_.load(std::memory_order_acquire) )
+              return;
+            b.wait();
+          }
+        }
+        if ( stop_.load(std::memory_order_relaxed) )
+          return;
+
+        const std::size_t slot = static_cast<std::size_t>(head % depth_);
+        const std::span<Record> out(buf_.data() + slot * batch_, batch_);
+        const std::size_t n = std::min(source_(out), batch_);
+        if ( n == 0 )
+          break;
+        counts_[slot] = n;
+        head_.store(++head, std::memory_order_release);
+      }
+    }
+    catch ( ... ) {
+      error_ = std::current_exception();
+    }
+    done_.store(true, std::memory_order_release);
+  }
+
+  std::span<const Record> ReplayPipeline::next_batch()
+  {
+    std::uint64_t tail = tail_.load(std::memory_order_relaxed);
+    if ( holding_ ) {
+      tail_.store(++tail, std::memory_order_release);
+      holding_ = false;
+    }
+
+    if ( head_cache_ == tail ) {
+      Backoff b;
+      for ( ;; ) {
+        head_cache_ = head_.load(std::memory_order_acquire);
+        if ( head_cache_ != tail )
+          break;
+        if ( done_.load(std::memory_order_acquire) ) {
+          // Re-check: the last batch may have landed before done_
+          head_cache_ = head_.load(std::memory_order_acquire);
+          if ( head_cache_ != tail )
+            break;
+          if ( error_ )
+            std::rethrow_exception(error_);
+          return {};
+        }
+        b.wait();
+      }
+    }
+
+    const std::size_t slot = static_cast<std::size_t>(tail % depth_);
+    const Record* first = buf_.data() + slot * batch_;
+    const std::size_t n = counts_[slot];
+    prefetch_records(first, std::min(n, kPrefetchRecords));
+    holding_ = true;
+    delivered_ += n;
+    return {first, n};
+  }
+
+  ReplayPipeline::Source kernel_source(const ReplayKernel& rk, std::size_t start, std::size_t stop)
+  {
+    const std::size_t end = std::min(stop, rk.size());
+    auto pos = std::make_shared<std::size_t>(std::min(start, end));
+    return [&rk, pos, end](std::span<Record> out) -> std::size_t {
+      const std::size_t n = std::min(out.size(), end - *pos);
+      if ( n > 0 ) {
+        // Pull the following source chunk toward the cache while copying this one
+        prefetch_records(rk.begin() + *pos + n, std::min(end - *pos - n, kPrefetchRecords));
+        std::memcpy(out.data(), rk.begin() + *pos, n * sizeof(Record));
+        *pos += n;
+      }
+      return n;
+    };
+  }
+
+} // namespace md::l2
@@ -0,0 +1,291 @@
+// Dataset catalog (see snap_catalog.hpp).
+// - Scan: one pass over the mapped records per file, files spread over threads.
+// - Storage: fixed-size entries + a path table, written to .part then renamed.
+
+#include "snap_catalog.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+#include "file_util.hpp"
+#include "parallel_for.hpp"
+#include "replay.hpp"
+#include "sim_digest.hpp"
+
+namespace fs = std::filesystem;
+
+namespace md::l2
+{
+
+  namespace
+  {
+
+    using sim::digest::mix;
+
+  } // namespace
+
+  // -------------------------
+  // Per-file scan
+  // -------------------------
+  CatalogEntry scan_snap(const std::string& snap_path)
+  {
+    CatalogEntry e{};
+    e.file_size = static_cast<std::uint64_t>(fs::file_size(snap_path));
+    e.write_time = write_time_of(snap_path);
+
+    const ReplayKernel rk(snap_path);
+    e.record_count = rk.size();
+    e.first_ts_recv_ns = (std::numeric_limits<std::int64_t>::max)();
+    e.last_ts_recv_ns = (std::numeric_limits<std::int64_t>::min)();
+
+    std::uint64_t h = mix(sim::digest::kSeed, e.record_count);
+    bool have_top = false;
+    std::int64_t prev_ts = 0;
+    for ( std::size_t i = 0; i < rk.size(); ++i ) {
+      const Record& r = rk[i];
+
+      std::uint64_t words[sizeof(Record) / 8];
+      std::memcpy(words, &r, sizeof(Record));
+      for ( const std::uint64_t w : words )
+        h = mix(h, w);
+
+      if ( i > 0 ) {
+        if ( r.ts_recv_ns < prev_ts )
+          ++e.ts_regressions;
+        else
+          e.max_gap_ns = std::max(e.max_gap_ns, r.ts_recv_ns - prev_ts);
+      }
+      prev_ts = r.ts_recv_ns;
+
+      if ( !record_has_top_of_book(r) ) {
+        ++e.no_top_of_book;
+        continue;
+      }
+      const std::int64_t bid = r.best_bid_price_q();
+      const std::int64_t ask = r.best_ask_price_q();
+      e.crossed += bid > ask ? 1u : 0u;
+      e.locked += bid == ask ? 1u : 0u;
+      const std::int64_t spread = ask - bid;
+      if ( !have_top ) {
+        e.min_best_bid_q = e.max_best_bid_q = bid;
+        e.min_spread_q = e.max_spread_q = spread;
+        have_top = true;
+      }
+      else {
+        e.min_best_bid_q = std::min(e.min_best_bid_q, bid);
+        e.max_best_bid_q = std::max(e.max_best_bid_q, bid);
+        e.min_spread_q = std::min(e.min_spread_q, spread);
+        e.max_spread_q = std::max(e.max_spread_q, spread);
+      }
+    }
+    if ( rk.size() > 0 ) {
+      e.first_ts_recv_ns = rk[0].ts_recv_ns;
+      e.last_ts_recv_ns = rk[rk.size() - 1].ts_recv_ns;
+    }
+    e.digest = h;
+    return e;
+  }
+
+  // -------------------------
+  // SnapCatalog
+  // -------------------------
+  SnapCatalog::SnapCatalog(std::string root) : root_(std::move(root))
+  {
+    const std::string path = file();
+    if ( !fs::exists(path) )
+      return;
+
+    std::ifstream in(path, std::ios::binary);
+    if ( !in )
+      throw std::runtime_error("Could not open catalog: " + path);
+
+    CatalogHeader h{};
+    in.read(reinterpret_cast<char*>(&h), sizeof(h));
+    if ( !in )
+      throw std::runtime_error("Truncated catalog header: " + path);
+    if ( h.magic != kCatalogMagic )
+      throw std::runtime_error("Not a snap catalog (bad magic): " + path);
+    if ( h.version < kCatalogVersion )
+      return; // older layout: rebuilt by the next refresh()
+    if ( h.version != kCatalogVersion )
+      throw std::runtime_error("Unsupported catalog version: " + path);
+    if ( h.endian_check != kEndianCheck )
+      throw std::runtime_error("Catalog endianness mismatch: " + path);
+    if ( h.entry_size != sizeof(CatalogEntry) )
+      throw std::runtime_error("Catalog entry size mismatch: " + path);
+
+    entries_.resize(static_cast<std::size_t>(h.count));
+    std::string table(static_cast<std::size_t>(h.path_bytes), '\0');
+    if ( h.count > 0 )
+      in.read(
+          reinterpret_cast<char*>(entries_.data()),
+          static_cast<std::streamsize>(h.count * sizeof(CatalogEntry)));
+    if ( h.path_bytes > 0 )
+      in.read(table.data(), static_cast<std::streamsize>(h.path_bytes));
+    if ( !in )
+      throw std::runtime_error("Truncated catalog: " + path);
+
+    paths_.reserve(entries_.size());
+    for ( const CatalogEntry& e : entries_ ) {
+      if ( e.path_offset + e.path_len > table.size() )
+        throw std::runtime_error("Catalog path table out of range: " + path);
+      paths_.emplace_back(table, static_cast<std::size_t>(e.path_offset), e.path_len);
+    }
+  }
+
+  std::string SnapCatalog::file() const { return (fs::path(root_) / kCatalogFileName).string(); }
+
+  std::string SnapCatalog::path(std::size_t i) const
+  {
+    return (fs::path(root_) / fs::path(paths_[i])).string();
+  }
+
+  std::size_t SnapCatalog::refresh(unsigned threads)
+  {
+    std::unordered_map<std::string, std::size_t> known;
+    for ( std::size_t i = 0; i < paths_.size(); ++i )
+      known.emplace(paths_[i], i);
+
+    std::vector<CatalogEntry> entries;
+    std::vector<std::string> paths;
+    std::vector<std::size_t> stale; // indices into entries/paths to rescan
+
+    for ( const auto& ent : fs::recursive_directory_iterator(root_) ) {
+      if ( !ent.is_regular_file() || ent.path().extension() != ".snap" )
+        continue;
+      std::string rel = fs::relative(ent.path(), root_).generic_string();
+      const auto size = static_cast<std::uint64_t>(ent.file_size());
+      const std::int64_t wt = write_time_of(ent.path());
+
+      const auto it = known.find(rel);
+      if ( it != known.end() && entries_[it->second].file_size == size &&
+           entries_[it->second].write_time == wt ) {
+        entries.push_back(entries_[it->second]);
+      }
+      else {
+        entries.emplace_back();
+        stale.push_back(entries.size() - 1);
+      }
+      paths.push_back(std::move(rel));
+    }
+
+    parallel_for(stale.size(), threads, [&](std::size_t k) {
+      const std::size_t i = stale[k];
+      entries[i] = scan_snap((fs::path(root_) / fs::path(paths[i])).string());
+    });
+
+    entries_ = std::move(entries);
+    paths_ = std::move(paths);
+    sort_();
+    return stale.size();
+  }
+
+  void SnapCatalog::upsert(const std::string& snap_path)
+  {
+    const fs::path rel_path = fs::relative(fs::absolute(snap_path), fs::absolute(root_));
+    if ( rel_path.empty() || *rel_path.begin() == ".." )
+      throw std::runtime_error("SnapCatalog: file not under root: " + snap_path);
+    const std::string rel = rel_path.generic_string();
+
+    const CatalogEntry e = scan_snap(snap_path);
+    const auto it = std::find(paths_.begin(), paths_.end(), rel);
+    if ( it == paths_.end() ) {
+      entries_.push_back(e);
+      paths_.push_back(rel);
+    }
+    else {
+      entries_[static_cast<std::size_t>(it - paths_.begin())] = e;
+    }
+    sort_();
+  }
+
+  void SnapCatalog::sort_()
+  {
+    std::vector<std::size_t> order(entries_.size());
+    for ( std::size_t i = 0; i < order.size(); ++i )
+      order[i] = i;
+    std::sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) {
+      if ( entries_[a].first_ts_recv_ns != entries_[b].first_ts_recv_ns )
+        return entries_[a].first_ts_recv_ns < entries_[b].first_ts_recv_ns;
+      return paths_[a] < paths_[b];
+    });
+
+    std::vector<CatalogEntry> entries;
+    std::vector<std::string> paths;
+    entries.reserve(order.size());
+    paths.reserve(order.size());
+    std::int64_t max_last = (std::numeric_limits<std::int64_t>::min)();
+    std::uint64_t path_offset = 0;
+    for ( const std::size_t i : order ) {
+      CatalogEntry& e = entries.emplace_back(entries_[i]);
+      paths.push_back(std::move(paths_[i]));
+      max_last = std::max(max_last, e.last_ts_recv_ns);
+      e.max_last_ts_recv_ns = max_last;
+      e.path_offset = path_offset;
+      e.path_len = static_cast<std::uint32_t>(paths.back().size());
+      path_offset += e.path_len;
+    }
+    entries_ = std::move(entries);
+    paths_ = std::move(paths);
+  }
+
+  void SnapCatalog::save() const
+  {
+    std::string table;
+    for ( const std::string& p : paths_ )
+      table += p;
+
+    CatalogHeader h{};
+    h.entry_size = sizeof(CatalogEntry);
+    h.count = entries_.size();
+    h.path_bytes = table.size();
+
+    const fs::path final_path = file();
+    const fs::path tmp = final_path.string() + ".part";
+    {
+      std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+      if ( !out )
+        throw std::runtime_error("Could not open catalog for writing: " + tmp.string());
+      out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+      if ( !entries_.empty() )
+        out.write(
+            reinterpret_cast<const char*>(entries_.data()),
+            static_cast<std::streamsize>(entries_.size() * sizeof(CatalogEntry)));
+      out.write(table.data(), static_cast<std::streamsize>(table.size()));
+      out.flush();
+      if ( !out )
+        throw std::runtime_error("Write failure for catalog: " + tmp.string());
+    }
+
+    replace_file(tmp, final_path, "catalog");
+  }
+
+  std::vector<std::size_t> SnapCatalog::overlapping(std::int64_t t0, std::int64_t t1) const
+  {
+    std::vector<std::size_t> out;
+    if ( t0 > t1 )
+      return out;
+
+    // Files starting after t1 are a suffix; files whose running max end is
+    // before t0 are a prefix.
+    const auto hi = std::partition_point(
+        entries_.begin(), entries_.end(), [t1](const CatalogEntry& e) {
+          return e.first_ts_recv_ns <= t1;
+        });
+    const auto lo = std::partition_point(entries_.begin(), hi, [t0](const CatalogEntry& e) {
+      return e.max_last_ts_recv_ns < t0;
+    });
+    for ( auto it = lo; it != hi; ++it ) {
+      if ( it->last_ts_recv_ns >= t0 )
+        out.push_back(static_cast<std::size_t>(it - entries_.begin()));
+    }
+    return out;
+  }
+
+} // namespace md::l2
@@ -0,0 +1,293 @@
+// Per-file statistics (see snap_stats.hpp).
+// - Pass: one sweep over the records, no allocation.
+// - Sidecar: fixed-size, written to .part then renamed.
+
+#include "snap_stats.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include "file_util.hpp"
+#include "parallel_for.hpp"
+
+namespace fs = std::filesystem;
+
+namespace md::l2
+{
+
+  namespace
+  {
+
+    constexpr std::int64_t kI64Max = (std::numeric_limits<std::int64_t>::max)();
+    constexpr std::int64_t kI64Min = (std::numeric_limits<std::int64_t>::min)();
+
+    // Sidecar matches a file with these records and end timestamps
+    bool stats_match(
+        const SnapStats& st,
+        std::uint64_t records,
+        std::int64_t first,
+        std::int64_t last) noexcept
+    {
+      return st.files == 1 && st.records == records &&
+             (records == 0 || (st.first_ts_recv_ns == first && st.last_ts_recv_ns == last));
+    }
+
+    SnapStats compute_and_save(const std::string& snap_path, const ReplayKernel& rk)
+    {
+      const SnapStats st = compute_stats(std::span<const Record>(rk.begin(), rk.size()));
+      try {
+        save_stats(stats_path(snap_path), st);
+      }
+      catch ( const std::runtime_error& ) {
+        // read-only data directory: the computed stats are still good
+      }
+      return st;
+    }
+
+  } // namespace
+
+  // -------------------------
+  // Histograms
+  // -------------------------
+  std::size_t log2_bucket(std::int64_t v) noexcept
+  {
+    return v <= 0 ? 0 : static_cast<std::size_t>(std::bit_width(static_cast<std::uint64_t>(v)));
+  }
+
+  std::int64_t hist_quantile(const Log2Hist& h, double q) noexcept
+  {
+    std::uint64_t total = 0;
+    for ( const std::uint64_t c : h )
+      total += c;
+    if ( total == 0 )
+      return 0;
+    q = std::clamp(q, 0.0, 1.0);
+    const double want = std::ceil(q * static_cast<double>(total));
+    const std::uint64_t rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(want));
+    std::uint64_t seen = 0;
+    for ( std::size_t k = 0; k < h.size(); ++k ) {
+      seen += h[k];
+      if ( seen >= rank )
+        return k == 0 ? 0 : (k >= 63 ? kI64Max : std::int64_t{1} << k);
+    }
+    return kI64Max;
+  }
+
+  // -------------------------
+  // Pass / merge
+  // -------------------------
+  SnapStats compute_stats(std::span<const Record> records) noexcept
+  {
+    SnapStats st{};
+    st.files = 1;
+    st.records = records.size();
+    st.first_ts_recv_ns = records.empty() ? kI64Max : records.front().ts_recv_ns;
+    st.last_ts_recv_ns = records.empty() ? kI64Min : records.back().ts_recv_ns;
+
+    std::int64_t prev_ts = st.first_ts_recv_ns;
+    for ( const Record& r : records ) {
+      if ( r.ts_recv_ns < prev_ts ) {
+        ++st.ts_regressions;
+      }
+      else if ( &r != records.data() ) {
+        const std::int64_t gap = r.ts_recv_ns - prev_ts;
+        st.max_gap_ns = std::max(st.max_gap_ns, gap);
+        ++st.gap_hist[log2_bucket(gap)];
+      }
+      prev_ts = r.ts_recv_ns;
+      st.ts_event_missing += r.ts_event_ms == 0 ? 1u : 0u;
+
+      for ( std::size_t d = 0; d < kDepth; ++d ) {
+        if ( is_bid_active(r.bids[d]) )
+          ++st.level_qty_hist[log2_bucket(r.bids[d].qty_q)];
+        else
+          ++st.empty_bid_levels[d];
+        if ( is_ask_active(r.asks[d]) )
+          ++st.level_qty_hist[log2_bucket(r.asks[d].qty_q)];
+        else
+          ++st.empty_ask_levels[d];
+      }
+
+      const bool bid = is_bid_active(r.bids[0]);
+      const bool ask = is_ask_active(r.asks[0]);
+      if ( bid )
+        ++st.top_qty_hist[log2_bucket(r.bids[0].qty_q)];
+      if ( ask )
+        ++st.top_qty_hist[log2_bucket(r.asks[0].qty_q)];
+      if ( !bid || !ask ) {
+        st.bid_only += bid ? 1u : 0u;
+        st.ask_only += ask ? 1u : 0u;
+        st.empty_book += (!bid && !ask) ? 1u : 0u;
+        continue;
+      }
+
+      const std::int64_t spread = r.asks[0].price_q - r.bids[0].price_q;
+      st.crossed += spread < 0 ? 1u : 0u;
+      st.locked += spread == 0 ? 1u : 0u;
+      st.min_spread_q = st.top_of_book == 0 ? spread : std::min(st.min_spread_q, spread);
+      st.max_spread_q = st.top_of_book == 0 ? spread : std::max(st.max_spread_q, spread);
+      ++st.spread_hist[log2_bucket(spread)];
+      ++st.top_of_book;
+    }
+    return st;
+  }
+
+  void SnapStats::merge(const SnapStats& o) noexcept
+  {
+    if ( o.top_of_book > 0 ) {
+      min_spread_q = top_of_book == 0 ? o.min_spread_q : std::min(min_spread_q, o.min_spread_q);
+      max_spread_q = top_of_book == 0 ? o.max_spread_q : std::max(max_spread_q, o.max_spread_q);
+    }
+    if ( files == 0 ) {
+      first_ts_recv_ns = o.first_ts_recv_ns;
+      last_ts_recv_ns = o.last_ts_recv_ns;
+    }
+    else {
+      first_ts_recv_ns = std::min(first_ts_recv_ns, o.first_ts_recv_ns);
+      last_ts_recv_ns = std::max(last_ts_recv_ns, o.last_ts_recv_ns);
+    }
+    max_gap_ns = std::max(max_gap_ns, o.max_gap_ns);
+
+    files += o.files;
+    records += o.records;
+    ts_regressions += o.ts_regressions;
+    ts_event_missing += o.ts_event_missing;
+    top_of_book += o.top_of_book;
+    bid_only += o.bid_only;
+    ask_only += o.ask_only;
+    empty_book += o.empty_book;
+    crossed += o.crossed;
+    locked += o.locked;
+    for ( std::size_t d = 0; d < kDepth; ++d ) {
+      empty_bid_levels[d] += o.empty_bid_levels[d];
+      empty_ask_levels[d] += o.empty_ask_levels[d];
+    }
+    for ( std::size_t k = 0; k < kStatsHistBuckets; ++k ) {
+      gap_hist[k] += o.gap_hist[k];
+      spread_hist[k] += o.spread_hist[k];
+      top_qty_hist[k] += o.top_qty_hist[k];
+      level_qty_hist[k] += o.level_qty_hist[k];
+    }
+  }
+
+  // -------------------------
+  // Sidecar
+  // -------------------------
+  std::string stats_path(const std::string& snap_path) { return snap_path + ".stats"; }
+
+  void save_stats(const std::string& path, const SnapStats& st)
+  {
+    const fs::path final_path = path;
+    const fs::path tmp = path + ".part";
+    {
+      std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+      if ( !out )
+        throw std::runtime_error("Could not open stats for writing: " + tmp.string());
+      const StatsHeader h{};
+      out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+      out.write(reinterpret_cast<const char*>(&st), sizeof(st));
+      out.flush();
+      if ( !out )
+        throw std::runtime_error("Write failure for stats: " + tmp.string());
+    }
+
+    replace_file(tmp, final_path, "stats");
+  }
+
+  SnapStats load_stats(const std::string& path)
+  {
+    std::ifstream in(path, std::ios::binary);
+    if ( !in )
+      throw std::runtime_error("Could not open stats: " + path);
+
+    StatsHeader h{};
+    in.read(reinterpret_cast<char*>(&h), sizeof(h));
+    if ( !in )
+      throw std::runtime_error("Truncated stats header: " + path);
+    if ( h.magic != kStatsMagic )
+      throw std::runtime_error("Not a stats sidecar (bad magic): " + path);
+    if ( h.version != kStatsVersion )
+      throw std::runtime_error("Unsupported stats version: " + path);
+    if ( h.endian_check != kEndianCheck )
+      throw std::runtime_error("Stats endianness mismatch: " + path);
+    if ( h.stats_size != sizeof(SnapStats) )
+      throw std::runtime_error("Stats size mismatch: " + path);
+
+    SnapStats st{};
+    in.read(reinterpret_cast<char*>(&st), sizeof(st));
+    if ( !in )
+      throw std::runtime_error("Truncated stats: " + path);
+    return st;
+  }
+
+  // -------------------------
+  // Files / ranges
+  // -------------------------
+  SnapStats load_or_compute_stats(const std::string& snap_path)
+  {
+    const ReplayKernel rk(snap_path);
+    const std::string path = stats_path(snap_path);
+    if ( fs::exists(path) ) {
+      try {
+        const SnapStats st = load_stats(path);
+        const bool empty = rk.size() == 0;
+        const std::int64_t first = empty ? 0 : rk[0].ts_recv_ns;
+        const std::int64_t last = empty ? 0 : rk[rk.size() - 1].ts_recv_ns;
+        if ( stats_match(st, rk.size(), first, last) )
+          return st;
+      }
+      catch ( const std::runtime_error& ) {
+        // stale or corrupt sidecar: recompute below
+      }
+    }
+    return compute_and_save(snap_path, rk);
+  }
+
+  std::vector<SnapStats>
+  stats_for_files(const std::vector<std::string>& snap_paths, unsigned threads)
+  {
+    std::vector<SnapStats> out(snap_paths.size());
+    parallel_for(snap_paths.size(), threads, [&](std::size_t i) {
+      out[i] = load_or_compute_stats(snap_paths[i]);
+    });
+    return out;
+  }
+
+  SnapStats aggregate_stats(
+      const SnapCatalog& catalog,
+      std::int64_t t0,
+      std::int64_t t1,
+      unsigned threads)
+  {
+    const std::vector<std::size_t> files = catalog.overlapping(t0, t1);
+    std::vector<SnapStats> per(files.size());
+    parallel_for(files.size(), threads, [&](std::size_t k) {
+      const CatalogEntry& e = catalog.entry(files[k]);
+      const std::string snap = catalog.path(files[k]);
+      try {
+        const SnapStats st = load_stats(stats_path(snap));
+        if ( stats_match(st, e.record_count, e.first_ts_recv_ns, e.last_ts_recv_ns) ) {
+          per[k] = st;
+          return;
+        }
+      }
+      catch ( const std::runtime_error& ) {
+        // missing, stale or corrupt sidecar
+      }
+      per[k] = compute_and_save(snap, ReplayKernel(snap));
+    });
+
+    SnapStats total{};
+    total.first_ts_recv_ns = kI64Max;
+    total.last_ts_recv_ns = kI64Min;
+    for ( const SnapStats& st : per )
+      total.merge(st);
+    return total;
+  }
+
+} // namespace md::l2
@@ -0,0 +1,251 @@
+// Block zone maps (see zone_map.hpp).
+// - Build: per-block min / max, blocks spread over threads.
+// - Scan: skip blocks by range, filter survivors in parallel, concatenate in order.
+
+#include "zone_map.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include "file_util.hpp"
+#include "parallel_for.hpp"
+
+namespace fs = std::filesystem;
+
+namespace md::l2
+{
+
+  namespace
+  {
+
+    constexpr std::int64_t kI64Max = (std::numeric_limits<std::int64_t>::max)();
+    constexpr std::int64_t kI64Min = (std::numeric_limits<std::int64_t>::min)();
+
+    Zone summarise(const Record* first, std::size_t n) noexcept
+    {
+      Zone z{};
+      z.lo.fill(kI64Max);
+      z.hi.fill(kI64Min);
+      z.records = static_cast<std::uint32_t>(n);
+      for ( std::size_t i = 0; i < n; ++i ) {
+        const Record& r = first[i];
+        for ( std::size_t f = 0; f < kZoneFields; ++f ) {
+          std::int64_t v = 0;
+          if ( !zone_value(r, static_cast<ZoneField>(f), v) )
+            break; // only TsRecvNs is defined without a top of book
+          z.lo[f] = std::min(z.lo[f], v);
+          z.hi[f] = std::max(z.hi[f], v);
+        }
+        z.top_of_book += record_has_top_of_book(r) ? 1u : 0u;
+      }
+      return z;
+    }
+
+    bool matches(const Record& r, std::span<const ZonePredicate> preds) noexcept
+    {
+      for ( const ZonePredicate& p : preds ) {
+        std::int64_t v = 0;
+        if ( !zone_value(r, p.field, v) || v < p.lo || v > p.hi )
+          return false;
+      }
+      return true;
+    }
+
+  } // namespace
+
+  std::string zone_map_path(const std::string& snap_path) { return snap_path + ".zmap"; }
+
+  // -------------------------
+  // Build / load / save
+  // -------------------------
+  ZoneMap ZoneMap::build(const ReplayKernel& rk, std::size_t block_records, unsigned threads)
+  {
+    if ( block_records == 0 || block_records > UINT32_MAX )
+      throw std::runtime_error("ZoneMap: block_records must be in [1, 2^32)");
+
+    ZoneMap zm;
+    zm.header_.block_records = static_cast<std::uint32_t>(block_records);
+    zm.header_.record_count = rk.size();
+    if ( rk.size() > 0 ) {
+      zm.header_.first_ts_recv_ns = rk[0].ts_recv_ns;
+      zm.header_.last_ts_recv_ns = rk[rk.size() - 1].ts_recv_ns;
+    }
+
+    const std::size_t blocks = (rk.size() + block_records - 1) / block_records;
+    zm.zones_.resize(blocks);
+    zm.header_.zones = blocks;
+    parallel_for(blocks, threads, [&](std::size_t b) {
+      const std::size_t start = b * block_records;
+      zm.zones_[b] = summarise(rk.begin() + start, std::min(block_records, rk.size() - start));
+    });
+    return zm;
+  }
+
+  ZoneMap ZoneMap::load(const std::string& path)
+  {
+    std::ifstream in(path, std::ios::binary);
+    if ( !in )
+      throw std::runtime_error("Could not open zone map: " + path);
+
+    ZoneMap zm;
+    ZoneMapHeader& h = zm.header_;
+    in.read(reinterpret_cast<char*>(&h), sizeof(h));
+    if ( !in )
+      throw std::runtime_error("Truncated zone map header: " + path);
+    if ( h.magic != kZoneMapMagic )
+      throw std::runtime_error("Not a zone map (bad magic): " + path);
+    if ( h.version != kZoneMapVersion )
+      throw std::runtime_error("Unsupported zone map version: " + path);
+    if ( h.endian_check != kEndianCheck )
+      throw std::runtime_error("Zone map endianness mismatch: " + path);
+    if ( h.zone_size != sizeof(Zone) )
+      throw std::runtime_error("Zone map zone size mismatch: " + path);
+    if ( h.block_records == 0 ||
+         h.zones != (h.record_count + h.block_records - 1) / h.block_records )
+      throw std::runtime_error("Zone map block count mismatch: " + path);
+
+    zm.zones_.resize(static_cast<std::size_t>(h.zones));
+    if ( h.zones > 0 ) {
+      in.read(
+          reinterpret_cast<char*>(zm.zones_.data()),
+          static_cast<std::streamsize>(h.zones * sizeof(Zone)));
+      if ( !in )
+        throw std::runtime_error("Truncated zone map: " + path);
+    }
+    return zm;
+  }
+
+  ZoneMap ZoneMap::load_or_build(const std::string& snap_path, const ReplayKernel& rk)
+  {
+    const std::string path = zone_map_path(snap_path);
+    if ( fs::exists(path) ) {
+      try {
+        ZoneMap zm = load(path);
+        if ( zm.describes_file(snap_path, rk) )
+          return zm;
+      }
+      catch ( const std::runtime_error& ) {
+        // stale or corrupt sidecar: rebuild below
+      }
+    }
+
+    ZoneMap zm = build(rk);
+    try {
+      zm.stamp(snap_path);
+      zm.save(path);
+    }
+    catch ( const std::runtime_error& ) {
+      // read-only data directory: the in-memory map is still good
+    }
+    return zm;
+  }
+
+  void ZoneMap::stamp(const std::string& snap_path)
+  {
+    header_.snap_size = static_cast<std::uint64_t>(fs::file_size(snap_path));
+    header_.snap_write_time = write_time_of(snap_path);
+  }
+
+  void ZoneMap::save(const std::string& path) const
+  {
+    const fs::path final_path = path;
+    const fs::path tmp = path + ".part";
+    {
+      std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+      if ( !out )
+        throw std::runtime_error("Could not open zone map for writing: " + tmp.string());
+      out.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+      if ( !zones_.empty() )
+        out.write(
+            reinterpret_cast<const char*>(zones_.data()),
+            static_cast<std::streamsize>(zones_.size() * sizeof(Zone)));
+      out.flush();
+      if ( !out )
+        throw std::runtime_error("Write failure for zone map: " + tmp.string());
+    }
+
+    replace_file(tmp, final_path, "zone map");
+  }
+
+  // -------------------------
+  // Queries
+  // -------------------------
+  bool ZoneMap::describes(const ReplayKernel& rk) const noexcept
+  {
+    if ( header_.record_count != rk.size() )
+      return false;
+    return rk.size() == 0 || (header_.first_ts_recv_ns == rk[0].ts_recv_ns &&
+                              header_.last_ts_recv_ns == rk[rk.size() - 1].ts_recv_ns);
+  }
+
+  bool ZoneMap::describes_file(const std::string& snap_path, const ReplayKernel& rk) const
+  {
+    return describes(rk) && header_.snap_size != 0 &&
+           header_.snap_size == static_cast<std::uint64_t>(fs::file_size(snap_path)) &&
+           header_.snap_write_time == write_time_of(snap_path);
+  }
+
+  bool ZoneMap::may_match(std::size_t b, std::span<const ZonePredicate> preds) const noexcept
+  {
+    const Zone& z = zones_[b];
+    for ( const ZonePredicate& p : preds ) {
+      const auto f = static_cast<std::size_t>(p.field);
+      if ( z.hi[f] < p.lo || z.lo[f] > p.hi )
+        return false;
+    }
+    return true;
+  }
+
+  std::vector<std::uint64_t> zone_scan(
+      const ReplayKernel& rk,
+      const ZoneMap& zm,
+      std::span<const ZonePredicate> preds,
+      unsigned threads,
+      ZoneScanStats* stats)
+  {
+    if ( !zm.describes(rk) )
+      throw std::runtime_error("zone_scan: zone map does not describe this file");
+    for ( const ZonePredicate& p : preds ) {
+      if ( static_cast<std::size_t>(p.field) >= kZoneFields )
+        throw std::runtime_error("zone_scan: unknown ZoneField");
+    }
+
+    std::vector<std::size_t> candidates;
+    for ( std::size_t b = 0; b < zm.size(); ++b ) {
+      if ( zm.may_match(b, preds) )
+        candidates.push_back(b);
+    }
+
+    // One output list per candidate block, concatenated in block order
+    std::vector<std::vector<std::uint64_t>> hits(candidates.size());
+    const std::size_t block = zm.block_records();
+    parallel_for(candidates.size(), threads, [&](std::size_t k) {
+      const std::size_t start = candidates[k] * block;
+      const std::size_t stop = std::min(start + block, rk.size());
+      std::vector<std::uint64_t>& out = hits[k];
+      for ( std::size_t i = start; i < stop; ++i ) {
+        if ( matches(rk[i], preds) )
+          out.push_back(i);
+      }
+    });
+
+    std::size_t total = 0;
+    for ( const auto& h : hits )
+      total += h.size();
+    std::vector<std::uint64_t> out;
+    out.reserve(total);
+    for ( const auto& h : hits )
+      out.insert(out.end(), h.begin(), h.end());
+
+    if ( stats ) {
+      stats->blocks = zm.size();
+      stats->blocks_scanned = candidates.size();
+      stats->matched = out.size();
+    }
+    return out;
+  }
+
+} // namespace md::l2
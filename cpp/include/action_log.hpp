@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "schema.hpp"
+#include "sim.hpp"
+
+/*
+ * =============================================================================
+ *  Agent action log (record / native replay)
+ * =============================================================================
+ *
+ * A MarketSimulator with an attached ActionLog records every agent action
+ * (place_limit, place_market, cancel, set_quotes) with the step index and
+ * simulator clock at which it was issued. replay_actions() re-executes the log
+ * against the same records at native speed, optionally under different
+ * SimulatorParams (fees, alpha, latency, ...) for counterfactual evaluation.
+ *
+ * File layout (little-endian, fixed-size records):
+ *   [ActionLogHeader][ActionRecord] * header.count
+ *
+ * A SetQuotes record is followed by `order_id` QuoteLevel continuation records
+ * (price_q, qty_q and the id set_quotes returned for that entry), so the ladder
+ * is stored inline.
+ */
+
+namespace sim
+{
+
+  constexpr std::uint32_t kActionLogMagic = 0x4C41534D; // "MSAL" in little-endian
+  constexpr std::uint16_t kActionLogVersion = 2;
+
+  enum class ActionType : std::uint8_t
+  {
+    PlaceLimit = 0,
+    PlaceMarket = 1,
+    Cancel = 2,
+    SetQuotes = 3,
+    QuoteLevel = 4 // continuation of the preceding SetQuotes
+  };
+
+  struct ActionRecord
+  {
+    u64 step{0};  // MarketSimulator::step_count() when issued
+    u64 ts_ns{0}; // MarketSimulator::now() when issued
+    // PlaceLimit/PlaceMarket: id returned in the recorded run (0 = rejected)
+    // Cancel: target order id (recorded run)
+    // SetQuotes: number of QuoteLevel records that follow
+    u64 order_id{0};
+    u64 client_order_id{0};
+    i64 price_q{0};
+    i64 qty_q{0};
+    ActionType type{ActionType::PlaceLimit};
+    Side side{Side::Buy};
+    Tif tif{Tif::GTC};
+    std::uint8_t reserved[5]{};
+  };
+
+  static_assert(std::is_trivially_copyable_v<ActionRecord>);
+  static_assert(sizeof(ActionRecord) == 56);
+
+  struct ActionLogHeader
+  {
+    std::uint32_t magic{kActionLogMagic};
+    std::uint16_t version{kActionLogVersion};
+    std::uint16_t record_size{sizeof(ActionRecord)};
+    std::uint32_t endian_check{md::l2::kEndianCheck};
+    std::uint32_t reserved0{0};
+
+    // reset() arguments of the recorded run
+    u64 start_ts_ns{0};
+    i64 cash_q{0};
+    i64 position_qty_q{0};
+    i64 locked_cash_q{0};
+    i64 locked_position_qty_q{0};
+
+    // SimulatorParams of the recorded run (the replay default)
+    u64 outbound_latency_ns{0};
+    u64 observation_latency_ns{0};
+    u64 max_orders{0};
+    u64 max_events{0};
+    u64 alpha_ppm{0};
+    u64 maker_fee_ppm{0};
+    u64 taker_fee_ppm{0};
+    i64 max_abs_position_qty_q{0};
+    std::uint8_t stp{0};
+    std::uint8_t spot_no_short{1};
+    std::uint8_t stochastic_depletion{0};
+    std::uint8_t reserved1[5]{};
+    u64 rng_seed{0};
+    u64 rng_stream{0};
+    u64 outbound_latency_jitter_ns{0};
+
+    // Data alignment: ts_recv_ns of the first stepped record, and steps taken
+    i64 first_record_ts_ns{0};
+    u64 steps{0};
+
+    u64 count{0}; // number of ActionRecords
+  };
+
+  static_assert(std::is_trivially_copyable_v<ActionLogHeader>);
+  static_assert(sizeof(ActionLogHeader) == 176);
+
+  /// In-memory action log. Attach with MarketSimulator::set_action_log() before
+  /// reset(): reset() starts a fresh log from the simulator's params and ledger.
+  class ActionLog
+  {
+  public:
+    const ActionLogHeader& header() const noexcept { return header_; }
+    const std::vector<ActionRecord>& records() const noexcept { return records_; }
+
+    SimulatorParams params() const;
+    Ledger initial_ledger() const;
+    Ns start_ts() const { return Ns{header_.start_ts_ns}; }
+
+    void save(const std::string& path) const;
+    static ActionLog load(const std::string& path);
+
+  private:
+    friend class MarketSimulator;
+
+    void begin_(const SimulatorParams& params, Ns start_ts, const Ledger& ledger);
+    void on_step_(const md::l2::Record& rec);
+    void push_(const ActionRecord& r);
+
+    ActionLogHeader header_{};
+    std::vector<ActionRecord> records_;
+  };
+
+  struct ActionReplayStats
+  {
+    u64 steps{0};
+    u64 actions{0};
+    u64 places_diverged{0}; // accepted/rejected differently from the recorded run
+    u64 cancels_skipped{0}; // target was never created in the replay
+  };
+
+  /// Re-execute `log` against `records` (the same records the recorded run stepped,
+  /// starting at its first step). `ex` is reset with the log's start time and
+  /// initial ledger but keeps its own params, so constructing it with different
+  /// SimulatorParams gives a counterfactual run. Throws std::runtime_error if the
+  /// records do not line up with the recorded timestamps.
+  ActionReplayStats replay_actions(
+      MarketSimulator& ex,
+      const ActionLog& log,
+      std::span<const md::l2::Record> records);
+
+} // namespace sim
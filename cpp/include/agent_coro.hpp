@@ -0,0 +1,291 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "schema.hpp"
+#include "sim.hpp"
+
+/*
+ * =============================================================================
+ *  Coroutine agents
+ * =============================================================================
+ *
+ * A strategy is a C++20 coroutine returning AgentTask. It owns one
+ * MarketSimulator account (AgentContext::sim()) and suspends on one condition
+ * at a time:
+ *
+ *   AgentTask maker(sim::AgentContext& ctx)
+ *   {
+ *     for ( ;; ) {
+ *       const md::l2::Record& rec = co_await ctx.next_record();
+ *       const sim::u64 id = ctx.sim().place_limit(...);
+ *       if ( co_await ctx.activation(id) != sim::OrderState::Active ) continue;
+ *       if ( auto f = co_await ctx.fill(id) ) { ... }
+ *       co_await ctx.sleep_for(sim::Ns{1'000'000});
+ *     }
+ *   }
+ *
+ * AgentScheduler drives any number of agents on one thread. For each record
+ * it steps every live agent's simulator and resumes only the agents whose
+ * awaited condition fired on that step; the check is a switch on the wait
+ * kind, not a call into the agent.
+ *
+ * Orders are placed/cancelled synchronously through ctx.sim() between awaits.
+ * Awaiting anything other than the AgentContext awaitables is not supported.
+ */
+
+namespace sim
+{
+
+  class AgentScheduler;
+
+  /// Coroutine return type of an agent. Starts suspended; the scheduler runs it.
+  class AgentTask final
+  {
+  public:
+    struct promise_type
+    {
+      std::exception_ptr error;
+
+      AgentTask get_return_object() noexcept
+      {
+        return AgentTask{std::coroutine_handle<promise_type>::from_promise(*this)};
+      }
+      std::suspend_always initial_suspend() noexcept { return {}; }
+      std::suspend_always final_suspend() noexcept { return {}; }
+      void return_void() noexcept {}
+      void unhandled_exception() noexcept { error = std::current_exception(); }
+    };
+
+    AgentTask() = default;
+    AgentTask(AgentTask&& other) noexcept : h_(std::exchange(other.h_, {})) {}
+    AgentTask& operator=(AgentTask&& other) noexcept
+    {
+      if ( this != &other ) {
+        if ( h_ )
+          h_.destroy();
+        h_ = std::exchange(other.h_, {});
+      }
+      return *this;
+    }
+    AgentTask(const AgentTask&) = delete;
+    AgentTask& operator=(const AgentTask&) = delete;
+    ~AgentTask()
+    {
+      if ( h_ )
+        h_.destroy();
+    }
+
+    bool done() const noexcept { return !h_ || h_.done(); }
+
+  private:
+    friend class AgentScheduler;
+    explicit AgentTask(std::coroutine_handle<promise_type> h) noexcept : h_(h) {}
+
+    std::coroutine_handle<promise_type> h_{};
+  };
+
+  enum class AgentWait : std::uint8_t
+  {
+    None = 0, // running, or finished
+    Record = 1,
+    Fill = 2,
+    Timer = 3,
+    Activation = 4
+  };
+
+  /// Per-agent state: the simulator account and the condition it waits on.
+  class AgentContext final
+  {
+  public:
+    MarketSimulator& sim() noexcept { return *sim_; }
+    const MarketSimulator& sim() const noexcept { return *sim_; }
+
+    std::size_t id() const noexcept { return id_; }
+    AgentWait waiting_on() const noexcept { return wait_; }
+
+    /// Last record stepped (nullptr before the first step).
+    const md::l2::Record* record() const noexcept { return rec_; }
+
+    // ---- Awaitables ----
+
+    /// Resumes after the next step; yields the record just stepped.
+    auto next_record() noexcept
+    {
+      struct Awaiter
+      {
+        AgentContext& ctx;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<>) noexcept { ctx.wait_ = AgentWait::Record; }
+        const md::l2::Record& await_resume() const noexcept { return *ctx.rec_; }
+      };
+      return Awaiter{*this};
+    }
+
+    /// Yields the next undelivered fill of `order_id`, counting fills since this
+    /// agent last suspended (so a fill on the current step, or one that landed
+    /// while it slept, is not missed, and no fill is delivered twice). Yields
+    /// nullopt if the order is unknown or terminal with no such fill.
+    auto fill(u64 order_id) noexcept
+    {
+      struct Awaiter
+      {
+        AgentContext& ctx;
+        u64 order_id;
+        bool await_ready() noexcept
+        {
+          ctx.fill_scan_ = ctx.step_mark_ > ctx.fill_next_ ? ctx.step_mark_ : ctx.fill_next_;
+          ctx.fill_.reset();
+          return ctx.poll_fill_(order_id) || ctx.order_done_(order_id);
+        }
+        void await_suspend(std::coroutine_handle<>) noexcept
+        {
+          ctx.wait_ = AgentWait::Fill;
+          ctx.wait_order_ = order_id;
+        }
+        std::optional<FillEvent> await_resume() noexcept { return std::exchange(ctx.fill_, {}); }
+      };
+      return Awaiter{*this, order_id};
+    }
+
+    /// Resumes at the first step with sim().now() >= t; yields now().
+    auto sleep_until(Ns t) noexcept
+    {
+      struct Awaiter
+      {
+        AgentContext& ctx;
+        Ns t;
+        bool await_ready() const noexcept { return ctx.sim_->now() >= t; }
+        void await_suspend(std::coroutine_handle<>) noexcept
+        {
+          ctx.wait_ = AgentWait::Timer;
+          ctx.wait_until_ = t;
+        }
+        Ns await_resume() const noexcept { return ctx.sim_->now(); }
+      };
+      return Awaiter{*this, t};
+    }
+
+    auto sleep_for(Ns d) noexcept { return sleep_until(sim_->now() + d); }
+
+    /// Resumes once `order_id` has left Pending; yields its state then
+    /// (Rejected for id 0 / unknown ids).
+    auto activation(u64 order_id) noexcept
+    {
+      struct Awaiter
+      {
+        AgentContext& ctx;
+        u64 order_id;
+        bool await_ready() const noexcept
+        {
+          return ctx.order_state_(order_id) != OrderState::Pending;
+        }
+        void await_suspend(std::coroutine_handle<>) noexcept
+        {
+          ctx.wait_ = AgentWait::Activation;
+          ctx.wait_order_ = order_id;
+        }
+        OrderState await_resume() const noexcept { return ctx.order_state_(order_id); }
+      };
+      return Awaiter{*this, order_id};
+    }
+
+  private:
+    friend class AgentScheduler;
+
+    OrderState order_state_(u64 order_id) const noexcept
+    {
+      const Order* o = sim_->find_order(order_id);
+      return o ? o->state : OrderState::Rejected;
+    }
+    bool order_done_(u64 order_id) const noexcept
+    {
+      const OrderState st = order_state_(order_id);
+      return st == OrderState::Filled || st == OrderState::Cancelled ||
+             st == OrderState::Rejected;
+    }
+    // Scan fills()[fill_scan_, end) for order_id; on a match store it in fill_.
+    bool poll_fill_(u64 order_id) noexcept
+    {
+      const std::vector<FillEvent>& fills = sim_->fills();
+      for ( std::size_t i = fill_scan_; i < fills.size(); ++i ) {
+        if ( fills[i].order_id == order_id ) {
+          fill_ = fills[i];
+          fill_next_ = i + 1;
+          fill_scan_ = i + 1;
+          return true;
+        }
+      }
+      fill_scan_ = fills.size();
+      return false;
+    }
+
+    std::unique_ptr<MarketSimulator> sim_;
+    std::size_t id_ = 0;
+    const md::l2::Record* rec_ = nullptr;
+
+    AgentWait wait_ = AgentWait::None;
+    u64 wait_order_ = 0;
+    Ns wait_until_{0};
+    // Indices into sim().fills()
+    std::size_t step_mark_ = 0; // fills when this agent last suspended
+    std::size_t fill_next_ = 0; // one past the last fill delivered by fill()
+    std::size_t fill_scan_ = 0; // next fill to scan while waiting
+    std::optional<FillEvent> fill_;
+  };
+
+  /// Single-threaded driver for many coroutine agents.
+  class AgentScheduler final
+  {
+  public:
+    using Factory = std::function<AgentTask(AgentContext&)>;
+
+    struct Stats
+    {
+      u64 steps{0};   // step() calls
+      u64 resumes{0}; // coroutine resumptions (including the initial run)
+    };
+
+    /// Create an agent with its own simulator (reset to start_ts / ledger) and run
+    /// it up to its first await. Returns the agent id (its index). Exceptions from
+    /// the agent body propagate.
+    std::size_t
+    spawn(const SimulatorParams& params, Ns start_ts, Ledger ledger, const Factory& factory);
+
+    /// Step every live agent's simulator with `rec`, then resume the agents whose
+    /// condition fired. Rethrows the first exception escaping an agent.
+    void step(const md::l2::Record& rec);
+
+    /// step() over a span; stops early once every agent has finished.
+    /// Returns the number of records stepped.
+    std::size_t run(std::span<const md::l2::Record> records);
+
+    std::size_t size() const noexcept { return agents_.size(); }
+    std::size_t live() const noexcept { return live_; }
+    bool done(std::size_t id) const noexcept { return tasks_[id].done(); }
+
+    AgentContext& agent(std::size_t id) noexcept { return *agents_[id]; }
+    const AgentContext& agent(std::size_t id) const noexcept { return *agents_[id]; }
+
+    const Stats& stats() const noexcept { return stats_; }
+
+  private:
+    bool fired_(AgentContext& a) noexcept;
+    void resume_(std::size_t id);
+
+    std::vector<std::unique_ptr<AgentContext>> agents_;
+    std::vector<AgentTask> tasks_;
+    std::size_t live_ = 0;
+    Stats stats_{};
+  };
+
+} // namespace sim
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "schema.hpp"
+
+/*
+ * =============================================================================
+ *  Native depth-stream recorder: exchange JSON -> .snap, no CSV / gzip step
+ * =============================================================================
+ *
+ * Replaces the Python path (json.loads -> CSV text -> gzip -> converter) for
+ * partial-depth streams (<symbol>@depth20@100ms):
+ *
+ *   DepthTransport --payload--> parse_depth_message() --Record--> RollingSnapWriter
+ *
+ * - parse_depth_message(): single-pass scanner over one payload, no DOM and no
+ *   allocation. Understands the spot ("bids"/"asks"), futures ("b"/"a", "E")
+ *   and combined-stream ({"stream":..,"data":{..}}) shapes; other keys are
+ *   skipped. Prices and quantities go straight from their decimal text to
+ *   fixed point (parse_decimal_fixed(), exact, no float round trip).
+ * - RollingSnapWriter: one .snap per UTC hour of ts_recv_ns, named like the
+ *   converter's output (<root>/<YYYY-MM-DD>/<SYMBOL>_depth20_<YYYY-MM-DD>_<HH>.snap)
+ *   so the catalog, stats and replay tooling see no difference. Crash-safe:
+ *   records go to <file>.part with a provisional header (record_count = 0);
+ *   closing an hour truncates any partial trailing record, writes the final
+ *   count, renames, and writes the .zmap / .stats sidecars. A .part left by a
+ *   crash is resumed (same hour) or finalised by recover_parts().
+ * - DepthTransport: where payloads come from. StreamTransport reads one
+ *   payload per line from a file or stdin, so a capture can be replayed (and
+ *   a live feed piped in from any websocket client, e.g. `websocat`).
+ *
+ * Levels past kDepth are ignored; missing, unparsable or zero-quantity levels
+ * keep the schema sentinels (same policy as the converter).
+ */
+
+namespace md::l2
+{
+
+  // -------------------------
+  // Parsing
+  // -------------------------
+
+  /// Decimal text ("123.4500", "-0.5", "7") -> round(value * scale). `scale`
+  /// must be a power of ten; digits past its precision round half away from
+  /// zero. False on an empty / malformed number, exponent notation or overflow.
+  bool parse_decimal_fixed(std::string_view s, std::int64_t scale, std::int64_t& out) noexcept;
+
+  /// Fill `out` from one depth payload (sentinels first, then levels, event
+  /// time from "E" / "eventTime" if present, else 0). False if the payload is
+  /// not a JSON object or has neither a bid nor an ask array.
+  bool parse_depth_message(std::string_view json, std::int64_t ts_recv_ns, Record& out) noexcept;
+
+  /// One diff-stream event ({"e":"depthUpdate","U":..,"u":..,["pu":..,]"b":..,"a":..})
+  /// or REST depth snapshot ({"lastUpdateId":..,"bids":..,"asks":..}), all
+  /// levels kept (qty_q == 0 removes the price). See order_book.hpp.
+  struct DepthUpdate
+  {
+    bool snapshot{false};
+    std::int64_t ts_recv_ns{0};
+    std::int64_t ts_event_ms{0};      // 0 if absent
+    std::uint64_t first_update_id{0}; // U (snapshot: lastUpdateId)
+    std::uint64_t last_update_id{0};  // u (snapshot: lastUpdateId)
+    std::uint64_t prev_update_id{0};  // pu (futures streams), 0 if absent
+    std::vector<Level> bids;
+    std::vector<Level> asks;
+  };
+
+  /// Fill `out` (buffers reused) from a diff event or snapshot. False if the
+  /// payload is malformed, misses its update ids or sides, or has a level that
+  /// does not parse (price <= 0 or qty < 0).
+  bool parse_depth_update(
+      std::string_view json,
+      std::int64_t ts_recv_ns,
+      DepthUpdate& out) noexcept;
+
+  // -------------------------
+  // Transport
+  // -------------------------
+
+  /// Source of raw depth payloads (one JSON message each).
+  class DepthTransport
+  {
+  public:
+    virtual ~DepthTransport() = default;
+
+    /// Block for the next payload and its receive time (ns since epoch).
+    /// False once the transport is closed / exhausted.
+    virtual bool next(std::string& payload, std::int64_t& ts_recv_ns) = 0;
+  };
+
+  /// One payload per line: "<ts_recv_ns>\t<json>" (replayed captures keep
+  /// their timestamps) or bare "<json>" (stamped with the system clock on
+  /// read). Blank lines are skipped.
+  class StreamTransport final : public DepthTransport
+  {
+  public:
+    explicit StreamTransport(std::istream& in) : in_(&in) {}
+
+    /// Owns the file. Throws std::runtime_error if it cannot be opened.
+    explicit StreamTransport(const std::string& path);
+
+    bool next(std::string& payload, std::int64_t& ts_recv_ns) override;
+
+  private:
+    std::unique_ptr<std::ifstream> file_;
+    std::istream* in_{nullptr};
+    std::string line_;
+  };
+
+  // -------------------------
+  // Writer
+  // -------------------------
+
+  class RollingSnapWriter final
+  {
+  public:
+    /// Files go under `root` and are named after `symbol`.
+    RollingSnapWriter(std::string root, std::string symbol);
+    ~RollingSnapWriter(); // close(), errors swallowed
+
+    RollingSnapWriter(const RollingSnapWriter&) = delete;
+    RollingSnapWriter& operator=(const RollingSnapWriter&) = delete;
+
+    /// Append one record, rolling to the file of its UTC hour first if that
+    /// is later than the open one (a ts_recv_ns step back stays in the open
+    /// file). Throws std::runtime_error on I/O failure.
+    void append(const Record& r);
+
+    /// Push buffered records to the OS (the .part stays readable).
+    void flush();
+
+    /// Finalise the open file, if any.
+    void close();
+
+    /// Finalise every "<symbol>_depth20_*.snap.part" under the root except the
+    /// open one (leftovers of a crash in an earlier hour). Returns the count.
+    std::size_t recover_parts();
+
+    /// Final path of the file for the hour containing ts_recv_ns.
+    std::filesystem::path path_for(std::int64_t ts_recv_ns) const;
+
+    std::size_t files_finalised() const noexcept { return files_finalised_; }
+    std::uint64_t records_in_file() const noexcept { return records_; }
+    const std::filesystem::path& current_path() const noexcept { return final_; }
+
+  private:
+    void open_hour_(std::int64_t hour, std::int64_t ts_recv_ns);
+
+    std::filesystem::path root_;
+    std::string symbol_;
+    std::int64_t hour_{-1}; // ts_recv_ns / 1h of the open file, -1 if none
+    std::filesystem::path final_;
+    std::filesystem::path part_;
+    std::ofstream out_;
+    std::uint64_t records_{0};
+    std::size_t files_finalised_{0};
+  };
+
+  /// Truncate a .snap.part to whole records, write its record_count, rename it
+  /// to the name without ".part" and write its .zmap / .stats sidecars.
+  /// Returns the record count. Throws std::runtime_error.
+  std::uint64_t finalise_snap_part(const std::filesystem::path& part);
+
+  // -------------------------
+  // Recorder loop
+  // -------------------------
+
+  struct RecorderStats
+  {
+    std::uint64_t messages{0};     // payloads received
+    std::uint64_t records{0};      // ... written
+    std::uint64_t bad_messages{0}; // ... rejected by parse_depth_message()
+  };
+
+  /// Pull payloads from `transport` into `writer` until the transport ends or
+  /// `stop` is set (checked between payloads), flushing every `flush_every`
+  /// records (0 = never), then close the writer.
+  RecorderStats record_depth(
+      DepthTransport& transport,
+      RollingSnapWriter& writer,
+      const std::atomic<bool>& stop,
+      std::uint64_t flush_every = 500);
+
+} // namespace md::l2
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "replay.hpp"
+#include "schema.hpp"
+#include "sim.hpp"
+
+/*
+ * =============================================================================
+ *  Random episode sampler (page-cache-aware)
+ * =============================================================================
+ *
+ * Draws fixed-length episode windows over a set of .snap files, uniformly in
+ * time: a start time is drawn over the union of the files' spans (weighted by
+ * duration) and the window starts at the first record at or after it.
+ *
+ * Random windows across months of data each land on cold pages. To soften
+ * that, the sampler
+ *
+ *   - plans `lookahead` windows at a time and hands them out sorted by
+ *     (file, start), so consecutive episodes share files and nearby pages;
+ *   - keeps the next `prefetch` planned windows warm from a background thread
+ *     that touches every page of each window before it is handed out.
+ *
+ * Draws use the counter-based RNG (sim_rng.hpp) keyed on (seed, stream,
+ * episode number): the planned set of every batch, and therefore the whole
+ * sequence, depends only on the config and file list, not on timing.
+ *
+ * A handed-out EpisodeWindow is a ready-to-run cursor: a span over the file
+ * mapping (valid for the sampler's lifetime) to step a simulator through, e.g.
+ * one window per environment of a BatchedSimulator.
+ */
+
+namespace sim
+{
+
+  struct EpisodeSamplerConfig
+  {
+    std::size_t episode_records{0}; // window length (> 0)
+    std::size_t lookahead{64};      // windows planned (and reordered) per batch
+    std::size_t prefetch{8};        // planned windows kept warm ahead of the consumer
+    u64 seed{0};
+    u64 stream{0};
+  };
+
+  struct EpisodeWindow
+  {
+    u64 episode{0};        // draw number (RNG counter)
+    std::uint32_t file{0}; // index into the sampler's files
+    std::size_t start{0};  // first record index in the file
+    std::span<const md::l2::Record> records;
+  };
+
+  struct EpisodeSamplerStats
+  {
+    u64 delivered{0};  // windows handed out
+    u64 warm{0};       // ... of which were fully prefetched first
+    u64 batches{0};    // planning batches
+    u64 prefetched{0}; // windows the background thread finished touching
+    u64 pages_touched{0};
+  };
+
+  class EpisodeSampler final
+  {
+  public:
+    /// Maps every file. Files shorter than one episode are never drawn from.
+    /// Throws std::runtime_error if episode_records or lookahead is 0, or no file
+    /// holds a full episode (and whatever ReplayKernel throws).
+    EpisodeSampler(const std::vector<std::string>& snap_paths, const EpisodeSamplerConfig& cfg);
+
+    EpisodeSampler(const EpisodeSampler&) = delete;
+    EpisodeSampler& operator=(const EpisodeSampler&) = delete;
+
+    ~EpisodeSampler();
+
+    /// Next window (plans a new batch when fewer than `prefetch` remain).
+    EpisodeWindow next();
+
+    /// Next out.size() windows, e.g. one per environment.
+    void next_batch(std::span<EpisodeWindow> out);
+
+    std::size_t files() const noexcept { return kernels_.size(); }
+    const md::l2::ReplayKernel& kernel(std::size_t file) const noexcept { return kernels_[file]; }
+    const EpisodeSamplerConfig& config() const noexcept { return cfg_; }
+
+    EpisodeSamplerStats stats() const;
+
+  private:
+    EpisodeWindow draw_(u64 episode) const noexcept;
+    void plan_batch_(); // mu_ held
+    void prefetch_loop_();
+
+    EpisodeSamplerConfig cfg_{};
+    std::vector<md::l2::ReplayKernel> kernels_;
+
+    // Time-uniform draw: candidate start times of file i are
+    // [t0_[i], t0_[i] + span_[i]), laid end to end at offset cum_[i].
+    std::vector<std::uint32_t> usable_; // files holding a full episode
+    std::vector<u64> t0_;
+    std::vector<u64> span_;
+    std::vector<u64> cum_;
+    u64 total_span_ = 0;
+
+    mutable std::mutex mu_;
+    std::condition_variable cv_;
+    std::deque<EpisodeWindow> planned_; // planned_[j] is window consumed_ + j
+    u64 next_episode_ = 0;
+    u64 consumed_ = 0;
+    u64 prefetch_next_ = 0; // next window (absolute index) for the prefetcher
+    bool stop_ = false;
+    EpisodeSamplerStats stats_{};
+
+    std::thread prefetcher_;
+  };
+
+} // namespace sim
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace md::l2
+{
+
+  /// Move `from` onto `to`, replacing `to` if it exists (the last step of every
+  /// write-to-.part-then-rename in core). `what` names the file in the error.
+  /// Throws std::runtime_error.
+  inline void replace_file(
+      const std::filesystem::path& from,
+      const std::filesystem::path& to,
+      std::string_view what = "file")
+  {
+    // On Windows, rename over existing may fail; remove existing first.
+    std::error_code ec;
+    std::filesystem::remove(to, ec);
+    ec.clear();
+    std::filesystem::rename(from, to, ec);
+    if ( ec )
+      throw std::runtime_error(
+          "Failed to rename " + std::string(what) + ": " + from.string() + " -> " + to.string() +
+          " : " + ec.message());
+  }
+
+  /// Last write time of `p` as a raw count of the filesystem clock, for equality
+  /// checks against an earlier value only. Throws std::filesystem::filesystem_error.
+  inline std::int64_t write_time_of(const std::filesystem::path& p)
+  {
+    return static_cast<std::int64_t>(
+        std::filesystem::last_write_time(p).time_since_epoch().count());
+  }
+
+} // namespace md::l2
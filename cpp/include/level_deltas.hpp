@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "schema.hpp"
+
+/*
+ * =============================================================================
+ *  Per-level quantity-delta stream (derived from L2 snapshots)
+ * =============================================================================
+ *
+ * For each Record t and each visible level i, stores the signed change of the
+ * displayed quantity at that *price* versus Record t-1:
+ *
+ *   dqty_q[i] = qty_t(p_i) - qty_{t-1}(p_i)
+ *
+ * where qty_{t-1}(p) = 0 if p was not present in Record t-1 (level appeared).
+ *
+ * Price matching is done by value (not by level index), so a book that shifts
+ * by one tick yields per-price deltas rather than index-aligned noise.
+ *
+ * Additionally, each side carries:
+ * - appear_mask: bit i set iff level i of Record t is active and its price was
+ *   not present in Record t-1
+ * - vanish_mask: bit j set iff level j of Record t-1 was active and its price is
+ *   not present in Record t
+ * - next_idx[j]: index in Record t of the price at level j of Record t-1, or -1
+ *   if it vanished (or level j was inactive)
+ *
+ * next_idx lets consumers that tracked a price at a known level index in the
+ * previous record find it in the current record in O(1), without re-scanning.
+ *
+ * The stream is purely derived and optional. It is produced in one forward pass
+ * over a contiguous Record range; each output depends only on (t-1, t), so large
+ * ranges can be split into chunks and built independently.
+ */
+
+namespace md::l2
+{
+
+  static_assert(kDepth <= 32, "appear/vanish masks are 32-bit.");
+
+  struct LevelDeltaSide final
+  {
+    std::array<std::int64_t, kDepth> dqty_q; // signed qty change at price of level i
+    std::array<std::int8_t, kDepth> next_idx; // prev level j -> current level index (-1 = gone)
+    std::uint32_t appear_mask;                // bits over current levels
+    std::uint32_t vanish_mask;                // bits over previous levels
+  };
+
+  static_assert(std::is_trivially_copyable_v<LevelDeltaSide>);
+
+  struct LevelDeltaRecord final
+  {
+    LevelDeltaSide bids;
+    LevelDeltaSide asks;
+  };
+
+  static_assert(std::is_trivially_copyable_v<LevelDeltaRecord>);
+  static_assert(alignof(LevelDeltaRecord) == 8);
+
+  /**
+   * Compute the delta record for `cur` relative to `prev`.
+   * If prev is nullptr, every active level of `cur` is treated as appeared.
+   */
+  void compute_level_deltas(const Record* prev, const Record& cur, LevelDeltaRecord& out) noexcept;
+
+  /**
+   * Fill out[0..(last-first)) for the Record range [first, last).
+   *
+   * `prev_of_first` is the record preceding `first` in the stream (nullptr at
+   * stream start). Passing it allows chunked/parallel construction that is
+   * bitwise identical to a single pass.
+   */
+  void build_level_deltas(
+      const Record* first,
+      const Record* last,
+      const Record* prev_of_first,
+      LevelDeltaRecord* out) noexcept;
+
+  /**
+   * Convenience: build the delta stream for a whole range (prev_of_first = nullptr).
+   */
+  std::vector<LevelDeltaRecord> build_level_deltas(const Record* first, const Record* last);
+
+} // namespace md::l2
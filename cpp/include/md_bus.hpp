@@ -0,0 +1,254 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "replay.hpp"
+#include "schema.hpp"
+
+/*
+ * =============================================================================
+ *  Shared-memory market-data bus (one replayer, many consumer processes)
+ * =============================================================================
+ *
+ * A BusPublisher replays a `.snap` file into a lock-free single-producer /
+ * multi-consumer ring that lives in a named shared mapping. Slots carry only
+ * (sequence number, record index, publish time): every consumer maps the same
+ * `.snap` itself and reads Records zero-copy from the OS page cache, so the
+ * ring never copies market data.
+ *
+ * Consumers attach by bus name and pick a mode:
+ * - Backpressure: the publisher never overwrites a slot this consumer has not
+ *   consumed yet (the slowest Backpressure consumer paces the replay).
+ * - FreeRun: the publisher ignores this consumer. When it falls more than
+ *   `capacity` records behind it skips to half a ring behind the head and
+ *   counts the gap in dropped().
+ *
+ * Shared layout (one mapping, created by the publisher):
+ *   [BusControl][BusSlot] * capacity
+ * BusControl holds the header, the producer head and one cache-line cursor per
+ * consumer (at most kBusMaxConsumers).
+ *
+ * Names are session-local (`Local\msrl_md_bus_<name>`). A consumer joins at the
+ * live head; to see the whole stream, wait for consumers() before publishing.
+ * A Backpressure consumer that dies without detaching stalls publish(); use
+ * try_publish() to apply a timeout policy.
+ */
+
+namespace md::l2
+{
+
+  constexpr std::uint32_t kBusMagic = 0x5355424D; // "MBUS" in little-endian
+  constexpr std::uint16_t kBusVersion = 1;
+  constexpr std::size_t kBusMaxConsumers = 32;
+  constexpr std::size_t kBusMaxPath = 1024;
+
+  enum class BusMode : std::uint32_t
+  {
+    Backpressure = 1,
+    FreeRun = 2
+  };
+
+  struct BusControl; // shared layout, defined in core/md_bus.cpp
+
+  namespace detail
+  {
+    // Owns one view of a bus mapping (handle + BusControl*).
+    struct BusMapping
+    {
+      BusControl* ctl = nullptr;
+      void* handle = nullptr;
+
+      BusMapping() = default;
+      BusMapping(const BusMapping&) = delete;
+      BusMapping& operator=(const BusMapping&) = delete;
+      ~BusMapping();
+    };
+  } // namespace detail
+
+  /**
+   * BusPublisher
+   * -------------
+   * Creates the shared mapping and owns the replay cursor over the `.snap`.
+   *
+   * Threading:
+   * - One publisher per bus, driven from a single thread.
+   */
+  class BusPublisher final
+  {
+  public:
+    /**
+     * Map `snap_path` and create bus `bus_name` with a ring of `capacity`
+     * slots (power of two, >= 2).
+     *
+     * Throws std::runtime_error if the bus already exists or mapping fails.
+     */
+    BusPublisher(const std::string& bus_name, const std::string& snap_path, std::size_t capacity);
+
+    BusPublisher(const BusPublisher&) = delete;
+    BusPublisher& operator=(const BusPublisher&) = delete;
+
+    /**
+     * Closes the bus (consumers drain and then see end-of-stream) and unmaps it.
+     */
+    ~BusPublisher();
+
+    /**
+     * Publish record `record_index` of the mapped file.
+     * Blocks while a Backpressure consumer is `capacity` records behind.
+     * Returns the sequence number of the published slot.
+     *
+     * Throws std::runtime_error if record_index is out of range or the bus is closed.
+     */
+    std::uint64_t publish(std::size_t record_index);
+
+    /**
+     * Non-blocking publish(): returns false (and publishes nothing) if a
+     * Backpressure consumer would be overrun.
+     */
+    [[nodiscard]]
+    bool try_publish(std::size_t record_index);
+
+    /**
+     * Publish the next record of the replay cursor (kernel().pos()).
+     * Returns the record, or nullptr at end-of-stream.
+     */
+    const Record* publish_next();
+
+    /**
+     * Publish up to n records from the replay cursor. Returns the number published.
+     */
+    std::size_t publish_batch(std::size_t n);
+
+    /**
+     * Mark end-of-stream. Idempotent; further publishes throw.
+     */
+    void close() noexcept;
+
+    /**
+     * Number of attached consumers (both modes).
+     */
+    std::size_t consumers() const noexcept;
+
+    /**
+     * Total records published (== next sequence number).
+     */
+    std::uint64_t published() const noexcept { return head_; }
+
+    std::size_t capacity() const noexcept { return capacity_; }
+    const std::string& name() const noexcept { return name_; }
+
+    ReplayKernel& kernel() noexcept { return kernel_; }
+    const ReplayKernel& kernel() const noexcept { return kernel_; }
+
+  private:
+    bool can_publish_() noexcept;
+    void write_slot_(std::size_t record_index) noexcept;
+
+    ReplayKernel kernel_;
+    std::string name_;
+    std::size_t capacity_ = 0;
+    std::uint64_t head_ = 0;       // local copy of BusControl::head
+    std::uint64_t min_cursor_ = 0; // cached slowest Backpressure cursor
+    bool closed_ = false;
+
+    detail::BusMapping map_;
+  };
+
+  /**
+   * BusConsumer
+   * ------------
+   * Attaches to a bus by name and maps the published `.snap` read-only.
+   *
+   * Lifetime:
+   * - Pointers returned by next()/try_next() point into this consumer's own
+   *   mapping of the file and stay valid until the BusConsumer is destroyed.
+   *
+   * Threading:
+   * - One thread per BusConsumer.
+   */
+  class BusConsumer final
+  {
+  public:
+    /**
+     * Attach to `bus_name` and claim a consumer slot.
+     *
+     * Throws std::runtime_error if the bus does not exist, is not initialised
+     * yet, or all kBusMaxConsumers slots are taken.
+     */
+    BusConsumer(const std::string& bus_name, BusMode mode);
+
+    BusConsumer(const BusConsumer&) = delete;
+    BusConsumer& operator=(const BusConsumer&) = delete;
+
+    /**
+     * Releases the consumer slot (a Backpressure consumer stops pacing the publisher).
+     */
+    ~BusConsumer();
+
+    /**
+     * Wait for the next record.
+     * Returns nullptr once the publisher has closed and the ring is drained.
+     */
+    [[nodiscard]]
+    const Record* next();
+
+    /**
+     * Return the next record if one is available now, else nullptr
+     * (check finished() to tell end-of-stream from an empty ring).
+     */
+    [[nodiscard]]
+    const Record* try_next();
+
+    /**
+     * True once the publisher has closed and everything published was consumed or dropped.
+     */
+    bool finished() const noexcept;
+
+    // ---- Last record returned by next()/try_next() ----
+    std::uint64_t seq() const noexcept { return seq_; }
+    std::uint64_t record_index() const noexcept { return record_index_; }
+    std::int64_t publish_ns() const noexcept { return publish_ns_; } // steady clock, ns
+
+    /**
+     * Records published but not yet consumed.
+     */
+    std::uint64_t lag() const noexcept;
+
+    /**
+     * Records skipped after an overrun (always 0 for Backpressure consumers).
+     */
+    std::uint64_t dropped() const noexcept { return dropped_; }
+
+    BusMode mode() const noexcept { return mode_; }
+    const ReplayKernel& kernel() const noexcept { return kernel_; }
+
+  private:
+    enum class Poll
+    {
+      Ready,
+      Empty,
+      Closed
+    };
+    Poll poll_() noexcept;
+    std::string attach_(const std::string& bus_name); // fills map_, returns the snap path
+
+    detail::BusMapping map_; // opened first: holds the snap path for kernel_
+    ReplayKernel kernel_;
+    BusMode mode_ = BusMode::Backpressure;
+    std::size_t slot_ = 0;      // index into BusControl::cursors
+    std::uint64_t next_ = 0;    // next sequence number to read
+    std::uint64_t seq_ = 0;
+    std::uint64_t record_index_ = 0;
+    std::int64_t publish_ns_ = 0;
+    std::uint64_t dropped_ = 0;
+  };
+
+  /**
+   * Steady-clock timestamp in ns, the clock publish_ns() is taken on.
+   * System-wide, so comparable across processes.
+   */
+  std::int64_t bus_clock_ns() noexcept;
+
+} // namespace md::l2
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "replay.hpp"
+#include "schema.hpp"
+
+/*
+ * =============================================================================
+ *  NUMA placement for parallel replay / simulation workers
+ * =============================================================================
+ *
+ * On multi-socket hosts, workers that all read one .snap mapping pull most of
+ * it from a remote node. Three placements for the records workers read:
+ *
+ *   Shared       the kernel's file mapping as is (page cache placement)
+ *   Interleaved  one private copy, striped across nodes in kNumaStripeBytes
+ *                stripes: each stripe is first touched by a thread pinned to
+ *                its node, so the OS backs it with that node's memory
+ *   Replicated   one private copy per node, allocated on that node
+ *                (VirtualAllocExNuma) and populated by a thread pinned there
+ *
+ * NumaWorkerPool keeps `workers_per_node` threads pinned to each node and runs
+ * a job on all of them; a worker reads records(worker.node_slot).
+ *
+ * On hosts without NUMA (or where the topology cannot be read) numa_nodes()
+ * returns one node covering the process's processors, and every placement
+ * degenerates to a single local copy.
+ */
+
+namespace md::l2
+{
+
+  inline constexpr std::size_t kNumaStripeBytes = 64 * 1024;
+
+  /// One NUMA node with at least one processor (Windows processor group + mask).
+  struct NumaNode
+  {
+    std::uint32_t id{0};
+    std::uint16_t group{0};
+    std::uint64_t mask{0};
+    std::uint32_t cpus{0};
+  };
+
+  /// Nodes with processors, ordered by id. Never empty.
+  std::vector<NumaNode> numa_nodes();
+
+  /// Restrict the calling thread to `node`'s processors. Returns false on failure.
+  bool pin_current_thread(const NumaNode& node) noexcept;
+
+  enum class NumaPlacement : std::uint8_t
+  {
+    Shared = 0,
+    Interleaved = 1,
+    Replicated = 2
+  };
+
+  /// Records [start, stop) of a kernel, placed across `nodes`.
+  class NumaRecordSet final
+  {
+  public:
+    /**
+     * Copy (Interleaved / Replicated) or reference (Shared) records [start, stop).
+     * Population runs on one pinned thread per node. With Shared the kernel must
+     * outlive the set.
+     *
+     * Throws std::runtime_error if nodes is empty or an allocation fails.
+     */
+    NumaRecordSet(
+        const ReplayKernel& rk,
+        NumaPlacement placement,
+        std::span<const NumaNode> nodes,
+        std::size_t start = 0,
+        std::size_t stop = SIZE_MAX);
+
+    NumaRecordSet(const NumaRecordSet&) = delete;
+    NumaRecordSet& operator=(const NumaRecordSet&) = delete;
+
+    ~NumaRecordSet();
+
+    /// Records for workers on nodes[node_slot] (the same span unless Replicated).
+    std::span<const Record> records(std::size_t node_slot) const noexcept
+    {
+      return views_[placement_ == NumaPlacement::Replicated ? node_slot : 0];
+    }
+
+    NumaPlacement placement() const noexcept { return placement_; }
+    std::size_t size() const noexcept { return views_.front().size(); }
+
+    /// Private bytes allocated (0 for Shared).
+    std::size_t bytes_allocated() const noexcept { return bytes_allocated_; }
+
+  private:
+    NumaPlacement placement_ = NumaPlacement::Shared;
+    std::vector<std::span<const Record>> views_;
+    std::vector<void*> blocks_; // owned allocations
+    std::size_t bytes_allocated_ = 0;
+  };
+
+  /// Persistent worker threads pinned per node.
+  class NumaWorkerPool final
+  {
+  public:
+    struct Worker
+    {
+      std::size_t index{0};     // [0, size())
+      std::size_t node_slot{0}; // index into the pool's nodes
+      std::uint32_t node_id{0};
+      bool pinned{false}; // pin_current_thread() succeeded
+    };
+
+    using Job = std::function<void(const Worker&)>;
+
+    /// Start workers_per_node threads on each node (worker i runs on node i % nodes).
+    /// Throws std::runtime_error if nodes is empty or workers_per_node == 0.
+    NumaWorkerPool(std::span<const NumaNode> nodes, std::size_t workers_per_node);
+
+    NumaWorkerPool(const NumaWorkerPool&) = delete;
+    NumaWorkerPool& operator=(const NumaWorkerPool&) = delete;
+
+    ~NumaWorkerPool();
+
+    /// Run job on every worker and wait. Rethrows the first exception a job threw.
+    void run(const Job& job);
+
+    std::size_t size() const noexcept { return workers_.size(); }
+    std::size_t nodes() const noexcept { return nodes_.size(); }
+    const Worker& worker(std::size_t i) const noexcept { return workers_[i]; }
+
+  private:
+    void loop_(std::size_t i);
+
+    std::vector<NumaNode> nodes_;
+    std::vector<Worker> workers_;
+    std::vector<std::thread> threads_;
+
+    std::mutex mu_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    const Job* job_ = nullptr;
+    std::uint64_t generation_ = 0;
+    std::size_t running_ = 0;
+    std::size_t ready_ = 0; // workers pinned and waiting
+    bool stop_ = false;
+    std::exception_ptr error_;
+  };
+
+} // namespace md::l2
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include "depth_recorder.hpp"
+#include "schema.hpp"
+
+/*
+ * =============================================================================
+ *  Full-depth order book from diff streams -> top-N snapshots
+ * =============================================================================
+ *
+ * The depth20 feed gives 20 levels every 100 ms. The diff stream
+ * (<symbol>@depth@100ms, or @depth on futures) applied to a REST snapshot
+ * gives the whole book after every update. BookBuilder does that over a
+ * recorded capture and emits Records at a configured depth and cadence, so
+ * finer-grained datasets come out of the same .snap pipeline.
+ *
+ * Input: DepthUpdate (parse_depth_update()), typically replayed from a capture
+ * in the StreamTransport format in which REST snapshots ("lastUpdateId") and
+ * diff events are interleaved in receive order.
+ *
+ * Synchronisation (Binance rules):
+ * - Diffs received while unsynced are buffered (the newest max_buffered).
+ * - A snapshot with id L <= the last applied u of a synced book is stale (a
+ *   late REST response) and ignored. Otherwise the book is replaced; buffered
+ *   / later diffs with u <= L (futures: u < L) are stale and dropped. The
+ *   first applied diff must straddle L + 1 (futures: L), i.e. U <= L + 1 <= u.
+ * - Then every diff must continue the previous one: U == prev u + 1 (futures:
+ *   pu == prev u). Anything else is a gap: the book is discarded and the
+ *   builder waits (buffering) for the next snapshot.
+ *
+ * Emission: cadence_ns == 0 emits one Record after every applied update.
+ * Otherwise updates are bucketed by ts_recv_ns / cadence_ns and one Record
+ * per bucket that saw updates holds the book after its last update (stamped
+ * with that update's ts_recv_ns / ts_event_ms); it is emitted when a later
+ * bucket starts, at a gap, or at finish(). Records carry `depth` levels per
+ * side; deeper levels keep the sentinels. The .snap format is fixed at kDepth
+ * levels, so depth is at most kDepth; OrderBook::level() reads any depth.
+ *
+ * OrderBook keeps each side as a sorted vector of levels with the best price
+ * at the back: updates cluster near the top of the book, so they are found by
+ * a short scan from the back (binary search otherwise) and insert / erase
+ * moves only the few levels above them. Top-N reads are contiguous.
+ */
+
+namespace md::l2
+{
+
+  enum class BookSide : std::uint8_t
+  {
+    Bid = 0,
+    Ask = 1
+  };
+
+  class OrderBook final
+  {
+  public:
+    void clear() noexcept;
+
+    /// Set the quantity at a price; qty_q <= 0 removes the level.
+    void set(BookSide side, std::int64_t price_q, std::int64_t qty_q);
+
+    std::size_t levels(BookSide side) const noexcept;
+
+    /// i-th best level (0 = best). Requires i < levels(side).
+    Level level(BookSide side, std::size_t i) const noexcept;
+
+    /// Best bid >= best ask (false if either side is empty).
+    bool crossed() const noexcept;
+
+    /// Levels [0, depth) of each side into rec.bids / rec.asks (depth <=
+    /// kDepth), sentinels for the rest. Timestamps are left alone.
+    void top(Record& rec, std::size_t depth) const noexcept;
+
+  private:
+    std::vector<Level> bids_; // ascending price: best bid at back()
+    std::vector<Level> asks_; // descending price: best ask at back()
+  };
+
+  struct BookBuilderConfig
+  {
+    std::size_t depth{kDepth};        // levels per side in emitted Records, [1, kDepth]
+    std::int64_t cadence_ns{0};       // 0 = one Record per applied update
+    std::size_t max_buffered{65'536}; // diffs kept while waiting for a snapshot
+  };
+
+  struct BookBuilderStats
+  {
+    std::uint64_t snapshots{0};       // snapshots loaded
+    std::uint64_t stale_snapshots{0}; // ignored: not newer than the synced book
+    std::uint64_t diffs{0};
+    std::uint64_t applied{0};         // diffs applied to a synced book
+    std::uint64_t stale{0};           // diffs already covered by the snapshot
+    std::uint64_t gaps{0};            // sequence breaks (book discarded)
+    std::uint64_t buffer_dropped{0};  // oldest buffered diffs dropped (max_buffered)
+    std::uint64_t records{0};         // Records emitted
+    std::uint64_t level_updates{0};   // price levels set / removed
+    std::size_t max_levels{0};        // deepest side seen
+  };
+
+  class BookBuilder final
+  {
+  public:
+    using Sink = std::function<void(const Record&)>;
+
+    /// Throws std::runtime_error on depth outside [1, kDepth] or a negative
+    /// cadence.
+    BookBuilder(const BookBuilderConfig& cfg, Sink sink);
+
+    /// Snapshot or diff, in receive order.
+    void on_update(const DepthUpdate& u);
+
+    /// Emit the pending cadence Record, if any (end of input).
+    void finish();
+
+    bool synced() const noexcept { return synced_; }
+    std::uint64_t last_update_id() const noexcept { return last_id_; }
+    const OrderBook& book() const noexcept { return book_; }
+    const BookBuilderStats& stats() const noexcept { return stats_; }
+
+  private:
+    void buffer_(const DepthUpdate& u); // keep while unsynced, at most max_buffered
+    void load_snapshot_(const DepthUpdate& u);
+    void on_diff_(const DepthUpdate& u);
+    void applied_(const DepthUpdate& u);
+    void emit_();
+
+    BookBuilderConfig cfg_;
+    Sink sink_;
+    OrderBook book_;
+    BookBuilderStats stats_{};
+
+    bool synced_{false};
+    bool first_after_snapshot_{false};
+    std::uint64_t last_id_{0};
+    std::deque<DepthUpdate> pending_; // diffs received while not synced
+
+    bool dirty_{false}; // applied updates not yet emitted (cadence mode)
+    std::int64_t bucket_{0};
+    std::int64_t last_ts_recv_ns_{0};
+    std::int64_t last_ts_event_ms_{0};
+    Record rec_{};
+  };
+
+  struct DiffReplayStats
+  {
+    std::uint64_t messages{0};
+    std::uint64_t bad_messages{0}; // rejected by parse_depth_update()
+  };
+
+  /// Feed every payload of `transport` to `builder` until the transport ends or
+  /// `stop` is set (checked between payloads), then builder.finish().
+  DiffReplayStats replay_depth_diffs(
+      DepthTransport& transport,
+      BookBuilder& builder,
+      const std::atomic<bool>& stop);
+
+} // namespace md::l2
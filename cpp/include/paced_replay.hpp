@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+
+#include "schema.hpp"
+
+/*
+ * =============================================================================
+ *  Wall-clock paced replay
+ * =============================================================================
+ *
+ * Delivers records at their original inter-arrival times (ts_recv_ns offsets
+ * from the first record), optionally scaled by `speed`. Each record has an
+ * absolute deadline, so a slow sink delays the records behind it but does
+ * not shift the schedule: later records catch up.
+ *
+ * Waiting is hybrid: sleep until `spin_ns` before the deadline (minus the
+ * oversleep observed so far), then busy-wait on the steady clock. Records
+ * are never delivered early; the delivery lag (hand-off time - deadline) is
+ * collected into PacedReplayStats.
+ */
+
+namespace md::l2
+{
+
+  class BusPublisher;
+
+  struct PacedReplayConfig
+  {
+    double speed = 1.0;             // 2.0 = twice as fast as recorded; must be > 0
+    std::int64_t spin_ns = 200'000; // busy-wait window before each deadline
+    std::int64_t max_gap_ns = 0;    // cap on one recorded gap (e.g. session breaks); 0 = off
+  };
+
+  /// Lag distribution over power-of-two buckets: bucket 0 holds lag <= 0,
+  /// bucket k (k >= 1) holds lag in [2^(k-1), 2^k) ns.
+  struct PacedReplayStats
+  {
+    std::uint64_t delivered = 0;
+    std::int64_t lag_min_ns = 0;
+    std::int64_t lag_max_ns = 0;
+    double lag_mean_ns = 0.0;
+    std::int64_t wall_ns = 0;     // first deadline -> last hand-off
+    std::int64_t schedule_ns = 0; // scaled (and gap-capped) span of the records
+    std::array<std::uint64_t, 64> lag_hist{};
+
+    /// Upper edge of the bucket holding quantile q in [0, 1] (0 if nothing delivered).
+    std::int64_t lag_quantile_ns(double q) const noexcept;
+  };
+
+  /// Called once per record, at (or after) its deadline. `index` is the
+  /// position within the replayed span.
+  using PacedSink = std::function<void(std::size_t index, const Record& rec)>;
+
+  /// Replay `records` in real time into `sink`. Throws std::runtime_error on an
+  /// invalid config.
+  PacedReplayStats paced_replay(
+      std::span<const Record> records,
+      const PacedReplayConfig& cfg,
+      const PacedSink& sink);
+
+  /// Replay the rest of the publisher's file (from kernel().pos()) in real time
+  /// onto its shared-memory bus; hand-off is BusPublisher::publish_next().
+  PacedReplayStats paced_replay(BusPublisher& bus, const PacedReplayConfig& cfg);
+
+} // namespace md::l2
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace md::l2
+{
+
+  /// Run fn(i) for every i in [0, n) on up to `threads` threads (0 = hardware
+  /// concurrency), handing out indices one at a time. After the first exception
+  /// no new indices start; it is rethrown once all threads have joined.
+  template <class Fn>
+  void parallel_for(std::size_t n, unsigned threads, Fn&& fn)
+  {
+    if ( threads == 0 )
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, n));
+    if ( threads <= 1 ) {
+      for ( std::size_t i = 0; i < n; ++i )
+        fn(i);
+      return;
+    }
+
+    std::atomic<std::size_t> next{0};
+    std::mutex mu;
+    std::exception_ptr error;
+    std::vector<std::thread> pool;
+    pool.reserve(threads);
+    for ( unsigned t = 0; t < threads; ++t ) {
+      pool.emplace_back([&] {
+        for ( std::size_t i; (i = next.fetch_add(1)) < n; ) {
+          try {
+            fn(i);
+          }
+          catch ( ... ) {
+            std::lock_guard<std::mutex> lk(mu);
+            if ( !error )
+              error = std::current_exception();
+            next.store(n);
+          }
+        }
+      });
+    }
+    for ( std::thread& t : pool )
+      t.join();
+    if ( error )
+      std::rethrow_exception(error);
+  }
+
+} // namespace md::l2
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <span>
 #include <string>
 
 #include "schema.hpp"
@@ -9,6 +11,29 @@
 namespace md::l2
 {
 
+  /**
+   * Follow mode: tail a .snap that is still being written (the recorder's
+   * <file>.snap.part, see depth_recorder.hpp).
+   *
+   * - The header may be provisional (record_count == 0) and the payload may end
+   *   in a partially written record; only whole records are exposed.
+   * - When the cursor reaches the visible end, next()/next_batch() wait: check
+   *   the file size, spin `spin_polls` times with a CPU pause, then sleep
+   *   `poll_ns` between checks (polling: the kernel is Windows-only and a
+   *   change notification per flush would not be cheaper). Growth remaps the
+   *   file to its new whole-record length.
+   * - End-of-stream: the writer finalised the file (record_count written) and
+   *   the cursor reached it, `stop` was set, or no record arrived for
+   *   idle_timeout_ns.
+   */
+  struct FollowConfig
+  {
+    std::int64_t poll_ns = 1'000'000;        // sleep between size checks; must be > 0
+    std::uint32_t spin_polls = 0;            // size checks before the first sleep
+    std::int64_t idle_timeout_ns = 0;        // 0 = wait for the writer indefinitely
+    const std::atomic<bool>* stop = nullptr; // optional; checked while waiting
+  };
+
   /**
    * ReplayKernel
    * -------------
@@ -23,7 +48,8 @@ namespace md::l2
    * Lifetime:
    * - ReplayKernel owns the memory mapping.
    * - Pointers returned by next()/data()/begin()/end() remain valid
-   *   until the ReplayKernel is destroyed.
+   *   until the ReplayKernel is destroyed (follow mode: until the file is
+   *   remapped, see poll()).
    *
    * Threading:
    * - Intended usage is single-threaded replay in simulators/benchmarks.
@@ -43,6 +69,19 @@ namespace md::l2
      */
     explicit ReplayKernel(const std::string& snap_path);
 
+    /**
+     * Follow a `.snap` that a writer is still appending to (see FollowConfig).
+     *
+     * The file is shared for writing, renaming and truncation by its writer.
+     * Waits for the header if the file is still shorter than one (same rules
+     * as next()); then validates it like the plain constructor, except that
+     * record_count may be 0 and a trailing partial record is not an error.
+     *
+     * Throws std::runtime_error on failure, an invalid config, or if the
+     * header does not appear before end-of-stream.
+     */
+    ReplayKernel(const std::string& snap_path, const FollowConfig& follow);
+
     // Non-copyable: mapping ownership must be unique
     ReplayKernel(const ReplayKernel&) = delete;
     ReplayKernel& operator=(const ReplayKernel&) = delete;
@@ -55,6 +94,7 @@ namespace md::l2
 
     /**
      * Total number of records in the mapped file.
+     * Follow mode: records visible so far (grows as the file is followed).
      */
     std::size_t size() const noexcept { return size_; }
 
@@ -81,9 +121,33 @@ namespace md::l2
      * - No allocations
      * - No Record copies
      * - One predictable branch (end-of-stream)
+     *
+     * Follow mode: at the visible end, waits for the writer (see FollowConfig).
+     * Throws std::runtime_error if the grown file cannot be remapped.
+     */
+    [[nodiscard]]
+    const Record* next();
+
+    /**
+     * Advance the replay cursor by up to n records and return them as a
+     * contiguous span over the mapping.
+     *
+     * Returns an empty span at end-of-stream. The last batch may be shorter
+     * than n.
+     *
+     * Follow mode: waits like next() only if no record is visible, then
+     * returns what is available (possibly fewer than n).
+     */
+    [[nodiscard]]
+    std::span<const Record> next_batch(std::size_t n);
+
+    /**
+     * Lookback window: the last (up to) k records already returned by
+     * next()/next_batch(), i.e. [max(0, pos()-k), pos()).
+     * Does not move the cursor.
      */
     [[nodiscard]]
-    const Record* next() noexcept;
+    std::span<const Record> window(std::size_t k) const noexcept;
 
     /**
      * Pointer to the first record.
@@ -110,6 +174,26 @@ namespace md::l2
      */
     const Record& operator[](std::size_t idx) const noexcept { return data_[idx]; }
 
+    // ---- Follow mode ----
+
+    bool following() const noexcept { return follow_; }
+
+    /**
+     * Check the file for new whole records without waiting and remap if it
+     * grew. Returns the number of records that became visible (always 0 when
+     * not following). Throws std::runtime_error if remapping fails.
+     *
+     * Remapping moves the records: pointers and spans obtained before a
+     * poll() / waiting next() / next_batch() that grew the file are invalid.
+     */
+    std::size_t poll();
+
+    /**
+     * End of the data: the cursor is at size() and, when following, the
+     * writer has finalised the file.
+     */
+    bool finished() const noexcept;
+
   private:
     // ---- Memory-mapped region ----
     const Record* data_ = nullptr; // start of records
@@ -122,9 +206,16 @@ namespace md::l2
     void* file_handle_ = nullptr;
     void* mapping_handle_ = nullptr;
 
+    // ---- Follow mode ----
+    bool follow_ = false;
+    bool final_ = false; // writer wrote record_count and all of it is mapped
+    FollowConfig follow_cfg_{};
+
     // ---- Helpers ----
     void map_file_(const std::string& path);
     void unmap_file_() noexcept;
+    void remap_(std::size_t records);
+    bool wait_for_records_();
   };
 
 } // namespace md::l2
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "replay.hpp"
+#include "schema.hpp"
+
+/*
+ * =============================================================================
+ *  Pipelined replay (record source on one core, simulator on another)
+ * =============================================================================
+ *
+ * ReplayPipeline runs a record source (decode, merge, derived fields, or a
+ * plain copy out of a mapping) on a producer thread and hands batches of
+ * Records to the consuming thread through a lock-free single-producer /
+ * single-consumer ring:
+ *
+ *   source(span<Record> out) -> count   [producer thread]
+ *       -> ring of `depth` slots x `batch_records` Records
+ *   next_batch() -> span<const Record>  [consumer thread]
+ *
+ * The producer and consumer indices sit on separate cache lines and each side
+ * caches the other's index, so the shared lines move once per batch rather
+ * than once per record. next_batch() software-prefetches the head of the batch
+ * it returns (the producer wrote it, so it is hot in another core's cache).
+ */
+
+namespace md::l2
+{
+
+  class ReplayPipeline final
+  {
+  public:
+    /// Fill `out` with up to out.size() records; return the number written.
+    /// Returning 0 ends the stream. Runs on the producer thread; exceptions are
+    /// rethrown from next_batch() on the consumer thread.
+    using Source = std::function<std::size_t(std::span<Record> out)>;
+
+    /**
+     * Start the producer thread.
+     * batch_records >= 1; depth (number of ring slots) >= 2.
+     *
+     * Throws std::runtime_error on invalid sizes.
+     */
+    ReplayPipeline(Source source, std::size_t batch_records = 256, std::size_t depth = 8);
+
+    ReplayPipeline(const ReplayPipeline&) = delete;
+    ReplayPipeline& operator=(const ReplayPipeline&) = delete;
+
+    /**
+     * Stops the producer (even if it is waiting for a free slot) and joins it.
+     */
+    ~ReplayPipeline();
+
+    /**
+     * Release the previous batch and wait for the next one.
+     *
+     * Returns an empty span at end-of-stream. The span is valid until the
+     * next call (its slot is then handed back to the producer).
+     */
+    [[nodiscard]]
+    std::span<const Record> next_batch();
+
+    std::size_t batch_records() const noexcept { return batch_; }
+    std::size_t depth() const noexcept { return depth_; }
+
+    /**
+     * Number of records handed to the consumer so far.
+     */
+    std::uint64_t delivered() const noexcept { return delivered_; }
+
+  private:
+    void produce_() noexcept;
+
+    Source source_;
+    std::size_t batch_ = 0;
+    std::size_t depth_ = 0;
+    std::vector<Record> buf_;         // depth_ slots of batch_ records
+    std::vector<std::size_t> counts_; // records in each slot
+
+    // Producer side: slots published. Consumer reads it.
+    alignas(64) std::atomic<std::uint64_t> head_{0};
+    std::atomic<bool> done_{false}; // producer finished (end-of-stream or error)
+    std::exception_ptr error_;      // written before done_
+
+    // Consumer side: slots released. Producer reads it.
+    alignas(64) std::atomic<std::uint64_t> tail_{0};
+    std::atomic<bool> stop_{false};
+
+    // Consumer-private
+    alignas(64) std::uint64_t head_cache_ = 0;
+    bool holding_ = false; // a batch is checked out
+    std::uint64_t delivered_ = 0;
+
+    std::thread producer_;
+  };
+
+  /// Source that copies [start, stop) out of a mapped kernel in batches (the
+  /// pipelined equivalent of next_batch() on the kernel itself). The kernel
+  /// must outlive the pipeline.
+  ReplayPipeline::Source
+  kernel_source(const ReplayKernel& rk, std::size_t start = 0, std::size_t stop = SIZE_MAX);
+
+} // namespace md::l2
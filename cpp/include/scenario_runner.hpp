@@ -0,0 +1,207 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "schema.hpp"
+#include "sim.hpp"
+
+namespace sim
+{
+
+  /// Scenario loop configuration. Mirrors microstructure_rl.spec.ScenarioSpec; the
+  /// simulator params/ledger are built by the caller exactly as the Python runner does.
+  struct ScenarioConfig
+  {
+    SimulatorParams params{};
+    Ledger initial_ledger{};
+    Ns start_ts{0};
+
+    u64 max_steps{0}; // 0 => run to end of records
+    u64 warmup_steps{1000};
+    u64 order_every_steps{5000}; // 0 disables the demo quoting policy
+    u64 check_every_steps{5000}; // checkpoint cadence; 0 => final checkpoint only
+    u64 conservation_every_steps{5000}; // fill-conservation cadence (every step if strict)
+
+    i64 qty_q{1};
+    i64 tick_q{1};
+
+    i64 cash_residual_tolerance_q{1};
+    i64 pos_residual_tolerance_q{0};
+    bool strict{false};
+
+    bool enable_markout{true};
+    std::vector<u64> markout_horizons_steps{100, 1000, 10000};
+  };
+
+  enum class LogLevel : std::uint8_t
+  {
+    Info = 0,
+    Warning = 1,
+    Error = 2
+  };
+
+  /// Log line produced by the loop; the caller forwards these to its logger.
+  struct LogLine
+  {
+    LogLevel level{LogLevel::Info};
+    std::string text;
+  };
+
+  /// One audit.jsonl row (InvariantChecker.check_accounting_residual + ts_ns).
+  struct AuditRow
+  {
+    u64 step{0};
+    i64 cash_q{0};
+    i64 locked_cash_q{0};
+    i64 cash_total_q{0};
+    i64 expected_cash_q{0};
+    i64 cash_residual_q{0};
+    i64 cash_residual_bound_q{0};
+    std::optional<i64> inferred_price_scale;
+    bool overflow_risk_flag{false};
+    std::optional<i64> mid_q;
+    std::optional<i64> wealth_mtm_q;
+    bool pass{true};
+    u64 ts_ns{0};
+  };
+
+  /// One completed markout.csv row; markout_price_q[i] is for markout_horizons()[i].
+  struct MarkoutRow
+  {
+    u64 fill_idx{0};
+    u64 fill_ts_ns{0};
+    u64 order_id{0};
+    LiquidityFlag liq{LiquidityFlag::Maker};
+    Side side{Side::Buy};
+    i64 qty_q{0};
+    i64 fill_price_q{0};
+    i64 mid0_q{0};
+    u64 step0{0};
+    std::vector<i64> markout_price_q;
+  };
+
+  /// Accumulated InvariantChecker accounting state (metrics.json "accounting").
+  struct AccountingSummary
+  {
+    u64 fills_seen{0};
+    i64 expected_cash_q{0};
+    i64 expected_fee_cash_q{0};
+    i64 max_cash_residual_q{0};
+    i64 max_cash_bound_q{0};
+    std::optional<i64> inferred_price_scale;
+    bool overflow_risk_flag{false};
+  };
+
+  /// Output of one checkpoint: the new fills/events are
+  /// simulator().fills()[fills_begin, fills_end) and events()[events_begin, events_end).
+  struct ScenarioCheckpoint
+  {
+    u64 step{0};
+    std::size_t fills_begin{0};
+    std::size_t fills_end{0};
+    std::size_t events_begin{0};
+    std::size_t events_end{0};
+    AuditRow audit{};
+  };
+
+  /// Native scenario loop: step, fill conservation, markouts, demo quoting and
+  /// checkpoint audits, with the same semantics (and therefore the same artifacts)
+  /// as the Python loop in microstructure_rl.runner. The caller owns artifact I/O:
+  ///
+  ///   while ( runner.advance() ) { write runner.checkpoint(); runner.take_logs(); }
+  ///
+  /// Strict-mode conservation failures throw std::runtime_error, like the Python loop.
+  class ScenarioRunner final
+  {
+  public:
+    // records must outlive the runner (typically a ReplayKernel mapping).
+    ScenarioRunner(const ScenarioConfig& cfg, std::span<const md::l2::Record> records);
+
+    // Run until the next checkpoint (the last one is the final flush).
+    // Returns false once the run has finished and no checkpoint was produced.
+    bool advance();
+
+    bool done() const noexcept { return done_; }
+    const ScenarioCheckpoint& checkpoint() const noexcept { return checkpoint_; }
+    const MarketSimulator& simulator() const noexcept { return ex_; }
+
+    // Log lines since the last call (moved out).
+    std::vector<LogLine> take_logs() { return std::exchange(logs_, {}); }
+
+    u64 steps() const noexcept { return steps_; }
+    u64 placed_orders() const noexcept { return placed_orders_; }
+    u64 failures() const noexcept { return failures_; }
+    std::size_t fills_seen() const noexcept { return last_fills_n_; }
+    std::size_t events_seen() const noexcept { return last_events_n_; }
+    const AccountingSummary& accounting() const noexcept { return acc_; }
+
+    // Sorted, de-duplicated positive horizons (column order of markout rows).
+    const std::vector<u64>& markout_horizons() const noexcept { return horizons_; }
+    const std::vector<MarkoutRow>& markout_rows() const noexcept { return markout_done_; }
+
+  private:
+    struct PendingMarkout
+    {
+      MarkoutRow row;
+      std::vector<bool> done;
+      std::size_t n_done{0};
+    };
+
+    void step_once_(const md::l2::Record& rec);
+    void check_conservation_();
+    void place_quotes_(i64 mid_q);
+    void run_checkpoint_(const md::l2::Record& rec);
+    void update_markouts_(i64 mid_q);
+    void log_(LogLevel level, std::string text);
+
+    ScenarioConfig cfg_;
+    std::span<const md::l2::Record> records_;
+    MarketSimulator ex_;
+
+    std::size_t next_rec_{0};
+    bool finished_{false}; // loop ended; only the final checkpoint remains
+    const md::l2::Record* final_rec_{nullptr};
+    bool done_{false};
+
+    u64 steps_{0};
+    u64 placed_orders_{0};
+    u64 failures_{0};
+
+    // FillConservation (ledger totals vs realised fill cashflows)
+    i64 c0_{0};
+    i64 p0_{0};
+    i64 realised_cash_delta_q_{0};
+    i64 realised_pos_delta_q_{0};
+    std::size_t fills_cursor_{0};
+
+    // InvariantChecker (checkpoint cadence)
+    AccountingSummary acc_{};
+    std::set<u64> reject_ids_;
+    std::size_t last_fills_n_{0};
+    std::size_t last_events_n_{0};
+
+    // MarkoutTracker
+    std::vector<u64> horizons_;
+    std::vector<PendingMarkout> markout_pending_;
+    std::vector<MarkoutRow> markout_done_;
+    u64 markout_fill_counter_{0};
+
+    ScenarioCheckpoint checkpoint_{};
+    std::vector<LogLine> logs_;
+  };
+
+  /// Enum names as exposed by the Python bindings (used in rows and messages).
+  const char* to_string(Side v) noexcept;
+  const char* to_string(LiquidityFlag v) noexcept;
+  const char* to_string(EventType v) noexcept;
+  const char* to_string(OrderState v) noexcept;
+  const char* to_string(RejectReason v) noexcept;
+
+} // namespace sim
@@ -9,9 +9,11 @@
 #include <memory_resource>
 #include <optional>
 #include <queue>
+#include <span>
 #include <vector>
 
-#include "schema.hpp" // md::l2::Record
+#include "level_deltas.hpp" // md::l2::LevelDeltaRecord
+#include "schema.hpp"       // md::l2::Record
 
 #ifndef SIM_ASSERT
 #  define SIM_ASSERT(x) assert(x)
@@ -142,6 +144,22 @@ namespace sim
 
     FeeSchedule fees{};
     RiskLimits risk{};
+
+    // Record state_digest() every N steps into digest_trail(). 0 => no trail.
+    u64 digest_every_steps{0};
+
+    // Stochastic extensions (sim_rng.hpp). Draws are keyed on (rng_seed, rng_stream,
+    // order id / price bucket, step), so results do not depend on how environments are
+    // split across threads or processes. Give every environment its own rng_stream.
+    u64 rng_seed{0};
+    u64 rng_stream{0};
+
+    // activate_ts = submit + outbound_latency + U[0, outbound_latency_jitter], per order.
+    Ns outbound_latency_jitter{0};
+
+    // Attribute a bucket's depletion in full with probability alpha_ppm / 1e6 (drawn
+    // per step and bucket) instead of the deterministic alpha_ppm share.
+    bool stochastic_depletion{false};
   };
 
   /// Portfolio ledger. All values in fixed-point int64.
@@ -185,6 +203,31 @@ namespace sim
     u64 order_id{0};
   };
 
+  /// Entry of the per-N-step state digest trail (SimulatorParams::digest_every_steps).
+  struct DigestCheckpoint
+  {
+    u64 step{0}; // step_count() at the checkpoint
+    Ns ts{0};
+    u64 digest{0};
+  };
+
+  /// Index of the first checkpoint at which two trails (same cadence) differ, or the
+  /// shorter length if they agree. A rolling digest stays different once it diverges,
+  /// so this is a binary search; the divergent step lies in (trail[i-1].step, trail[i].step].
+  std::size_t first_divergence(
+      std::span<const DigestCheckpoint> a,
+      std::span<const DigestCheckpoint> b) noexcept;
+
+  class ActionLog;                      // action_log.hpp
+  enum class ActionType : std::uint8_t; // action_log.hpp
+
+  /// One desired ladder level for MarketSimulator::set_quotes().
+  struct QuoteLevel
+  {
+    i64 price_q{0};
+    i64 qty_q{0}; // <= 0 => no quote at this price
+  };
+
   /// Minimal order object stored in the simulator.
   struct alignas(64) Order
   {
@@ -278,6 +321,12 @@ namespace sim
     // Sets market_ to a step-scoped pointer for internal helpers.
     void step(const md::l2::Record& rec);
 
+    // Same as step(rec), with the precomputed delta-stream entry for rec
+    // (see level_deltas.hpp). deltas must be computed against the record passed
+    // to the previous step() call; depletion then reads per-price deltas directly
+    // instead of re-finding each bucket price in the snapshot.
+    void step(const md::l2::Record& rec, const md::l2::LevelDeltaRecord& deltas);
+
     // Place orders. Return assigned simulator order_id (0 if rejected).
     [[nodiscard]] u64 place_limit(const LimitOrderRequest& req);
     [[nodiscard]] u64 place_market(const MarketOrderRequest& req);
@@ -286,6 +335,29 @@ namespace sim
     // If the order is still PENDING, cancellation is allowed (releases locks).
     bool cancel(u64 order_id);
 
+    // Reconcile this side's live (PENDING/ACTIVE/PARTIAL) orders to a desired ladder,
+    // price bucket by price bucket. At each ladder price, live orders are kept in queue
+    // order while their remaining qty fits the target (queue position preserved), the
+    // others are cancelled and any shortfall is placed as one new GTC order. Live orders
+    // at prices not in the ladder are cancelled. All cancels are issued before places.
+    // Returns one id per ladder entry: the front kept order, else the new order (0 if
+    // nothing rests there, e.g. rejected place). Repeated prices are summed.
+    std::vector<u64> set_quotes(Side side, std::span<const QuoteLevel> ladder);
+
+    // Optional action recording (see action_log.hpp). Non-owning; nullptr disables.
+    // Attach before reset(): reset() starts a fresh log.
+    void set_action_log(ActionLog* log) noexcept { action_log_ = log; }
+    ActionLog* action_log() const noexcept { return action_log_; }
+
+    // Number of step() calls since reset() (the step index recorded with actions).
+    u64 step_count() const noexcept { return step_count_; }
+
+    // Rolling 64-bit digest of the run so far: reset() inputs, every lifecycle event,
+    // every fill (with the order state it produced) and, per step, the clock and
+    // ledger. Equal digests at step k <=> identical runs up to k (modulo collisions).
+    u64 state_digest() const noexcept { return digest_; }
+    const std::vector<DigestCheckpoint>& digest_trail() const noexcept { return digest_trail_; }
+
     // --- Accessors (intended to be O(1)) ---
     Ns now() const { return now_; }
     const SimulatorParams& params() const { return params_; }
@@ -296,8 +368,40 @@ namespace sim
     const std::vector<Event>& events() const { return events_; }
     const std::vector<FillEvent>& fills() const { return fills_; }
 
+    // O(1) lookup by simulator order id via id_to_index_.
+    // order_index() returns kInvalidIndex for unknown ids; find_order() returns nullptr.
+    u64 order_index(u64 order_id) const noexcept
+    {
+      if ( order_id == 0 || order_id >= id_to_index_.size() )
+        return kInvalidIndex;
+      return id_to_index_[order_id];
+    }
+    const Order* find_order(u64 order_id) const noexcept
+    {
+      const u64 idx = order_index(order_id);
+      return (idx == kInvalidIndex) ? nullptr : &orders_[idx];
+    }
+
+    // Bumped whenever orders()/events()/fills() storage may have moved or been
+    // cleared (reset(), fill-log reallocation). External views over the raw
+    // vectors (e.g. zero-copy numpy arrays) are valid only while it is unchanged.
+    // orders_/events_ are reserved to their hard caps, so they never reallocate.
+    u64 storage_version() const noexcept { return storage_version_; }
+
   private:
     // --- Internal helpers ---
+    // Unrecorded place/cancel (set_quotes records the ladder, not its parts).
+    u64 place_limit_(const LimitOrderRequest& req);
+    bool cancel_(u64 order_id);
+    void log_action_(
+        ActionType type,
+        Side side,
+        Tif tif,
+        i64 price_q,
+        i64 qty_q,
+        u64 client_order_id,
+        u64 order_id);
+
     RejectReason validate_limit_(const LimitOrderRequest& req) const;
     RejectReason validate_market_(const MarketOrderRequest& req) const;
 
@@ -337,6 +441,9 @@ namespace sim
     // Step-scoped, read-only view of current market state.
     const md::l2::Record* market_{nullptr};
 
+    // Step-scoped, optional delta-stream entry for market_ (nullptr if not provided).
+    const md::l2::LevelDeltaRecord* deltas_{nullptr};
+
     // Orders stored in insertion order; simulator order_id maps to index via id_to_index_.
     std::vector<Order> orders_;
 
@@ -344,7 +451,14 @@ namespace sim
     // Sized to params_.max_orders + 1 in reset().
     std::vector<u64> id_to_index_;
 
-    std::priority_queue<PendingEntry, std::vector<PendingEntry>, PendingCmp> pending_;
+    // priority_queue with read access to the heap storage, so set_quotes() can
+    // enumerate pending orders without draining the queue.
+    struct PendingQueue : std::priority_queue<PendingEntry, std::vector<PendingEntry>, PendingCmp>
+    {
+      const std::vector<PendingEntry>& entries() const noexcept { return c; }
+    };
+
+    PendingQueue pending_;
     u64 next_order_id_{1};
     u64 next_seq_{1};
 
@@ -393,6 +507,36 @@ namespace sim
     // Fill log (separate from lifecycle events).
     std::vector<FillEvent> fills_;
 
+    // See storage_version().
+    u64 storage_version_{0};
+
+    ActionLog* action_log_{nullptr};
+    u64 step_count_{0};
+
+    // See state_digest(); folded in push_event_(), apply_fill_() and digest_step_().
+    u64 digest_{0};
+    std::vector<DigestCheckpoint> digest_trail_;
+    void digest_step_();
+
+    // set_quotes() scratch, reused across calls (no per-step allocation once warm).
+    struct QuoteLive
+    {
+      i64 price_q;
+      u64 rank; // queue order within a price: resting FIFO, then pending by seq
+      u64 order_id;
+      i64 remaining_q;
+    };
+    struct QuoteWant
+    {
+      i64 price_q;
+      i64 qty_q;
+      i64 shortfall_q;
+      u64 id;
+    };
+    std::vector<QuoteLive> quote_live_;
+    std::vector<QuoteWant> quote_want_;
+    std::vector<u64> quote_cancel_;
+
     // Apply a single fill (updates ledger, unlocks, emits FillEvent).
     void apply_fill_(Order& o, i64 price_q, i64 qty_q, LiquidityFlag liq);
 
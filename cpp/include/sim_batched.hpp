@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "schema.hpp"
+#include "sim.hpp"
+
+/*
+ * =============================================================================
+ *  Lockstep batched simulator (many small environments, structure-of-arrays)
+ * =============================================================================
+ *
+ * BatchedSimulator runs N independent accounts ("environments") with the same
+ * matching rules as MarketSimulator, but stores them column-wise instead of as
+ * N object graphs:
+ *
+ *   per env :  clock, ledger, activation FIFO
+ *   per slot:  state / side / price / qty / filled / qty_ahead / bucket queue
+ *              state, laid out slot-major ([slot * envs + env])
+ *
+ * Each environment holds at most `slots` live (pending or resting) orders. A
+ * slot is reused once its order is terminal; order handles are slot + 1 (0
+ * means rejected), so a handle only names the slot's current order.
+ *
+ * step() advances every environment by one record (shared, or each env's own
+ * index into a record span) as a sequence of passes over the batch:
+ *
+ *   1) queue pass      for each slot, over all envs: level lookup, bucket
+ *                      visibility state machine, trade-through, depletion
+ *   2) passive fills   envs with depletion only: FIFO allocation per price
+ *   3) aggressive      envs with marketable orders only: sweep visible depth
+ *   4) activation      envs with due pending orders only: STP, queue init
+ *
+ * Pass 1 is branch-light per element and runs over contiguous per-slot
+ * columns; the sequential passes are gated per env so idle environments cost a
+ * mask test. Ledger arithmetic and queue initialisation are the scalar ones
+ * (sim_fixed_point.hpp, sim_queue.hpp).
+ *
+ * Conformance: for the same params, records and actions, each environment
+ * matches a fresh MarketSimulator in ledger, clock, order states, filled and
+ * queue-ahead quantities. Not modelled: event/fill logs (fill_count() only),
+ * max_orders/max_events (replaced by the slot capacity), observation latency,
+ * action logs, digests and delta-stream steps.
+ */
+
+namespace sim
+{
+
+  class BatchedSimulator final
+  {
+  public:
+    static constexpr std::size_t kMaxSlots = 64;
+
+    /// Uses params.outbound_latency, alpha_ppm, stp, fees, risk and the stochastic
+    /// fields; env e draws as a MarketSimulator with rng_stream = params.rng_stream + e.
+    /// Throws std::runtime_error unless envs >= 1 and 1 <= slots <= kMaxSlots.
+    BatchedSimulator(const SimulatorParams& params, std::size_t envs, std::size_t slots);
+
+    // Reset every env, or one env (e.g. at its episode boundary).
+    void reset(Ns start_ts, const Ledger& initial_ledger);
+    void reset(std::size_t env, Ns start_ts, const Ledger& initial_ledger);
+
+    /// Same validation and locking as MarketSimulator::place_limit. Returns the
+    /// order handle (slot + 1), or 0 if rejected or every slot is live.
+    [[nodiscard]] u64 place_limit(std::size_t env, const LimitOrderRequest& req);
+
+    /// Cancel a pending or resting order; false if the handle is not live.
+    bool cancel(std::size_t env, u64 handle);
+
+    /// Step every env with the same record.
+    void step(const md::l2::Record& rec);
+
+    /// Step env e with records[index[e]]. index.size() must equal envs().
+    /// Throws std::runtime_error on a size mismatch or out-of-range index.
+    void step(std::span<const md::l2::Record> records, std::span<const std::uint32_t> index);
+
+    /// Step env e with *records[e] (e.g. each env's own episode window).
+    /// Throws std::runtime_error unless records.size() == envs() and none is null.
+    void step(std::span<const md::l2::Record* const> records);
+
+    std::size_t envs() const noexcept { return envs_; }
+    std::size_t slots() const noexcept { return slots_; }
+    const SimulatorParams& params() const noexcept { return params_; }
+
+    Ns now(std::size_t env) const noexcept { return Ns{now_[env]}; }
+    Ledger ledger(std::size_t env) const noexcept
+    {
+      return Ledger{cash_[env], position_[env], locked_cash_[env], locked_position_[env]};
+    }
+    /// Number of fills applied since the env's reset.
+    u64 fill_count(std::size_t env) const noexcept { return fill_count_[env]; }
+
+    // Per-order views. Unknown handles read as Rejected / 0.
+    OrderState order_state(std::size_t env, u64 handle) const noexcept
+    {
+      return valid_(handle) ? state_[at_(env, handle)] : OrderState::Rejected;
+    }
+    i64 filled_qty(std::size_t env, u64 handle) const noexcept
+    {
+      return valid_(handle) ? filled_[at_(env, handle)] : 0;
+    }
+    i64 qty_ahead(std::size_t env, u64 handle) const noexcept
+    {
+      return valid_(handle) ? ahead_[at_(env, handle)] : 0;
+    }
+
+  private:
+    bool valid_(u64 handle) const noexcept { return handle != 0 && handle <= slots_; }
+    std::size_t at_(std::size_t env, u64 handle) const noexcept
+    {
+      return static_cast<std::size_t>(handle - 1) * envs_ + env;
+    }
+
+    void step_();
+    void queue_pass_();
+    void passive_fills_(std::size_t env);
+    void aggressive_fills_(std::size_t env);
+    void activate_due_(std::size_t env);
+
+    void apply_fill_(std::size_t env, std::size_t i, i64 price_q, i64 qty_q, LiquidityFlag liq);
+    void unlock_remaining_(std::size_t env, std::size_t i);
+    bool apply_stp_on_activate_(std::size_t env, std::size_t i);
+    void compact_fifo_(std::size_t env);
+
+    SimulatorParams params_{};
+    std::size_t envs_ = 0;
+    std::size_t slots_ = 0;
+
+    // ---- Per env ----
+    std::vector<u64> now_;
+    std::vector<i64> cash_;
+    std::vector<i64> position_;
+    std::vector<i64> locked_cash_;
+    std::vector<i64> locked_position_;
+    std::vector<u64> next_seq_; // = order id of the env's next order
+    std::vector<u64> steps_;
+    std::vector<u64> fill_count_;
+    // Resting slots in activation order (= per-price FIFO order): fifo_[env * slots_ + j]
+    std::vector<std::uint8_t> fifo_;
+    std::vector<std::uint8_t> fifo_len_;
+    // Step-scoped
+    std::vector<const md::l2::Record*> rec_;
+    std::vector<std::uint8_t> work_;
+
+    // ---- Per slot, [slot * envs_ + env] ----
+    std::vector<OrderState> state_;
+    std::vector<Side> side_;
+    std::vector<i64> price_;
+    std::vector<i64> qty_;
+    std::vector<i64> filled_;
+    std::vector<i64> ahead_; // qty_ahead_q
+    std::vector<u64> activate_ts_;
+    std::vector<u64> seq_;
+    // Price-bucket queue state, replicated on every resting order at that price
+    std::vector<Visibility> vis_;
+    std::vector<std::int16_t> level_idx_;
+    std::vector<i64> level_qty_;
+    // Step-scoped: depletion left to allocate at this order's price
+    std::vector<i64> depletion_;
+  };
+
+} // namespace sim
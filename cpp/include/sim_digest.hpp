@@ -0,0 +1,39 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+
+// Standalone (no sim.hpp): core also digests with it (snap_catalog.cpp).
+namespace sim::digest
+{
+
+  using u64 = std::uint64_t;
+
+  inline constexpr u64 kSeed = 0x316769646C72736DULL; // "msrldig1" in little-endian
+
+  inline constexpr u64 kP1 = 0x9E3779B185EBCA87ULL;
+  inline constexpr u64 kP2 = 0xC2B2AE3D27D4EB4FULL;
+  inline constexpr u64 kP4 = 0x85EBCA77C2B2AE63ULL;
+
+  // xxh64-style accumulate: order-sensitive, every input bit avalanches into h.
+  inline constexpr u64 mix(u64 h, u64 v) noexcept
+  {
+    v *= kP2;
+    v = std::rotl(v, 31);
+    v *= kP1;
+    h ^= v;
+    return std::rotl(h, 27) * kP1 + kP4;
+  }
+
+  inline constexpr u64 mix(u64 h, std::int64_t v) noexcept
+  {
+    return mix(h, static_cast<u64>(v));
+  }
+
+  // Pack up to 3 one-byte enum tags into one word (a in the low byte).
+  inline constexpr u64 tags(std::uint8_t a, std::uint8_t b = 0, std::uint8_t c = 0) noexcept
+  {
+    return static_cast<u64>(a) | (static_cast<u64>(b) << 8) | (static_cast<u64>(c) << 16);
+  }
+
+} // namespace sim::digest
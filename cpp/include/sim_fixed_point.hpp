@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+#include "schema.hpp" // md::l2::kPriceScale
+#include "sim.hpp"    // sim::i64, sim::u64, SIM_ASSERT
+
+#if defined(_MSC_VER)
+#  include <intrin.h>
+// _umul128/_udiv128 are x64-only. If you build Win32, do NOT attempt to run.
+#  if !defined(_M_X64)
+#    error "MSVC build must target x64 (/M_X64) for 128-bit mul/div intrinsics."
+#  endif
+#endif
+
+// Fixed-point ledger arithmetic shared by MarketSimulator and BatchedSimulator.
+namespace sim::fixed
+{
+
+  // Computes floor((a*b)/div) with 128-bit intermediates.
+  // Assumptions for v0 fills:
+  // - a >= 0 (price_q)
+  // - b >= 0 (qty_q or notional)
+  // - div > 0
+  inline i64 mul_div_u64_to_i64(i64 a, i64 b, i64 div)
+  {
+    SIM_ASSERT(a >= 0);
+    SIM_ASSERT(b >= 0);
+    SIM_ASSERT(div > 0);
+
+#if defined(_MSC_VER)
+    unsigned __int64 hi = 0;
+    const unsigned __int64 lo =
+        _umul128(static_cast<unsigned __int64>(a), static_cast<unsigned __int64>(b), &hi);
+    unsigned __int64 rem = 0;
+    const unsigned __int64 q = _udiv128(hi, lo, static_cast<unsigned __int64>(div), &rem);
+    return static_cast<i64>(q);
+#elif defined(__GNUC__) || defined(__clang__)
+    __int128 prod = static_cast<__int128>(a) * static_cast<__int128>(b);
+    return static_cast<i64>(prod / static_cast<__int128>(div));
+#else
+#  error "No 128-bit multiply/divide support for this compiler."
+#endif
+  }
+
+  inline i64 notional_cash_q(i64 price_q, i64 qty_q)
+  {
+    // price_q = price * kPriceScale, qty_q = qty * kQtyScale
+    // notional_cash_q should be in cash_q quantization.
+    // Using the schema scale constant (PRICE_SCALE does not exist).
+    return mul_div_u64_to_i64(price_q, qty_q, md::l2::kPriceScale);
+  }
+
+  inline i64 fee_cash_q(i64 notional_q, u64 fee_ppm)
+  {
+    return mul_div_u64_to_i64(notional_q, static_cast<i64>(fee_ppm), 1'000'000);
+  }
+
+  // a*b into *out; returns true (and leaves *out untouched) on i64 overflow.
+  inline bool mul_i64_overflow(i64 a, i64 b, i64* out)
+  {
+#if defined(_MSC_VER)
+    // MSVC x64: use builtin 128-bit multiply
+    // Note: _mul128 returns high 64 bits and stores low 64 bits in *out_low.
+    __int64 high = 0;
+    __int64 low = 0;
+    low = _mul128(static_cast<__int64>(a), static_cast<__int64>(b), &high);
+
+    // If high is not sign-extension of low's sign bit, overflow occurred
+    const bool neg = (low < 0);
+    const __int64 expected_high = neg ? -1 : 0;
+    if ( high != expected_high )
+      return true;
+
+    *out = static_cast<i64>(low);
+    return false;
+#else
+    __int128 prod = static_cast<__int128>(a) * static_cast<__int128>(b);
+    if ( prod > static_cast<__int128>(std::numeric_limits<i64>::max()) )
+      return true;
+    if ( prod < static_cast<__int128>(std::numeric_limits<i64>::min()) )
+      return true;
+    *out = static_cast<i64>(prod);
+    return false;
+#endif
+  }
+
+} // namespace sim::fixed
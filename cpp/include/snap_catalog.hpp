@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "schema.hpp"
+
+/*
+ * =============================================================================
+ *  Dataset catalog: one index file for every .snap under a processed root
+ * =============================================================================
+ *
+ * Finding the files that cover a time range used to mean opening every .snap
+ * under DATA_PROCESSED_ROOT and reading its first and last record. The catalog
+ * records, per file, its path (relative to the root), record count, first /
+ * last ts_recv_ns, size, write time, a full-content digest and a few summary
+ * stats, in one small file at <root>/catalog.snapidx.
+ *
+ * File layout (little-endian):
+ *   [CatalogHeader][CatalogEntry] * header.count [path bytes] * header.path_bytes
+ *
+ * Entries are sorted by (first_ts_recv_ns, path); empty files sort last.
+ * max_last_ts_recv_ns is the running maximum of last_ts_recv_ns, so the files
+ * overlapping [t0, t1] are found with two binary searches (overlapping()),
+ * without touching any data file. python/md/snap_catalog.py reads the same
+ * file with numpy.
+ *
+ * Maintenance: `converter --catalog <root>` (run by ingest.py after a batch)
+ * calls refresh(), which rescans only files that are new or whose size / write
+ * time changed, drops entries for files that are gone, and saves atomically.
+ * The catalog is not safe to refresh from two processes at once.
+ */
+
+namespace md::l2
+{
+
+  constexpr std::uint32_t kCatalogMagic = 0x5443534D; // "MSCT" in little-endian
+  constexpr std::uint16_t kCatalogVersion = 2; // 2: locked split out of crossed
+  inline constexpr const char* kCatalogFileName = "catalog.snapidx";
+
+  struct CatalogHeader
+  {
+    std::uint32_t magic{kCatalogMagic};
+    std::uint16_t version{kCatalogVersion};
+    std::uint16_t entry_size{0};
+    std::uint32_t endian_check{kEndianCheck};
+    std::uint32_t reserved0{0};
+    std::uint64_t count{0};      // number of CatalogEntry
+    std::uint64_t path_bytes{0}; // size of the path table
+  };
+
+  static_assert(std::is_trivially_copyable_v<CatalogHeader>);
+  static_assert(sizeof(CatalogHeader) == 32);
+
+  struct CatalogEntry
+  {
+    std::uint64_t path_offset{0}; // into the path table (UTF-8, '/' separators)
+    std::uint32_t path_len{0};
+    std::uint32_t reserved0{0};
+
+    std::uint64_t record_count{0};
+    std::int64_t first_ts_recv_ns{0}; // INT64_MAX for an empty file
+    std::int64_t last_ts_recv_ns{0};  // INT64_MIN for an empty file
+    std::int64_t max_last_ts_recv_ns{0};
+    std::uint64_t file_size{0};
+    std::int64_t write_time{0}; // filesystem clock ticks; only compared for staleness
+    std::uint64_t digest{0};    // xxh64-style fold over every record byte
+
+    // Summary stats
+    std::uint64_t no_top_of_book{0}; // records missing the best bid or ask
+    std::uint64_t crossed{0};        // best bid > best ask (both active), as SnapStats
+    std::uint64_t locked{0};         // best bid == best ask (both active), as SnapStats
+    std::uint64_t ts_regressions{0}; // ts_recv_ns lower than the previous record's
+    std::int64_t max_gap_ns{0};      // largest ts_recv_ns step
+    std::int64_t min_best_bid_q{0};  // over records with a top of book (0 if none)
+    std::int64_t max_best_bid_q{0};
+    std::int64_t min_spread_q{0};
+    std::int64_t max_spread_q{0};
+  };
+
+  static_assert(std::is_trivially_copyable_v<CatalogEntry>);
+  static_assert(sizeof(CatalogEntry) == 144);
+
+  /// Catalog fields of one .snap (path fields and max_last_ts_recv_ns are left
+  /// for SnapCatalog to fill).
+  /// Maps and reads the whole file. Throws whatever ReplayKernel throws.
+  CatalogEntry scan_snap(const std::string& snap_path);
+
+  class SnapCatalog final
+  {
+  public:
+    /// Catalog of `root`: loads <root>/catalog.snapidx if present, else starts
+    /// empty (also for an older catalog version: refresh() rescans everything).
+    /// Throws std::runtime_error on a corrupt or incompatible file.
+    explicit SnapCatalog(std::string root);
+
+    /// Rescan `root` for .snap files (recursively) on up to `threads` threads
+    /// (0 = hardware concurrency). Unchanged files keep their entries. Returns
+    /// the number of files scanned.
+    std::size_t refresh(unsigned threads = 0);
+
+    /// Add or replace the entry for one file under root.
+    void upsert(const std::string& snap_path);
+
+    /// Write <root>/catalog.snapidx (.part then rename).
+    void save() const;
+
+    const std::string& root() const noexcept { return root_; }
+    std::string file() const;
+
+    std::size_t size() const noexcept { return entries_.size(); }
+    std::span<const CatalogEntry> entries() const noexcept { return entries_; }
+    const CatalogEntry& entry(std::size_t i) const noexcept { return entries_[i]; }
+    const std::string& relative_path(std::size_t i) const noexcept { return paths_[i]; }
+    std::string path(std::size_t i) const; // root / relative_path(i)
+
+    /// Indices of the files with records in [t0, t1] (inclusive), in
+    /// first-timestamp order. O(log n) plus the files between the two search
+    /// bounds (just the result when files do not nest).
+    std::vector<std::size_t> overlapping(std::int64_t t0, std::int64_t t1) const;
+
+  private:
+    void sort_();
+
+    std::string root_;
+    std::vector<CatalogEntry> entries_;
+    std::vector<std::string> paths_; // parallel to entries_
+  };
+
+} // namespace md::l2
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "replay.hpp"
+#include "schema.hpp"
+#include "snap_catalog.hpp"
+
+/*
+ * =============================================================================
+ *  Per-file data-quality statistics (single pass, sidecar, mergeable)
+ * =============================================================================
+ *
+ * compute_stats() makes one pass over a file's records and fills a fixed-size
+ * SnapStats: book-state counts (crossed / locked / one-sided / empty), empty
+ * level counts per depth index, timestamp health, and power-of-two histograms
+ * of inter-arrival gaps, spreads and level quantities.
+ *
+ * The result is stored next to the file as <file>.snap.stats (written by the
+ * converter after each conversion, or by `converter --stats <root>` for every
+ * file under a root on all cores). SnapStats::merge() is plain addition (plus
+ * min / max), so a date range is aggregated from the sidecars alone:
+ * aggregate_stats() picks the files from the catalog and never maps a .snap
+ * whose sidecar is current.
+ *
+ * Histograms: bucket 0 holds v <= 0, bucket k (k >= 1) holds v in
+ * [2^(k-1), 2^k) (as PacedReplayStats::lag_hist).
+ *
+ * Sidecar layout (little-endian): [StatsHeader][SnapStats]
+ */
+
+namespace md::l2
+{
+
+  constexpr std::uint32_t kStatsMagic = 0x5453534D; // "MSST" in little-endian
+  constexpr std::uint16_t kStatsVersion = 1;
+  inline constexpr std::size_t kStatsHistBuckets = 64;
+
+  using Log2Hist = std::array<std::uint64_t, kStatsHistBuckets>;
+
+  /// Bucket of v in a Log2Hist.
+  std::size_t log2_bucket(std::int64_t v) noexcept;
+
+  /// Upper edge of the bucket holding quantile q in [0, 1] (0 if the
+  /// histogram is empty).
+  std::int64_t hist_quantile(const Log2Hist& h, double q) noexcept;
+
+  struct SnapStats
+  {
+    std::uint64_t files{0}; // files merged in
+    std::uint64_t records{0};
+    std::int64_t first_ts_recv_ns{0}; // INT64_MAX if no records
+    std::int64_t last_ts_recv_ns{0};  // INT64_MIN if no records
+
+    // Timestamps
+    std::uint64_t ts_regressions{0};   // ts_recv_ns below the previous record's
+    std::uint64_t ts_event_missing{0}; // ts_event_ms == 0
+    std::int64_t max_gap_ns{0};        // largest forward ts_recv_ns step within a file
+
+    // Book state at level 0
+    std::uint64_t top_of_book{0}; // both sides active
+    std::uint64_t bid_only{0};
+    std::uint64_t ask_only{0};
+    std::uint64_t empty_book{0};
+    std::uint64_t crossed{0}; // best bid > best ask
+    std::uint64_t locked{0};  // best bid == best ask
+    std::int64_t min_spread_q{0}; // over top-of-book records (0 if none)
+    std::int64_t max_spread_q{0};
+    std::uint64_t reserved0{0};
+
+    // Inactive levels per depth index
+    std::array<std::uint64_t, kDepth> empty_bid_levels{};
+    std::array<std::uint64_t, kDepth> empty_ask_levels{};
+
+    Log2Hist gap_hist{};       // ts_recv_ns gaps (ns) between consecutive records
+    Log2Hist spread_hist{};    // best ask - best bid (price_q), top-of-book records
+    Log2Hist top_qty_hist{};   // bids[0] / asks[0] qty_q, active levels
+    Log2Hist level_qty_hist{}; // qty_q of every active level, both sides
+
+    /// Fold another file's (or range's) stats in. Gaps across the boundary
+    /// are not counted.
+    void merge(const SnapStats& o) noexcept;
+  };
+
+  static_assert(std::is_trivially_copyable_v<SnapStats>);
+  static_assert(sizeof(SnapStats) == 128 + 2 * kDepth * 8 + 4 * kStatsHistBuckets * 8);
+
+  struct StatsHeader
+  {
+    std::uint32_t magic{kStatsMagic};
+    std::uint16_t version{kStatsVersion};
+    std::uint16_t stats_size{sizeof(SnapStats)};
+    std::uint32_t endian_check{kEndianCheck};
+    std::uint32_t reserved0{0};
+  };
+
+  static_assert(std::is_trivially_copyable_v<StatsHeader>);
+  static_assert(sizeof(StatsHeader) == 16);
+
+  /// One pass over `records` (files = 1).
+  SnapStats compute_stats(std::span<const Record> records) noexcept;
+
+  /// Sidecar path for a .snap: "<snap_path>.stats".
+  std::string stats_path(const std::string& snap_path);
+
+  /// Write (.part then rename) / read a sidecar. Throws std::runtime_error.
+  void save_stats(const std::string& path, const SnapStats& st);
+  SnapStats load_stats(const std::string& path);
+
+  /// The sidecar of `snap_path` if it matches the file (record count and first
+  /// / last timestamps), else computed from the records and written back (a
+  /// failed write is ignored).
+  SnapStats load_or_compute_stats(const std::string& snap_path);
+
+  /// load_or_compute_stats() for every file, on up to `threads` threads
+  /// (0 = hardware concurrency). Result i belongs to snap_paths[i].
+  std::vector<SnapStats> stats_for_files(
+      const std::vector<std::string>& snap_paths,
+      unsigned threads = 0);
+
+  /// Merged stats of the catalog's files with records in [t0, t1] (whole
+  /// files). Sidecars are checked against the catalog entries; only files with
+  /// a missing or stale sidecar are read.
+  SnapStats aggregate_stats(
+      const SnapCatalog& catalog,
+      std::int64_t t0,
+      std::int64_t t1,
+      unsigned threads = 0);
+
+} // namespace md::l2
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "replay.hpp"
+#include "schema.hpp"
+
+/*
+ * =============================================================================
+ *  Block zone maps: predicate pushdown over .snap files
+ * =============================================================================
+ *
+ * A zone map splits a file into blocks of `block_records` records and keeps,
+ * per block, the min / max of a few derived fields (ZoneField). A scan with a
+ * conjunction of range predicates skips every block whose [min, max] misses
+ * one of them, and filters the remaining blocks record by record on a thread
+ * pool. The result is a sorted list of record indices: use them with
+ * ReplayKernel::operator[] or as a numpy fancy index into the memmap views.
+ *
+ * Book fields (everything but TsRecvNs) are defined only for records with a
+ * top of book (record_has_top_of_book); such records never match a predicate
+ * on them, and a block without one has an empty [INT64_MAX, INT64_MIN] range.
+ *
+ * Sidecar: <file>.snap.zmap, written by the converter after each conversion
+ * (or on demand by load_or_build()). It is stamped with the .snap's size and
+ * write time, so a rewritten .snap gets a fresh map even when its record count
+ * and end timestamps are unchanged. Layout (little-endian):
+ *   [ZoneMapHeader][Zone] * header.zones
+ */
+
+namespace md::l2
+{
+
+  constexpr std::uint32_t kZoneMapMagic = 0x5A4D534D; // "MSMZ" in little-endian
+  constexpr std::uint16_t kZoneMapVersion = 2;
+  inline constexpr std::size_t kZoneBlockRecords = 4096;
+
+  enum class ZoneField : std::uint8_t
+  {
+    TsRecvNs = 0,
+    BestBid = 1, // bids[0].price_q
+    BestAsk = 2, // asks[0].price_q
+    Spread = 3,  // best ask - best bid
+    BidQty = 4,  // bids[0].qty_q
+    AskQty = 5   // asks[0].qty_q
+  };
+
+  inline constexpr std::size_t kZoneFields = 6;
+
+  /// Value of `field` for one record; false for a book field of a record
+  /// without a top of book.
+  inline bool zone_value(const Record& r, ZoneField field, std::int64_t& out) noexcept
+  {
+    if ( field == ZoneField::TsRecvNs ) {
+      out = r.ts_recv_ns;
+      return true;
+    }
+    if ( !record_has_top_of_book(r) )
+      return false;
+    switch ( field ) {
+    case ZoneField::BestBid:
+      out = r.bids[0].price_q;
+      break;
+    case ZoneField::BestAsk:
+      out = r.asks[0].price_q;
+      break;
+    case ZoneField::Spread:
+      out = r.asks[0].price_q - r.bids[0].price_q;
+      break;
+    case ZoneField::BidQty:
+      out = r.bids[0].qty_q;
+      break;
+    default:
+      out = r.asks[0].qty_q;
+      break;
+    }
+    return true;
+  }
+
+  struct Zone
+  {
+    std::array<std::int64_t, kZoneFields> lo; // per ZoneField, over the block
+    std::array<std::int64_t, kZoneFields> hi;
+    std::uint32_t records{0};
+    std::uint32_t top_of_book{0}; // records with a top of book
+  };
+
+  static_assert(std::is_trivially_copyable_v<Zone>);
+  static_assert(sizeof(Zone) == 104);
+
+  struct ZoneMapHeader
+  {
+    std::uint32_t magic{kZoneMapMagic};
+    std::uint16_t version{kZoneMapVersion};
+    std::uint16_t zone_size{sizeof(Zone)};
+    std::uint32_t endian_check{kEndianCheck};
+    std::uint32_t block_records{0};
+    std::uint64_t record_count{0}; // of the .snap it describes
+    std::int64_t first_ts_recv_ns{0};
+    std::int64_t last_ts_recv_ns{0};
+    std::uint64_t zones{0};
+    std::uint64_t snap_size{0};      // see ZoneMap::stamp(); 0 = not stamped
+    std::int64_t snap_write_time{0}; // write_time_of() the .snap
+  };
+
+  static_assert(std::is_trivially_copyable_v<ZoneMapHeader>);
+  static_assert(sizeof(ZoneMapHeader) == 64);
+
+  /// lo <= value(field) <= hi
+  struct ZonePredicate
+  {
+    ZoneField field{ZoneField::TsRecvNs};
+    std::int64_t lo{0};
+    std::int64_t hi{0};
+  };
+
+  /// Sidecar path for a .snap: "<snap_path>.zmap".
+  std::string zone_map_path(const std::string& snap_path);
+
+  class ZoneMap final
+  {
+  public:
+    ZoneMap() = default;
+
+    /// One pass over the kernel's records, blocks spread over `threads`
+    /// threads (0 = hardware concurrency). Throws if block_records is 0.
+    static ZoneMap build(
+        const ReplayKernel& rk,
+        std::size_t block_records = kZoneBlockRecords,
+        unsigned threads = 0);
+
+    /// Throws std::runtime_error on a missing, corrupt or incompatible file.
+    static ZoneMap load(const std::string& path);
+
+    /// Load zone_map_path(snap_path) if describes_file(snap_path, rk), else build
+    /// and stamp it and try to save it there.
+    static ZoneMap load_or_build(const std::string& snap_path, const ReplayKernel& rk);
+
+    /// Record the size and write time of the .snap the map was built from, once
+    /// that file is final. Throws std::filesystem::filesystem_error.
+    void stamp(const std::string& snap_path);
+
+    /// Write (.part then rename).
+    void save(const std::string& path) const;
+
+    std::size_t block_records() const noexcept { return header_.block_records; }
+    std::size_t record_count() const noexcept { return header_.record_count; }
+    std::size_t size() const noexcept { return zones_.size(); }
+    std::span<const Zone> zones() const noexcept { return zones_; }
+    const ZoneMapHeader& header() const noexcept { return header_; }
+
+    /// True unless block `b`'s ranges rule out a record matching every predicate.
+    bool may_match(std::size_t b, std::span<const ZonePredicate> preds) const noexcept;
+
+    /// True if the map was built over `rk`'s records (count and end timestamps).
+    bool describes(const ReplayKernel& rk) const noexcept;
+
+    /// describes(rk), and the .snap at snap_path still has the size and write
+    /// time stamp() recorded (catches a rewrite that keeps the count and end
+    /// timestamps). Throws std::filesystem::filesystem_error.
+    bool describes_file(const std::string& snap_path, const ReplayKernel& rk) const;
+
+  private:
+    ZoneMapHeader header_{};
+    std::vector<Zone> zones_;
+  };
+
+  struct ZoneScanStats
+  {
+    std::size_t blocks{0};         // blocks in the map
+    std::size_t blocks_scanned{0}; // ... not skipped by the zone ranges
+    std::size_t matched{0};        // records returned
+  };
+
+  /// Sorted indices of the records of rk matching every predicate (all records
+  /// if preds is empty). Candidate blocks are filtered on up to `threads`
+  /// threads (0 = hardware concurrency). Throws std::runtime_error if the map
+  /// does not describe rk.
+  std::vector<std::uint64_t> zone_scan(
+      const ReplayKernel& rk,
+      const ZoneMap& zm,
+      std::span<const ZonePredicate> preds,
+      unsigned threads = 0,
+      ZoneScanStats* stats = nullptr);
+
+} // namespace md::l2
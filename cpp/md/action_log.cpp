@@ -0,0 +1,283 @@
+#include "action_log.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+namespace sim
+{
+
+  // -------------------------
+  // Recording
+  // -------------------------
+  void ActionLog::begin_(const SimulatorParams& p, Ns start_ts, const Ledger& ledger)
+  {
+    header_ = ActionLogHeader{};
+    header_.start_ts_ns = start_ts.value;
+    header_.cash_q = ledger.cash_q;
+    header_.position_qty_q = ledger.position_qty_q;
+    header_.locked_cash_q = ledger.locked_cash_q;
+    header_.locked_position_qty_q = ledger.locked_position_qty_q;
+
+    header_.outbound_latency_ns = p.outbound_latency.value;
+    header_.observation_latency_ns = p.observation_latency.value;
+    header_.max_orders = p.max_orders;
+    header_.max_events = p.max_events;
+    header_.alpha_ppm = p.alpha_ppm;
+    header_.maker_fee_ppm = p.fees.maker_fee_ppm;
+    header_.taker_fee_ppm = p.fees.taker_fee_ppm;
+    header_.max_abs_position_qty_q = p.risk.max_abs_position_qty_q;
+    header_.stp = static_cast<std::uint8_t>(p.stp);
+    header_.spot_no_short = p.risk.spot_no_short ? 1 : 0;
+    header_.stochastic_depletion = p.stochastic_depletion ? 1 : 0;
+    header_.rng_seed = p.rng_seed;
+    header_.rng_stream = p.rng_stream;
+    header_.outbound_latency_jitter_ns = p.outbound_latency_jitter.value;
+
+    records_.clear();
+  }
+
+  void ActionLog::on_step_(const md::l2::Record& rec)
+  {
+    if ( header_.steps == 0 )
+      header_.first_record_ts_ns = rec.ts_recv_ns;
+    ++header_.steps;
+  }
+
+  void ActionLog::push_(const ActionRecord& r)
+  {
+    records_.push_back(r);
+    header_.count = records_.size();
+  }
+
+  void MarketSimulator::log_action_(
+      ActionType type,
+      Side side,
+      Tif tif,
+      i64 price_q,
+      i64 qty_q,
+      u64 client_order_id,
+      u64 order_id)
+  {
+    ActionRecord r{};
+    r.step = step_count_;
+    r.ts_ns = now_.value;
+    r.order_id = order_id;
+    r.client_order_id = client_order_id;
+    r.price_q = price_q;
+    r.qty_q = qty_q;
+    r.type = type;
+    r.side = side;
+    r.tif = tif;
+    action_log_->push_(r);
+  }
+
+  // -------------------------
+  // Header accessors
+  // -------------------------
+  SimulatorParams ActionLog::params() const
+  {
+    SimulatorParams p{};
+    p.outbound_latency = Ns{header_.outbound_latency_ns};
+    p.observation_latency = Ns{header_.observation_latency_ns};
+    p.max_orders = static_cast<std::size_t>(header_.max_orders);
+    p.max_events = static_cast<std::size_t>(header_.max_events);
+    p.alpha_ppm = header_.alpha_ppm;
+    p.fees.maker_fee_ppm = header_.maker_fee_ppm;
+    p.fees.taker_fee_ppm = header_.taker_fee_ppm;
+    p.risk.max_abs_position_qty_q = header_.max_abs_position_qty_q;
+    p.stp = static_cast<StpPolicy>(header_.stp);
+    p.risk.spot_no_short = header_.spot_no_short != 0;
+    p.stochastic_depletion = header_.stochastic_depletion != 0;
+    p.rng_seed = header_.rng_seed;
+    p.rng_stream = header_.rng_stream;
+    p.outbound_latency_jitter = Ns{header_.outbound_latency_jitter_ns};
+    return p;
+  }
+
+  Ledger ActionLog::initial_ledger() const
+  {
+    Ledger l{};
+    l.cash_q = header_.cash_q;
+    l.position_qty_q = header_.position_qty_q;
+    l.locked_cash_q = header_.locked_cash_q;
+    l.locked_position_qty_q = header_.locked_position_qty_q;
+    return l;
+  }
+
+  // -------------------------
+  // File I/O
+  // -------------------------
+  void ActionLog::save(const std::string& path) const
+  {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if ( !out )
+      throw std::runtime_error("Could not open action log for writing: " + path);
+
+    ActionLogHeader h = header_;
+    h.count = records_.size();
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    if ( !records_.empty() )
+      out.write(
+          reinterpret_cast<const char*>(records_.data()),
+          static_cast<std::streamsize>(records_.size() * sizeof(ActionRecord)));
+    out.flush();
+    if ( !out )
+      throw std::runtime_error("Write failure for action log: " + path);
+  }
+
+  ActionLog ActionLog::load(const std::string& path)
+  {
+    std::ifstream in(path, std::ios::binary);
+    if ( !in )
+      throw std::runtime_error("Could not open action log: " + path);
+
+    ActionLog log;
+    in.read(reinterpret_cast<char*>(&log.header_), sizeof(log.header_));
+    if ( !in )
+      throw std::runtime_error("Truncated action log header: " + path);
+
+    const ActionLogHeader& h = log.header_;
+    if ( h.magic != kActionLogMagic )
+      throw std::runtime_error("Not an action log (bad magic): " + path);
+    if ( h.version != kActionLogVersion )
+      throw std::runtime_error("Unsupported action log version: " + path);
+    if ( h.endian_check != md::l2::kEndianCheck )
+      throw std::runtime_error("Action log endianness mismatch: " + path);
+    if ( h.record_size != sizeof(ActionRecord) )
+      throw std::runtime_error("Action log record size mismatch: " + path);
+
+    log.records_.resize(static_cast<std::size_t>(h.count));
+    if ( h.count > 0 ) {
+      in.read(
+          reinterpret_cast<char*>(log.records_.data()),
+          static_cast<std::streamsize>(h.count * sizeof(ActionRecord)));
+      if ( !in )
+        throw std::runtime_error("Truncated action log records: " + path);
+    }
+    return log;
+  }
+
+  // -------------------------
+  // Replay
+  // -------------------------
+  namespace
+  {
+    // recorded id -> replay id (0 = never created in the replay)
+    struct IdMap
+    {
+      std::vector<u64> ids;
+
+      void set(u64 recorded, u64 replayed)
+      {
+        if ( recorded == 0 )
+          return;
+        if ( recorded >= ids.size() )
+          ids.resize(recorded + 1, 0);
+        ids[recorded] = replayed;
+      }
+
+      u64 get(u64 recorded) const { return recorded < ids.size() ? ids[recorded] : 0; }
+    };
+  } // namespace
+
+  ActionReplayStats replay_actions(
+      MarketSimulator& ex,
+      const ActionLog& log,
+      std::span<const md::l2::Record> records)
+  {
+    const ActionLogHeader& h = log.header();
+    if ( records.size() < h.steps )
+      throw std::runtime_error("replay_actions: fewer records than recorded steps");
+    if ( h.steps > 0 && records[0].ts_recv_ns != h.first_record_ts_ns )
+      throw std::runtime_error("replay_actions: records do not start at the recorded first step");
+
+    ex.reset(log.start_ts(), log.initial_ledger());
+
+    ActionReplayStats st{};
+    IdMap idmap;
+    std::vector<QuoteLevel> ladder;
+    std::vector<u64> ladder_ids;
+
+    const std::vector<ActionRecord>& acts = log.records();
+    std::size_t a = 0;
+    for ( u64 k = 0;; ++k ) {
+      // Actions issued after k steps
+      while ( a < acts.size() && acts[a].step == k ) {
+        const ActionRecord& r = acts[a];
+        if ( r.ts_ns != ex.now().value )
+          throw std::runtime_error("replay_actions: action timestamp does not match the records");
+
+        switch ( r.type ) {
+        case ActionType::PlaceLimit: {
+          LimitOrderRequest req{};
+          req.side = r.side;
+          req.price_q = r.price_q;
+          req.qty_q = r.qty_q;
+          req.tif = r.tif;
+          req.client_order_id = r.client_order_id;
+          const u64 id = ex.place_limit(req);
+          idmap.set(r.order_id, id);
+          if ( (id == 0) != (r.order_id == 0) )
+            ++st.places_diverged;
+          ++a;
+          break;
+        }
+        case ActionType::PlaceMarket: {
+          MarketOrderRequest req{};
+          req.side = r.side;
+          req.qty_q = r.qty_q;
+          req.tif = r.tif;
+          req.client_order_id = r.client_order_id;
+          const u64 id = ex.place_market(req);
+          idmap.set(r.order_id, id);
+          if ( (id == 0) != (r.order_id == 0) )
+            ++st.places_diverged;
+          ++a;
+          break;
+        }
+        case ActionType::Cancel: {
+          const u64 id = idmap.get(r.order_id);
+          if ( id == 0 )
+            ++st.cancels_skipped;
+          else
+            (void)ex.cancel(id);
+          ++a;
+          break;
+        }
+        case ActionType::SetQuotes: {
+          const std::size_t n = static_cast<std::size_t>(r.order_id);
+          if ( a + 1 + n > acts.size() )
+            throw std::runtime_error("replay_actions: truncated SetQuotes ladder");
+          ladder.clear();
+          for ( std::size_t i = 0; i < n; ++i ) {
+            const ActionRecord& q = acts[a + 1 + i];
+            if ( q.type != ActionType::QuoteLevel )
+              throw std::runtime_error("replay_actions: malformed SetQuotes ladder");
+            ladder.push_back(QuoteLevel{q.price_q, q.qty_q});
+          }
+          ladder_ids = ex.set_quotes(r.side, ladder);
+          for ( std::size_t i = 0; i < n; ++i )
+            idmap.set(acts[a + 1 + i].order_id, ladder_ids[i]);
+          a += 1 + n;
+          break;
+        }
+        default:
+          throw std::runtime_error("replay_actions: unexpected action type");
+        }
+        ++st.actions;
+      }
+
+      if ( k >= h.steps )
+        break;
+      if ( a < acts.size() && acts[a].step < k + 1 )
+        throw std::runtime_error("replay_actions: actions out of step order");
+      ex.step(records[k]);
+      ++st.steps;
+    }
+
+    if ( a < acts.size() )
+      throw std::runtime_error("replay_actions: actions recorded beyond the last step");
+    return st;
+  }
+
+} // namespace sim
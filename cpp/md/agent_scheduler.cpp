@@ -0,0 +1,107 @@
+#include <stdexcept>
+
+#include "agent_coro.hpp"
+
+namespace sim
+{
+
+  std::size_t AgentScheduler::spawn(
+      const SimulatorParams& params,
+      Ns start_ts,
+      Ledger ledger,
+      const Factory& factory)
+  {
+    auto ctx = std::make_unique<AgentContext>();
+    ctx->sim_ = std::make_unique<MarketSimulator>(params);
+    ctx->sim_->reset(start_ts, ledger);
+    ctx->id_ = agents_.size();
+
+    AgentTask task = factory(*ctx);
+    if ( !task.h_ )
+      throw std::runtime_error("AgentScheduler: factory returned an empty task");
+
+    const std::size_t id = ctx->id_;
+    agents_.push_back(std::move(ctx));
+    tasks_.push_back(std::move(task));
+    ++live_;
+    resume_(id); // run to the first await
+    return id;
+  }
+
+  bool AgentScheduler::fired_(AgentContext& a) noexcept
+  {
+    switch ( a.wait_ ) {
+    case AgentWait::Record:
+      return true;
+    case AgentWait::Timer:
+      return a.sim_->now() >= a.wait_until_;
+    case AgentWait::Activation:
+      return a.order_state_(a.wait_order_) != OrderState::Pending;
+    case AgentWait::Fill:
+      return a.poll_fill_(a.wait_order_) || a.order_done_(a.wait_order_);
+    case AgentWait::None:
+      break;
+    }
+    return false;
+  }
+
+  void AgentScheduler::resume_(std::size_t id)
+  {
+    AgentContext& a = *agents_[id];
+    auto h = tasks_[id].h_;
+
+    a.wait_ = AgentWait::None;
+    ++stats_.resumes;
+    h.resume();
+    a.step_mark_ = a.sim_->fills().size(); // fills from here on land while it waits
+
+    if ( h.done() ) {
+      --live_;
+      if ( std::exception_ptr e = std::exchange(h.promise().error, nullptr) )
+        std::rethrow_exception(e);
+      return;
+    }
+    if ( a.wait_ == AgentWait::None )
+      throw std::runtime_error("AgentScheduler: agent suspended on an unsupported awaitable");
+  }
+
+  void AgentScheduler::step(const md::l2::Record& rec)
+  {
+    ++stats_.steps;
+    std::exception_ptr first_error;
+
+    for ( std::size_t i = 0; i < agents_.size(); ++i ) {
+      if ( tasks_[i].done() )
+        continue;
+      AgentContext& a = *agents_[i];
+      a.sim_->step(rec);
+      a.rec_ = &rec;
+      if ( !fired_(a) )
+        continue;
+      // Finish the step for every agent before surfacing an error
+      try {
+        resume_(i);
+      }
+      catch ( ... ) {
+        if ( !first_error )
+          first_error = std::current_exception();
+      }
+    }
+
+    if ( first_error )
+      std::rethrow_exception(first_error);
+  }
+
+  std::size_t AgentScheduler::run(std::span<const md::l2::Record> records)
+  {
+    std::size_t n = 0;
+    for ( const md::l2::Record& rec : records ) {
+      if ( live_ == 0 )
+        break;
+      step(rec);
+      ++n;
+    }
+    return n;
+  }
+
+} // namespace sim
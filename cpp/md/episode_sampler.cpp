@@ -0,0 +1,175 @@
+#include "episode_sampler.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "sim_rng.hpp"
+
+namespace sim
+{
+  namespace
+  {
+    constexpr std::size_t kPageBytes = 4096;
+
+    // Fault in every page of the window (one read per page). Returns pages read.
+    u64 touch_pages(std::span<const md::l2::Record> w) noexcept
+    {
+      const auto* p = reinterpret_cast<const volatile unsigned char*>(w.data());
+      const std::size_t bytes = w.size_bytes();
+      u64 pages = 0;
+      for ( std::size_t off = 0; off < bytes; off += kPageBytes, ++pages )
+        (void)p[off];
+      if ( bytes > 0 )
+        (void)p[bytes - 1];
+      return pages;
+    }
+  } // namespace
+
+  EpisodeSampler::EpisodeSampler(
+      const std::vector<std::string>& snap_paths,
+      const EpisodeSamplerConfig& cfg)
+      : cfg_(cfg)
+  {
+    if ( cfg_.episode_records == 0 || cfg_.lookahead == 0 )
+      throw std::runtime_error("EpisodeSampler: episode_records and lookahead must be > 0");
+
+    kernels_.reserve(snap_paths.size());
+    for ( const std::string& path : snap_paths )
+      kernels_.emplace_back(path);
+
+    for ( std::size_t i = 0; i < kernels_.size(); ++i ) {
+      const md::l2::ReplayKernel& rk = kernels_[i];
+      if ( rk.size() < cfg_.episode_records )
+        continue;
+      const auto first = static_cast<u64>(rk[0].ts_recv_ns);
+      const auto last = static_cast<u64>(rk[rk.size() - cfg_.episode_records].ts_recv_ns);
+      usable_.push_back(static_cast<std::uint32_t>(i));
+      t0_.push_back(first);
+      span_.push_back(last >= first ? last - first + 1 : 1);
+      cum_.push_back(total_span_);
+      total_span_ += span_.back();
+    }
+    if ( usable_.empty() )
+      throw std::runtime_error("EpisodeSampler: no file holds a full episode");
+
+    plan_batch_(); // the prefetcher starts on it right away
+    prefetcher_ = std::thread([this] { prefetch_loop_(); });
+  }
+
+  EpisodeSampler::~EpisodeSampler()
+  {
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    prefetcher_.join();
+  }
+
+  // ----------------------------
+  // Planning
+  // ----------------------------
+  EpisodeWindow EpisodeSampler::draw_(u64 episode) const noexcept
+  {
+    const u64 bits = rng::draw_u64(cfg_.seed, cfg_.stream, rng::Stream::EpisodeStart, episode, 0);
+    const u64 u = rng::below(bits, total_span_);
+    const std::size_t k =
+        static_cast<std::size_t>(std::upper_bound(cum_.begin(), cum_.end(), u) - cum_.begin()) - 1;
+    const auto t = static_cast<std::int64_t>(t0_[k] + (u - cum_[k]));
+
+    const md::l2::ReplayKernel& rk = kernels_[usable_[k]];
+    const md::l2::Record* first = rk.begin();
+    const md::l2::Record* last = rk.begin() + (rk.size() - cfg_.episode_records);
+    const md::l2::Record* at = std::partition_point(
+        first, last, [t](const md::l2::Record& r) { return r.ts_recv_ns < t; });
+
+    EpisodeWindow w{};
+    w.episode = episode;
+    w.file = usable_[k];
+    w.start = static_cast<std::size_t>(at - first);
+    w.records = std::span<const md::l2::Record>(at, cfg_.episode_records);
+    return w;
+  }
+
+  void EpisodeSampler::plan_batch_()
+  {
+    std::vector<EpisodeWindow> batch(cfg_.lookahead);
+    for ( EpisodeWindow& w : batch )
+      w = draw_(next_episode_++);
+
+    // File then offset order: neighbours share files and pages
+    std::sort(batch.begin(), batch.end(), [](const EpisodeWindow& a, const EpisodeWindow& b) {
+      if ( a.file != b.file )
+        return a.file < b.file;
+      if ( a.start != b.start )
+        return a.start < b.start;
+      return a.episode < b.episode;
+    });
+    planned_.insert(planned_.end(), batch.begin(), batch.end());
+    ++stats_.batches;
+  }
+
+  // ----------------------------
+  // Consumer
+  // ----------------------------
+  EpisodeWindow EpisodeSampler::next()
+  {
+    std::unique_lock<std::mutex> lk(mu_);
+    if ( planned_.size() <= cfg_.prefetch )
+      plan_batch_();
+
+    const EpisodeWindow w = planned_.front();
+    planned_.pop_front();
+    ++stats_.delivered;
+    if ( prefetch_next_ > consumed_ )
+      ++stats_.warm;
+    ++consumed_;
+    prefetch_next_ = std::max(prefetch_next_, consumed_);
+    lk.unlock();
+
+    cv_.notify_one();
+    return w;
+  }
+
+  void EpisodeSampler::next_batch(std::span<EpisodeWindow> out)
+  {
+    for ( EpisodeWindow& w : out )
+      w = next();
+  }
+
+  EpisodeSamplerStats EpisodeSampler::stats() const
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    return stats_;
+  }
+
+  // ----------------------------
+  // Background prefetch
+  // ----------------------------
+  void EpisodeSampler::prefetch_loop_()
+  {
+    for ( ;; ) {
+      u64 idx = 0;
+      std::span<const md::l2::Record> win;
+      {
+        std::unique_lock<std::mutex> lk(mu_);
+        cv_.wait(lk, [this] {
+          return stop_ || (prefetch_next_ < consumed_ + planned_.size() &&
+                           prefetch_next_ < consumed_ + cfg_.prefetch);
+        });
+        if ( stop_ )
+          return;
+        idx = prefetch_next_;
+        win = planned_[static_cast<std::size_t>(idx - consumed_)].records;
+      }
+
+      const u64 pages = touch_pages(win);
+
+      std::lock_guard<std::mutex> lk(mu_);
+      prefetch_next_ = std::max(prefetch_next_, idx + 1);
+      ++stats_.prefetched;
+      stats_.pages_touched += pages;
+    }
+  }
+
+} // namespace sim
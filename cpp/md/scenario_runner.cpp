@@ -0,0 +1,425 @@
+#include "scenario_runner.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#if defined(_MSC_VER)
+#  include <intrin.h>
+#endif
+
+namespace sim
+{
+  namespace
+  {
+    i64 abs_i64(i64 v) noexcept { return v < 0 ? -v : v; }
+
+    // runner._mid_from_record: floor((bid + ask) / 2) on a valid, uncrossed top of book.
+    // bid + (ask - bid) / 2 is the same value without overflowing on the ask sentinel.
+    std::optional<i64> mid_of(const md::l2::Record& rec) noexcept
+    {
+      const i64 bid = rec.best_bid_price_q();
+      const i64 ask = rec.best_ask_price_q();
+      if ( bid > 0 && ask > 0 && bid < ask )
+        return bid + (ask - bid) / 2;
+      return std::nullopt;
+    }
+
+    // floor(a * b / d) for d > 0, as Python's (a * b) // d. nullopt if the result (or,
+    // on MSVC, the product) does not fit in i64.
+    std::optional<i64> mul_floordiv(i64 a, i64 b, i64 d) noexcept
+    {
+#if defined(_MSC_VER)
+      __int64 high = 0;
+      const __int64 low = _mul128(a, b, &high);
+      if ( high != (low < 0 ? -1 : 0) )
+        return std::nullopt;
+      i64 q = low / d;
+      if ( (low % d != 0) && (low < 0) )
+        --q;
+      return q;
+#else
+      const i128 prod = static_cast<i128>(a) * static_cast<i128>(b);
+      i128 q = prod / d;
+      if ( (prod % d != 0) && (prod < 0) )
+        --q;
+      if ( q > std::numeric_limits<i64>::max() || q < std::numeric_limits<i64>::min() )
+        return std::nullopt;
+      return static_cast<i64>(q);
+#endif
+    }
+
+    std::string str(i64 v) { return std::to_string(v); }
+    std::string str(u64 v) { return std::to_string(v); }
+  } // namespace
+
+  const char* to_string(Side v) noexcept { return v == Side::Buy ? "Buy" : "Sell"; }
+
+  const char* to_string(LiquidityFlag v) noexcept
+  {
+    return v == LiquidityFlag::Maker ? "Maker" : "Taker";
+  }
+
+  const char* to_string(EventType v) noexcept
+  {
+    switch ( v ) {
+    case EventType::Submit: return "Submit";
+    case EventType::Activate: return "Activate";
+    case EventType::Cancel: return "Cancel";
+    case EventType::Reject: return "Reject";
+    }
+    return "?";
+  }
+
+  const char* to_string(OrderState v) noexcept
+  {
+    switch ( v ) {
+    case OrderState::Pending: return "Pending";
+    case OrderState::Active: return "Active";
+    case OrderState::Partial: return "Partial";
+    case OrderState::Filled: return "Filled";
+    case OrderState::Cancelled: return "Cancelled";
+    case OrderState::Rejected: return "Rejected";
+    }
+    return "?";
+  }
+
+  const char* to_string(RejectReason v) noexcept
+  {
+    switch ( v ) {
+    case RejectReason::None: return "None";
+    case RejectReason::InvalidParams: return "InvalidParams";
+    case RejectReason::InsufficientFunds: return "InsufficientFunds";
+    case RejectReason::InsufficientResources: return "InsufficientResources";
+    case RejectReason::SelfTradePrevention: return "SelfTradePrevention";
+    case RejectReason::UnknownOrderId: return "UnknownOrderId";
+    case RejectReason::AlreadyTerminal: return "AlreadyTerminal";
+    }
+    return "?";
+  }
+
+  ScenarioRunner::ScenarioRunner(
+      const ScenarioConfig& cfg,
+      std::span<const md::l2::Record> records)
+      : cfg_(cfg), records_(records), ex_(cfg.params)
+  {
+    if ( records_.empty() )
+      throw std::runtime_error("ScenarioRunner: empty record range");
+
+    ex_.reset(cfg_.start_ts, cfg_.initial_ledger);
+
+    c0_ = ex_.ledger().cash_q;
+    p0_ = ex_.ledger().position_qty_q;
+    acc_.expected_cash_q = cfg_.initial_ledger.cash_q;
+
+    for ( u64 h : cfg_.markout_horizons_steps ) {
+      if ( h > 0 )
+        horizons_.push_back(h);
+    }
+    std::sort(horizons_.begin(), horizons_.end());
+    horizons_.erase(std::unique(horizons_.begin(), horizons_.end()), horizons_.end());
+  }
+
+  bool ScenarioRunner::advance()
+  {
+    if ( done_ )
+      return false;
+
+    while ( !finished_ ) {
+      if ( next_rec_ >= records_.size() ) {
+        // End of stream: the Python loop flushes against the first record.
+        finished_ = true;
+        final_rec_ = &records_[0];
+        break;
+      }
+
+      const md::l2::Record& rec = records_[next_rec_++];
+      step_once_(rec);
+
+      const bool stop = cfg_.max_steps > 0 && steps_ >= cfg_.max_steps;
+      if ( stop ) {
+        finished_ = true;
+        final_rec_ = &rec;
+      }
+      if ( cfg_.check_every_steps > 0 && (steps_ % cfg_.check_every_steps == 0) ) {
+        run_checkpoint_(rec);
+        return true;
+      }
+    }
+
+    // Final checkpoint to flush tail deltas
+    run_checkpoint_(*final_rec_);
+    done_ = true;
+    return true;
+  }
+
+  void ScenarioRunner::log_(LogLevel level, std::string text)
+  {
+    logs_.push_back(LogLine{level, std::move(text)});
+  }
+
+  void ScenarioRunner::step_once_(const md::l2::Record& rec)
+  {
+    ex_.step(rec);
+    ++steps_;
+
+    // Ingest new fills into the conservation totals
+    const auto& fills = ex_.fills();
+    for ( ; fills_cursor_ < fills.size(); ++fills_cursor_ ) {
+      const FillEvent& f = fills[fills_cursor_];
+      if ( f.side == Side::Buy ) {
+        realised_cash_delta_q_ -= f.notional_cash_q + f.fee_cash_q;
+        realised_pos_delta_q_ += f.qty_q;
+      }
+      else {
+        realised_cash_delta_q_ += f.notional_cash_q - f.fee_cash_q;
+        realised_pos_delta_q_ -= f.qty_q;
+      }
+    }
+
+    if ( cfg_.strict ||
+         (cfg_.conservation_every_steps > 0 && steps_ % cfg_.conservation_every_steps == 0) )
+      check_conservation_();
+
+    const std::optional<i64> mid_q = mid_of(rec);
+
+    // per-step markout update is cheap (no snapshots)
+    if ( cfg_.enable_markout && mid_q )
+      update_markouts_(*mid_q);
+
+    // demo quoting policy
+    if ( cfg_.order_every_steps > 0 && steps_ >= cfg_.warmup_steps &&
+         (steps_ % cfg_.order_every_steps == 0) && mid_q )
+      place_quotes_(*mid_q);
+  }
+
+  void ScenarioRunner::check_conservation_()
+  {
+    const i64 cash_residual = ex_.ledger().cash_q - (c0_ + realised_cash_delta_q_);
+    const i64 pos_residual = ex_.ledger().position_qty_q - (p0_ + realised_pos_delta_q_);
+
+    std::string err;
+    if ( abs_i64(cash_residual) > cfg_.cash_residual_tolerance_q )
+      err = "cash residual " + str(cash_residual) + " exceeds bound " +
+            str(cfg_.cash_residual_tolerance_q);
+    else if ( abs_i64(pos_residual) > cfg_.pos_residual_tolerance_q )
+      err = "pos residual " + str(pos_residual) + " exceeds bound " +
+            str(cfg_.pos_residual_tolerance_q);
+    if ( err.empty() )
+      return;
+
+    const std::string msg = "invariant FAIL at step=" + str(steps_) + ": " + err;
+    log_(LogLevel::Error, msg);
+    if ( cfg_.strict )
+      throw std::runtime_error(msg);
+  }
+
+  void ScenarioRunner::place_quotes_(i64 mid_q)
+  {
+    LimitOrderRequest b{};
+    b.side = Side::Buy;
+    b.price_q = mid_q - cfg_.tick_q;
+    b.qty_q = cfg_.qty_q;
+    b.tif = Tif::GTC;
+
+    LimitOrderRequest s{};
+    s.side = Side::Sell;
+    s.price_q = mid_q + cfg_.tick_q;
+    s.qty_q = cfg_.qty_q;
+    s.tif = Tif::GTC;
+
+    const u64 idb = ex_.place_limit(b);
+    const u64 ida = ex_.place_limit(s);
+    if ( idb == 0 || ida == 0 ) {
+      std::string msg = "order rejected (idb=" + str(idb) + ", ida=" + str(ida) +
+                        "); check max_events/max_orders";
+      if ( cfg_.strict ) {
+        ++failures_;
+        log_(LogLevel::Error, std::move(msg));
+      }
+      else {
+        log_(LogLevel::Warning, std::move(msg));
+      }
+      return;
+    }
+
+    placed_orders_ += 2;
+    log_(
+        LogLevel::Info,
+        "place | step=" + str(steps_) + " | mid_q=" + str(mid_q) + " | bid id=" + str(idb) +
+            " px=" + str(b.price_q) + " qty=" + str(cfg_.qty_q) + " | ask id=" + str(ida) +
+            " px=" + str(s.price_q) + " qty=" + str(cfg_.qty_q));
+  }
+
+  void ScenarioRunner::update_markouts_(i64 mid_q)
+  {
+    if ( markout_pending_.empty() )
+      return;
+
+    std::size_t keep = 0;
+    for ( std::size_t i = 0; i < markout_pending_.size(); ++i ) {
+      PendingMarkout& pm = markout_pending_[i];
+      const i64 sign = (pm.row.side == Side::Buy) ? 1 : -1;
+      for ( std::size_t h = 0; h < horizons_.size(); ++h ) {
+        if ( pm.done[h] )
+          continue;
+        if ( steps_ - pm.row.step0 >= horizons_[h] ) {
+          pm.row.markout_price_q[h] = sign * (mid_q - pm.row.mid0_q);
+          pm.done[h] = true;
+          ++pm.n_done;
+        }
+      }
+
+      if ( pm.n_done == horizons_.size() ) {
+        markout_done_.push_back(std::move(pm.row));
+        continue;
+      }
+      if ( keep != i )
+        markout_pending_[keep] = std::move(pm);
+      ++keep;
+    }
+    markout_pending_.resize(keep);
+  }
+
+  void ScenarioRunner::run_checkpoint_(const md::l2::Record& rec)
+  {
+    const auto& fills = ex_.fills();
+    const auto& events = ex_.events();
+
+    checkpoint_ = ScenarioCheckpoint{};
+    checkpoint_.step = steps_;
+    checkpoint_.fills_begin = last_fills_n_;
+    checkpoint_.fills_end = fills.size();
+    checkpoint_.events_begin = last_events_n_;
+    checkpoint_.events_end = events.size();
+    last_fills_n_ = fills.size();
+    last_events_n_ = events.size();
+
+    // Expected accounting from new fills/events
+    for ( std::size_t i = checkpoint_.fills_begin; i < checkpoint_.fills_end; ++i ) {
+      const FillEvent& f = fills[i];
+      const i64 sign = (f.side == Side::Buy) ? 1 : -1;
+      acc_.expected_cash_q += (-sign) * f.notional_cash_q;
+      acc_.expected_cash_q -= f.fee_cash_q;
+      acc_.expected_fee_cash_q += f.fee_cash_q;
+      ++acc_.fills_seen;
+
+      // infer price scale once (best effort): price_q / notional_cash_q
+      if ( !acc_.inferred_price_scale && f.notional_cash_q != 0 ) {
+        const i64 scale = abs_i64(f.price_q) / abs_i64(f.notional_cash_q);
+        if ( scale > 0 )
+          acc_.inferred_price_scale = scale;
+      }
+    }
+    for ( std::size_t i = checkpoint_.events_begin; i < checkpoint_.events_end; ++i ) {
+      if ( events[i].type == EventType::Reject )
+        reject_ids_.insert(events[i].order_id);
+    }
+
+    const std::optional<i64> mid_q = mid_of(rec);
+
+    // Markouts register new fills at the checkpoint step (approx)
+    if ( cfg_.enable_markout && mid_q ) {
+      for ( std::size_t i = checkpoint_.fills_begin; i < checkpoint_.fills_end; ++i ) {
+        const FillEvent& f = fills[i];
+        PendingMarkout pm{};
+        pm.row.fill_idx = markout_fill_counter_++;
+        pm.row.fill_ts_ns = f.ts.value;
+        pm.row.order_id = f.order_id;
+        pm.row.liq = f.liq;
+        pm.row.side = f.side;
+        pm.row.qty_q = f.qty_q;
+        pm.row.fill_price_q = f.price_q;
+        pm.row.mid0_q = *mid_q;
+        pm.row.step0 = steps_;
+        pm.row.markout_price_q.assign(horizons_.size(), 0);
+        pm.done.assign(horizons_.size(), false);
+        markout_pending_.push_back(std::move(pm));
+      }
+    }
+
+    // Contract: every Reject event refers to a Rejected order with a reason
+    if ( !reject_ids_.empty() ) {
+      std::vector<std::string> bad;
+      for ( u64 oid : reject_ids_ ) {
+        const Order* o = ex_.find_order(oid);
+        if ( !o ) {
+          bad.push_back("Reject event for unknown order_id=" + str(oid));
+          continue;
+        }
+        const std::string st = to_string(o->state);
+        if ( o->state != OrderState::Rejected )
+          bad.push_back("order_id=" + str(oid) + " had Reject event but state=" + st);
+        if ( o->reject_reason == RejectReason::None )
+          bad.push_back("order_id=" + str(oid) + " state=" + st + " but reject_reason=None");
+      }
+      if ( !bad.empty() ) {
+        std::string msg;
+        for ( std::size_t i = 0; i < bad.size() && i < 10; ++i ) {
+          if ( i )
+            msg += " | ";
+          msg += bad[i];
+        }
+        if ( cfg_.strict ) {
+          ++failures_;
+          log_(LogLevel::Error, "contract violation: " + msg);
+        }
+        else {
+          log_(LogLevel::Warning, "WARN: " + msg);
+        }
+      }
+    }
+
+    // Accounting residual
+    const Ledger& led = ex_.ledger();
+    AuditRow& row = checkpoint_.audit;
+    row.step = steps_;
+    row.cash_q = led.cash_q;
+    row.locked_cash_q = led.locked_cash_q;
+    row.cash_total_q = led.cash_q;
+    row.expected_cash_q = acc_.expected_cash_q;
+    row.cash_residual_q = led.cash_q - acc_.expected_cash_q;
+    row.cash_residual_bound_q = cfg_.cash_residual_tolerance_q;
+    acc_.max_cash_residual_q = (std::max)(acc_.max_cash_residual_q, abs_i64(row.cash_residual_q));
+    acc_.max_cash_bound_q = (std::max)(acc_.max_cash_bound_q, cfg_.cash_residual_tolerance_q);
+
+    if ( mid_q ) {
+      const i64 pos = led.position_qty_q;
+      const i64 mid = *mid_q;
+      if ( mid != 0 && pos != 0 )
+        row.overflow_risk_flag = abs_i64(pos) > std::numeric_limits<i64>::max() / abs_i64(mid);
+      acc_.overflow_risk_flag = acc_.overflow_risk_flag || row.overflow_risk_flag;
+
+      // MTM wealth (best effort): cash + pos*mid/scale if scale known
+      if ( acc_.inferred_price_scale && *acc_.inferred_price_scale > 0 ) {
+        if ( const auto pv = mul_floordiv(pos, mid, *acc_.inferred_price_scale) )
+          row.wealth_mtm_q = led.cash_q + *pv;
+      }
+    }
+    row.inferred_price_scale = acc_.inferred_price_scale;
+    row.mid_q = mid_q;
+    row.pass = abs_i64(row.cash_residual_q) <= cfg_.cash_residual_tolerance_q;
+    row.ts_ns = ex_.now().value;
+
+    if ( !row.pass ) {
+      ++failures_;
+      log_(
+          LogLevel::Error,
+          "invariant FAIL at step=" + str(steps_) + ": cash residual " +
+              str(row.cash_residual_q) + " exceeds bound " + str(row.cash_residual_bound_q));
+    }
+
+    log_(
+        LogLevel::Info,
+        "progress | steps=" + str(steps_) + " | placed=" + str(placed_orders_) +
+            " | fills=" + str(static_cast<u64>(last_fills_n_)) +
+            " | events=" + str(static_cast<u64>(last_events_n_)) + " | cash=" + str(led.cash_q) +
+            " | locked_cash=" + str(led.locked_cash_q) +
+            " | avail_cash=" + str(led.cash_q - led.locked_cash_q) +
+            " | pos=" + str(led.position_qty_q) +
+            " | locked_pos=" + str(led.locked_position_qty_q) +
+            " | avail_pos=" + str(led.position_qty_q - led.locked_position_qty_q));
+  }
+
+} // namespace sim
@@ -2,7 +2,9 @@
 
 #include <algorithm>
 
+#include "action_log.hpp"
 #include "schema.hpp"
+#include "sim_digest.hpp"
 #include "sim_queue.hpp"
 
 namespace sim
@@ -19,14 +21,25 @@ namespace sim
     now_ = start_ts;
     ledger_ = initial_ledger;
     market_ = nullptr;
+    deltas_ = nullptr;
 
     orders_.clear();
     events_.clear();
     fills_.clear();
     pending_ = decltype(pending_)();
+    ++storage_version_;
 
     next_order_id_ = 1;
     next_seq_ = 1;
+    step_count_ = 0;
+
+    digest_ = digest::kSeed;
+    digest_ = digest::mix(digest_, start_ts.value);
+    digest_ = digest::mix(digest_, initial_ledger.cash_q);
+    digest_ = digest::mix(digest_, initial_ledger.position_qty_q);
+    digest_ = digest::mix(digest_, initial_ledger.locked_cash_q);
+    digest_ = digest::mix(digest_, initial_ledger.locked_position_qty_q);
+    digest_trail_.clear();
 
     id_to_index_.assign(params_.max_orders + 1, kInvalidIndex);
     id_to_index_[0] = kInvalidIndex;
@@ -49,12 +62,24 @@ namespace sim
 
     SIM_ASSERT(ledger_.locked_cash_q >= 0);
     SIM_ASSERT(ledger_.locked_position_qty_q >= 0);
+
+    if ( action_log_ )
+      action_log_->begin_(params_, start_ts, initial_ledger);
+  }
+
+  void MarketSimulator::step(const md::l2::Record& rec, const md::l2::LevelDeltaRecord& deltas)
+  {
+    deltas_ = &deltas;
+    step(rec);
   }
 
   void MarketSimulator::step(const md::l2::Record& rec)
   {
     market_ = &rec;
     now_ = Ns{static_cast<u64>(rec.ts_recv_ns)};
+    ++step_count_;
+    if ( action_log_ )
+      action_log_->on_step_(rec);
 
     // ------------------------------------------------------------
     // (1) Queue + passive fills are handled bucket-level in
@@ -178,7 +203,10 @@ namespace sim
         }
       }
 
+      digest_step_();
+
       market_ = nullptr;
+      deltas_ = nullptr;
     }
   }
 
@@ -187,6 +215,14 @@ namespace sim
     if ( events_.size() >= params_.max_events )
       return false;
     events_.push_back(Event{ts, id, et, st, rr});
+    digest_ = digest::mix(digest_, ts.value);
+    digest_ = digest::mix(digest_, id);
+    digest_ = digest::mix(
+        digest_,
+        digest::tags(
+            static_cast<std::uint8_t>(et),
+            static_cast<std::uint8_t>(st),
+            static_cast<std::uint8_t>(rr)));
     return true;
   }
 
@@ -216,4 +252,34 @@ namespace sim
     }
   }
 
+  void MarketSimulator::digest_step_()
+  {
+    digest_ = digest::mix(digest_, step_count_);
+    digest_ = digest::mix(digest_, now_.value);
+    digest_ = digest::mix(digest_, ledger_.cash_q);
+    digest_ = digest::mix(digest_, ledger_.position_qty_q);
+    digest_ = digest::mix(digest_, ledger_.locked_cash_q);
+    digest_ = digest::mix(digest_, ledger_.locked_position_qty_q);
+
+    const u64 every = params_.digest_every_steps;
+    if ( every > 0 && step_count_ % every == 0 )
+      digest_trail_.push_back(DigestCheckpoint{step_count_, now_, digest_});
+  }
+
+  std::size_t first_divergence(
+      std::span<const DigestCheckpoint> a,
+      std::span<const DigestCheckpoint> b) noexcept
+  {
+    std::size_t lo = 0;
+    std::size_t hi = (std::min)(a.size(), b.size());
+    while ( lo < hi ) {
+      const std::size_t mid = lo + (hi - lo) / 2;
+      if ( a[mid].digest == b[mid].digest && a[mid].step == b[mid].step )
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    return lo;
+  }
+
 } // namespace sim
@@ -0,0 +1,642 @@
+#include "sim_batched.hpp"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+#include "sim_fixed_point.hpp"
+#include "sim_lookup.hpp"
+#include "sim_queue.hpp"
+#include "sim_rng.hpp"
+
+namespace sim
+{
+  namespace
+  {
+    constexpr std::uint8_t kWorkPassive = 1;    // depletion to allocate
+    constexpr std::uint8_t kWorkAggressive = 2; // a resting order is marketable
+    constexpr std::uint8_t kWorkActivate = 4;   // a pending order is due
+
+    inline bool is_resting(OrderState st) noexcept
+    {
+      return st == OrderState::Active || st == OrderState::Partial;
+    }
+
+    inline bool is_live(OrderState st) noexcept
+    {
+      return st == OrderState::Pending || is_resting(st);
+    }
+
+    // Bucket visibility state machine, trade-through and depletion for one resting
+    // order, on the bucket state replicated into its slot (mirrors
+    // MarketSimulator::apply_passive_fills_one_bucket_). Returns the effective
+    // depletion to allocate at this price (0 on a re-anchor or visibility change).
+    inline i64 update_bucket(
+        const SimulatorParams& params,
+        u64 stream,
+        u64 step,
+        const lookup::LevelLookup& m,
+        i64 best_bid,
+        i64 best_ask,
+        Side side,
+        i64 price_q,
+        Visibility& vis,
+        std::int16_t& level_idx,
+        i64& level_qty,
+        i64& ahead) noexcept
+    {
+      if ( m.found ) {
+        if ( vis == Visibility::Frozen || vis == Visibility::Blind || level_idx < 0 ) {
+          // Pessimistic re-anchor; no depletion inferred on this tick
+          vis = Visibility::Visible;
+          level_idx = m.idx;
+          level_qty = m.qty_q;
+          ahead = m.qty_q;
+          return 0;
+        }
+      }
+      else {
+        if ( m.within_range ) {
+          if ( vis == Visibility::Blind ) {
+            vis = Visibility::Visible;
+            level_idx = -1;
+            level_qty = 0;
+            ahead = 0;
+          }
+          else if ( vis == Visibility::Visible && level_idx >= 0 ) {
+            vis = Visibility::Frozen;
+            level_idx = -1;
+            level_qty = 0;
+          }
+        }
+        else if ( vis == Visibility::Visible ) {
+          vis = Visibility::Frozen;
+          level_idx = -1;
+          level_qty = 0;
+        }
+        return 0;
+      }
+
+      // Trade-through: if crossed, the queue is irrelevant
+      if ( side == Side::Buy ) {
+        if ( lookup::is_valid_ask_price(best_ask) && best_ask <= price_q )
+          ahead = 0;
+      }
+      else {
+        if ( lookup::is_valid_bid_price(best_bid) && best_bid >= price_q )
+          ahead = 0;
+      }
+
+      const i64 prev = level_qty;
+      const i64 nowq = m.qty_q;
+      const i64 depl = (prev > nowq) ? (prev - nowq) : 0;
+      level_idx = m.idx;
+      level_qty = nowq;
+      return rng::effective_depletion(params, stream, step, side, price_q, depl);
+    }
+  } // namespace
+
+  BatchedSimulator::BatchedSimulator(
+      const SimulatorParams& params,
+      std::size_t envs,
+      std::size_t slots)
+      : params_(params), envs_(envs), slots_(slots)
+  {
+    if ( envs_ < 1 )
+      throw std::runtime_error("BatchedSimulator: need envs >= 1");
+    if ( slots_ < 1 || slots_ > kMaxSlots )
+      throw std::runtime_error("BatchedSimulator: slots must be in [1, 64]");
+    SIM_ASSERT(params_.alpha_ppm <= 1'000'000);
+
+    now_.resize(envs_);
+    cash_.resize(envs_);
+    position_.resize(envs_);
+    locked_cash_.resize(envs_);
+    locked_position_.resize(envs_);
+    next_seq_.resize(envs_);
+    steps_.resize(envs_);
+    fill_count_.resize(envs_);
+    fifo_.resize(envs_ * slots_);
+    fifo_len_.resize(envs_);
+    rec_.resize(envs_);
+    work_.resize(envs_);
+
+    const std::size_t n = envs_ * slots_;
+    state_.resize(n);
+    side_.resize(n);
+    price_.resize(n);
+    qty_.resize(n);
+    filled_.resize(n);
+    ahead_.resize(n);
+    activate_ts_.resize(n);
+    seq_.resize(n);
+    vis_.resize(n);
+    level_idx_.resize(n);
+    level_qty_.resize(n);
+    depletion_.resize(n);
+
+    reset(Ns{0}, Ledger{});
+  }
+
+  void BatchedSimulator::reset(Ns start_ts, const Ledger& initial_ledger)
+  {
+    for ( std::size_t e = 0; e < envs_; ++e )
+      reset(e, start_ts, initial_ledger);
+  }
+
+  void BatchedSimulator::reset(std::size_t env, Ns start_ts, const Ledger& initial_ledger)
+  {
+    SIM_ASSERT(env < envs_);
+    SIM_ASSERT(initial_ledger.locked_cash_q >= 0);
+    SIM_ASSERT(initial_ledger.locked_position_qty_q >= 0);
+
+    now_[env] = start_ts.value;
+    cash_[env] = initial_ledger.cash_q;
+    position_[env] = initial_ledger.position_qty_q;
+    locked_cash_[env] = initial_ledger.locked_cash_q;
+    locked_position_[env] = initial_ledger.locked_position_qty_q;
+    next_seq_[env] = 1;
+    steps_[env] = 0;
+    fill_count_[env] = 0;
+    fifo_len_[env] = 0;
+    rec_[env] = nullptr;
+    work_[env] = 0;
+
+    for ( std::size_t k = 0; k < slots_; ++k ) {
+      const std::size_t i = k * envs_ + env;
+      state_[i] = OrderState::Rejected; // free
+      side_[i] = Side::Buy;
+      price_[i] = 0;
+      qty_[i] = 0;
+      filled_[i] = 0;
+      ahead_[i] = 0;
+      activate_ts_[i] = 0;
+      seq_[i] = 0;
+      vis_[i] = Visibility::Blind;
+      level_idx_[i] = -1;
+      level_qty_[i] = 0;
+      depletion_[i] = 0;
+    }
+  }
+
+  // ----------------------------
+  // Orders
+  // ----------------------------
+  u64 BatchedSimulator::place_limit(std::size_t env, const LimitOrderRequest& req)
+  {
+    SIM_ASSERT(env < envs_);
+
+    std::size_t k = 0;
+    while ( k < slots_ && is_live(state_[k * envs_ + env]) )
+      ++k;
+    if ( k == slots_ )
+      return 0;
+
+    if ( req.qty_q <= 0 || req.price_q <= 0 )
+      return 0;
+
+    // Risk check and lock (MarketSimulator::risk_check_and_lock_limit_)
+    if ( req.side == Side::Buy ) {
+      i64 required = 0;
+      if ( fixed::mul_i64_overflow(req.price_q, req.qty_q, &required) || required < 0 )
+        return 0;
+      if ( cash_[env] - locked_cash_[env] < required )
+        return 0;
+      locked_cash_[env] += required;
+    }
+    else {
+      if ( params_.risk.spot_no_short &&
+           position_[env] - locked_position_[env] < req.qty_q )
+        return 0;
+      locked_position_[env] += req.qty_q;
+    }
+
+    const std::size_t i = k * envs_ + env;
+    state_[i] = OrderState::Pending;
+    side_[i] = req.side;
+    price_[i] = req.price_q;
+    qty_[i] = req.qty_q;
+    filled_[i] = 0;
+    ahead_[i] = 0;
+    seq_[i] = next_seq_[env]++;
+    activate_ts_[i] =
+        (Ns{now_[env]} + rng::outbound_latency(params_, params_.rng_stream + env, seq_[i])).value;
+    vis_[i] = Visibility::Blind;
+    level_idx_[i] = -1;
+    level_qty_[i] = 0;
+    return static_cast<u64>(k) + 1;
+  }
+
+  bool BatchedSimulator::cancel(std::size_t env, u64 handle)
+  {
+    SIM_ASSERT(env < envs_);
+    if ( !valid_(handle) )
+      return false;
+    const std::size_t i = at_(env, handle);
+    if ( !is_live(state_[i]) )
+      return false;
+
+    // A resting order leaves the activation FIFO at the next compaction
+    unlock_remaining_(env, i);
+    state_[i] = OrderState::Cancelled;
+    return true;
+  }
+
+  void BatchedSimulator::unlock_remaining_(std::size_t env, std::size_t i)
+  {
+    const i64 remaining = qty_[i] - filled_[i];
+    if ( remaining <= 0 )
+      return;
+
+    if ( side_[i] == Side::Buy ) {
+      i64 delta = 0;
+      if ( fixed::mul_i64_overflow(price_[i], remaining, &delta) )
+        locked_cash_[env] = 0;
+      else
+        locked_cash_[env] -= delta;
+      if ( locked_cash_[env] < 0 )
+        locked_cash_[env] = 0;
+    }
+    else {
+      locked_position_[env] -= remaining;
+      if ( locked_position_[env] < 0 )
+        locked_position_[env] = 0;
+    }
+  }
+
+  void BatchedSimulator::apply_fill_(
+      std::size_t env,
+      std::size_t i,
+      i64 price_q,
+      i64 qty_q,
+      LiquidityFlag liq)
+  {
+    SIM_ASSERT(qty_q > 0);
+    SIM_ASSERT(filled_[i] + qty_q <= qty_[i]);
+
+    const i64 notional_q = fixed::notional_cash_q(price_q, qty_q);
+    const u64 fee_ppm =
+        (liq == LiquidityFlag::Maker) ? params_.fees.maker_fee_ppm : params_.fees.taker_fee_ppm;
+    const i64 fee_q = fixed::fee_cash_q(notional_q, fee_ppm);
+
+    if ( side_[i] == Side::Buy ) {
+      cash_[env] -= notional_q;
+      cash_[env] -= fee_q;
+      position_[env] += qty_q;
+    }
+    else {
+      cash_[env] += notional_q;
+      cash_[env] -= fee_q;
+      position_[env] -= qty_q;
+    }
+
+    filled_[i] += qty_q;
+    if ( filled_[i] == qty_[i] ) {
+      unlock_remaining_(env, i);
+      state_[i] = OrderState::Filled;
+    }
+    else {
+      state_[i] = OrderState::Partial;
+    }
+    ++fill_count_[env];
+  }
+
+  // ----------------------------
+  // Step
+  // ----------------------------
+  void BatchedSimulator::step(const md::l2::Record& rec)
+  {
+    std::fill(rec_.begin(), rec_.end(), &rec);
+    step_();
+  }
+
+  void BatchedSimulator::step(
+      std::span<const md::l2::Record> records,
+      std::span<const std::uint32_t> index)
+  {
+    if ( index.size() != envs_ )
+      throw std::runtime_error("BatchedSimulator::step: index.size() must equal envs()");
+    for ( std::size_t e = 0; e < envs_; ++e ) {
+      if ( index[e] >= records.size() )
+        throw std::runtime_error("BatchedSimulator::step: record index out of range");
+      rec_[e] = &records[index[e]];
+    }
+    step_();
+  }
+
+  void BatchedSimulator::step(std::span<const md::l2::Record* const> records)
+  {
+    if ( records.size() != envs_ )
+      throw std::runtime_error("BatchedSimulator::step: records.size() must equal envs()");
+    for ( std::size_t e = 0; e < envs_; ++e ) {
+      if ( !records[e] )
+        throw std::runtime_error("BatchedSimulator::step: null record");
+      rec_[e] = records[e];
+    }
+    step_();
+  }
+
+  void BatchedSimulator::step_()
+  {
+    for ( std::size_t e = 0; e < envs_; ++e ) {
+      now_[e] = static_cast<u64>(rec_[e]->ts_recv_ns);
+      ++steps_[e];
+    }
+
+    // (1) Queue state + depletion for every resting order
+    queue_pass_();
+
+    // (2) Passive fills, (3) aggressive fills
+    for ( std::size_t e = 0; e < envs_; ++e ) {
+      if ( work_[e] & kWorkPassive )
+        passive_fills_(e);
+      if ( work_[e] & kWorkAggressive )
+        aggressive_fills_(e);
+    }
+
+    // (4) Activate newly-due orders (NOT fill-eligible until next step)
+    for ( std::size_t k = 0; k < slots_; ++k ) {
+      const std::size_t base = k * envs_;
+      for ( std::size_t e = 0; e < envs_; ++e ) {
+        const bool due =
+            state_[base + e] == OrderState::Pending && activate_ts_[base + e] <= now_[e];
+        work_[e] |= due ? kWorkActivate : 0;
+      }
+    }
+    for ( std::size_t e = 0; e < envs_; ++e ) {
+      if ( work_[e] & kWorkActivate )
+        activate_due_(e);
+    }
+  }
+
+  void BatchedSimulator::queue_pass_()
+  {
+    std::fill(work_.begin(), work_.end(), std::uint8_t{0});
+
+    for ( std::size_t k = 0; k < slots_; ++k ) {
+      const std::size_t base = k * envs_;
+      for ( std::size_t e = 0; e < envs_; ++e ) {
+        const std::size_t i = base + e;
+        depletion_[i] = 0;
+        if ( !is_resting(state_[i]) )
+          continue;
+
+        const md::l2::Record& r = *rec_[e];
+        const i64 best_bid = r.bids[0].price_q;
+        const i64 best_ask = r.asks[0].price_q;
+        const Side side = side_[i];
+        const i64 px = price_[i];
+        const lookup::LevelLookup m =
+            (side == Side::Buy) ? lookup::bid_level(r, px) : lookup::ask_level(r, px);
+
+        const i64 ep = update_bucket(
+            params_,
+            params_.rng_stream + e,
+            steps_[e],
+            m,
+            best_bid,
+            best_ask,
+            side,
+            px,
+            vis_[i],
+            level_idx_[i],
+            level_qty_[i],
+            ahead_[i]);
+        depletion_[i] = ep;
+
+        // Superset of the aggressive pass: passive fills only remove orders
+        const bool marketable =
+            (side == Side::Buy)
+                ? (lookup::is_valid_ask_price(best_ask) && px >= best_ask)
+                : (lookup::is_valid_bid_price(best_bid) && px <= best_bid);
+        work_[e] |= static_cast<std::uint8_t>(
+            (ep > 0 ? kWorkPassive : 0) | (marketable ? kWorkAggressive : 0));
+      }
+    }
+  }
+
+  void BatchedSimulator::passive_fills_(std::size_t env)
+  {
+    // FIFO allocation per price: walk resting orders in activation order; each
+    // hands its bucket's leftover depletion to the later orders at its price.
+    const std::uint8_t* q = fifo_.data() + env * slots_;
+    const std::size_t len = fifo_len_[env];
+    for ( std::size_t j = 0; j < len; ++j ) {
+      const std::size_t i = q[j] * envs_ + env;
+      if ( !is_resting(state_[i]) )
+        continue;
+      i64 ep = depletion_[i];
+      if ( ep <= 0 )
+        continue;
+
+      // 1) Consume depletion to move this order forward in the displayed queue
+      if ( ahead_[i] > 0 ) {
+        const i64 consume = (ahead_[i] < ep) ? ahead_[i] : ep;
+        ahead_[i] -= consume;
+        ep -= consume;
+      }
+
+      // 2) If at front, allocate the rest to this order as a passive fill
+      if ( ep > 0 && ahead_[i] == 0 ) {
+        const i64 remaining = qty_[i] - filled_[i];
+        if ( remaining > 0 ) {
+          const i64 fill = (remaining < ep) ? remaining : ep;
+          apply_fill_(env, i, price_[i], fill, LiquidityFlag::Maker);
+          ep -= fill;
+        }
+      }
+
+      for ( std::size_t jj = j + 1; jj < len; ++jj ) {
+        const std::size_t t = q[jj] * envs_ + env;
+        if ( is_resting(state_[t]) && side_[t] == side_[i] && price_[t] == price_[i] )
+          depletion_[t] = ep;
+      }
+    }
+  }
+
+  void BatchedSimulator::aggressive_fills_(std::size_t env)
+  {
+    const md::l2::Record& r = *rec_[env];
+    if ( !md::l2::record_has_top_of_book(r) )
+      return;
+
+    const i64 best_bid = r.bids[0].price_q;
+    const i64 best_ask = r.asks[0].price_q;
+
+    // Marketable resting orders in FIFO order, then by price priority (stable)
+    std::array<std::size_t, kMaxSlots> buys{};
+    std::array<std::size_t, kMaxSlots> sells{};
+    std::size_t nb = 0;
+    std::size_t ns = 0;
+    const std::uint8_t* q = fifo_.data() + env * slots_;
+    for ( std::size_t j = 0; j < fifo_len_[env]; ++j ) {
+      const std::size_t i = q[j] * envs_ + env;
+      if ( !is_resting(state_[i]) )
+        continue;
+      if ( side_[i] == Side::Buy ) {
+        if ( lookup::is_valid_ask_price(best_ask) && price_[i] >= best_ask )
+          buys[nb++] = i;
+      }
+      else if ( lookup::is_valid_bid_price(best_bid) && price_[i] <= best_bid ) {
+        sells[ns++] = i;
+      }
+    }
+    std::stable_sort(buys.begin(), buys.begin() + nb, [this](std::size_t a, std::size_t b) {
+      return price_[a] > price_[b];
+    });
+    std::stable_sort(sells.begin(), sells.begin() + ns, [this](std::size_t a, std::size_t b) {
+      return price_[a] < price_[b];
+    });
+
+    // Local copy of visible depth so orders in the same step consume it sequentially
+    std::array<i64, md::l2::kDepth> bid_qty_rem{};
+    std::array<i64, md::l2::kDepth> ask_qty_rem{};
+    for ( std::size_t l = 0; l < md::l2::kDepth; ++l ) {
+      bid_qty_rem[l] = lookup::is_valid_bid_price(r.bids[l].price_q) ? r.bids[l].qty_q : 0;
+      ask_qty_rem[l] = lookup::is_valid_ask_price(r.asks[l].price_q) ? r.asks[l].qty_q : 0;
+    }
+
+    // BUY takers sweep asks from best outward while ask_price <= limit
+    for ( std::size_t n = 0; n < nb; ++n ) {
+      const std::size_t i = buys[n];
+      i64 remaining = qty_[i] - filled_[i];
+      for ( std::size_t l = 0; l < md::l2::kDepth && remaining > 0; ++l ) {
+        const i64 px = r.asks[l].price_q;
+        if ( !lookup::is_valid_ask_price(px) || px > price_[i] )
+          break;
+        i64& avail = ask_qty_rem[l];
+        if ( avail <= 0 )
+          continue;
+        const i64 dq = (remaining < avail) ? remaining : avail;
+        apply_fill_(env, i, px, dq, LiquidityFlag::Taker);
+        remaining -= dq;
+        avail -= dq;
+      }
+    }
+
+    // SELL takers sweep bids from best outward while bid_price >= limit
+    for ( std::size_t n = 0; n < ns; ++n ) {
+      const std::size_t i = sells[n];
+      i64 remaining = qty_[i] - filled_[i];
+      for ( std::size_t l = 0; l < md::l2::kDepth && remaining > 0; ++l ) {
+        const i64 px = r.bids[l].price_q;
+        if ( !lookup::is_valid_bid_price(px) || px < price_[i] )
+          break;
+        i64& avail = bid_qty_rem[l];
+        if ( avail <= 0 )
+          continue;
+        const i64 dq = (remaining < avail) ? remaining : avail;
+        apply_fill_(env, i, px, dq, LiquidityFlag::Taker);
+        remaining -= dq;
+        avail -= dq;
+      }
+    }
+  }
+
+  // ----------------------------
+  // Activation
+  // ----------------------------
+  void BatchedSimulator::compact_fifo_(std::size_t env)
+  {
+    std::uint8_t* q = fifo_.data() + env * slots_;
+    std::size_t out = 0;
+    for ( std::size_t j = 0; j < fifo_len_[env]; ++j ) {
+      if ( is_resting(state_[q[j] * envs_ + env]) )
+        q[out++] = q[j];
+    }
+    fifo_len_[env] = static_cast<std::uint8_t>(out);
+  }
+
+  bool BatchedSimulator::apply_stp_on_activate_(std::size_t env, std::size_t i)
+  {
+    if ( params_.stp == StpPolicy::None )
+      return true;
+
+    // Self-cross against the best resting opposite price (MarketSimulator keeps
+    // it as a summary; with a handful of slots a scan is as cheap).
+    const bool buy = side_[i] == Side::Buy;
+    bool self_cross = false;
+    for ( std::size_t k = 0; k < slots_ && !self_cross; ++k ) {
+      const std::size_t t = k * envs_ + env;
+      if ( is_resting(state_[t]) && side_[t] != side_[i] )
+        self_cross = buy ? (price_[t] <= price_[i]) : (price_[t] >= price_[i]);
+    }
+    if ( !self_cross )
+      return true;
+
+    if ( params_.stp == StpPolicy::RejectIncoming ) {
+      unlock_remaining_(env, i);
+      state_[i] = OrderState::Rejected;
+      return false;
+    }
+
+    // CancelResting: cancel ALL crossing opposite resting orders
+    for ( std::size_t k = 0; k < slots_; ++k ) {
+      const std::size_t t = k * envs_ + env;
+      if ( !is_resting(state_[t]) || side_[t] == side_[i] )
+        continue;
+      if ( buy ? (price_[t] <= price_[i]) : (price_[t] >= price_[i]) ) {
+        unlock_remaining_(env, t);
+        state_[t] = OrderState::Cancelled;
+      }
+    }
+    return true;
+  }
+
+  void BatchedSimulator::activate_due_(std::size_t env)
+  {
+    compact_fifo_(env);
+    std::uint8_t* q = fifo_.data() + env * slots_;
+    const md::l2::Record& rec = *rec_[env];
+
+    for ( ;; ) {
+      // Next due order by (activate_ts, seq), as MarketSimulator's pending heap
+      std::size_t k_next = slots_;
+      for ( std::size_t k = 0; k < slots_; ++k ) {
+        const std::size_t i = k * envs_ + env;
+        if ( state_[i] != OrderState::Pending || activate_ts_[i] > now_[env] )
+          continue;
+        if ( k_next == slots_ )
+          k_next = k;
+        else {
+          const std::size_t b = k_next * envs_ + env;
+          if ( activate_ts_[i] < activate_ts_[b] ||
+               (activate_ts_[i] == activate_ts_[b] && seq_[i] < seq_[b]) )
+            k_next = k;
+        }
+      }
+      if ( k_next == slots_ )
+        break;
+
+      const std::size_t i = k_next * envs_ + env;
+      if ( !apply_stp_on_activate_(env, i) )
+        continue;
+
+      state_[i] = OrderState::Active;
+
+      Order o{};
+      o.type = OrderType::Limit;
+      o.side = side_[i];
+      o.price_q = price_[i];
+      queue::init_on_activate(rec, o);
+      ahead_[i] = o.qty_ahead_q;
+
+      // Join the bucket state of a resting order at this price, else seed it from
+      // the activation-time snapshot.
+      vis_[i] = o.visibility;
+      level_idx_[i] = o.last_level_idx;
+      level_qty_[i] = o.last_level_qty_q;
+      for ( std::size_t j = 0; j < fifo_len_[env]; ++j ) {
+        const std::size_t t = q[j] * envs_ + env;
+        if ( is_resting(state_[t]) && side_[t] == side_[i] && price_[t] == price_[i] ) {
+          vis_[i] = vis_[t];
+          level_idx_[i] = level_idx_[t];
+          level_qty_[i] = level_qty_[t];
+          break;
+        }
+      }
+      q[fifo_len_[env]++] = static_cast<std::uint8_t>(k_next);
+    }
+  }
+
+} // namespace sim
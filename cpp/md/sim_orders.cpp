@@ -1,41 +1,10 @@
-#include <limits>
-
+#include "action_log.hpp"
 #include "sim.hpp"
-
-#if defined(_MSC_VER)
-#  include <intrin.h>
-#endif
+#include "sim_fixed_point.hpp"
+#include "sim_rng.hpp"
 
 namespace
 {
-  inline bool mul_i64_overflow(sim::i64 a, sim::i64 b, sim::i64* out)
-  {
-#if defined(_MSC_VER)
-    // MSVC x64: use builtin 128-bit multiply
-    // Note: _mul128 returns high 64 bits and stores low 64 bits in *out_low.
-    __int64 high = 0;
-    __int64 low = 0;
-    low = _mul128(static_cast<__int64>(a), static_cast<__int64>(b), &high);
-
-    // If high is not sign-extension of low's sign bit, overflow occurred
-    const bool neg = (low < 0);
-    const __int64 expected_high = neg ? -1 : 0;
-    if ( high != expected_high )
-      return true;
-
-    *out = static_cast<sim::i64>(low);
-    return false;
-#else
-    __int128 prod = static_cast<__int128>(a) * static_cast<__int128>(b);
-    if ( prod > static_cast<__int128>(std::numeric_limits<sim::i64>::max()) )
-      return true;
-    if ( prod < static_cast<__int128>(std::numeric_limits<sim::i64>::min()) )
-      return true;
-    *out = static_cast<sim::i64>(prod);
-    return false;
-#endif
-  }
-
   inline bool is_terminal(sim::OrderState st)
   {
     return st == sim::OrderState::Filled || st == sim::OrderState::Cancelled ||
@@ -51,6 +20,21 @@ namespace
 namespace sim
 {
   u64 MarketSimulator::place_limit(const LimitOrderRequest& req)
+  {
+    const u64 id = place_limit_(req);
+    if ( action_log_ )
+      log_action_(
+          ActionType::PlaceLimit,
+          req.side,
+          req.tif,
+          req.price_q,
+          req.qty_q,
+          req.client_order_id,
+          id);
+    return id;
+  }
+
+  u64 MarketSimulator::place_limit_(const LimitOrderRequest& req)
   {
     if ( next_order_id_ == 0 || next_order_id_ > params_.max_orders ) {
       (void)push_event_(
@@ -105,7 +89,7 @@ namespace sim
     o.price_q = req.price_q;
     o.qty_q = req.qty_q;
     o.submit_ts = now_;
-    o.activate_ts = now_ + params_.outbound_latency;
+    o.activate_ts = now_ + rng::outbound_latency(params_, params_.rng_stream, id);
     o.state = OrderState::Pending;
 
     orders_.push_back(o);
@@ -125,6 +109,9 @@ namespace sim
 
   u64 MarketSimulator::place_market(const MarketOrderRequest& req)
   {
+    if ( action_log_ )
+      log_action_(
+          ActionType::PlaceMarket, req.side, req.tif, 0, req.qty_q, req.client_order_id, 0);
     const RejectReason vr = validate_market_(req);
     if ( vr != RejectReason::None ) {
       (void)push_event_(now_, 0, EventType::Reject, OrderState::Rejected, vr);
@@ -137,6 +124,13 @@ namespace sim
   }
 
   bool MarketSimulator::cancel(u64 order_id)
+  {
+    if ( action_log_ )
+      log_action_(ActionType::Cancel, Side::Buy, Tif::GTC, 0, 0, 0, order_id);
+    return cancel_(order_id);
+  }
+
+  bool MarketSimulator::cancel_(u64 order_id)
   {
     if ( order_id == 0 || order_id >= id_to_index_.size() )
       return false;
@@ -187,7 +181,7 @@ namespace sim
 
     if ( side == Side::Buy ) {
       i64 required = 0;
-      if ( mul_i64_overflow(price_q, qty_q, &required) )
+      if ( fixed::mul_i64_overflow(price_q, qty_q, &required) )
         return RejectReason::InvalidParams;
       if ( required < 0 )
         return RejectReason::InvalidParams;
@@ -224,7 +218,7 @@ namespace sim
 
     if ( o.side == Side::Buy ) {
       i64 delta = 0;
-      if ( mul_i64_overflow(o.price_q, remaining, &delta) ) {
+      if ( fixed::mul_i64_overflow(o.price_q, remaining, &delta) ) {
         // Should never happen if lock used same arithmetic
         ledger_.locked_cash_q = 0;
       }
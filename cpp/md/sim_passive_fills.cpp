@@ -1,6 +1,9 @@
+#include <cstddef>
+
 #include "schema.hpp"
 #include "sim.hpp"
 #include "sim_lookup.hpp"
+#include "sim_rng.hpp"
 
 namespace sim
 {
@@ -23,11 +26,34 @@ namespace sim
     const i64 best_bid = rec.bids[0].price_q;
     const i64 best_ask = rec.asks[0].price_q;
 
-    // Lookup this bucket price in top-N
-    const auto m =
-        (side == Side::Buy)
-            ? lookup::bid_level(rec, bucket_price_q)
-            : lookup::ask_level(rec, bucket_price_q);
+    // Lookup this bucket price in top-N.
+    // With a delta stream, a bucket seen at level j on the previous step is found at
+    // next_idx[j] in O(1) and its qty change is read directly; anything else (vanished,
+    // re-anchor, mismatched stream) falls back to the snapshot scan.
+    lookup::LevelLookup m{};
+    bool have_dq = false;
+    i64 dq = 0;
+    if ( deltas_ && b.visibility == Visibility::Visible && b.last_level_idx >= 0 &&
+         b.last_level_idx < static_cast<std::int16_t>(md::l2::kDepth) ) {
+      const auto& ds = (side == Side::Buy) ? deltas_->bids : deltas_->asks;
+      const std::int8_t k = ds.next_idx[static_cast<std::size_t>(b.last_level_idx)];
+      if ( k >= 0 ) {
+        const auto& lv = (side == Side::Buy) ? rec.bids[k] : rec.asks[k];
+        if ( lv.price_q == bucket_price_q ) {
+          m.found = true;
+          m.within_range = true;
+          m.idx = k;
+          m.qty_q = lv.qty_q;
+          dq = ds.dqty_q[static_cast<std::size_t>(k)];
+          have_dq = true;
+        }
+      }
+    }
+    if ( !have_dq ) {
+      m = (side == Side::Buy)
+              ? lookup::bid_level(rec, bucket_price_q)
+              : lookup::ask_level(rec, bucket_price_q);
+    }
 
     // ----------------------------
     // Bucket-level visibility state machine (mirrors update_one_cached behavior)
@@ -138,8 +164,12 @@ namespace sim
     // ----------------------------
     const i64 prev = b.last_level_qty_q;
     const i64 nowq = m.qty_q;
-    const i64 depl = (prev > nowq) ? (prev - nowq) : 0;
-    i64 Ep = lookup::effective_depletion(depl, params_.alpha_ppm);
+    // Stream deltas are relative to the previous record, which is exactly what the
+    // bucket last observed (buckets are refreshed every step).
+    SIM_ASSERT(!have_dq || dq == nowq - prev);
+    const i64 depl = have_dq ? ((dq < 0) ? -dq : 0) : ((prev > nowq) ? (prev - nowq) : 0);
+    i64 Ep = rng::effective_depletion(
+        params_, params_.rng_stream, step_count_, side, bucket_price_q, depl);
 
     b.last_level_idx = m.idx;
     b.last_level_qty_q = nowq;
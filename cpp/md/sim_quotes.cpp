@@ -0,0 +1,129 @@
+#include <algorithm>
+
+#include "action_log.hpp"
+#include "sim.hpp"
+
+namespace sim
+{
+
+  std::vector<u64> MarketSimulator::set_quotes(Side side, std::span<const QuoteLevel> ladder)
+  {
+    // --- Desired ladder: sorted by price, repeated prices summed ---
+    quote_want_.clear();
+    for ( const QuoteLevel& q : ladder )
+      quote_want_.push_back(QuoteWant{q.price_q, q.qty_q > 0 ? q.qty_q : 0, 0, 0});
+    std::sort(
+        quote_want_.begin(),
+        quote_want_.end(),
+        [](const QuoteWant& a, const QuoteWant& b) { return a.price_q < b.price_q; });
+    {
+      std::size_t n = 0;
+      for ( std::size_t i = 0; i < quote_want_.size(); ++i ) {
+        if ( n > 0 && quote_want_[n - 1].price_q == quote_want_[i].price_q )
+          quote_want_[n - 1].qty_q += quote_want_[i].qty_q;
+        else
+          quote_want_[n++] = quote_want_[i];
+      }
+      quote_want_.resize(n);
+    }
+
+    // --- Live orders on this side, in (price, queue order) ---
+    // Snapshot first: cancels below unlink orders and may erase buckets.
+    quote_live_.clear();
+    u64 rank = 0;
+    const bool buy = (side == Side::Buy);
+    const std::vector<i64>& prices = buy ? bid_prices_ : ask_prices_;
+    const std::vector<Bucket>& buckets = buy ? bid_buckets_ : ask_buckets_;
+    for ( std::size_t b = 0; b < buckets.size(); ++b ) {
+      for ( u64 idx = buckets[b].head; idx != kInvalidIndex; idx = orders_[idx].bucket_next ) {
+        const Order& o = orders_[idx];
+        quote_live_.push_back(QuoteLive{prices[b], rank++, o.id, o.qty_q - o.filled_qty_q});
+      }
+    }
+    const std::size_t n_resting = quote_live_.size();
+    for ( const PendingEntry& e : pending_.entries() ) {
+      const Order* o = find_order(e.order_id);
+      if ( !o || o->side != side || o->state != OrderState::Pending )
+        continue;
+      // Pending orders join behind everything resting at their price.
+      quote_live_.push_back(QuoteLive{o->price_q, rank + e.seq, o->id, o->qty_q});
+    }
+    if ( quote_live_.size() > n_resting ) {
+      std::sort(
+          quote_live_.begin(),
+          quote_live_.end(),
+          [](const QuoteLive& a, const QuoteLive& b) {
+            return a.price_q != b.price_q ? a.price_q < b.price_q : a.rank < b.rank;
+          });
+    }
+
+    // --- Diff bucket by bucket (both sequences are price-ascending) ---
+    quote_cancel_.clear();
+    std::size_t w = 0;
+    for ( std::size_t i = 0; i < quote_live_.size(); ) {
+      const i64 px = quote_live_[i].price_q;
+      while ( w < quote_want_.size() && quote_want_[w].price_q < px )
+        ++w;
+      QuoteWant* want = nullptr;
+      if ( w < quote_want_.size() && quote_want_[w].price_q == px )
+        want = &quote_want_[w];
+      i64 kept_q = 0;
+      for ( ; i < quote_live_.size() && quote_live_[i].price_q == px; ++i ) {
+        const QuoteLive& l = quote_live_[i];
+        if ( want && kept_q + l.remaining_q <= want->qty_q ) {
+          kept_q += l.remaining_q;
+          if ( want->id == 0 )
+            want->id = l.order_id;
+        }
+        else {
+          quote_cancel_.push_back(l.order_id);
+        }
+      }
+      if ( want )
+        want->shortfall_q = want->qty_q - kept_q;
+    }
+    for ( QuoteWant& want : quote_want_ ) {
+      if ( want.id == 0 )
+        want.shortfall_q = want.qty_q; // no live orders at this price
+    }
+
+    // --- Cancels first (releases locks for the places) ---
+    for ( const u64 id : quote_cancel_ )
+      (void)cancel_(id);
+
+    // --- Places, in ladder order; ids aligned with the ladder ---
+    const auto lookup = [this](i64 price_q) -> QuoteWant& {
+      return *std::lower_bound(
+          quote_want_.begin(),
+          quote_want_.end(),
+          price_q,
+          [](const QuoteWant& a, i64 p) { return a.price_q < p; });
+    };
+    std::vector<u64> ids(ladder.size(), 0);
+    for ( std::size_t i = 0; i < ladder.size(); ++i ) {
+      QuoteWant& want = lookup(ladder[i].price_q);
+      if ( want.shortfall_q > 0 ) {
+        LimitOrderRequest req{};
+        req.side = side;
+        req.price_q = want.price_q;
+        req.qty_q = want.shortfall_q;
+        req.tif = Tif::GTC;
+        const u64 id = place_limit_(req);
+        want.shortfall_q = 0;
+        if ( want.id == 0 )
+          want.id = id;
+      }
+      ids[i] = want.id;
+    }
+
+    // Recorded as one action: the ladder, with the ids it resolved to
+    if ( action_log_ ) {
+      log_action_(ActionType::SetQuotes, side, Tif::GTC, 0, 0, 0, ladder.size());
+      for ( std::size_t i = 0; i < ladder.size(); ++i )
+        log_action_(
+            ActionType::QuoteLevel, side, Tif::GTC, ladder[i].price_q, ladder[i].qty_q, 0, ids[i]);
+    }
+    return ids;
+  }
+
+} // namespace sim
@@ -1,9 +1,40 @@
+#include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
-
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "action_log.hpp"
+#include "agent_coro.hpp"
+#include "depth_recorder.hpp"
+#include "episode_sampler.hpp"
+#include "level_deltas.hpp"
+#include "md_bus.hpp"
+#include "numa.hpp"
+#include "order_book.hpp"
+#include "paced_replay.hpp"
+#include "replay_pipeline.hpp"
+#include "scenario_runner.hpp"
 #include "schema.hpp"
 #include "sim.hpp"
+#include "sim_batched.hpp"
+#include "sim_rng.hpp"
+#include "snap_catalog.hpp"
+#include "snap_stats.hpp"
+#include "zone_map.hpp"
 
 namespace
 {
@@ -32,6 +63,49 @@ namespace
     return r;
   }
 
+  // Write a .snap of n records with ts_recv_ns = ts0 + k * dt.
+  void write_snap(
+      const std::filesystem::path& path,
+      std::size_t n,
+      std::int64_t ts0,
+      std::int64_t dt)
+  {
+    const md::l2::FileHeader h{
+        md::l2::kMagic,
+        md::l2::kVersion,
+        md::l2::kDepth,
+        sizeof(md::l2::Record),
+        md::l2::kEndianCheck,
+        md::l2::kPriceScale,
+        md::l2::kQtyScale,
+        n};
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    for ( std::size_t k = 0; k < n; ++k ) {
+      const md::l2::Record r = make_record_ns(ts0 + static_cast<std::int64_t>(k) * dt);
+      out.write(reinterpret_cast<const char*>(&r), sizeof(r));
+    }
+  }
+
+  // Write a .snap holding exactly `recs`.
+  void write_snap_records(const std::filesystem::path& path, std::span<const md::l2::Record> recs)
+  {
+    const md::l2::FileHeader h{
+        md::l2::kMagic,
+        md::l2::kVersion,
+        md::l2::kDepth,
+        sizeof(md::l2::Record),
+        md::l2::kEndianCheck,
+        md::l2::kPriceScale,
+        md::l2::kQtyScale,
+        recs.size()};
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    out.write(
+        reinterpret_cast<const char*>(recs.data()),
+        static_cast<std::streamsize>(recs.size_bytes()));
+  }
+
   md::l2::Record make_record_one_bid_level(
       std::int64_t ts_recv_ns,
       i64 best_bid_p,
@@ -52,6 +126,58 @@ namespace
            st == sim::OrderState::Rejected;
   }
 
+  struct TakerOutcome
+  {
+    sim::OrderState state = sim::OrderState::Pending;
+    std::optional<sim::FillEvent> fill;
+    std::optional<sim::FillEvent> again;
+    sim::Ns placed{0};
+    sim::Ns woke{0};
+    bool done = false;
+  };
+
+  // Cross the spread once, then idle on a timer.
+  sim::AgentTask taker_agent(sim::AgentContext& ctx, TakerOutcome& out)
+  {
+    const md::l2::Record& r0 = co_await ctx.next_record();
+    sim::LimitOrderRequest take{};
+    take.side = sim::Side::Buy;
+    take.price_q = r0.asks[0].price_q;
+    take.qty_q = 1;
+    const u64 id = ctx.sim().place_limit(take);
+    out.placed = ctx.sim().now();
+
+    out.state = co_await ctx.activation(id);
+    out.fill = co_await ctx.fill(id);
+    out.again = co_await ctx.fill(id); // terminal, nothing left
+    out.woke = co_await ctx.sleep_for(sim::Ns{5'000});
+    out.done = true;
+  }
+
+  // Rest at the bid, then sleep through the step that fills the order.
+  sim::AgentTask sleeping_maker_agent(sim::AgentContext& ctx, TakerOutcome& out)
+  {
+    const md::l2::Record& r0 = co_await ctx.next_record();
+    sim::LimitOrderRequest make{};
+    make.side = sim::Side::Buy;
+    make.price_q = r0.bids[0].price_q;
+    make.qty_q = 1;
+    const u64 id = ctx.sim().place_limit(make);
+    out.placed = ctx.sim().now();
+
+    out.state = co_await ctx.activation(id);
+    out.woke = co_await ctx.sleep_for(sim::Ns{10'000});
+    out.fill = co_await ctx.fill(id);
+    out.again = co_await ctx.fill(id);
+    out.done = true;
+  }
+
+  sim::AgentTask throwing_agent(sim::AgentContext& ctx)
+  {
+    co_await ctx.next_record();
+    throw std::runtime_error("agent failed");
+  }
+
 } // namespace
 
 int main()
@@ -394,6 +520,89 @@ int main()
     assert(ledger_after.cash_q - ledger_before.cash_q == -(fe.notional_cash_q + fe.fee_cash_q));
   }
 
+  // 5) Level-delta stream: per-price deltas + appear/vanish, and stepping with the stream
+  //    must be bitwise identical to stepping without it.
+  {
+    // Book shifts down one tick: 100 vanishes, 98 appears, 99 depletes 40 -> 35.
+    const auto a = make_record_one_bid_level(0, 100, 10, 99, 40, 101, 10);
+    const auto b = make_record_one_bid_level(1, 99, 35, 98, 7, 101, 12);
+    md::l2::LevelDeltaRecord d{};
+    md::l2::compute_level_deltas(&a, b, d);
+    assert(d.bids.dqty_q[0] == -5); // 99: 40 -> 35
+    assert(d.bids.dqty_q[1] == 7);  // 98 appeared
+    assert(d.bids.appear_mask == 0b10u);
+    assert(d.bids.vanish_mask == 0b01u); // 100 gone
+    assert(d.bids.next_idx[0] == -1 && d.bids.next_idx[1] == 0);
+    assert(d.asks.dqty_q[0] == 2 && d.asks.appear_mask == 0 && d.asks.vanish_mask == 0);
+
+    // Deterministic pseudo-random book walk.
+    std::vector<md::l2::Record> recs;
+    std::uint64_t x = 88172645463325252ull;
+    auto rnd = [&x](std::uint64_t mod) {
+      x ^= x << 13;
+      x ^= x >> 7;
+      x ^= x << 17;
+      return static_cast<i64>(x % mod);
+    };
+    i64 mid = 1000;
+    for ( std::int64_t t = 0; t < 400; ++t ) {
+      mid += rnd(3) - 1;
+      md::l2::Record r = make_record_ns(t, mid - 1, 1 + rnd(50), mid + 1, 1 + rnd(50));
+      for ( std::size_t i = 1; i < 6; ++i ) {
+        r.bids[i] = md::l2::Level{mid - 1 - static_cast<i64>(i), 1 + rnd(50)};
+        r.asks[i] = md::l2::Level{mid + 1 + static_cast<i64>(i), 1 + rnd(50)};
+      }
+      recs.push_back(r);
+    }
+    const auto deltas = md::l2::build_level_deltas(recs.data(), recs.data() + recs.size());
+
+    sim::SimulatorParams p2 = p;
+    p2.max_orders = 256;
+    p2.max_events = 4096;
+    p2.outbound_latency = sim::Ns{0};
+    p2.alpha_ppm = 400'000;
+    p2.stp = sim::StpPolicy::None;
+
+    sim::Ledger l{};
+    l.cash_q = 1'000'000'000;
+    l.position_qty_q = 1'000'000;
+
+    sim::MarketSimulator ex_scan(p2);
+    sim::MarketSimulator ex_delta(p2);
+    ex_scan.reset(sim::Ns{0}, l);
+    ex_delta.reset(sim::Ns{0}, l);
+
+    for ( std::size_t t = 0; t < recs.size(); ++t ) {
+      ex_scan.step(recs[t]);
+      ex_delta.step(recs[t], deltas[t]);
+      if ( t % 7 == 0 ) {
+        sim::LimitOrderRequest rq{};
+        rq.side = (t % 14 == 0) ? sim::Side::Buy : sim::Side::Sell;
+        rq.price_q = (rq.side == sim::Side::Buy) ? recs[t].bids[2].price_q
+                                                 : recs[t].asks[2].price_q;
+        rq.qty_q = 5;
+        const u64 i1 = ex_scan.place_limit(rq);
+        const u64 i2 = ex_delta.place_limit(rq);
+        assert(i1 == i2);
+      }
+    }
+
+    assert(ex_scan.fills().size() == ex_delta.fills().size());
+    assert(!ex_scan.fills().empty());
+    for ( std::size_t i = 0; i < ex_scan.fills().size(); ++i ) {
+      const auto& f1 = ex_scan.fills()[i];
+      const auto& f2 = ex_delta.fills()[i];
+      assert(f1.order_id == f2.order_id && f1.price_q == f2.price_q && f1.qty_q == f2.qty_q);
+      assert(f1.liq == f2.liq && f1.ts == f2.ts);
+    }
+    for ( std::size_t i = 0; i < ex_scan.orders().size(); ++i ) {
+      assert(ex_scan.orders()[i].qty_ahead_q == ex_delta.orders()[i].qty_ahead_q);
+      assert(ex_scan.orders()[i].state == ex_delta.orders()[i].state);
+    }
+    assert(ex_scan.ledger().cash_q == ex_delta.ledger().cash_q);
+    assert(ex_scan.ledger().position_qty_q == ex_delta.ledger().position_qty_q);
+  }
+
   // ----------------------------
   // 3) STP invariants (RejectIncoming)
   // ----------------------------
@@ -961,5 +1170,1779 @@ int main()
     ex.step(r0);
   }
 
+  // ----------------------------
+  // O(1) order lookup + storage version stamps (zero-copy view validity)
+  // ----------------------------
+  {
+    sim::SimulatorParams p2 = p;
+    p2.max_orders = 32;
+    p2.max_events = 256;
+    p2.outbound_latency = sim::Ns{0};
+
+    sim::MarketSimulator ex(p2);
+    sim::Ledger l{};
+    l.cash_q = 1'000'000;
+    l.position_qty_q = 1'000'000;
+    ex.reset(sim::Ns{0}, l);
+    const u64 v0 = ex.storage_version();
+
+    auto r0 = make_record_ns(0, 100, 10, 101, 10);
+    ex.step(r0);
+
+    sim::LimitOrderRequest b{};
+    b.side = sim::Side::Buy;
+    b.price_q = 99;
+    b.qty_q = 1;
+    const u64 id1 = ex.place_limit(b);
+    const u64 id2 = ex.place_limit(b);
+    assert(id1 && id2);
+
+    assert(ex.order_index(id2) == 1);
+    assert(ex.find_order(id1) == &ex.orders()[0]);
+    assert(ex.find_order(id2)->id == id2);
+    assert(ex.find_order(0) == nullptr);
+    assert(ex.find_order(id2 + 100) == nullptr);
+    assert(ex.order_index(id2 + 100) == sim::kInvalidIndex);
+
+    // orders_/events_ never reallocate: no version bump without fills/reset.
+    const sim::Order* base = ex.orders().data();
+    ex.step(r0);
+    assert(ex.orders().data() == base);
+    assert(ex.storage_version() == v0);
+
+    ex.reset(sim::Ns{0}, l);
+    assert(ex.storage_version() != v0);
+    assert(ex.find_order(id1) == nullptr);
+  }
+
+  // ----------------------------
+  // Native ScenarioRunner: checkpoint cadence, quoting, accounting, determinism
+  // ----------------------------
+  {
+    std::vector<md::l2::Record> recs;
+    for ( int i = 0; i < 40; ++i ) {
+      // Touch oscillates so resting quotes get crossed and fill.
+      const i64 bid = (i % 4 < 2) ? 100 : 104;
+      recs.push_back(make_record_ns(1'000 + i * 10, bid, 10, bid + 2, 10));
+    }
+
+    sim::ScenarioConfig cfg{};
+    cfg.params = p;
+    cfg.params.max_orders = 256;
+    cfg.params.max_events = 4096;
+    cfg.params.outbound_latency = sim::Ns{0};
+    cfg.initial_ledger.cash_q = 1'000'000'000;
+    cfg.initial_ledger.position_qty_q = 1'000;
+    cfg.warmup_steps = 2;
+    cfg.order_every_steps = 3;
+    cfg.check_every_steps = 10;
+    cfg.markout_horizons_steps = {5, 1, 5, 0};
+
+    auto run = [&](const sim::ScenarioConfig& c) {
+      sim::ScenarioRunner r(c, recs);
+      std::vector<sim::ScenarioCheckpoint> cps;
+      while ( r.advance() )
+        cps.push_back(r.checkpoint());
+      assert(!r.advance());
+      assert(r.done());
+      return std::make_pair(std::move(cps), r.simulator().fills().size());
+    };
+
+    sim::ScenarioRunner r(cfg, recs);
+    u64 n_cp = 0;
+    std::size_t fills_next = 0;
+    while ( r.advance() ) {
+      const auto& cp = r.checkpoint();
+      assert(cp.fills_begin == fills_next);
+      fills_next = cp.fills_end;
+      assert(cp.audit.pass);
+      ++n_cp;
+    }
+    // 4 cadence checkpoints (10, 20, 30, 40) + final flush
+    assert(n_cp == 5);
+    assert(r.steps() == recs.size());
+    assert(r.placed_orders() > 0);
+    assert(r.failures() == 0);
+    assert(r.fills_seen() == r.simulator().fills().size());
+    assert(r.accounting().fills_seen == r.simulator().fills().size());
+    assert((r.markout_horizons() == std::vector<u64>{1, 5}));
+    for ( const auto& m : r.markout_rows() )
+      assert(m.markout_price_q.size() == 2);
+    (void)r.take_logs();
+    assert(r.take_logs().empty());
+
+    // Deterministic: identical checkpoints on a second run
+    auto a = run(cfg);
+    auto b = run(cfg);
+    assert(a.second == b.second && a.first.size() == b.first.size());
+    for ( std::size_t i = 0; i < a.first.size(); ++i ) {
+      assert(a.first[i].fills_end == b.first[i].fills_end);
+      assert(a.first[i].audit.cash_q == b.first[i].audit.cash_q);
+    }
+
+    // max_steps on a cadence boundary: cadence checkpoint, then final flush at the same step
+    sim::ScenarioConfig c2 = cfg;
+    c2.max_steps = 20;
+    auto c = run(c2);
+    assert(c.first.size() == 3);
+    assert(c.first[1].step == 20 && c.first[2].step == 20);
+    assert(c.first[2].fills_begin == c.first[2].fills_end);
+  }
+
+
+  // ----------------------------
+  // set_quotes: minimal cancel/place diff, queue position kept on unchanged levels
+  // ----------------------------
+  {
+    sim::MarketSimulator s(p);
+    sim::Ledger L{};
+    L.cash_q = 1'000'000;
+    L.position_qty_q = 1'000;
+    s.reset(sim::Ns{0}, L);
+    s.step(make_record_ns(0));
+
+    using Q = sim::QuoteLevel;
+    const std::vector<Q> ladder0{{99, 2}, {98, 3}};
+    const auto ids0 = s.set_quotes(sim::Side::Buy, ladder0);
+    assert(ids0.size() == 2 && ids0[0] != 0 && ids0[1] != 0 && ids0[0] != ids0[1]);
+
+    // Same ladder while still PENDING: no-op
+    const std::size_t ev0 = s.events().size();
+    assert(s.set_quotes(sim::Side::Buy, ladder0) == ids0);
+    assert(s.events().size() == ev0 && s.orders().size() == 2);
+
+    s.step(make_record_ns(10)); // activate
+    assert(s.find_order(ids0[0])->state == sim::OrderState::Active);
+
+    // 99 unchanged (kept), 98 removed (cancel), 97 new (place)
+    const std::size_t ev1 = s.events().size();
+    const auto ids1 = s.set_quotes(sim::Side::Buy, std::vector<Q>{{97, 1}, {99, 2}});
+    assert(ids1.size() == 2 && ids1[1] == ids0[0]);
+    assert(ids1[0] != 0 && ids1[0] != ids0[1]);
+    assert(s.find_order(ids0[1])->state == sim::OrderState::Cancelled);
+    assert(s.events().size() == ev1 + 2);
+
+    // Size increase keeps the front order and tops up behind it
+    s.step(make_record_ns(20));
+    const auto ids2 = s.set_quotes(sim::Side::Buy, std::vector<Q>{{99, 3}, {97, 1}});
+    assert(ids2[0] == ids0[0] && ids2[1] == ids1[0]);
+    assert(s.orders().size() == 4 && s.orders().back().price_q == 99);
+    assert(s.orders().back().qty_q == 1);
+
+    // Size decrease below the front order's remaining qty: cancel/replace (priority lost)
+    const auto ids3 = s.set_quotes(sim::Side::Buy, std::vector<Q>{{99, 1}});
+    assert(ids3.size() == 1 && ids3[0] != ids0[0]);
+    assert(s.find_order(ids0[0])->state == sim::OrderState::Cancelled);
+    assert(s.find_order(ids1[0])->state == sim::OrderState::Cancelled);
+    assert(s.ledger().locked_cash_q == 99);
+
+    // Other side untouched; empty ladder cancels everything on the side
+    const auto asks = s.set_quotes(sim::Side::Sell, std::vector<Q>{{105, 2}});
+    assert(asks.size() == 1 && asks[0] != 0);
+    assert(s.set_quotes(sim::Side::Buy, std::vector<Q>{}).empty());
+    assert(s.ledger().locked_cash_q == 0);
+    assert(s.find_order(asks[0])->state == sim::OrderState::Pending);
+  }
+
+
+  // ----------------------------
+  // Action log: record, save/load, native replay (identical and counterfactual)
+  // ----------------------------
+  {
+    std::vector<md::l2::Record> recs;
+    for ( int i = 0; i < 60; ++i ) {
+      const i64 bid = (i % 6 < 3) ? 100 : 101;
+      recs.push_back(make_record_ns(10 * i, bid, 10 + (i % 4), bid + 1, 10 + (i % 3)));
+    }
+
+    sim::SimulatorParams rp = p;
+    rp.max_orders = 256;
+    rp.max_events = 4096;
+    rp.fees.maker_fee_ppm = 100;
+    rp.fees.taker_fee_ppm = 500;
+    sim::Ledger L{};
+    L.cash_q = 1'000'000;
+    L.position_qty_q = 1'000;
+
+    // Recorded "agent": quote ladders, plus an occasional crossing order and cancel
+    sim::ActionLog log;
+    sim::MarketSimulator ex(rp);
+    ex.set_action_log(&log);
+    ex.reset(sim::Ns{0}, L);
+    u64 last_take = 0;
+    for ( std::size_t k = 0; k < recs.size(); ++k ) {
+      ex.step(recs[k]);
+      const i64 bid = recs[k].bids[0].price_q;
+      const i64 ask = recs[k].asks[0].price_q;
+      if ( k % 5 == 0 ) {
+        (void)ex.set_quotes(sim::Side::Buy, std::vector<sim::QuoteLevel>{{bid, 2}, {bid - 1, 1}});
+        (void)ex.set_quotes(sim::Side::Sell, std::vector<sim::QuoteLevel>{{ask, 2}});
+      }
+      if ( k % 7 == 3 ) {
+        sim::LimitOrderRequest take{};
+        take.side = sim::Side::Buy;
+        take.price_q = ask;
+        take.qty_q = 1;
+        last_take = ex.place_limit(take);
+      }
+      if ( k % 7 == 4 && last_take != 0 )
+        (void)ex.cancel(last_take);
+    }
+    assert(log.header().steps == recs.size());
+    assert(log.header().first_record_ts_ns == recs[0].ts_recv_ns);
+    assert(!log.records().empty() && !ex.fills().empty());
+
+    // Save/load round trip
+    const auto tmp = std::filesystem::temp_directory_path() / "msrl_test_actions.bin";
+    log.save(tmp.string());
+    const sim::ActionLog back = sim::ActionLog::load(tmp.string());
+    std::filesystem::remove(tmp);
+    assert(back.records().size() == log.records().size());
+    assert(back.header().steps == log.header().steps);
+    assert(back.params().fees.taker_fee_ppm == 500);
+
+    // Same params: bitwise-identical outcome
+    sim::MarketSimulator re(back.params());
+    const auto st = sim::replay_actions(re, back, recs);
+    assert(st.steps == recs.size() && st.places_diverged == 0 && st.cancels_skipped == 0);
+    assert(re.ledger().cash_q == ex.ledger().cash_q);
+    assert(re.ledger().position_qty_q == ex.ledger().position_qty_q);
+    assert(re.fills().size() == ex.fills().size());
+    assert(re.events().size() == ex.events().size());
+    for ( std::size_t i = 0; i < ex.fills().size(); ++i ) {
+      assert(re.fills()[i].order_id == ex.fills()[i].order_id);
+      assert(re.fills()[i].fee_cash_q == ex.fills()[i].fee_cash_q);
+    }
+
+    // Counterfactual: zero fees, same actions
+    sim::SimulatorParams cf = back.params();
+    cf.fees = sim::FeeSchedule{};
+    sim::MarketSimulator re0(cf);
+    const auto st0 = sim::replay_actions(re0, back, recs);
+    assert(st0.actions == st.actions);
+    for ( const auto& f : re0.fills() )
+      assert(f.fee_cash_q == 0);
+
+    // Misaligned data is rejected
+    bool threw = false;
+    try {
+      sim::MarketSimulator bad(rp);
+      (void)sim::replay_actions(bad, back, std::span(recs).subspan(1));
+    }
+    catch ( const std::runtime_error& ) {
+      threw = true;
+    }
+    assert(threw);
+  }
+
+
+  // ----------------------------
+  // Rolling state digest + checkpoint trail: equal runs agree, divergence is localised
+  // ----------------------------
+  {
+    std::vector<md::l2::Record> recs;
+    for ( int i = 0; i < 80; ++i ) {
+      // price 100.00000000 / 100.00000100 in 1e8 fixed point (non-zero notional per lot)
+      const i64 bid = (i % 8 < 4) ? 10'000'000'000 : 10'000'000'100;
+      recs.push_back(make_record_ns(10 * i, bid, 10 + (i % 4), bid + 100, 10 + (i % 3)));
+    }
+
+    // fee_ppm only changes fee_cash_q, so runs diverge exactly at the first fill
+    const auto run = [&](u64 fee_ppm) {
+      sim::SimulatorParams dp = p;
+      dp.max_orders = 256;
+      dp.max_events = 4096;
+      dp.fees.maker_fee_ppm = fee_ppm;
+      dp.fees.taker_fee_ppm = fee_ppm;
+      dp.digest_every_steps = 4;
+      auto ex = std::make_unique<sim::MarketSimulator>(dp);
+      sim::Ledger L{};
+      L.cash_q = 1'000'000'000'000;
+      L.position_qty_q = 1'000;
+      ex->reset(sim::Ns{0}, L);
+      for ( std::size_t k = 0; k < recs.size(); ++k ) {
+        ex->step(recs[k]);
+        if ( k == 30 ) {
+          sim::LimitOrderRequest take{};
+          take.side = sim::Side::Buy;
+          take.price_q = recs[k].asks[0].price_q;
+          take.qty_q = 1;
+          (void)ex->place_limit(take);
+        }
+      }
+      return ex;
+    };
+
+    const auto a = run(0);
+    const auto b = run(0);
+    const auto c = run(1'000'000);
+    assert(a->digest_trail().size() == recs.size() / 4);
+    assert(a->state_digest() == b->state_digest());
+    assert(sim::first_divergence(a->digest_trail(), b->digest_trail()) == a->digest_trail().size());
+
+    assert(!a->fills().empty());
+    assert(a->state_digest() != c->state_digest());
+    const std::size_t i = sim::first_divergence(a->digest_trail(), c->digest_trail());
+    assert(i < a->digest_trail().size());
+    // The first checkpoint that differs is the first one at/after the first fill
+    const u64 fill_step = [&] {
+      for ( std::size_t k = 0; k < recs.size(); ++k )
+        if ( static_cast<i64>(a->fills()[0].ts.value) == recs[k].ts_recv_ns )
+          return static_cast<u64>(k + 1);
+      return u64{0};
+    }();
+    assert(i == 0 || a->digest_trail()[i - 1].step < fill_step);
+    assert(fill_step <= a->digest_trail()[i].step);
+
+    // Any action moves the digest
+    const u64 d0 = a->state_digest();
+    sim::LimitOrderRequest r{};
+    r.side = sim::Side::Buy;
+    r.price_q = 90;
+    r.qty_q = 1;
+    (void)a->place_limit(r);
+    assert(a->state_digest() != d0);
+  }
+
+  // ---------------------------------------------
+  // Test: md bus (a Backpressure consumer sees every record in order; a FreeRun
+  // consumer that never reads resumes half a ring behind the head)
+  // ---------------------------------------------
+  {
+    constexpr std::size_t kN = 100;
+    constexpr std::size_t kCap = 8;
+    const std::filesystem::path snap =
+        std::filesystem::temp_directory_path() / "msrl_test_md_bus.snap";
+    {
+      const md::l2::FileHeader h{
+          md::l2::kMagic,
+          md::l2::kVersion,
+          md::l2::kDepth,
+          sizeof(md::l2::Record),
+          md::l2::kEndianCheck,
+          md::l2::kPriceScale,
+          md::l2::kQtyScale,
+          kN};
+      std::ofstream out(snap, std::ios::binary | std::ios::trunc);
+      out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+      for ( std::size_t k = 0; k < kN; ++k ) {
+        const md::l2::Record r = make_record_ns(static_cast<std::int64_t>(1'000 + k));
+        out.write(reinterpret_cast<const char*>(&r), sizeof(r));
+      }
+    }
+
+    {
+      md::l2::BusPublisher pub("msrl_test_bus", snap.string(), kCap);
+      md::l2::BusConsumer lazy("msrl_test_bus", md::l2::BusMode::FreeRun);
+      md::l2::BusConsumer bp("msrl_test_bus", md::l2::BusMode::Backpressure);
+      assert(pub.consumers() == 2);
+
+      std::vector<std::int64_t> seen;
+      std::thread reader([&] {
+        while ( const md::l2::Record* r = bp.next() )
+          seen.push_back(r->ts_recv_ns);
+      });
+      assert(pub.publish_batch(kN + 5) == kN);
+      pub.close();
+      reader.join();
+
+      assert(seen.size() == kN);
+      for ( std::size_t k = 0; k < kN; ++k )
+        assert(seen[k] == static_cast<std::int64_t>(1'000 + k));
+      assert(bp.dropped() == 0 && bp.finished());
+
+      std::size_t got = 0;
+      while ( const md::l2::Record* r = lazy.try_next() ) {
+        assert(r == &lazy.kernel()[lazy.record_index()]); // zero-copy into the file mapping
+        ++got;
+      }
+      assert(got == kCap / 2);
+      assert(lazy.dropped() == kN - kCap / 2);
+      assert(lazy.seq() == kN - 1 && lazy.finished() && lazy.lag() == 0);
+    }
+    std::filesystem::remove(snap);
+  }
+
+  // ---------------------------------------------
+  // Test: paced replay (never early, in order, schedule = scaled and gap-capped span)
+  // ---------------------------------------------
+  {
+    std::vector<md::l2::Record> recs;
+    for ( std::int64_t k = 0; k < 50; ++k )
+      recs.push_back(make_record_ns(1'000'000 + k * 100'000)); // 100 us apart
+    recs.back().ts_recv_ns += 10'000'000'000;                  // one 10 s gap
+
+    md::l2::PacedReplayConfig cfg{};
+    cfg.speed = 2.0;
+    cfg.spin_ns = 50'000;
+    cfg.max_gap_ns = 200'000;
+
+    std::vector<std::size_t> order;
+    const md::l2::PacedReplayStats st =
+        md::l2::paced_replay(recs, cfg, [&](std::size_t i, const md::l2::Record& r) {
+          assert(&r == &recs[i]);
+          order.push_back(i);
+        });
+
+    assert(st.delivered == recs.size() && order.size() == recs.size());
+    for ( std::size_t i = 0; i < order.size(); ++i )
+      assert(order[i] == i);
+    assert(st.schedule_ns == (48 * 100'000 + 200'000) / 2);
+    assert(st.lag_min_ns >= 0);
+    assert(st.wall_ns >= st.schedule_ns);
+    std::uint64_t binned = 0;
+    for ( const std::uint64_t n : st.lag_hist )
+      binned += n;
+    assert(binned == st.delivered);
+    assert(st.lag_quantile_ns(0.5) <= st.lag_quantile_ns(0.99));
+    assert(st.lag_quantile_ns(1.0) == st.lag_max_ns);
+
+    bool threw = false;
+    try {
+      cfg.speed = 0.0;
+      (void)md::l2::paced_replay(recs, cfg, [](std::size_t, const md::l2::Record&) {});
+    }
+    catch ( const std::runtime_error& ) {
+      threw = true;
+    }
+    assert(threw);
+  }
+
+  // ---------------------------------------------
+  // Test: replay pipeline (order and count survive batching; source errors
+  // surface on the consumer; teardown while the producer waits for a slot)
+  // ---------------------------------------------
+  {
+    constexpr std::size_t kN = 1'000;
+    std::size_t made = 0;
+    const auto counting = [&made](std::span<md::l2::Record> out) {
+      std::size_t n = 0;
+      for ( ; n < out.size() && made < kN; ++n, ++made )
+        out[n] = make_record_ns(static_cast<std::int64_t>(made));
+      return n;
+    };
+
+    {
+      md::l2::ReplayPipeline pipe(counting, 16, 4);
+      std::int64_t expect = 0;
+      for ( auto b = pipe.next_batch(); !b.empty(); b = pipe.next_batch() ) {
+        assert(b.size() <= 16);
+        for ( const md::l2::Record& r : b )
+          assert(r.ts_recv_ns == expect++);
+      }
+      assert(expect == static_cast<std::int64_t>(kN));
+      assert(pipe.delivered() == kN);
+      assert(pipe.next_batch().empty());
+    }
+
+    {
+      std::size_t calls = 0;
+      md::l2::ReplayPipeline pipe(
+          [&calls](std::span<md::l2::Record> out) -> std::size_t {
+            if ( ++calls > 3 )
+              throw std::runtime_error("decode failed");
+            out[0] = make_record_ns(0);
+            return 1;
+          },
+          8,
+          2);
+      std::size_t batches = 0;
+      bool threw = false;
+      try {
+        while ( !pipe.next_batch().empty() )
+          ++batches;
+      }
+      catch ( const std::runtime_error& ) {
+        threw = true;
+      }
+      assert(threw && batches == 3);
+    }
+
+    {
+      md::l2::ReplayPipeline pipe(
+          [](std::span<md::l2::Record> out) {
+            for ( md::l2::Record& r : out )
+              r = make_record_ns(1);
+            return out.size();
+          },
+          4,
+          2);
+      assert(pipe.next_batch().size() == 4);
+    } // producer is blocked on a full ring here; the destructor must still join
+  }
+
+  // ----------------------------
+  // Coroutine agents: one scheduler, many accounts, resume only on fired waits
+  // ----------------------------
+  {
+    sim::SimulatorParams pa = p;
+    pa.max_orders = 4;
+    pa.max_events = 64;
+    pa.outbound_latency = sim::Ns{1'000};
+    sim::Ledger led{};
+    led.cash_q = 1'000'000'000;
+
+    constexpr std::size_t kAgents = 200;
+    std::vector<TakerOutcome> out(kAgents);
+    sim::AgentScheduler sched;
+    for ( std::size_t i = 0; i < kAgents; ++i ) {
+      const std::size_t id = sched.spawn(pa, sim::Ns{0}, led, [&out, i](sim::AgentContext& ctx) {
+        return taker_agent(ctx, out[i]);
+      });
+      assert(id == i);
+      assert(sched.agent(i).waiting_on() == sim::AgentWait::Record);
+    }
+    assert(sched.live() == kAgents);
+
+    std::vector<md::l2::Record> recs;
+    for ( std::int64_t k = 1; k <= 40; ++k )
+      recs.push_back(make_record_ns(k * 1'000));
+
+    const std::size_t stepped = sched.run(recs);
+    assert(sched.live() == 0);
+    assert(stepped < recs.size()); // stopped once every agent finished
+
+    for ( std::size_t i = 0; i < kAgents; ++i ) {
+      const TakerOutcome& o = out[i];
+      assert(o.done && sched.done(i));
+      assert(o.state == sim::OrderState::Active || o.state == sim::OrderState::Filled);
+      assert(o.fill && o.fill->price_q == 101 && o.fill->qty_q == 1);
+      assert(!o.again);
+      assert(o.woke >= o.placed + sim::Ns{5'000});
+      assert(sched.agent(i).waiting_on() == sim::AgentWait::None);
+    }
+
+    // At most: initial run, record, activation, fill, timer. Waiting agents are
+    // not resumed on every step.
+    assert(sched.stats().resumes <= 5 * kAgents);
+    assert(sched.stats().steps == stepped);
+  }
+
+  // A fill that lands while the agent is parked on a timer is still delivered
+  {
+    sim::SimulatorParams pa = p;
+    pa.max_orders = 4;
+    pa.max_events = 64;
+    pa.outbound_latency = sim::Ns{1'000};
+    sim::Ledger led{};
+    led.cash_q = 1'000'000'000;
+
+    TakerOutcome out;
+    sim::AgentScheduler sched;
+    sched.spawn(pa, sim::Ns{0}, led, [&out](sim::AgentContext& ctx) {
+      return sleeping_maker_agent(ctx, out);
+    });
+    std::vector<md::l2::Record> recs;
+    for ( std::int64_t k = 1; k <= 20; ++k )
+      recs.push_back(k == 5 ? make_record_ns(k * 1'000, 99, 10, 100, 10) // ask trades through
+                            : make_record_ns(k * 1'000));
+    sched.run(recs);
+    assert(sched.live() == 0 && out.done);
+    assert(out.state == sim::OrderState::Active);
+    assert(out.woke >= out.placed + sim::Ns{10'000});
+    assert(sched.agent(0).sim().fills().size() == 1);
+    assert(out.fill && out.fill->price_q == 100 && out.fill->qty_q == 1);
+    assert(!out.again);
+  }
+
+  {
+    sim::AgentScheduler sched;
+    sim::Ledger led{};
+    led.cash_q = 1'000;
+    sched.spawn(p, sim::Ns{0}, led, [](sim::AgentContext& ctx) { return throwing_agent(ctx); });
+    bool threw = false;
+    try {
+      sched.step(make_record_ns(1));
+    }
+    catch ( const std::runtime_error& ) {
+      threw = true;
+    }
+    assert(threw && sched.live() == 0 && sched.done(0));
+  }
+
+  // ----------------------------
+  // BatchedSimulator: every env conforms to its own scalar MarketSimulator
+  // ----------------------------
+  {
+    constexpr std::size_t kEnvs = 48;
+    constexpr std::size_t kSlots = 4;
+    constexpr std::size_t kSteps = 400;
+    constexpr std::size_t kSkew = 8; // per-env record offset in indexed mode
+    constexpr i64 kTick = 1'000'000;
+    constexpr i64 kUnit = 100'000;
+
+    std::uint64_t rng = 0x9E3779B97F4A7C15ull;
+    auto next = [&rng]() {
+      rng ^= rng << 13;
+      rng ^= rng >> 7;
+      rng ^= rng << 17;
+      return rng;
+    };
+    auto size_q = [&next]() { return static_cast<i64>(1 + next() % 20) * kUnit; };
+
+    // Random-walk book: 5 levels per side, one-tick spread, jittery sizes
+    std::vector<md::l2::Record> recs;
+    i64 mid = 50'000;
+    for ( std::size_t t = 0; t < kSteps + kSkew; ++t ) {
+      mid += static_cast<i64>(next() % 3) - 1;
+      md::l2::Record r = make_record_ns(
+          static_cast<std::int64_t>(1'000 * (t + 1)), mid * kTick, size_q(), (mid + 1) * kTick,
+          size_q());
+      for ( i64 l = 1; l < 5; ++l ) {
+        r.bids[static_cast<std::size_t>(l)] = md::l2::Level{(mid - l) * kTick, size_q()};
+        r.asks[static_cast<std::size_t>(l)] = md::l2::Level{(mid + 1 + l) * kTick, size_q()};
+      }
+      recs.push_back(r);
+    }
+
+    sim::Ledger led{};
+    led.cash_q = 1'000'000'000'000'000'000;
+    led.position_qty_q = 50 * kUnit;
+
+    for ( const bool indexed : {false, true} ) {
+      sim::SimulatorParams pb = p;
+      pb.max_orders = 2 * kSteps;
+      pb.max_events = 1u << 16;
+      pb.outbound_latency = sim::Ns{1'500};
+      pb.stp = indexed ? sim::StpPolicy::CancelResting : sim::StpPolicy::RejectIncoming;
+      pb.fees.maker_fee_ppm = 100;
+      pb.fees.taker_fee_ppm = 700;
+      if ( indexed ) {
+        // Stochastic latency and depletion: env e draws on stream rng_stream + e
+        pb.rng_seed = 0x5EED;
+        pb.rng_stream = 100;
+        pb.outbound_latency_jitter = sim::Ns{2'500};
+        pb.stochastic_depletion = true;
+      }
+
+      sim::BatchedSimulator batch(pb, kEnvs, kSlots);
+      batch.reset(sim::Ns{0}, led);
+      std::vector<std::unique_ptr<sim::MarketSimulator>> ref;
+      for ( std::size_t e = 0; e < kEnvs; ++e ) {
+        sim::SimulatorParams pe = pb;
+        pe.rng_stream += e;
+        ref.push_back(std::make_unique<sim::MarketSimulator>(pe));
+        ref.back()->reset(sim::Ns{0}, led);
+      }
+      // Scalar order id held in each batch slot (0 = none)
+      std::vector<u64> ids(kEnvs * kSlots, 0);
+
+      std::vector<std::uint32_t> index(kEnvs);
+      u64 fills = 0;
+      u64 terminal = 0;
+      for ( std::size_t t = 0; t < kSteps; ++t ) {
+        for ( std::size_t e = 0; e < kEnvs; ++e ) {
+          sim::MarketSimulator& s = *ref[e];
+          u64* slot_ids = ids.data() + e * kSlots;
+          const md::l2::Record& last = recs[indexed ? t + e % kSkew : t];
+          const std::uint64_t action = next() % 4;
+
+          std::size_t live = 0;
+          for ( std::size_t k = 0; k < kSlots; ++k )
+            live += slot_ids[k] != 0;
+
+          if ( action <= 1 && live < kSlots ) {
+            // Around the touch: from 3 ticks behind to crossing by 1
+            sim::LimitOrderRequest req{};
+            req.side = (next() & 1) ? sim::Side::Buy : sim::Side::Sell;
+            const i64 off = static_cast<i64>(next() % 5) - 3;
+            req.price_q = (req.side == sim::Side::Buy)
+                              ? last.bids[0].price_q + off * kTick
+                              : last.asks[0].price_q - off * kTick;
+            req.qty_q = static_cast<i64>(1 + next() % 15) * kUnit;
+
+            const u64 h = batch.place_limit(e, req);
+            const u64 id = s.place_limit(req);
+            assert((h == 0) == (id == 0));
+            if ( h != 0 ) {
+              assert(slot_ids[h - 1] == 0);
+              slot_ids[h - 1] = id;
+            }
+          }
+          else if ( action == 2 && live > 0 ) {
+            std::size_t k = static_cast<std::size_t>(next() % kSlots);
+            while ( slot_ids[k] == 0 )
+              k = (k + 1) % kSlots;
+            assert(batch.cancel(e, k + 1) == s.cancel(slot_ids[k]));
+          }
+        }
+
+        if ( indexed ) {
+          for ( std::size_t e = 0; e < kEnvs; ++e ) {
+            index[e] = static_cast<std::uint32_t>(t + e % kSkew);
+            ref[e]->step(recs[index[e]]);
+          }
+          batch.step(recs, index);
+        }
+        else {
+          for ( std::size_t e = 0; e < kEnvs; ++e )
+            ref[e]->step(recs[t]);
+          batch.step(recs[t]);
+        }
+
+        for ( std::size_t e = 0; e < kEnvs; ++e ) {
+          const sim::MarketSimulator& s = *ref[e];
+          const sim::Ledger a = batch.ledger(e);
+          const sim::Ledger& b = s.ledger();
+          assert(batch.now(e) == s.now());
+          assert(a.cash_q == b.cash_q && a.position_qty_q == b.position_qty_q);
+          assert(a.locked_cash_q == b.locked_cash_q);
+          assert(a.locked_position_qty_q == b.locked_position_qty_q);
+          assert(batch.fill_count(e) == s.fills().size());
+
+          u64* slot_ids = ids.data() + e * kSlots;
+          for ( std::size_t k = 0; k < kSlots; ++k ) {
+            if ( slot_ids[k] == 0 )
+              continue;
+            const sim::Order& o = *s.find_order(slot_ids[k]);
+            assert(batch.order_state(e, k + 1) == o.state);
+            assert(batch.filled_qty(e, k + 1) == o.filled_qty_q);
+            assert(batch.qty_ahead(e, k + 1) == o.qty_ahead_q);
+            if ( is_terminal(o.state) ) {
+              slot_ids[k] = 0;
+              ++terminal;
+            }
+          }
+        }
+      }
+
+      for ( std::size_t e = 0; e < kEnvs; ++e )
+        fills += batch.fill_count(e);
+      assert(fills > kEnvs && terminal > kEnvs);
+
+      batch.reset(0, sim::Ns{5}, sim::Ledger{});
+      assert(batch.now(0) == sim::Ns{5} && batch.ledger(0).cash_q == 0);
+      assert(batch.fill_count(0) == 0 && batch.order_state(0, 1) == sim::OrderState::Rejected);
+      assert(batch.ledger(1).cash_q == ref[1]->ledger().cash_q);
+    }
+
+    bool threw = false;
+    try {
+      sim::BatchedSimulator bad(p, 4, 0);
+    }
+    catch ( const std::runtime_error& ) {
+      threw = true;
+    }
+    assert(threw);
+
+    sim::BatchedSimulator one(p, 2, 1);
+    sim::Ledger rich{};
+    rich.cash_q = 1'000'000'000;
+    one.reset(sim::Ns{0}, rich);
+    sim::LimitOrderRequest req{};
+    req.price_q = 100;
+    req.qty_q = 1;
+    assert(one.place_limit(0, req) == 1);
+    assert(one.place_limit(0, req) == 0); // every slot live
+    assert(one.cancel(0, 1) && !one.cancel(0, 1));
+    assert(one.place_limit(0, req) == 1); // slot reused
+    const std::uint32_t bad_index[2] = {0, 3};
+    threw = false;
+    try {
+      one.step(recs, bad_index);
+      one.step(std::span<const md::l2::Record>(recs.data(), 2), bad_index);
+    }
+    catch ( const std::runtime_error& ) {
+      threw = true;
+    }
+    assert(threw);
+  }
+
+  // ---------------------------------------------
+  // Test: NUMA placement (every placement reads the kernel's records; the pool
+  // runs a job once per worker and rethrows a worker's exception)
+  // ---------------------------------------------
+  {
+    constexpr std::size_t kN = 5'000; // several kNumaStripeBytes stripes
+    const std::filesystem::path snap =
+        std::filesystem::temp_directory_path() / "msrl_test_numa.snap";
+    {
+      const md::l2::FileHeader h{
+          md::l2::kMagic,
+          md::l2::kVersion,
+          md::l2::kDepth,
+          sizeof(md::l2::Record),
+          md::l2::kEndianCheck,
+          md::l2::kPriceScale,
+          md::l2::kQtyScale,
+          kN};
+      std::ofstream out(snap, std::ios::binary | std::ios::trunc);
+      out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+      for ( std::size_t k = 0; k < kN; ++k ) {
+        const md::l2::Record r = make_record_ns(static_cast<std::int64_t>(1'000 + k));
+        out.write(reinterpret_cast<const char*>(&r), sizeof(r));
+      }
+    }
+
+    const std::vector<md::l2::NumaNode> host = md::l2::numa_nodes();
+    assert(!host.empty());
+    for ( const md::l2::NumaNode& n : host )
+      assert(n.mask != 0 && n.cpus > 0);
+
+    // The first node twice: two placement slots even on a single-node host
+    const std::vector<md::l2::NumaNode> nodes{host.front(), host.front()};
+    {
+      md::l2::ReplayKernel k(snap.string());
+      for ( const auto placement :
+            {md::l2::NumaPlacement::Shared,
+             md::l2::NumaPlacement::Interleaved,
+             md::l2::NumaPlacement::Replicated} ) {
+        const md::l2::NumaRecordSet set(k, placement, nodes, 10, kN - 10);
+        assert(set.size() == kN - 20);
+        assert((set.bytes_allocated() == 0) == (placement == md::l2::NumaPlacement::Shared));
+        for ( std::size_t slot = 0; slot < nodes.size(); ++slot ) {
+          const std::span<const md::l2::Record> recs = set.records(slot);
+          assert(recs.size() == kN - 20);
+          for ( std::size_t i = 0; i < recs.size(); ++i )
+            assert(recs[i].ts_recv_ns == static_cast<std::int64_t>(1'010 + i));
+        }
+      }
+      assert(md::l2::NumaRecordSet(k, md::l2::NumaPlacement::Replicated, nodes, kN).size() == 0);
+    }
+    std::filesystem::remove(snap);
+
+    md::l2::NumaWorkerPool pool(nodes, 2);
+    assert(pool.size() == 4 && pool.nodes() == 2);
+    std::vector<int> runs(pool.size(), 0);
+    for ( int round = 0; round < 3; ++round ) {
+      pool.run([&](const md::l2::NumaWorkerPool::Worker& w) {
+        assert(w.node_slot == w.index % 2 && w.node_id == host.front().id);
+        ++runs[w.index];
+      });
+    }
+    for ( int r : runs )
+      assert(r == 3);
+
+    bool threw = false;
+    try {
+      pool.run([](const md::l2::NumaWorkerPool::Worker& w) {
+        if ( w.index == 1 )
+          throw std::runtime_error("worker failed");
+      });
+    }
+    catch ( const std::runtime_error& ) {
+      threw = true;
+    }
+    assert(threw);
+    pool.run([&](const md::l2::NumaWorkerPool::Worker& w) { ++runs[w.index]; });
+    assert(runs[1] == 4);
+
+    threw = false;
+    try {
+      md::l2::NumaWorkerPool empty(std::span<const md::l2::NumaNode>{}, 1);
+    }
+    catch ( const std::runtime_error& ) {
+      threw = true;
+    }
+    assert(threw);
+  }
+
+  // ---------------------------------------------
+  // Test: counter-based RNG (Philox4x32-10 known answers; draws are pure
+  // functions of their key and counter; jittered latency stays in range)
+  // ---------------------------------------------
+  {
+    namespace rng = sim::rng;
+    using Block = rng::Block;
+
+    // Random123 known-answer vectors
+    static_assert(
+        rng::philox4x32(Block{0, 0, 0, 0}, rng::Key{0, 0}) ==
+        Block{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8});
+    static_assert(
+        rng::philox4x32(
+            Block{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+            rng::Key{0xffffffff, 0xffffffff}) ==
+        Block{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd});
+    static_assert(
+        rng::philox4x32(
+            Block{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+            rng::Key{0xa4093822, 0x299f31d0}) ==
+        Block{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1});
+
+    // Order of evaluation does not matter; every input field matters
+    const rng::Key key = rng::derive_key(7, 3, rng::Stream::User);
+    std::vector<u64> fwd(64);
+    rng::fill_u64(key, 11, 1'000, fwd);
+    for ( std::size_t j = fwd.size(); j-- > 0; )
+      assert(fwd[j] == rng::draw_u64(7, 3, rng::Stream::User, 11, 1'000 + j));
+    const u64 d = rng::draw_u64(7, 3, rng::Stream::User, 11, 1'000);
+    assert(d != rng::draw_u64(8, 3, rng::Stream::User, 11, 1'000));
+    assert(d != rng::draw_u64(7, 4, rng::Stream::User, 11, 1'000));
+    assert(d != rng::draw_u64(7, 3, rng::Stream::Latency, 11, 1'000));
+    assert(d != rng::draw_u64(7, 3, rng::Stream::User, 12, 1'000));
+    assert(d != rng::draw_u64(7, 3, rng::Stream::User, 11, 1'001));
+
+    // below(): in range and roughly uniform
+    std::size_t hist[8] = {};
+    for ( u64 j = 0; j < 8'000; ++j ) {
+      const u64 b = rng::below(rng::draw_u64(key, 0, j), 8);
+      assert(b < 8);
+      ++hist[b];
+    }
+    for ( std::size_t h : hist )
+      assert(h > 800 && h < 1'200);
+
+    for ( u64 ep = 0; ep < 100; ++ep ) {
+      const u64 s0 = rng::episode_start(1, 2, ep, 1'000, 100);
+      assert(s0 <= 900 && s0 == rng::episode_start(1, 2, ep, 1'000, 100));
+    }
+    assert(rng::episode_start(1, 2, 0, 50, 100) == 0);
+
+    // Jittered outbound latency: activate_ts in [submit + latency, + jitter]
+    sim::SimulatorParams pj = p;
+    pj.rng_seed = 42;
+    pj.rng_stream = 9;
+    pj.outbound_latency = sim::Ns{1'000};
+    pj.outbound_latency_jitter = sim::Ns{500};
+    sim::MarketSimulator a(pj);
+    sim::MarketSimulator b(pj);
+    sim::Ledger rich{};
+    rich.cash_q = 1'000'000'000'000;
+    a.reset(sim::Ns{0}, rich);
+    b.reset(sim::Ns{0}, rich);
+    sim::LimitOrderRequest req{};
+    req.price_q = 100;
+    req.qty_q = 1;
+    bool varied = false;
+    for ( int k = 0; k < 16; ++k ) {
+      const u64 ia = a.place_limit(req);
+      const u64 ib = b.place_limit(req);
+      assert(ia != 0 && ia == ib);
+      const sim::Ns at = a.find_order(ia)->activate_ts;
+      assert(at == b.find_order(ib)->activate_ts);
+      assert(at >= sim::Ns{1'000} && at <= sim::Ns{1'500});
+      assert(at == rng::outbound_latency(pj, 9, ia));
+      varied = varied || at != a.find_order(1)->activate_ts;
+    }
+    assert(varied);
+  }
+
+  // ---------------------------------------------
+  // Test: episode sampler (reproducible, time-uniform, batches handed out in
+  // file/offset order; windows are spans into the files)
+  // ---------------------------------------------
+  {
+    const std::filesystem::path dir = std::filesystem::temp_directory_path();
+    const std::vector<std::string> paths{
+        (dir / "msrl_test_ep_a.snap").string(),
+        (dir / "msrl_test_ep_b.snap").string(),
+        (dir / "msrl_test_ep_c.snap").string()};
+    write_snap(paths[0], 2'000, 1'000, 1); // starts span 1'901 ns
+    write_snap(paths[1], 500, 50'000, 10); // starts span 4'001 ns
+    write_snap(paths[2], 50, 90'000, 1);   // shorter than an episode
+
+    sim::EpisodeSamplerConfig cfg{};
+    cfg.episode_records = 100;
+    cfg.lookahead = 16;
+    cfg.prefetch = 4;
+    cfg.seed = 3;
+
+    constexpr std::size_t kDraws = 960;
+    std::vector<sim::EpisodeWindow> seq(kDraws);
+    {
+      sim::EpisodeSampler s(paths, cfg);
+      assert(s.files() == 3);
+      s.next_batch(seq);
+      const sim::EpisodeSamplerStats st = s.stats();
+      assert(st.delivered == kDraws && st.warm <= st.delivered);
+      assert(st.batches == kDraws / cfg.lookahead + 1);
+
+      std::size_t from_b = 0;
+      for ( std::size_t j = 0; j < kDraws; ++j ) {
+        const sim::EpisodeWindow& w = seq[j];
+        assert(w.file < 2 && w.episode / cfg.lookahead == j / cfg.lookahead);
+        const md::l2::ReplayKernel& k = s.kernel(w.file);
+        assert(w.start + cfg.episode_records <= k.size());
+        assert(w.records.data() == k.begin() + w.start);
+        assert(w.records.size() == cfg.episode_records);
+        if ( j % cfg.lookahead != 0 ) {
+          const sim::EpisodeWindow& prev = seq[j - 1];
+          assert(prev.file < w.file || (prev.file == w.file && prev.start <= w.start));
+        }
+        from_b += w.file == 1;
+      }
+      // ~4'001 / 5'902 of the time span is file b
+      assert(from_b > kDraws / 2 && from_b < kDraws * 4 / 5);
+    }
+    {
+      sim::EpisodeSampler again(paths, cfg);
+      for ( const sim::EpisodeWindow& w : seq ) {
+        const sim::EpisodeWindow v = again.next();
+        assert(v.episode == w.episode && v.file == w.file && v.start == w.start);
+      }
+    }
+
+    bool threw = false;
+    try {
+      sim::EpisodeSamplerConfig bad = cfg;
+      bad.episode_records = 5'000;
+      sim::EpisodeSampler none(paths, bad);
+    }
+    catch ( const std::runtime_error& ) {
+      threw = true;
+    }
+    assert(threw);
+    for ( const std::string& path : paths )
+      std::filesystem::remove(path);
+
+    // One window per env drives a BatchedSimulator
+    sim::BatchedSimulator batch(p, 2, 1);
+    const md::l2::Record r0 = make_record_ns(7);
+    const md::l2::Record r1 = make_record_ns(9);
+    const md::l2::Record* ptrs[2] = {&r0, &r1};
+    batch.step(ptrs);
+    assert(batch.now(0) == sim::Ns{7} && batch.now(1) == sim::Ns{9});
+    ptrs[1] = nullptr;
+    threw = false;
+    try {
+      batch.step(ptrs);
+    }
+    catch ( const std::runtime_error& ) {
+      threw = true;
+    }
+    assert(threw);
+  }
+
+  // ---------------------------------------------
+  // Test: dataset catalog (scan, time-range queries, save/load, incremental
+  // refresh)
+  // ---------------------------------------------
+  {
+    namespace fs = std::filesystem;
+    const fs::path root = fs::temp_directory_path() / "msrl_test_catalog";
+    fs::remove_all(root);
+    fs::create_directories(root / "2025-01-01");
+    fs::create_directories(root / "2025-01-02");
+    write_snap(root / "2025-01-01" / "a.snap", 100, 1'000, 10); // [1'000, 1'990]
+    write_snap(root / "2025-01-01" / "b.snap", 50, 2'000, 10);  // [2'000, 2'490]
+    write_snap(root / "2025-01-02" / "c.snap", 10, 1'500, 1);   // [1'500, 1'509] nested in a
+    write_snap(root / "2025-01-02" / "empty.snap", 0, 0, 0);
+
+    md::l2::SnapCatalog cat(root.string());
+    assert(cat.size() == 0);
+    assert(cat.refresh(2) == 4);
+    assert(cat.size() == 4);
+    assert(cat.relative_path(0) == "2025-01-01/a.snap");
+    assert(cat.relative_path(1) == "2025-01-02/c.snap");
+    assert(cat.relative_path(2) == "2025-01-01/b.snap");
+    assert(cat.relative_path(3) == "2025-01-02/empty.snap");
+
+    const md::l2::CatalogEntry& a = cat.entry(0);
+    assert(a.record_count == 100 && a.first_ts_recv_ns == 1'000 && a.last_ts_recv_ns == 1'990);
+    assert(a.file_size == sizeof(md::l2::FileHeader) + 100 * sizeof(md::l2::Record));
+    assert(a.max_gap_ns == 10 && a.ts_regressions == 0 && a.crossed == 0);
+    assert(a.no_top_of_book == 0 && a.min_spread_q == 1 && a.max_spread_q == 1);
+    assert(a.min_best_bid_q == 100 && a.max_best_bid_q == 100);
+    assert(cat.entry(1).max_last_ts_recv_ns == 1'990);
+    assert(cat.entry(3).record_count == 0);
+    assert(a.digest != cat.entry(2).digest);
+    assert(a.digest == md::l2::scan_snap(cat.path(0)).digest);
+
+    using Idx = std::vector<std::size_t>;
+    assert(cat.overlapping(0, 999).empty());
+    assert((cat.overlapping(0, 1'000) == Idx{0}));
+    assert((cat.overlapping(1'505, 1'505) == Idx{0, 1}));
+    assert((cat.overlapping(1'600, 2'000) == Idx{0, 2}));
+    assert((cat.overlapping(2'100, 9'999) == Idx{2}));
+    assert(cat.overlapping(2'491, INT64_MAX).empty());
+    assert(cat.overlapping(2'000, 1'000).empty());
+
+    cat.save();
+    {
+      const md::l2::SnapCatalog loaded(root.string());
+      assert(loaded.size() == cat.size());
+      for ( std::size_t i = 0; i < cat.size(); ++i ) {
+        assert(loaded.relative_path(i) == cat.relative_path(i));
+        assert(std::memcmp(&loaded.entry(i), &cat.entry(i), sizeof(md::l2::CatalogEntry)) == 0);
+      }
+      assert((loaded.overlapping(1'600, 2'000) == Idx{0, 2}));
+    }
+
+    // Unchanged files are not rescanned; changed and removed ones are picked up
+    assert(cat.refresh() == 0);
+    write_snap(root / "2025-01-01" / "b.snap", 60, 3'000, 10);
+    fs::remove(root / "2025-01-02" / "empty.snap");
+    assert(cat.refresh() == 1);
+    assert(cat.size() == 3 && cat.entry(2).first_ts_recv_ns == 3'000);
+
+    write_snap(root / "d.snap", 5, 500, 1);
+    cat.upsert((root / "d.snap").string());
+    assert(cat.size() == 4 && cat.relative_path(0) == "d.snap");
+
+    bool threw = false;
+    try {
+      cat.upsert((fs::temp_directory_path() / "elsewhere.snap").string());
+    }
+    catch ( const std::runtime_error& ) {
+      threw = true;
+    }
+    assert(threw);
+
+    {
+      std::ofstream junk(root / md::l2::kCatalogFileName, std::ios::binary | std::ios::trunc);
+      junk << "not a catalog, long enough to hold a header";
+    }
+    threw = false;
+    try {
+      md::l2::SnapCatalog bad(root.string());
+    }
+    catch ( const std::runtime_error& ) {
+      threw = true;
+    }
+    assert(threw);
+    fs::remove_all(root);
+  }
+
+  // ---------------------------------------------
+  // Test: zone maps (block skipping, parallel filter == brute force, sidecar)
+  // ---------------------------------------------
+  {
+    namespace fs = std::filesystem;
+    const fs::path path = fs::temp_directory_path() / "msrl_test_zmap.snap";
+    std::vector<md::l2::Record> recs;
+    for ( std::int64_t k = 0; k < 10'000; ++k ) {
+      const i64 bid = 1'000 + k / 100; // rises by one tick every 100 records
+      recs.push_back(make_record_ns(k * 10, bid, 5 + k % 7, bid + 1, 3));
+    }
+    for ( std::size_t k = 3'000; k < 3'010; ++k )
+      recs[k].asks[0].price_q = recs[k].bids[0].price_q + 10; // wide spread
+    for ( std::size_t k = 5'000; k < 5'005; ++k )
+      recs[k].bids[0] = md::l2::Level{md::l2::kBidNullPriceQ, md::l2::kNullQtyQ};
+    write_snap_records(path, recs);
+    fs::remove(md::l2::zone_map_path(path.string()));
+
+    const fs::path other = fs::temp_directory_path() / "msrl_test_zmap_other.snap";
+    write_snap(other, 20, 0, 1);
+    {
+      const md::l2::ReplayKernel rk(path.string());
+      const md::l2::ZoneMap zm = md::l2::ZoneMap::build(rk, 1'000, 3);
+      assert(zm.size() == 10 && zm.describes(rk));
+      const md::l2::Zone& z5 = zm.zones()[5];
+      assert(z5.records == 1'000 && z5.top_of_book == 995);
+      assert(z5.lo[0] == 50'000 && z5.hi[0] == 59'990);
+      assert(z5.lo[1] == 1'050 && z5.hi[1] == 1'059);
+
+      auto brute = [&](std::span<const md::l2::ZonePredicate> preds) {
+        std::vector<std::uint64_t> out;
+        for ( std::size_t i = 0; i < rk.size(); ++i ) {
+          bool ok = true;
+          for ( const md::l2::ZonePredicate& p : preds ) {
+            std::int64_t v = 0;
+            ok = ok && md::l2::zone_value(rk[i], p.field, v) && v >= p.lo && v <= p.hi;
+          }
+          if ( ok )
+            out.push_back(i);
+        }
+        return out;
+      };
+
+      using md::l2::ZoneField;
+      md::l2::ZoneScanStats st{};
+      const md::l2::ZonePredicate wide[] = {{ZoneField::Spread, 5, INT64_MAX}};
+      const auto hits = md::l2::zone_scan(rk, zm, wide, 4, &st);
+      assert(hits.size() == 10 && hits.front() == 3'000 && hits.back() == 3'009);
+      assert(st.blocks == 10 && st.blocks_scanned == 1 && st.matched == 10);
+
+      const md::l2::ZonePredicate band[] = {
+          {ZoneField::BestBid, 1'020, 1'064},
+          {ZoneField::BidQty, 6, 7},
+          {ZoneField::TsRecvNs, 25'000, INT64_MAX}};
+      assert(md::l2::zone_scan(rk, zm, band, 4, &st) == brute(band));
+      assert(st.blocks_scanned == 5); // blocks 2..6
+
+      // Book predicates never match records without a top of book
+      const md::l2::ZonePredicate any_ask[] = {{ZoneField::BestAsk, INT64_MIN, INT64_MAX}};
+      assert(md::l2::zone_scan(rk, zm, any_ask, 2).size() == rk.size() - 5);
+      assert(md::l2::zone_scan(rk, zm, {}, 2).size() == rk.size());
+      const md::l2::ZonePredicate none[] = {{ZoneField::BestBid, 0, 999}};
+      assert(md::l2::zone_scan(rk, zm, none, 2, &st).empty() && st.blocks_scanned == 0);
+
+      // Sidecar round trip; a stale sidecar is rebuilt
+      const md::l2::ZoneMap built = md::l2::ZoneMap::load_or_build(path.string(), rk);
+      assert(fs::exists(md::l2::zone_map_path(path.string())));
+      const md::l2::ZoneMap loaded = md::l2::ZoneMap::load(md::l2::zone_map_path(path.string()));
+      assert(loaded.size() == built.size() && loaded.block_records() == md::l2::kZoneBlockRecords);
+      const auto zones = built.zones();
+      assert(std::memcmp(loaded.zones().data(), zones.data(), zones.size_bytes()) == 0);
+      assert(md::l2::zone_scan(rk, loaded, band, 1) == brute(band));
+
+      const md::l2::ReplayKernel rk2(other.string());
+      assert(!zm.describes(rk2));
+      bool threw = false;
+      try {
+        (void)md::l2::zone_scan(rk2, zm, band);
+      }
+      catch ( const std::runtime_error& ) {
+        threw = true;
+      }
+      assert(threw);
+      fs::copy_file(
+          md::l2::zone_map_path(path.string()),
+          md::l2::zone_map_path(other.string()),
+          fs::copy_options::overwrite_existing);
+      assert(md::l2::ZoneMap::load_or_build(other.string(), rk2).size() == 1);
+      assert(md::l2::ZoneMap::load(md::l2::zone_map_path(other.string())).record_count() == 20);
+    } // kernels unmapped before the files are removed
+
+    // Same count and end timestamps, different data in between: the old sidecar
+    // still describes the kernel but not the file, and load_or_build() rebuilds it
+    {
+      const auto wt = fs::last_write_time(path);
+      for ( std::size_t k = 5'000; k < 5'010; ++k )
+        recs[k] = make_record_ns(recs[k].ts_recv_ns, 500, 1, 501, 1);
+      write_snap_records(path, recs);
+      fs::last_write_time(path, wt + std::chrono::seconds(2)); // coarse-clock filesystems
+
+      const md::l2::ReplayKernel rk(path.string());
+      const std::string zmap = md::l2::zone_map_path(path.string());
+      const md::l2::ZoneMap old = md::l2::ZoneMap::load(zmap);
+      assert(old.describes(rk) && !old.describes_file(path.string(), rk));
+      const md::l2::ZoneMap fresh = md::l2::ZoneMap::load_or_build(path.string(), rk);
+      assert(fresh.describes_file(path.string(), rk));
+      assert(md::l2::ZoneMap::load(zmap).describes_file(path.string(), rk));
+      const md::l2::ZonePredicate cheap[] = {{md::l2::ZoneField::BestBid, 0, 999}};
+      assert(md::l2::zone_scan(rk, old, cheap, 2).empty()); // pruned by the stale map
+      assert(md::l2::zone_scan(rk, fresh, cheap, 2).size() == 10);
+    }
+
+    for ( const fs::path& p : {path, other} ) {
+      fs::remove(md::l2::zone_map_path(p.string()));
+      fs::remove(p);
+    }
+  }
+
+  // ---------------------------------------------
+  // Test: per-file stats (single pass, sidecar, aggregation over a catalog range)
+  // ---------------------------------------------
+  {
+    namespace fs = std::filesystem;
+    std::vector<md::l2::Record> recs;
+    for ( std::int64_t k = 0; k < 100; ++k )
+      recs.push_back(make_record_ns(k * 10, 100, 3, 104, 5)); // spread 4, gaps 10
+    recs[10].bids[0].price_q = 105;                           // crossed
+    recs[11].bids[0].price_q = 104;                           // locked
+    recs[12].bids[0] = md::l2::Level{md::l2::kBidNullPriceQ, md::l2::kNullQtyQ}; // ask only
+    recs[13].bids[0] = md::l2::Level{md::l2::kBidNullPriceQ, md::l2::kNullQtyQ};
+    recs[13].asks[0] = md::l2::Level{md::l2::kAskNullPriceQ, md::l2::kNullQtyQ}; // empty
+    recs[14].bids[1] = md::l2::Level{99, 1'000};
+    recs[20].ts_recv_ns = recs[19].ts_recv_ns - 1; // regression
+    recs[30].ts_event_ms = 1;
+
+    const md::l2::SnapStats st = md::l2::compute_stats(recs);
+    assert(st.files == 1 && st.records == 100);
+    assert(st.first_ts_recv_ns == 0 && st.last_ts_recv_ns == 990);
+    assert(st.ts_regressions == 1 && st.ts_event_missing == 99 && st.max_gap_ns == 21);
+    assert(st.top_of_book == 98 && st.ask_only == 1 && st.bid_only == 0 && st.empty_book == 1);
+    assert(st.crossed == 1 && st.locked == 1);
+    assert(st.min_spread_q == -1 && st.max_spread_q == 4);
+    assert(st.empty_bid_levels[0] == 2 && st.empty_ask_levels[0] == 1);
+    assert(st.empty_bid_levels[1] == 99 && st.empty_ask_levels[md::l2::kDepth - 1] == 100);
+    assert(st.gap_hist[md::l2::log2_bucket(10)] == 97); // 99 gaps: one regression, one 21
+    assert(st.gap_hist[md::l2::log2_bucket(21)] == 1);
+    assert(st.spread_hist[0] == 2 && st.spread_hist[md::l2::log2_bucket(4)] == 96);
+    assert(st.top_qty_hist[md::l2::log2_bucket(3)] == 98); // active best bids
+    assert(st.top_qty_hist[md::l2::log2_bucket(5)] == 99); // active best asks
+    assert(st.level_qty_hist[md::l2::log2_bucket(1'000)] == 1);
+    assert(md::l2::hist_quantile(st.gap_hist, 0.5) == 16); // bucket [8, 16)
+    assert(md::l2::hist_quantile(st.gap_hist, 1.0) == 32);
+    assert(md::l2::hist_quantile(md::l2::Log2Hist{}, 0.5) == 0);
+
+    // Merge == stats of the concatenation, except gaps across the boundary
+    const std::span<const md::l2::Record> all(recs);
+    md::l2::SnapStats merged = md::l2::compute_stats(all.first(50));
+    merged.merge(md::l2::compute_stats(all.subspan(50)));
+    assert(merged.files == 2 && merged.records == 100 && merged.crossed == 1);
+    assert(merged.first_ts_recv_ns == 0 && merged.last_ts_recv_ns == 990);
+    assert(merged.min_spread_q == -1 && merged.max_spread_q == 4);
+    assert(merged.empty_bid_levels == st.empty_bid_levels && merged.spread_hist == st.spread_hist);
+    assert(merged.gap_hist[md::l2::log2_bucket(10)] == 96);
+
+    // Sidecars and catalog-range aggregation
+    const fs::path root = fs::temp_directory_path() / "msrl_test_stats";
+    fs::remove_all(root);
+    fs::create_directories(root);
+    const fs::path a = root / "a.snap";
+    const fs::path b = root / "b.snap";
+    write_snap_records(a, recs);
+    write_snap(b, 10, 5'000, 1);
+
+    const auto per = md::l2::stats_for_files({a.string(), b.string()}, 2);
+    assert(per[0].crossed == 1 && per[1].records == 10 && per[1].top_of_book == 10);
+    assert(fs::exists(md::l2::stats_path(a.string())));
+    assert(md::l2::load_stats(md::l2::stats_path(b.string())).last_ts_recv_ns == 5'009);
+
+    md::l2::SnapCatalog cat(root.string());
+    cat.refresh(1);
+    assert(cat.size() == 2);
+    assert(cat.entry(0).crossed == st.crossed && cat.entry(0).locked == st.locked); // same rule
+    md::l2::SnapStats sum = md::l2::aggregate_stats(cat, 0, INT64_MAX, 2);
+    assert(sum.files == 2 && sum.records == 110 && sum.top_of_book == 108);
+    assert(sum.first_ts_recv_ns == 0 && sum.last_ts_recv_ns == 5'009);
+    assert(md::l2::aggregate_stats(cat, 5'000, 5'000).records == 10);
+    assert(md::l2::aggregate_stats(cat, 2'000, 3'000).files == 0);
+
+    // A current sidecar is trusted (the data file is not read)...
+    md::l2::SnapStats doctored = per[0];
+    doctored.crossed = 42;
+    md::l2::save_stats(md::l2::stats_path(a.string()), doctored);
+    assert(md::l2::aggregate_stats(cat, 0, 100).crossed == 42);
+    assert(md::l2::load_or_compute_stats(a.string()).crossed == 42);
+    // ... a stale or missing one is recomputed and rewritten
+    write_snap(a, 5, 0, 1);
+    assert(md::l2::load_or_compute_stats(a.string()).crossed == 0);
+    fs::remove(md::l2::stats_path(b.string()));
+    cat.refresh(1);
+    sum = md::l2::aggregate_stats(cat, 0, INT64_MAX, 2);
+    assert(sum.records == 15 && sum.crossed == 0);
+    assert(fs::exists(md::l2::stats_path(b.string())));
+    fs::remove_all(root);
+  }
+
+  // ---------------------------------------------
+  // Test: native depth recorder (JSON -> fixed point, hourly .snap rolling,
+  // crash recovery)
+  // ---------------------------------------------
+  {
+    namespace fs = std::filesystem;
+    using md::l2::parse_decimal_fixed;
+    constexpr std::int64_t kScale = md::l2::kPriceScale;
+    std::int64_t v = 0;
+    assert(parse_decimal_fixed("123.45", kScale, v) && v == 12'345'000'000);
+    assert(parse_decimal_fixed("7", kScale, v) && v == 700'000'000);
+    assert(parse_decimal_fixed("-0.5", kScale, v) && v == -50'000'000);
+    assert(parse_decimal_fixed("0.000000015", kScale, v) && v == 2); // half rounds away
+    assert(parse_decimal_fixed("0.0000000149", kScale, v) && v == 1);
+    assert(parse_decimal_fixed("92233720368.54775807", kScale, v) && v == INT64_MAX);
+    assert(!parse_decimal_fixed("92233720368.54775808", kScale, v));
+    assert(!parse_decimal_fixed("", kScale, v) && !parse_decimal_fixed(".", kScale, v));
+    assert(!parse_decimal_fixed("1e5", kScale, v) && !parse_decimal_fixed("1.2.3", kScale, v));
+    assert(!parse_decimal_fixed("1", 3, v));
+
+    md::l2::Record r{};
+    assert(md::l2::parse_depth_message(
+        R"({"lastUpdateId":1,"bids":[["100.5","2"],["100.4","0.00000000"]],)"
+        R"("asks":[["100.6","1.5"]]})",
+        42, r));
+    assert(r.ts_recv_ns == 42 && r.ts_event_ms == 0);
+    assert(r.bids[0].price_q == 10'050'000'000 && r.bids[0].qty_q == 200'000'000);
+    assert(r.bids[1].price_q == md::l2::kBidNullPriceQ && r.bids[1].qty_q == 0); // zero qty
+    assert(r.asks[0].price_q == 10'060'000'000 && r.asks[0].qty_q == 150'000'000);
+    assert(r.asks[1].price_q == md::l2::kAskNullPriceQ);
+
+    // Futures shape (event time, escaped strings, other keys skipped)
+    assert(md::l2::parse_depth_message(
+        R"({"e":"depthUpdate","E":1700000000123,"s":"BTC\"\\","x":{"y":[1,{"z":null}]},)"
+        R"("b":[["1","1"]],"a":[]})",
+        1, r));
+    assert(r.ts_event_ms == 1'700'000'000'123 && r.bids[0].qty_q == kScale);
+    assert(r.asks[0].price_q == md::l2::kAskNullPriceQ);
+
+    // Combined stream wrapper; levels past kDepth are ignored
+    std::string deep = R"({"stream":"btcusdt@depth20@100ms","data":{"asks":[)";
+    for ( int i = 1; i <= 25; ++i )
+      deep += (i > 1 ? "," : "") + ("[\"" + std::to_string(i) + "\",\"1\"]");
+    deep += "]}}";
+    assert(md::l2::parse_depth_message(deep, 1, r));
+    assert(r.asks[md::l2::kDepth - 1].price_q == 20 * kScale);
+    assert(r.bids[0].price_q == md::l2::kBidNullPriceQ);
+
+    assert(!md::l2::parse_depth_message(R"({"bids":[["1","1"])", 1, r));   // truncated
+    assert(!md::l2::parse_depth_message(R"({"result":null,"id":1})", 1, r)); // no book
+    assert(!md::l2::parse_depth_message(R"({"b":[]} x)", 1, r));            // trailing bytes
+    assert(!md::l2::parse_depth_message("[]", 1, r));
+
+    // Replay a capture across an hour (and day) boundary
+    const fs::path root = fs::temp_directory_path() / "msrl_test_recorder";
+    fs::remove_all(root);
+    fs::create_directories(root);
+    const std::int64_t h23 = 1'735'772'400LL * 1'000'000'000; // 2025-01-01 23:00 UTC
+    const std::int64_t hour_ns = 3'600'000'000'000LL;
+    const auto line = [](std::int64_t ts, std::int64_t px) {
+      return std::to_string(ts) + "\t{\"bids\":[[\"" + std::to_string(px) +
+             "\",\"1\"]],\"asks\":[[\"" + std::to_string(px + 1) + "\",\"1\"]]}\n";
+    };
+    const fs::path capture = root / "capture.jsonl";
+    {
+      std::ofstream out(capture, std::ios::binary);
+      out << line(h23 + 1, 100) << line(h23 + 2, 101) << "not json\n\n"
+          << line(h23 + hour_ns - 1, 102) << line(h23 + hour_ns, 200)
+          << line(h23 + hour_ns - 5, 201); // step back: stays in the open file
+    }
+    const fs::path f23 = root / "2025-01-01" / "BTCUSDT_depth20_2025-01-01_23.snap";
+    const fs::path f00 = root / "2025-01-02" / "BTCUSDT_depth20_2025-01-02_00.snap";
+    {
+      md::l2::RollingSnapWriter writer(root.string(), "BTCUSDT");
+      assert(writer.path_for(h23 + 5) == f23 && writer.path_for(h23 + hour_ns) == f00);
+      md::l2::StreamTransport transport(capture.string());
+      const std::atomic<bool> stop{false};
+      const md::l2::RecorderStats st = md::l2::record_depth(transport, writer, stop, 2);
+      assert(st.messages == 6 && st.records == 5 && st.bad_messages == 1);
+      assert(writer.files_finalised() == 2 && !fs::exists(f23.string() + ".part"));
+
+      const md::l2::ReplayKernel a(f23.string());
+      const md::l2::ReplayKernel b(f00.string());
+      assert(a.size() == 3 && b.size() == 2);
+      assert(a[2].bids[0].price_q == 102 * kScale && b[1].asks[0].price_q == 202 * kScale);
+      assert(fs::exists(md::l2::zone_map_path(f00.string())));
+      assert(md::l2::load_stats(md::l2::stats_path(f23.string())).records == 3);
+
+      // A restart within the hour appends to the finalised file
+      writer.append(a[0]);
+      assert(writer.records_in_file() == 4);
+      writer.close();
+    }
+    assert(md::l2::ReplayKernel(f23.string()).size() == 4);
+
+    // Crash leftovers: a .part with a provisional header and a torn record
+    {
+      const fs::path part = root / "2025-01-02" / "BTCUSDT_depth20_2025-01-02_05.snap.part";
+      fs::copy_file(f00, part);
+      md::l2::FileHeader h{};
+      {
+        std::fstream io(part, std::ios::binary | std::ios::in | std::ios::out);
+        io.read(reinterpret_cast<char*>(&h), sizeof(h));
+        h.record_count = 0;
+        io.seekp(0);
+        io.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        io.seekp(0, std::ios::end);
+        io.write("torn", 4);
+      }
+      md::l2::RollingSnapWriter writer(root.string(), "BTCUSDT");
+      assert(writer.recover_parts() == 1 && !fs::exists(part));
+      const fs::path fixed = root / "2025-01-02" / "BTCUSDT_depth20_2025-01-02_05.snap";
+      assert(md::l2::ReplayKernel(fixed.string()).size() == 2);
+      assert(md::l2::RollingSnapWriter(root.string(), "ETHUSDT").recover_parts() == 0);
+    }
+
+    // Bare payloads are stamped on read
+    std::istringstream in("{\"b\":[[\"1\",\"1\"]]}\n");
+    md::l2::StreamTransport live(in);
+    std::string payload;
+    std::int64_t ts = 0;
+    assert(live.next(payload, ts) && ts > h23 && payload == "{\"b\":[[\"1\",\"1\"]]}");
+    assert(!live.next(payload, ts));
+    fs::remove_all(root);
+  }
+
+  // ---------------------------------------------
+  // Test: full-depth order book from diff streams (ladder vs reference map,
+  // snapshot sync, gap detection, cadence emission)
+  // ---------------------------------------------
+  {
+    using md::l2::BookSide;
+
+    // Ladder against an ordered map, updates anywhere in a deep book
+    md::l2::OrderBook book;
+    std::map<std::int64_t, std::int64_t> ref_bids, ref_asks;
+    std::uint64_t x = 0x9E3779B97F4A7C15ULL;
+    for ( int i = 0; i < 20'000; ++i ) {
+      x ^= x << 13, x ^= x >> 7, x ^= x << 17;
+      const bool bid = (x & 1) != 0;
+      const auto off = static_cast<std::int64_t>((x >> 8) % 300);
+      const std::int64_t qty =
+          (x >> 20) % 3 == 0 ? 0 : static_cast<std::int64_t>((x >> 24) % 50 + 1);
+      const std::int64_t price = bid ? 1'000 - off : 1'001 + off;
+      book.set(bid ? BookSide::Bid : BookSide::Ask, price, qty);
+      auto& ref = bid ? ref_bids : ref_asks;
+      if ( qty > 0 )
+        ref[price] = qty;
+      else
+        ref.erase(price);
+    }
+    assert(book.levels(BookSide::Bid) == ref_bids.size());
+    assert(book.levels(BookSide::Ask) == ref_asks.size());
+    {
+      std::size_t i = 0;
+      for ( auto it = ref_bids.rbegin(); it != ref_bids.rend(); ++it, ++i ) {
+        const md::l2::Level l = book.level(BookSide::Bid, i);
+        assert(l.price_q == it->first && l.qty_q == it->second);
+      }
+      i = 0;
+      for ( const auto& [price, qty] : ref_asks ) {
+        const md::l2::Level l = book.level(BookSide::Ask, i++);
+        assert(l.price_q == price && l.qty_q == qty);
+      }
+    }
+    assert(!book.crossed());
+    md::l2::Record top{};
+    book.top(top, 3);
+    assert(top.bids[0].price_q == ref_bids.rbegin()->first);
+    assert(top.asks[2].price_q == std::next(ref_asks.begin(), 2)->first);
+    assert(top.bids[3].price_q == md::l2::kBidNullPriceQ && top.asks[3].qty_q == 0);
+    book.set(BookSide::Bid, 2'000, 1);
+    assert(book.crossed());
+
+    // Diff payloads and snapshots parse into DepthUpdate
+    md::l2::DepthUpdate u;
+    assert(md::l2::parse_depth_update(
+        R"({"e":"depthUpdate","E":123,"s":"BTCUSDT","U":157,"u":160,"pu":149,)"
+        R"("b":[["0.0024","10"]],"a":[["0.0026","0.00000000"]]})",
+        7, u));
+    assert(!u.snapshot && u.first_update_id == 157 && u.last_update_id == 160);
+    assert(u.prev_update_id == 149 && u.ts_event_ms == 123 && u.ts_recv_ns == 7);
+    assert(u.bids.size() == 1 && u.bids[0].price_q == 240'000 && u.asks[0].qty_q == 0);
+    assert(md::l2::parse_depth_update(R"({"lastUpdateId":10,"bids":[],"asks":[]})", 7, u));
+    assert(u.snapshot && u.first_update_id == 10 && u.last_update_id == 10);
+    assert(!md::l2::parse_depth_update(R"({"U":1,"u":2,"b":[["x","1"]],"a":[]})", 7, u));
+    assert(!md::l2::parse_depth_update(R"({"U":3,"u":2,"b":[],"a":[]})", 7, u)); // U > u
+    assert(!md::l2::parse_depth_update(R"({"b":[],"a":[]})", 7, u));             // no ids
+
+    const auto snapshot = [](std::uint64_t id, std::int64_t ts, std::int64_t bid) {
+      md::l2::DepthUpdate s;
+      s.snapshot = true;
+      s.first_update_id = s.last_update_id = id;
+      s.ts_recv_ns = ts;
+      s.bids = {{bid, 5}, {bid - 1, 5}};
+      s.asks = {{bid + 1, 5}};
+      return s;
+    };
+    const auto diff = [](std::uint64_t first, std::uint64_t last, std::int64_t ts,
+                         std::int64_t price, std::int64_t qty, std::uint64_t prev = 0) {
+      md::l2::DepthUpdate d;
+      d.first_update_id = first;
+      d.last_update_id = last;
+      d.prev_update_id = prev;
+      d.ts_recv_ns = ts;
+      d.bids = {{price, qty}};
+      return d;
+    };
+
+    // Spot rules: buffer before the snapshot, drop stale, straddle L + 1, then U == u + 1
+    {
+      std::vector<md::l2::Record> out;
+      md::l2::BookBuilderConfig cfg{};
+      cfg.depth = 2;
+      md::l2::BookBuilder b(cfg, [&](const md::l2::Record& r) { out.push_back(r); });
+      b.on_update(diff(1, 5, 1, 99, 7));    // stale once the snapshot (10) arrives
+      b.on_update(diff(6, 12, 2, 100, 9));  // straddles 11
+      assert(!b.synced() && out.empty());
+      b.on_update(snapshot(10, 3, 100));
+      assert(b.synced() && b.last_update_id() == 12);
+      assert(b.stats().stale == 1 && b.stats().applied == 1 && out.size() == 2);
+      assert(out[1].bids[0].qty_q == 9 && out[1].ts_recv_ns == 2);
+      assert(out[1].bids[2].price_q == md::l2::kBidNullPriceQ); // depth 2
+      b.on_update(diff(13, 14, 4, 101, 1));
+      assert(out.back().bids[0].price_q == 101);
+      b.on_update(diff(16, 16, 5, 102, 1)); // 15 missing
+      assert(!b.synced() && b.stats().gaps == 1 && out.size() == 3);
+      b.on_update(diff(17, 18, 6, 103, 1));
+      b.on_update(snapshot(16, 7, 200));
+      assert(b.synced() && b.last_update_id() == 18 && out.back().bids[0].price_q == 200);
+      assert(b.book().level(BookSide::Bid, 1).price_q == 199);
+      assert(b.stats().snapshots == 2 && b.stats().applied == 3 && b.stats().stale == 2);
+      const std::size_t emitted = out.size();
+      b.on_update(snapshot(15, 8, 50)); // late REST response: must not rewind the book
+      assert(b.synced() && b.last_update_id() == 18 && out.size() == emitted);
+      assert(b.stats().snapshots == 2 && b.stats().stale_snapshots == 1);
+      assert(b.book().level(BookSide::Bid, 0).price_q == 200);
+      b.on_update(diff(19, 19, 9, 104, 1));
+      assert(b.synced() && b.stats().gaps == 1 && b.stats().applied == 4);
+    }
+
+    // max_buffered holds on every buffering path, gaps included
+    {
+      md::l2::BookBuilderConfig cfg{};
+      cfg.max_buffered = 1;
+      md::l2::BookBuilder b(cfg, [](const md::l2::Record&) {});
+      b.on_update(diff(1, 1, 1, 100, 1));
+      b.on_update(diff(2, 2, 2, 100, 1));
+      assert(b.stats().buffer_dropped == 1);
+      b.on_update(snapshot(2, 3, 100));
+      assert(b.synced());
+      b.on_update(diff(4, 4, 4, 100, 1)); // 3 missing
+      b.on_update(diff(5, 5, 5, 100, 1));
+      b.on_update(diff(6, 6, 6, 100, 1));
+      assert(!b.synced() && b.stats().gaps == 1 && b.stats().buffer_dropped == 3);
+      b.on_update(snapshot(4, 7, 100)); // replays only the newest buffered diff: 6
+      assert(!b.synced() && b.stats().gaps == 2 && b.stats().buffer_dropped == 3);
+    }
+
+    // Futures rules: straddle L, then pu == previous u
+    {
+      std::size_t n = 0;
+      md::l2::BookBuilder b({}, [&](const md::l2::Record&) { ++n; });
+      b.on_update(snapshot(10, 1, 100));
+      b.on_update(diff(8, 12, 2, 100, 1, 7));
+      b.on_update(diff(13, 15, 3, 100, 2, 12));
+      assert(b.synced() && b.stats().applied == 2 && n == 3);
+      b.on_update(diff(17, 18, 4, 100, 3, 16));
+      assert(!b.synced() && b.stats().gaps == 1);
+    }
+
+    // Cadence: one record per bucket with updates, the book after its last update
+    {
+      std::vector<md::l2::Record> out;
+      md::l2::BookBuilderConfig cfg{};
+      cfg.cadence_ns = 100;
+      md::l2::BookBuilder b(cfg, [&](const md::l2::Record& r) { out.push_back(r); });
+      b.on_update(snapshot(1, 10, 100));
+      b.on_update(diff(2, 2, 50, 100, 8));
+      assert(out.empty());
+      b.on_update(diff(3, 3, 150, 100, 9));
+      b.on_update(diff(4, 4, 420, 100, 10));
+      b.finish();
+      assert(out.size() == 3);
+      assert(out[0].ts_recv_ns == 50 && out[0].bids[0].qty_q == 8);
+      assert(out[1].ts_recv_ns == 150 && out[2].ts_recv_ns == 420 && out[2].bids[0].qty_q == 10);
+      bool threw = false;
+      try {
+        cfg.depth = md::l2::kDepth + 1;
+        md::l2::BookBuilder bad(cfg, [](const md::l2::Record&) {});
+      }
+      catch ( const std::runtime_error& ) {
+        threw = true;
+      }
+      assert(threw);
+    }
+
+    // Capture replay (StreamTransport format)
+    {
+      std::istringstream in(
+          "1\t{\"e\":\"depthUpdate\",\"U\":5,\"u\":6,\"b\":[[\"1.5\",\"2\"]],\"a\":[]}\n"
+          "2\t{\"lastUpdateId\":5,\"bids\":[[\"1.4\",\"1\"]],\"asks\":[[\"1.6\",\"1\"]]}\n"
+          "3\tgarbage\n"
+          "4\t{\"e\":\"depthUpdate\",\"U\":7,\"u\":7,\"b\":[[\"1.4\",\"0\"]],\"a\":[]}\n");
+      md::l2::StreamTransport transport(in);
+      std::vector<md::l2::Record> out;
+      md::l2::BookBuilder b({}, [&](const md::l2::Record& r) { out.push_back(r); });
+      const std::atomic<bool> stop{false};
+      const md::l2::DiffReplayStats st = md::l2::replay_depth_diffs(transport, b, stop);
+      assert(st.messages == 4 && st.bad_messages == 1 && out.size() == 3);
+      assert(out.back().ts_recv_ns == 4 && out.back().bids[0].price_q == 150'000'000);
+      assert(out.back().bids[1].price_q == md::l2::kBidNullPriceQ);
+      assert(b.stats().level_updates == 4);
+    }
+  }
+
+  // ---------------------------------------------
+  // Test: follow mode (provisional header, torn tail, growth, finalisation)
+  // ---------------------------------------------
+  {
+    namespace fs = std::filesystem;
+    const fs::path dir = fs::temp_directory_path() / "msrl_test_follow";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    const auto rec = [](std::int64_t i) {
+      md::l2::Record r{};
+      r.ts_recv_ns = 1'000 + i;
+      r.bids[0] = md::l2::Level{100 + i, 1};
+      r.asks[0] = md::l2::Level{200 + i, 1};
+      return r;
+    };
+    md::l2::FollowConfig cfg{};
+    cfg.poll_ns = 100'000;
+    cfg.spin_polls = 16;
+    cfg.idle_timeout_ns = 50'000'000;
+
+    // Raw file: header written in pieces, then 1.5 records, then the rest and the count
+    const fs::path raw = dir / "raw.snap.part";
+    md::l2::FileHeader h{};
+    h.magic = md::l2::kMagic;
+    h.version = md::l2::kVersion;
+    h.depth = md::l2::kDepth;
+    h.record_size = sizeof(md::l2::Record);
+    h.endian_check = md::l2::kEndianCheck;
+    h.price_scale = md::l2::kPriceScale;
+    h.qty_scale = md::l2::kQtyScale;
+    h.record_count = 0;
+    const auto* hb = reinterpret_cast<const char*>(&h);
+    std::ofstream out(raw, std::ios::binary);
+    out.write(hb, 16).flush();
+
+    bool threw = false;
+    try {
+      md::l2::ReplayKernel k(raw.string(), cfg); // header incomplete until the timeout
+    }
+    catch ( const std::runtime_error& ) {
+      threw = true;
+    }
+    assert(threw);
+
+    out.write(hb + 16, sizeof(h) - 16);
+    const md::l2::Record r0 = rec(0), r1 = rec(1);
+    out.write(reinterpret_cast<const char*>(&r0), sizeof(r0));
+    out.write(reinterpret_cast<const char*>(&r1), sizeof(r1) / 2).flush();
+
+    md::l2::ReplayKernel k(raw.string(), cfg);
+    assert(k.following() && k.size() == 1);
+    const md::l2::Record* p = k.next();
+    assert(p && p->ts_recv_ns == 1'000);
+    assert(k.next() == nullptr && !k.finished()); // half a record is never exposed
+    assert(k.poll() == 0 && k.size() == 1);
+
+    out.write(reinterpret_cast<const char*>(&r1) + sizeof(r1) / 2, sizeof(r1) - sizeof(r1) / 2);
+    out.flush();
+    assert(k.poll() == 1 && k.size() == 2 && !k.finished());
+    p = k.next();
+    assert(p && p->bids[0].price_q == 101 && k.window(2).size() == 2);
+    h.record_count = 2;
+    out.seekp(0);
+    out.write(hb, sizeof(h)).flush();
+    out.close();
+    assert(k.next() == nullptr && k.finished());
+
+    // Already final: plain replay with finished() once drained
+    md::l2::ReplayKernel done(raw.string(), cfg);
+    assert(done.size() == 2 && !done.finished());
+    assert(done.next_batch(8).size() == 2 && done.finished());
+
+    // Stop flag ends a wait with no timeout
+    {
+      std::atomic<bool> stop{false};
+      md::l2::FollowConfig c2 = cfg;
+      c2.idle_timeout_ns = 0;
+      c2.stop = &stop;
+      const fs::path part = dir / "stop.snap.part";
+      std::ofstream(part, std::ios::binary).write(hb, sizeof(h)); // count 2, no records: not final
+      md::l2::ReplayKernel ks(part.string(), c2);
+      std::thread t([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        stop.store(true);
+      });
+      assert(ks.next() == nullptr && !ks.finished());
+      t.join();
+    }
+
+    // Live recorder: a follower reads every record in order while the writer appends,
+    // then stops at the finalised count (the .part is renamed under it)
+    {
+      constexpr std::int64_t h23 = 1'735'772'400LL * 1'000'000'000LL;
+      constexpr std::int64_t kN = 300;
+      md::l2::RollingSnapWriter w(dir.string(), "FOLLOW");
+      md::l2::Record r = rec(0);
+      r.ts_recv_ns = h23;
+      w.append(r);
+      w.flush();
+      const fs::path part = w.current_path().string() + ".part";
+
+      md::l2::FollowConfig c3{};
+      c3.poll_ns = 50'000;
+      c3.idle_timeout_ns = 5'000'000'000;
+      md::l2::ReplayKernel kf(part.string(), c3);
+      std::thread writer([&] {
+        for ( std::int64_t i = 1; i < kN; ++i ) {
+          md::l2::Record ri = rec(i);
+          ri.ts_recv_ns = h23 + i;
+          w.append(ri);
+          if ( i % 7 == 0 )
+            w.flush();
+        }
+        w.close();
+      });
+      std::int64_t seen = 0;
+      while ( const md::l2::Record* q = kf.next() ) {
+        assert(q->ts_recv_ns == h23 + seen && q->bids[0].price_q == 100 + seen);
+        ++seen;
+      }
+      writer.join();
+      assert(seen == kN && kf.finished() && kf.size() == kN);
+      assert(!fs::exists(part) && md::l2::ReplayKernel(w.current_path().string()).size() == kN);
+    }
+
+    fs::remove_all(dir);
+  }
+
   return 0;
 }
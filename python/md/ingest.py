@@ -23,7 +23,9 @@ The script:
     --date, --dates, --range, or --all-dates (filesystem discovery)
 4) Builds a flat job list (one job per hourly file)
 5) Runs jobs in a ProcessPoolExecutor with bounded parallelism
-6) Produces a global summary and returns non-zero exit code if any failures occur
+6) Refreshes the dataset catalog (<DATA_PROCESSED_ROOT>/catalog.snapidx) with
+   `converter --catalog` (skip with --no-catalog)
+7) Produces a global summary and returns non-zero exit code if any failures occur
 
 ------------------------------------------------------------------------------------
 Configuration sources and precedence
@@ -293,6 +295,7 @@ def parse_args() -> argparse.Namespace:
     p.add_argument("--workers", type=int, default=None, help="Override max workers")
     p.add_argument("--dry-run", action="store_true", help="Print planned work without running converter")
     p.add_argument("--limit", type=int, default=None, help="Limit number of files total (for testing)")
+    p.add_argument("--no-catalog", action="store_true", help="Do not refresh catalog.snapidx after converting")
     return p.parse_args()
 
 
@@ -418,6 +421,17 @@ def main() -> int:
             results.append(r)
             print(f"{'SUCCESS' if r.ok else 'ERROR  '}: [{r.tag}] {r.src} ({r.secs:.2f}s) {r.msg}")
 
+    catalog_ok = True
+    if not args.no_catalog:
+        cp = subprocess.run(
+            [str(converter_exe), "--catalog", str(out_root)],
+            text=True,
+            stdout=subprocess.DEVNULL,
+            stderr=subprocess.PIPE,
+        )
+        catalog_ok = cp.returncode == 0
+        print(f"{'SUCCESS' if catalog_ok else 'ERROR  '}: catalog {(cp.stderr or '').strip()}")
+
     fails = [r for r in results if not r.ok]
     print(f"\nSummary: ok={len(results) - len(fails)}/{len(results)} failed={len(fails)}")
     if fails:
@@ -436,7 +450,7 @@ def main() -> int:
 
         return 1
 
-    return 0
+    return 0 if catalog_ok else 1
 
 
 if __name__ == "__main__":
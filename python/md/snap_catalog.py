@@ -0,0 +1,131 @@
+"""
+Reader for the dataset catalog (<DATA_PROCESSED_ROOT>/catalog.snapidx) written by
+`converter --catalog <root>` (C++: cpp/include/snap_catalog.hpp).
+
+Answers "which .snap files cover [t0, t1]" with two binary searches over the
+entry arrays, without opening any data file.
+
+Example:
+  cat = SnapCatalog.load(Path(os.environ["DATA_PROCESSED_ROOT"]))
+  for p in cat.files_overlapping(t0_ns, t1_ns):
+      ...
+"""
+
+from __future__ import annotations
+
+from dataclasses import dataclass
+from pathlib import Path
+from typing import List, Union
+
+import numpy as np
+
+# =============================================================================
+# Constants / dtypes (must match the C++ layout; little-endian)
+# =============================================================================
+
+CATALOG_MAGIC = 0x5443534D  # "MSCT" little-endian
+CATALOG_VERSION = 2
+CATALOG_FILE_NAME = "catalog.snapidx"
+ENDIAN_CHECK = 0x01020304
+
+CATALOG_HEADER_DTYPE = np.dtype(
+    [
+        ("magic", "<u4"),
+        ("version", "<u2"),
+        ("entry_size", "<u2"),
+        ("endian_check", "<u4"),
+        ("reserved0", "<u4"),
+        ("count", "<u8"),
+        ("path_bytes", "<u8"),
+    ],
+    align=False,
+)
+
+CATALOG_ENTRY_DTYPE = np.dtype(
+    [
+        ("path_offset", "<u8"),
+        ("path_len", "<u4"),
+        ("reserved0", "<u4"),
+        ("record_count", "<u8"),
+        ("first_ts_recv_ns", "<i8"),
+        ("last_ts_recv_ns", "<i8"),
+        ("max_last_ts_recv_ns", "<i8"),
+        ("file_size", "<u8"),
+        ("write_time", "<i8"),
+        ("digest", "<u8"),
+        ("no_top_of_book", "<u8"),
+        ("crossed", "<u8"),  # best bid > best ask (as SnapStats)
+        ("locked", "<u8"),  # best bid == best ask
+        ("ts_regressions", "<u8"),
+        ("max_gap_ns", "<i8"),
+        ("min_best_bid_q", "<i8"),
+        ("max_best_bid_q", "<i8"),
+        ("min_spread_q", "<i8"),
+        ("max_spread_q", "<i8"),
+    ],
+    align=False,
+)
+
+assert CATALOG_HEADER_DTYPE.itemsize == 32
+assert CATALOG_ENTRY_DTYPE.itemsize == 144
+
+
+@dataclass(frozen=True)
+class SnapCatalog:
+    """
+    Catalog entries (structured array, sorted by first_ts_recv_ns) and their
+    paths relative to `root`.
+    """
+    root: Path
+    entries: np.ndarray
+    paths: List[str]
+
+    @staticmethod
+    def load(root: Union[str, Path]) -> "SnapCatalog":
+        root = Path(root)
+        path = root / CATALOG_FILE_NAME
+        buf = path.read_bytes()
+        if len(buf) < CATALOG_HEADER_DTYPE.itemsize:
+            raise ValueError(f"Truncated catalog header: {path}")
+
+        h = np.frombuffer(buf, dtype=CATALOG_HEADER_DTYPE, count=1)[0]
+        if int(h["magic"]) != CATALOG_MAGIC:
+            raise ValueError(f"Not a snap catalog (bad magic): {path}")
+        if int(h["version"]) != CATALOG_VERSION:
+            raise ValueError(f"Unsupported catalog version: {path}")
+        if int(h["endian_check"]) != ENDIAN_CHECK:
+            raise ValueError(f"Catalog endianness mismatch: {path}")
+        if int(h["entry_size"]) != CATALOG_ENTRY_DTYPE.itemsize:
+            raise ValueError(f"Catalog entry size mismatch: {path}")
+
+        count = int(h["count"])
+        off = CATALOG_HEADER_DTYPE.itemsize
+        table_off = off + count * CATALOG_ENTRY_DTYPE.itemsize
+        if len(buf) < table_off + int(h["path_bytes"]):
+            raise ValueError(f"Truncated catalog: {path}")
+
+        entries = np.frombuffer(buf, dtype=CATALOG_ENTRY_DTYPE, count=count, offset=off)
+        table = buf[table_off : table_off + int(h["path_bytes"])]
+        paths = [
+            table[int(e["path_offset"]) : int(e["path_offset"]) + int(e["path_len"])].decode("utf-8")
+            for e in entries
+        ]
+        return SnapCatalog(root=root, entries=entries, paths=paths)
+
+    def __len__(self) -> int:
+        return len(self.paths)
+
+    def path(self, i: int) -> Path:
+        return self.root / self.paths[i]
+
+    def overlapping(self, t0: int, t1: int) -> np.ndarray:
+        """Indices of files with records in [t0, t1] (ts_recv_ns, inclusive), in time order."""
+        if t0 > t1:
+            return np.empty(0, dtype=np.int64)
+        hi = int(np.searchsorted(self.entries["first_ts_recv_ns"], t1, side="right"))
+        lo = int(np.searchsorted(self.entries["max_last_ts_recv_ns"][:hi], t0, side="left"))
+        idx = np.arange(lo, hi, dtype=np.int64)
+        return idx[self.entries["last_ts_recv_ns"][lo:hi] >= t0]
+
+    def files_overlapping(self, t0: int, t1: int) -> List[Path]:
+        return [self.path(int(i)) for i in self.overlapping(t0, t1)]
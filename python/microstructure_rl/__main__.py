@@ -1,8 +1,10 @@
 from __future__ import annotations
 
 import argparse
+import os
 from pathlib import Path
 
+from .batch import date_range, run_batch, snaps_for_dates, specs_for_snaps
 from .runner import run_scenario
 from .spec import ScenarioSpec
 
@@ -48,6 +50,12 @@ def _build_parser() -> argparse.ArgumentParser:
         "--strict", action="store_true", help="Fail hard on invariant violations"
     )
     rn.add_argument("--log-level", default="INFO")
+    rn.add_argument(
+        "--engine",
+        choices=["native", "python"],
+        default="native",
+        help="Scenario loop implementation (python = reference loop)",
+    )
 
     # If no spec, allow same knobs as make-spec (subset commonly tweaked)
     rn.add_argument("--max-steps", type=int, default=0)
@@ -73,6 +81,32 @@ def _build_parser() -> argparse.ArgumentParser:
         "--markout-horizons-steps", nargs="*", type=int, default=[100, 1000, 10000]
     )
 
+    bt = sub.add_parser(
+        "batch", help="Run many specs (or one template over dates) on a worker pool"
+    )
+    bt.add_argument("--spec", nargs="*", default=[], help="spec.json files")
+    bt.add_argument("--spec-dir", help="Directory of spec *.json files")
+    bt.add_argument(
+        "--template", help="Template spec.json; snap_path is replaced per file"
+    )
+    bt.add_argument(
+        "--processed-root",
+        default=os.environ.get("DATA_PROCESSED_ROOT"),
+        help="Root of <YYYY-MM-DD>/*.snap (default: DATA_PROCESSED_ROOT)",
+    )
+    bt.add_argument("--date", help="Single date YYYY-MM-DD (with --template)")
+    bt.add_argument("--date-from", help="Range start YYYY-MM-DD (with --template)")
+    bt.add_argument("--date-to", help="Range end YYYY-MM-DD, inclusive")
+    bt.add_argument(
+        "--out-root", default="runs", help="Root directory for run artifacts"
+    )
+    bt.add_argument("--workers", type=int, default=os.cpu_count() or 1)
+    bt.add_argument(
+        "--strict", action="store_true", help="Fail runs hard on invariant violations"
+    )
+    bt.add_argument("--log-level", default="INFO")
+    bt.add_argument("--engine", choices=["native", "python"], default="native")
+
     return p
 
 
@@ -142,10 +176,42 @@ def main() -> int:
             out_root=Path(args.out_root),
             strict=bool(args.strict),
             log_level=str(args.log_level),
+            engine=str(args.engine),
         )
         print(str(run_dir))
         return 0
 
+    if args.cmd == "batch":
+        specs = [ScenarioSpec.load(Path(x)) for x in args.spec]
+        if args.spec_dir:
+            specs += [
+                ScenarioSpec.load(x) for x in sorted(Path(args.spec_dir).glob("*.json"))
+            ]
+        if args.template:
+            if not args.processed_root:
+                p.error("--processed-root (or DATA_PROCESSED_ROOT) is required with --template")
+            if args.date:
+                dates = [args.date]
+            elif args.date_from and args.date_to:
+                dates = date_range(args.date_from, args.date_to)
+            else:
+                p.error("--template needs --date or --date-from/--date-to")
+            snaps = snaps_for_dates(Path(args.processed_root), dates)
+            specs += specs_for_snaps(ScenarioSpec.load(Path(args.template)), snaps)
+        if not specs:
+            p.error("no specs selected (use --spec, --spec-dir or --template with dates)")
+
+        batch_dir = run_batch(
+            specs=specs,
+            out_root=Path(args.out_root),
+            workers=int(args.workers),
+            strict=bool(args.strict),
+            log_level=str(args.log_level),
+            engine=str(args.engine),
+        )
+        print(str(batch_dir))
+        return 0
+
     return 2
 
 
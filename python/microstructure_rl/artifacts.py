@@ -30,8 +30,11 @@ class ArtifactPaths:
     markout_csv: Path
 
 
-def make_run_dir(root: Path, run_id: str, timestamp_utc: str) -> ArtifactPaths:
-    run_dir = (root / f"{run_id}_{timestamp_utc}").resolve()
+def make_run_dir(
+    root: Path, run_id: str, timestamp_utc: str, suffix: str = ""
+) -> ArtifactPaths:
+    name = f"{run_id}_{timestamp_utc}" + (f"_{suffix}" if suffix else "")
+    run_dir = (root / name).resolve()
     run_dir.mkdir(parents=True, exist_ok=False)
     return ArtifactPaths(
         run_dir=run_dir,
@@ -0,0 +1,345 @@
+"""
+Batch scenario executor: many ScenarioSpecs (or one template over a date range) in
+one invocation, scheduled over a bounded process pool.
+
+Scheduling
+----------
+- Specs are grouped by `snap_path`. A group is worked on back-to-back so the file
+  stays resident in the OS page cache (each run also fingerprints the whole file).
+- Groups are started longest-first (estimated cost = file bytes per run), so the
+  big files do not end up as a tail on one worker.
+- Each worker slot keeps pulling runs from its own group. When that group is empty
+  it takes the largest unstarted group, and once none are left it steals a run
+  from the group with the most remaining work (another slot is already reading
+  that file, so the cache is warm for both).
+
+Outputs
+-------
+- Per-run artifacts: exactly what `run_scenario` writes, under `out_root`; run
+  dirs carry the spec index so identical specs started together do not collide.
+- Merged summary: `<out_root>/batch_<ts>/summary.csv` + `summary.json`, one row per
+  spec in input order (failed runs carry `status="ERROR"` and the error text).
+- A worker process that dies (BrokenProcessPool) fails the runs in flight on the
+  pool at that moment; the pool is rebuilt and the remaining runs continue.
+"""
+
+from __future__ import annotations
+
+import dataclasses
+import hashlib
+import logging
+import os
+import time
+from collections import deque
+from concurrent.futures import FIRST_COMPLETED, Future, ProcessPoolExecutor, wait
+from concurrent.futures.process import BrokenProcessPool
+from dataclasses import dataclass, field
+from datetime import datetime, timedelta, timezone
+from pathlib import Path
+from typing import Any, Deque, Dict, List, Optional, Sequence
+
+from .artifacts import write_csv, write_json
+from .spec import ScenarioSpec
+
+
+SUMMARY_COLUMNS = [
+    "index",
+    "snap_path",
+    "status",
+    "run_dir",
+    "run_id",
+    "steps",
+    "placed_orders",
+    "fills",
+    "events",
+    "failures",
+    "max_cash_residual_q",
+    "state_digest",
+    "elapsed_s",
+    "error",
+]
+
+
+# ---------------------------
+# Spec expansion
+# ---------------------------
+def date_range(d0: str, d1: str) -> List[str]:
+    """Inclusive list of YYYY-MM-DD strings."""
+    a = datetime.strptime(d0, "%Y-%m-%d").date()
+    b = datetime.strptime(d1, "%Y-%m-%d").date()
+    out: List[str] = []
+    cur = a
+    while cur <= b:
+        out.append(cur.strftime("%Y-%m-%d"))
+        cur += timedelta(days=1)
+    return out
+
+
+def snaps_for_dates(processed_root: Path, dates: Sequence[str]) -> List[Path]:
+    """`.snap` files under <processed_root>/<YYYY-MM-DD>/ (ingest.py layout)."""
+    out: List[Path] = []
+    for d in dates:
+        out.extend(sorted((processed_root / d).glob("*.snap")))
+    return out
+
+
+def snap_stream_offset(snap: Path) -> int:
+    """Stable 64-bit RNG stream offset for a `.snap`, keyed on its file name only."""
+    digest = hashlib.blake2b(Path(snap).name.encode("utf-8"), digest_size=8).digest()
+    return int.from_bytes(digest, "little")
+
+
+def specs_for_snaps(template: ScenarioSpec, snaps: Sequence[Path]) -> List[ScenarioSpec]:
+    """
+    One spec per file: the template with `snap_path` replaced. Each file draws from RNG
+    stream `template.rng_stream + snap_stream_offset(file)` (mod 2**64), so a stochastic
+    run reproduces for any worker count and whatever else the sweep contains.
+    """
+    return [
+        dataclasses.replace(
+            template,
+            snap_path=str(p),
+            rng_stream=(template.rng_stream + snap_stream_offset(p)) % 2**64,
+        )
+        for p in snaps
+    ]
+
+
+# ---------------------------
+# Scheduling
+# ---------------------------
+@dataclass
+class _Group:
+    snap_path: str
+    cost_per_run: int
+    pending: Deque[int] = field(default_factory=deque)  # spec indices
+    started: bool = False
+
+    @property
+    def remaining_cost(self) -> int:
+        return self.cost_per_run * len(self.pending)
+
+
+def _estimate_cost(snap_path: str) -> int:
+    try:
+        return max(1, os.path.getsize(snap_path))
+    except OSError:
+        return 1
+
+
+def plan_groups(specs: Sequence[ScenarioSpec]) -> List[_Group]:
+    """Group spec indices by snap_path, largest total cost first (stable on ties)."""
+    by_path: Dict[str, _Group] = {}
+    for i, s in enumerate(specs):
+        g = by_path.get(s.snap_path)
+        if g is None:
+            g = _Group(snap_path=s.snap_path, cost_per_run=_estimate_cost(s.snap_path))
+            by_path[s.snap_path] = g
+        g.pending.append(i)
+    return sorted(by_path.values(), key=lambda g: g.remaining_cost, reverse=True)
+
+
+def _next_for_slot(home: Optional[_Group], groups: List[_Group]) -> Optional[tuple]:
+    """(group, spec index) for a free slot, or None when all work is handed out."""
+    if home is not None and home.pending:
+        return home, home.pending.popleft()
+    for g in groups:  # largest unstarted group
+        if not g.started and g.pending:
+            g.started = True
+            return g, g.pending.popleft()
+    victim = max((g for g in groups if g.pending), key=lambda g: g.remaining_cost, default=None)
+    if victim is None:
+        return None
+    # Steal from the tail; the owner keeps consuming from the head.
+    return victim, victim.pending.pop()
+
+
+# ---------------------------
+# Worker
+# ---------------------------
+def _new_row(index: int, spec: ScenarioSpec) -> Dict[str, Any]:
+    row: Dict[str, Any] = {c: None for c in SUMMARY_COLUMNS}
+    row["index"] = index
+    row["snap_path"] = spec.snap_path
+    return row
+
+
+def _run_one(
+    index: int,
+    spec: ScenarioSpec,
+    out_root: str,
+    strict: bool,
+    log_level: str,
+    engine: str,
+) -> Dict[str, Any]:
+    """Process-pool entry point (top level so it pickles under spawn on Windows)."""
+    import json
+
+    from .runner import run_scenario
+
+    row = _new_row(index, spec)
+    t0 = time.perf_counter()
+    try:
+        run_dir = run_scenario(
+            spec=spec,
+            out_root=Path(out_root),
+            strict=strict,
+            log_level=log_level,
+            engine=engine,
+            run_dir_suffix=f"{index:05d}",
+        )
+        metrics = json.loads((run_dir / "metrics.json").read_text(encoding="utf-8"))
+        row.update(
+            status="OK" if not metrics.get("failures") else "FAIL",
+            run_dir=str(run_dir),
+            run_id=metrics.get("run_id"),
+            steps=metrics.get("steps"),
+            placed_orders=metrics.get("placed_orders"),
+            fills=metrics.get("fills"),
+            events=metrics.get("events"),
+            failures=metrics.get("failures"),
+            max_cash_residual_q=metrics.get("accounting", {}).get("max_cash_residual_q"),
+            state_digest=metrics.get("digests", {}).get("state_digest"),
+        )
+    except Exception as e:  # one bad run must not sink the batch
+        row.update(status="ERROR", error=f"{type(e).__name__}: {e}")
+    row["elapsed_s"] = round(time.perf_counter() - t0, 3)
+    return row
+
+
+# ---------------------------
+# Driver
+# ---------------------------
+def run_batch(
+    *,
+    specs: Sequence[ScenarioSpec],
+    out_root: Path,
+    workers: int,
+    strict: bool,
+    log_level: str,
+    engine: str = "native",
+) -> Path:
+    """
+    Run all specs and write the merged summary. Returns the batch directory.
+    """
+    logger = logging.getLogger("mrl.batch")
+    logger.setLevel(getattr(logging, log_level.upper(), logging.INFO))
+    h = logging.StreamHandler()
+    h.setFormatter(logging.Formatter("%(asctime)s | %(levelname)s | %(message)s"))
+    logger.handlers[:] = [h]
+
+    if not specs:
+        raise ValueError("run_batch: no specs")
+    out_root = out_root.resolve()
+    out_root.mkdir(parents=True, exist_ok=True)
+    ts = datetime.now(timezone.utc).strftime("%Y%m%dT%H%M%SZ")
+    batch_dir = out_root / f"batch_{ts}"
+    batch_dir.mkdir(parents=True, exist_ok=False)
+
+    groups = plan_groups(specs)
+    n_slots = max(1, min(int(workers), len(specs)))
+    logger.info(
+        "batch | specs=%d | files=%d | workers=%d | dir=%s",
+        len(specs),
+        len(groups),
+        n_slots,
+        str(batch_dir),
+    )
+
+    rows: List[Optional[Dict[str, Any]]] = [None] * len(specs)
+    t0 = time.perf_counter()
+    homes: List[Optional[_Group]] = [None] * n_slots
+    inflight: Dict[Future, tuple] = {}  # future -> (slot, spec index)
+    pool = ProcessPoolExecutor(max_workers=n_slots)
+
+    def submit(slot: int) -> bool:
+        """False if the pool is broken (the run is put back for the next pool)."""
+        nxt = _next_for_slot(homes[slot], groups)
+        if nxt is None:
+            return True
+        g, idx = nxt
+        homes[slot] = g
+        try:
+            fut = pool.submit(
+                _run_one, idx, specs[idx], str(out_root), strict, log_level, engine
+            )
+        except BrokenProcessPool:
+            g.pending.appendleft(idx)
+            return False
+        inflight[fut] = (slot, idx)
+        return True
+
+    def record(row: Dict[str, Any]) -> None:
+        rows[row["index"]] = row
+        log = logger.error if row["status"] == "ERROR" else logger.info
+        log(
+            "run | %d/%d | %s | %s | %.1fs%s",
+            sum(r is not None for r in rows),
+            len(specs),
+            row["status"],
+            row["snap_path"],
+            row["elapsed_s"] or 0.0,
+            f" | {row['error']}" if row["error"] else "",
+        )
+
+    def died(idx: int, e: BaseException) -> Dict[str, Any]:
+        row = _new_row(idx, specs[idx])
+        row.update(status="ERROR", error=f"{type(e).__name__}: {e}")
+        return row
+
+    try:
+        broken = not all([submit(slot) for slot in range(n_slots)])
+        while inflight or broken:
+            if broken:
+                # Every run still on the dead pool fails with it; start a fresh pool
+                for fut in list(inflight):
+                    _, idx = inflight.pop(fut)
+                    try:
+                        record(fut.result())
+                    except BrokenProcessPool as e:
+                        record(died(idx, e))
+                pool.shutdown(wait=True)
+                logger.error("batch | worker process died, restarting the pool")
+                pool = ProcessPoolExecutor(max_workers=n_slots)
+                broken = not all([submit(slot) for slot in range(n_slots)])
+                continue
+
+            done, _ = wait(list(inflight), return_when=FIRST_COMPLETED)
+            for fut in done:
+                slot, idx = inflight.pop(fut)
+                try:
+                    row = fut.result()
+                except BrokenProcessPool as e:
+                    row = died(idx, e)
+                    broken = True
+                record(row)
+                if not broken:
+                    broken = not submit(slot)
+    finally:
+        pool.shutdown(wait=True)
+
+    final = [r for r in rows if r is not None]
+    write_csv(
+        batch_dir / "summary.csv",
+        SUMMARY_COLUMNS,
+        [[r[c] for c in SUMMARY_COLUMNS] for r in final],
+    )
+    status_counts: Dict[str, int] = {}
+    for r in final:
+        status_counts[r["status"]] = status_counts.get(r["status"], 0) + 1
+    write_json(
+        batch_dir / "summary.json",
+        {
+            "timestamp_utc": ts,
+            "engine": engine,
+            "strict": bool(strict),
+            "workers": n_slots,
+            "specs": len(specs),
+            "files": len(groups),
+            "status_counts": status_counts,
+            "wall_s": round(time.perf_counter() - t0, 3),
+            "runs": final,
+        },
+    )
+    logger.info("batch done | %s | dir=%s", status_counts, str(batch_dir))
+    return batch_dir
@@ -61,6 +61,39 @@ def _mid_from_record(rec: Any) -> Optional[int]:
     return None
 
 
+def _fill_row(f: Any) -> Dict[str, object]:
+    return {
+        "ts": int(f.ts),
+        "order_id": int(f.order_id),
+        "liq": getattr(f.liq, "name", str(f.liq)),
+        "side": getattr(f.side, "name", str(f.side)),
+        "price_q": int(f.price_q),
+        "qty_q": int(f.qty_q),
+        "notional_cash_q": int(f.notional_cash_q),
+        "fee_cash_q": int(f.fee_cash_q),
+    }
+
+
+def _event_row(e: Any) -> Dict[str, object]:
+    return {
+        "ts": int(e.ts),
+        "order_id": int(e.order_id),
+        "type": getattr(e.type, "name", str(e.type)),
+        "state": getattr(e.state, "name", str(e.state)),
+        "reject_reason": getattr(e.reject_reason, "name", str(e.reject_reason)),
+    }
+
+
+def _pos_bound_q(spec: ScenarioSpec) -> int:
+    return int(
+        getattr(
+            spec,
+            "pos_bound_q",
+            getattr(spec, "position_residual_tolerance_q", 0),
+        )
+    )
+
+
 def _build_params_and_ledger(mrl: Any, spec: ScenarioSpec) -> Tuple[Any, Any]:
     sim = mrl.sim
     p = sim.SimulatorParams()
@@ -78,6 +111,11 @@ def _build_params_and_ledger(mrl: Any, spec: ScenarioSpec) -> Tuple[Any, Any]:
         p.outbound_latency_ns = int(spec.outbound_latency_ns)
     if hasattr(p, "observation_latency_ns"):
         p.observation_latency_ns = int(spec.observation_latency_ns)
+    if hasattr(p, "rng_seed"):
+        p.rng_seed = int(spec.rng_seed)
+        p.rng_stream = int(spec.rng_stream)
+        p.outbound_latency_jitter_ns = int(spec.outbound_latency_jitter_ns)
+        p.stochastic_depletion = bool(spec.stochastic_depletion)
 
     led = sim.Ledger()
     led.cash_q = int(spec.initial_cash_q)
@@ -117,68 +155,13 @@ def _place_demo_orders(
     return idb, ida
 
 
-def run_scenario(
-    *,
-    spec: ScenarioSpec,
-    out_root: Path,
-    strict: bool,
-    log_level: str,
-) -> Path:
-    import microstructure_rl._core as mrl  # local import to keep module load explicit
-
-    logger = logging.getLogger("mrl.scenario")
-    logger.setLevel(getattr(logging, log_level.upper(), logging.INFO))
-    h = logging.StreamHandler()
-    h.setFormatter(logging.Formatter("%(asctime)s | %(levelname)s | %(message)s"))
-    logger.handlers[:] = [h]
-
-    repo_root = Path.cwd()
-    out_root = out_root.resolve()
-    out_root.mkdir(parents=True, exist_ok=True)
-
-    # Run id is hash(spec canonical json + data fingerprint + git sha)
-    dfp = fingerprint_file(Path(spec.snap_path))
-    spec_json = spec.canonical_json()
-    git = _git_info(repo_root)
-    run_id_material = {
-        "spec": json.loads(spec_json),
-        "data": dfp.to_dict(),
-        "git_sha": git.get("git_sha"),
-    }
-    run_id = sha256_text(
-        json.dumps(run_id_material, sort_keys=True, separators=(",", ":"))
-    )[0:16]
-    ts = _utc_stamp()
-    paths = make_run_dir(out_root, run_id, ts)
-
-    # Persist spec + manifest + replay token
-    spec.save(paths.spec_json)
-
-    manifest: Dict[str, object] = {
-        "run_id": run_id,
-        "timestamp_utc": ts,
-        "core_module_file": getattr(mrl, "__file__", None),
-        "platform": platform.platform(),
-        "python": platform.python_version(),
-        "data_fingerprint": dfp.to_dict(),
-        **git,
-    }
-    write_json(paths.manifest_json, manifest)
-
-    replay_token: Dict[str, object] = {
-        "run_id": run_id,
-        "timestamp_utc": ts,
-        "spec_sha256": sha256_text(spec_json),
-        "spec_path": str(paths.spec_json),
-        "data_fingerprint": dfp.to_dict(),
-        **git,
-        "how_to_rerun": f'python -m microstructure_rl.scenario run --spec "{paths.spec_json}"',
-    }
-    write_json(paths.replay_token_json, replay_token)
-
-    logger.info("core module: %s", getattr(mrl, "__file__", "<no file>"))
-    logger.debug("exports(sim): %s", [x for x in dir(mrl.sim) if not x.startswith("_")])
-
+def _run_python_loop(
+    mrl: Any, spec: ScenarioSpec, paths: Any, *, strict: bool, logger: logging.Logger
+) -> Dict[str, Any]:
+    """
+    Reference scenario loop in Python (one binding crossing per step). Kept for
+    cross-checking the native loop: both must write byte-identical artifacts.
+    """
     # Setup engine
     params, init_ledger = _build_params_and_ledger(mrl, spec)
     ex = mrl.sim.MarketSimulator(params)
@@ -234,33 +217,12 @@ def run_scenario(
         fill_rows = []
         for f in new_fills:
             checker.observe_fill(f)
-            fill_rows.append(
-                {
-                    "ts": int(f.ts),
-                    "order_id": int(f.order_id),
-                    "liq": getattr(f.liq, "name", str(f.liq)),
-                    "side": getattr(f.side, "name", str(f.side)),
-                    "price_q": int(f.price_q),
-                    "qty_q": int(f.qty_q),
-                    "notional_cash_q": int(f.notional_cash_q),
-                    "fee_cash_q": int(f.fee_cash_q),
-                }
-            )
+            fill_rows.append(_fill_row(f))
 
         event_rows = []
         for e in new_events:
             checker.observe_event(e)
-            event_rows.append(
-                {
-                    "ts": int(e.ts),
-                    "order_id": int(e.order_id),
-                    "type": getattr(e.type, "name", str(e.type)),
-                    "state": getattr(e.state, "name", str(e.state)),
-                    "reject_reason": getattr(
-                        e.reject_reason, "name", str(e.reject_reason)
-                    ),
-                }
-            )
+            event_rows.append(_event_row(e))
 
         if fill_rows:
             append_jsonl(paths.fills_jsonl, fill_rows)
@@ -340,13 +302,7 @@ def run_scenario(
             # - cash bound: 0 if integer accounting is exact, else 1..few units
             # - pos bound: 0 should hold
             cash_bound_q = int(getattr(spec, "cash_residual_tolerance_q", 1))
-            pos_bound_q = int(
-                getattr(
-                    spec,
-                    "pos_bound_q",
-                    getattr(spec, "position_residual_tolerance_q", 0),
-                )
-            )
+            pos_bound_q = _pos_bound_q(spec)
             err = inv.check(ex, cash_bound_q=cash_bound_q, pos_bound_q=pos_bound_q)
             if err:
                 logger.error("invariant FAIL at step=%d: %s", steps, err)
@@ -418,20 +374,13 @@ def run_scenario(
             rows = [[r.get(k) for k in header] for r in completed]
             write_csv(paths.markout_csv, header, rows)
 
-    # Summaries + digests
-    fills_digest = file_sha256(paths.fills_jsonl)
-    events_digest = file_sha256(paths.events_jsonl)
-    audit_digest = file_sha256(paths.audit_jsonl)
-
-    metrics: Dict[str, object] = {
-        "run_id": run_id,
-        "timestamp_utc": ts,
+    return {
         "steps": steps,
         "placed_orders": placed_orders,
         "fills": last_fills_n,
         "events": last_events_n,
         "failures": failures,
-        "strict": bool(strict),
+        "state_digest": int(ex.state_digest),
         "accounting": {
             "fills_seen": checker.acc.fills_seen,
             "expected_fee_cash_q": checker.acc.expected_fee_cash_q,
@@ -440,11 +389,232 @@ def run_scenario(
             "inferred_price_scale": checker.acc.inferred_price_scale,
             "overflow_risk_flag": checker.acc.overflow_risk_flag,
         },
+    }
+
+
+_LOG_LEVELS = {"Info": logging.INFO, "Warning": logging.WARNING, "Error": logging.ERROR}
+
+
+def _forward_logs(runner: Any, logger: logging.Logger) -> None:
+    for line in runner.take_logs():
+        logger.log(_LOG_LEVELS[line.level.name], "%s", line.text)
+
+
+def _audit_row(a: Any) -> Dict[str, object]:
+    # Same keys/order as InvariantChecker.check_accounting_residual + ts_ns
+    return {
+        "step": int(a.step),
+        "cash_q": int(a.cash_q),
+        "locked_cash_q": int(a.locked_cash_q),
+        "cash_total_q": int(a.cash_total_q),
+        "expected_cash_q": int(a.expected_cash_q),
+        "cash_residual_q": int(a.cash_residual_q),
+        "cash_residual_bound_q": int(a.cash_residual_bound_q),
+        "inferred_price_scale": a.inferred_price_scale,
+        "overflow_risk_flag": bool(a.overflow_risk_flag),
+        "mid_q": a.mid_q,
+        "wealth_mtm_q": a.wealth_mtm_q,
+        "status": "PASS" if a.passed else "FAIL",
+        "ts_ns": int(a.ts_ns),
+    }
+
+
+def _run_native_loop(
+    mrl: Any, spec: ScenarioSpec, paths: Any, *, strict: bool, logger: logging.Logger
+) -> Dict[str, Any]:
+    """
+    Scenario loop in C++ (sim.ScenarioRunner): stepping, conservation, markouts,
+    demo quoting and audits run natively with the GIL released; Python only writes
+    the checkpoint deltas with the same row builders as the reference loop.
+    """
+    sim = mrl.sim
+    params, init_ledger = _build_params_and_ledger(mrl, spec)
+
+    cfg = sim.ScenarioConfig()
+    cfg.params = params
+    cfg.initial_ledger = init_ledger
+    cfg.start_ts_ns = int(spec.start_ts_ns)
+    cfg.max_steps = int(spec.max_steps)
+    cfg.warmup_steps = int(spec.warmup_steps)
+    cfg.order_every_steps = int(spec.order_every_steps)
+    cfg.check_every_steps = int(spec.check_every_steps)
+    cfg.conservation_every_steps = 5000
+    cfg.qty_q = int(spec.qty_q)
+    cfg.tick_q = int(spec.tick_q)
+    cfg.cash_residual_tolerance_q = int(getattr(spec, "cash_residual_tolerance_q", 1))
+    cfg.pos_residual_tolerance_q = _pos_bound_q(spec)
+    cfg.strict = bool(strict)
+    cfg.enable_markout = bool(spec.enable_markout)
+    cfg.markout_horizons_steps = [int(h) for h in spec.markout_horizons_steps]
+
+    rk = mrl.md_l2.ReplayKernel(spec.snap_path)
+    if rk.size() == 0:
+        raise RuntimeError(f"empty snap: {spec.snap_path}")
+    runner = sim.ScenarioRunner(cfg, rk)
+
+    while True:
+        try:
+            more = runner.advance()
+        finally:
+            _forward_logs(runner, logger)
+        if not more:
+            break
+        fill_rows = [_fill_row(f) for f in runner.new_fills()]
+        event_rows = [_event_row(e) for e in runner.new_events()]
+        if fill_rows:
+            append_jsonl(paths.fills_jsonl, fill_rows)
+        if event_rows:
+            append_jsonl(paths.events_jsonl, event_rows)
+        append_jsonl(paths.audit_jsonl, [_audit_row(runner.checkpoint.audit)])
+
+    if spec.enable_markout:
+        completed = runner.markout_rows
+        if completed:
+            header = [
+                "fill_idx",
+                "fill_ts_ns",
+                "order_id",
+                "liq",
+                "side",
+                "qty_q",
+                "fill_price_q",
+                "mid0_q",
+                "step0",
+            ] + [f"markout_price_q_h{h}" for h in runner.markout_horizons]
+            rows = [
+                [
+                    int(r.fill_idx),
+                    int(r.fill_ts_ns),
+                    int(r.order_id),
+                    r.liq.name,
+                    r.side.name,
+                    int(r.qty_q),
+                    int(r.fill_price_q),
+                    int(r.mid0_q),
+                    int(r.step0),
+                    *[int(x) for x in r.markout_price_q],
+                ]
+                for r in completed
+            ]
+            write_csv(paths.markout_csv, header, rows)
+
+    acc = runner.accounting
+    return {
+        "steps": int(runner.steps),
+        "placed_orders": int(runner.placed_orders),
+        "fills": int(runner.fills_seen),
+        "events": int(runner.events_seen),
+        "failures": int(runner.failures),
+        "state_digest": int(runner.simulator.state_digest),
+        "accounting": {
+            "fills_seen": int(acc.fills_seen),
+            "expected_fee_cash_q": int(acc.expected_fee_cash_q),
+            "max_cash_residual_q": int(acc.max_cash_residual_q),
+            "max_cash_residual_bound_q": int(acc.max_cash_bound_q),
+            "inferred_price_scale": acc.inferred_price_scale,
+            "overflow_risk_flag": bool(acc.overflow_risk_flag),
+        },
+    }
+
+
+def run_scenario(
+    *,
+    spec: ScenarioSpec,
+    out_root: Path,
+    strict: bool,
+    log_level: str,
+    engine: str = "native",
+    run_dir_suffix: str = "",
+) -> Path:
+    """
+    Run one scenario and write its artifacts under `out_root`. The run dir is
+    `<run_id>_<timestamp>[_<run_dir_suffix>]`; callers that start identical specs
+    within the same second (batches) pass a distinguishing suffix.
+    """
+    import microstructure_rl._core as mrl  # local import to keep module load explicit
+
+    logger = logging.getLogger("mrl.scenario")
+    logger.setLevel(getattr(logging, log_level.upper(), logging.INFO))
+    h = logging.StreamHandler()
+    h.setFormatter(logging.Formatter("%(asctime)s | %(levelname)s | %(message)s"))
+    logger.handlers[:] = [h]
+
+    repo_root = Path.cwd()
+    out_root = out_root.resolve()
+    out_root.mkdir(parents=True, exist_ok=True)
+
+    # Run id is hash(spec canonical json + data fingerprint + git sha)
+    dfp = fingerprint_file(Path(spec.snap_path))
+    spec_json = spec.canonical_json()
+    git = _git_info(repo_root)
+    run_id_material = {
+        "spec": json.loads(spec_json),
+        "data": dfp.to_dict(),
+        "git_sha": git.get("git_sha"),
+    }
+    run_id = sha256_text(
+        json.dumps(run_id_material, sort_keys=True, separators=(",", ":"))
+    )[0:16]
+    ts = _utc_stamp()
+    paths = make_run_dir(out_root, run_id, ts, run_dir_suffix)
+
+    # Persist spec + manifest + replay token
+    spec.save(paths.spec_json)
+
+    manifest: Dict[str, object] = {
+        "run_id": run_id,
+        "timestamp_utc": ts,
+        "core_module_file": getattr(mrl, "__file__", None),
+        "platform": platform.platform(),
+        "python": platform.python_version(),
+        "data_fingerprint": dfp.to_dict(),
+        **git,
+    }
+    write_json(paths.manifest_json, manifest)
+
+    replay_token: Dict[str, object] = {
+        "run_id": run_id,
+        "timestamp_utc": ts,
+        "spec_sha256": sha256_text(spec_json),
+        "spec_path": str(paths.spec_json),
+        "data_fingerprint": dfp.to_dict(),
+        **git,
+        "how_to_rerun": f'python -m microstructure_rl.scenario run --spec "{paths.spec_json}"',
+    }
+    write_json(paths.replay_token_json, replay_token)
+
+    logger.info("core module: %s", getattr(mrl, "__file__", "<no file>"))
+    logger.debug("exports(sim): %s", [x for x in dir(mrl.sim) if not x.startswith("_")])
+
+    if engine == "native":
+        res = _run_native_loop(mrl, spec, paths, strict=strict, logger=logger)
+    elif engine == "python":
+        res = _run_python_loop(mrl, spec, paths, strict=strict, logger=logger)
+    else:
+        raise ValueError(f"unknown engine: {engine!r} (expected 'native' or 'python')")
+
+    # Summaries + digests
+    fills_digest = file_sha256(paths.fills_jsonl)
+    events_digest = file_sha256(paths.events_jsonl)
+    audit_digest = file_sha256(paths.audit_jsonl)
+
+    metrics: Dict[str, object] = {
+        "run_id": run_id,
+        "timestamp_utc": ts,
+        "steps": res["steps"],
+        "placed_orders": res["placed_orders"],
+        "fills": res["fills"],
+        "events": res["events"],
+        "failures": res["failures"],
+        "strict": bool(strict),
+        "accounting": res["accounting"],
         "digests": {
             "fills_jsonl_sha256": fills_digest,
             "events_jsonl_sha256": events_digest,
             "audit_jsonl_sha256": audit_digest,
             "spec_json_sha256": sha256_text(spec_json),
+            # Rolling simulator digest (cheap cross-build/thread-count comparison)
+            "state_digest": f"{res['state_digest']:016x}",
         },
     }
     write_json(paths.metrics_json, metrics)
@@ -453,9 +623,9 @@ def run_scenario(
     replay_token["digests"] = metrics["digests"]
     write_json(paths.replay_token_json, replay_token)
 
-    if failures and strict:
+    if res["failures"] and strict:
         raise RuntimeError(
-            f"scenario failed with {failures} invariant/contract violations; run_dir={paths.run_dir}"
+            f"scenario failed with {res['failures']} invariant/contract violations; run_dir={paths.run_dir}"
         )
 
     logger.info("done | run_dir=%s", str(paths.run_dir))
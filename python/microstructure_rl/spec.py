@@ -42,6 +42,13 @@ class ScenarioSpec:
     observation_latency_ns: int = 0
     start_ts_ns: int = 0
 
+    # Stochastic extensions (counter-based RNG: draws depend only on seed/stream,
+    # never on how runs are scheduled across workers)
+    rng_seed: int = 0
+    rng_stream: int = 0
+    outbound_latency_jitter_ns: int = 0
+    stochastic_depletion: bool = False
+
     # Ledger
     initial_cash_q: int = 10**18
     initial_position_qty_q: int = 10**9
@@ -0,0 +1,97 @@
+from __future__ import annotations
+
+from dataclasses import dataclass, field
+from typing import Any, Optional, Tuple
+
+import numpy as np
+
+
+class StaleViewError(RuntimeError):
+    """Raised when a view is used after the simulator storage it aliases has moved."""
+
+
+def _dtype_from_layout(layout: Tuple[list, int]) -> np.dtype:
+    fields, itemsize = layout
+    return np.dtype(
+        {
+            "names": [str(name) for name, _, _ in fields],
+            "formats": [str(fmt) for _, _, fmt in fields],
+            "offsets": [int(off) for _, off, _ in fields],
+            "itemsize": int(itemsize),
+        }
+    )
+
+
+@dataclass(frozen=True)
+class StampedView:
+    """
+    Structured, read-only numpy view over simulator storage plus the
+    storage_version it was taken at. Zero-copy: rows alias the C++ vectors.
+
+    The rows are only reachable through `array` (or SimViews.get()), which
+    raises StaleViewError once the storage has moved.
+    """
+
+    _array: np.ndarray = field(repr=False, compare=False)
+    version: int
+    _owner: "SimViews" = field(repr=False, compare=False)
+
+    @property
+    def array(self) -> np.ndarray:
+        return self._owner.get(self)
+
+
+class SimViews:
+    """
+    Zero-copy structured views over MarketSimulator orders/events/fills.
+
+    Views alias live C++ memory: they are invalidated by reset() and, for fills,
+    by fill-log growth. Reading a stale view (v.array or get()) raises
+    StaleViewError; check is_current() and take a fresh one. Copy
+    (np.array(v.array)) anything that must outlive the episode.
+    """
+
+    def __init__(self, ex: Any) -> None:
+        from . import _core as mrl  # local import to keep module load explicit
+
+        self._ex = ex
+        self.order_dtype = _dtype_from_layout(mrl.sim.order_layout())
+        self.event_dtype = _dtype_from_layout(mrl.sim.event_layout())
+        self.fill_dtype = _dtype_from_layout(mrl.sim.fill_layout())
+
+    def _wrap(self, buf: Any, dtype: np.dtype) -> StampedView:
+        raw = np.asarray(buf)
+        if raw.shape[0] == 0:
+            arr = np.empty(0, dtype=dtype)
+        else:
+            arr = raw.view(dtype).reshape(raw.shape[0])
+        arr.flags.writeable = False
+        return StampedView(_array=arr, version=int(self._ex.storage_version), _owner=self)
+
+    def orders(self) -> StampedView:
+        return self._wrap(self._ex.orders_buffer(), self.order_dtype)
+
+    def events(self) -> StampedView:
+        return self._wrap(self._ex.events_buffer(), self.event_dtype)
+
+    def fills(self) -> StampedView:
+        return self._wrap(self._ex.fills_buffer(), self.fill_dtype)
+
+    def is_current(self, view: StampedView) -> bool:
+        return view.version == int(self._ex.storage_version)
+
+    def get(self, view: StampedView) -> np.ndarray:
+        if not self.is_current(view):
+            raise StaleViewError(
+                f"view taken at storage_version={view.version}, "
+                f"simulator is at {int(self._ex.storage_version)}"
+            )
+        return view._array
+
+    def order_row(self, view: StampedView, order_id: int) -> Optional[np.void]:
+        """O(1) row lookup in an orders view via the simulator id -> index map."""
+        arr = self.get(view)
+        idx = self._ex.order_index(int(order_id))
+        if idx is None or idx >= arr.shape[0]:
+            return None
+        return arr[idx]
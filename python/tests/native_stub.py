@@ -0,0 +1,18 @@
+"""
+Shared test setup: puts python/ on sys.path and a stand-in for the native
+`microstructure_rl._core` in sys.modules, so the package imports without a built
+extension. Import it before any microstructure_rl module.
+"""
+
+from __future__ import annotations
+
+import sys
+import types
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parents[1]))
+
+core = types.ModuleType("microstructure_rl._core")
+core.md_l2 = types.SimpleNamespace()
+core.sim = types.SimpleNamespace()
+core = sys.modules.setdefault("microstructure_rl._core", core)
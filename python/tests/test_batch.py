@@ -0,0 +1,90 @@
+"""
+Batch executor tests with the scenario run replaced (no native module).
+
+    python -m unittest discover -s python/tests
+"""
+
+from __future__ import annotations
+
+import json
+import multiprocessing
+import os
+import tempfile
+import unittest
+from pathlib import Path
+from unittest import mock
+
+import native_stub  # noqa: F401  (stubs _core; before microstructure_rl)
+from microstructure_rl import batch, runner
+from microstructure_rl.spec import ScenarioSpec
+
+
+def _loop(mrl, spec, paths, *, strict, logger):
+    return {
+        "steps": 1,
+        "placed_orders": 0,
+        "fills": 0,
+        "events": 0,
+        "failures": 0,
+        "state_digest": 0,
+        "accounting": {},
+    }
+
+
+def _run_one_or_die(index, spec, out_root, strict, log_level, engine):
+    if index == 1:
+        os._exit(3)  # simulated native crash in the worker
+    row = batch._new_row(index, spec)
+    row.update(status="OK", elapsed_s=0.0)
+    return row
+
+
+class BatchTest(unittest.TestCase):
+    def setUp(self) -> None:
+        self.tmp = tempfile.TemporaryDirectory()
+        root = Path(self.tmp.name)
+        snap = root / "data.snap"
+        snap.write_bytes(b"\0" * 64)
+        self.spec = ScenarioSpec(snap_path=str(snap))
+        self.out = root / "runs"
+
+    def tearDown(self) -> None:
+        self.tmp.cleanup()
+
+    def test_identical_specs_get_distinct_run_dirs(self) -> None:
+        with mock.patch.object(runner, "_run_native_loop", _loop):
+            rows = [
+                batch._run_one(i, self.spec, str(self.out), False, "ERROR", "native")
+                for i in range(3)
+            ]
+        self.assertEqual([r["status"] for r in rows], ["OK"] * 3)
+        self.assertEqual(len({r["run_dir"] for r in rows}), 3)
+
+    def test_rng_stream_follows_the_file_not_its_position(self) -> None:
+        root = Path(self.tmp.name)
+        a, b, c = (root / f"BTCUSDT_depth20_2024-01-0{d}_00.snap" for d in (1, 2, 3))
+        first = batch.specs_for_snaps(self.spec, [a, b])
+        second = batch.specs_for_snaps(self.spec, [c, b, a])
+        stream = {s.snap_path: s.rng_stream for s in first}
+        for s in second:
+            if s.snap_path in stream:
+                self.assertEqual(s.rng_stream, stream[s.snap_path])
+        self.assertEqual(len({s.rng_stream for s in second}), 3)
+
+    @unittest.skipUnless(
+        "fork" in multiprocessing.get_all_start_methods(), "needs fork to patch workers"
+    )
+    def test_dead_worker_fails_its_run_and_the_batch_continues(self) -> None:
+        specs = [self.spec] * 4
+        with mock.patch.object(batch, "_run_one", _run_one_or_die):
+            batch_dir = batch.run_batch(
+                specs=specs, out_root=self.out, workers=1, strict=False, log_level="CRITICAL"
+            )
+        summary = json.loads((batch_dir / "summary.json").read_text(encoding="utf-8"))
+        status = {r["index"]: r["status"] for r in summary["runs"]}
+        self.assertEqual(status, {0: "OK", 1: "ERROR", 2: "OK", 3: "OK"})
+        self.assertIn("BrokenProcessPool", summary["runs"][1]["error"])
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,63 @@
+"""
+Runner tests that do not need the native module: `_core` is stubbed and the
+scenario loop replaced, so only run_scenario()'s own bookkeeping runs.
+
+    python -m unittest discover -s python/tests
+"""
+
+from __future__ import annotations
+
+import tempfile
+import unittest
+from pathlib import Path
+from unittest import mock
+
+import native_stub  # noqa: F401  (stubs _core; before microstructure_rl)
+from microstructure_rl import runner
+from microstructure_rl.spec import ScenarioSpec
+
+
+def _fake_loop(failures: int):
+    def loop(mrl, spec, paths, *, strict, logger):
+        return {
+            "steps": 10,
+            "placed_orders": 1,
+            "fills": 0,
+            "events": 0,
+            "failures": failures,
+            "state_digest": 0x1234,
+            "accounting": {},
+        }
+
+    return loop
+
+
+class RunScenarioStrictTest(unittest.TestCase):
+    def setUp(self) -> None:
+        self.tmp = tempfile.TemporaryDirectory()
+        root = Path(self.tmp.name)
+        snap = root / "data.snap"
+        snap.write_bytes(b"\0" * 64)
+        self.spec = ScenarioSpec(snap_path=str(snap))
+        self.out = root / "runs"
+
+    def tearDown(self) -> None:
+        self.tmp.cleanup()
+
+    def _run(self, failures: int, strict: bool) -> Path:
+        with mock.patch.object(runner, "_run_native_loop", _fake_loop(failures)):
+            return runner.run_scenario(
+                spec=self.spec, out_root=self.out, strict=strict, log_level="ERROR"
+            )
+
+    def test_strict_violation_raises_runtime_error(self) -> None:
+        with self.assertRaisesRegex(RuntimeError, "failed with 3 invariant"):
+            self._run(failures=3, strict=True)
+
+    def test_non_strict_violation_returns_run_dir(self) -> None:
+        run_dir = self._run(failures=3, strict=False)
+        self.assertTrue((run_dir / "metrics.json").exists())
+
+
+if __name__ == "__main__":
+    unittest.main()
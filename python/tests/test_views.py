@@ -0,0 +1,64 @@
+"""
+StampedView staleness checks against a fake simulator (no native module).
+
+    python -m unittest discover -s python/tests
+"""
+
+from __future__ import annotations
+
+import types
+import unittest
+
+import numpy as np
+
+import native_stub  # stubs _core; before microstructure_rl
+from microstructure_rl import views
+
+_LAYOUT = ([("id", 0, "<u8"), ("qty_q", 8, "<i8")], 16)
+
+
+class _FakeSim:
+    def __init__(self) -> None:
+        self.storage_version = 1
+        self.rows = np.zeros((2, 16), dtype=np.uint8)
+
+    def orders_buffer(self) -> np.ndarray:
+        return self.rows
+
+    def order_index(self, order_id: int):
+        return 1 if order_id == 7 else None
+
+
+class StampedViewTest(unittest.TestCase):
+    def setUp(self) -> None:
+        self.sim_ns = types.SimpleNamespace(
+            order_layout=lambda: _LAYOUT,
+            event_layout=lambda: _LAYOUT,
+            fill_layout=lambda: _LAYOUT,
+        )
+        self._saved = native_stub.core.sim
+        native_stub.core.sim = self.sim_ns
+        self.ex = _FakeSim()
+        self.v = views.SimViews(self.ex)
+
+    def tearDown(self) -> None:
+        native_stub.core.sim = self._saved
+
+    def test_current_view_reads_rows(self) -> None:
+        o = self.v.orders()
+        self.assertEqual(o.array.shape, (2,))
+        self.assertFalse(o.array.flags.writeable)
+        self.assertIsNotNone(self.v.order_row(o, 7))
+
+    def test_stale_view_raises_on_array_access(self) -> None:
+        o = self.v.orders()
+        self.ex.storage_version += 1  # reset() / fill-log reallocation
+        self.assertFalse(self.v.is_current(o))
+        with self.assertRaises(views.StaleViewError):
+            o.array
+        with self.assertRaises(views.StaleViewError):
+            self.v.order_row(o, 7)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,400 @@
+"""
+Binding-overhead micro-benchmark suite for `_core`.
+
+Measures the per-call cost of Python -> C++ crossings on the hot calls:
+  replay_next          ReplayKernel.next()
+  record_field_access  RecordView.ts_recv_ns / best_bid_price_q / best_ask_price_q
+  bids_view            RecordView.bids() ndarray creation
+  sim_step             MarketSimulator.step(record)
+  place_limit          MarketSimulator.place_limit(req)
+  cancel               MarketSimulator.cancel(order_id)
+  fills_snapshot       MarketSimulator.fills() (copying snapshot)
+
+and compares each against:
+  native  the same loop driven in C++ (cpp/bench/bench_sim.cpp, BM_Native_*)
+  memmap  the equivalent SnapReader numpy.memmap access, where one exists
+
+Output is one JSON document (schema "msrl.bench_bindings/1") meant to be archived
+per release and diffed. `overhead_ns` = python ns/op - native ns/op.
+
+------------------------------------------------------------------------------
+Usage examples
+------------------------------------------------------------------------------
+From repo root:
+
+  python scripts\\bench_bindings.py --snap D:\\data\\BTCUSDT.snap --out bench.json
+  python scripts\\bench_bindings.py --snap <file> --native-bench build\\Release\\bench_sim.exe
+
+The native binary reads the file from MSRL_BENCH_SNAP; this script sets it.
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import os
+import platform
+import subprocess
+import sys
+import time
+from pathlib import Path
+from typing import Any, Callable, Dict, List, Optional
+
+REPO_ROOT = Path(__file__).resolve().parents[1]
+
+SCHEMA = "msrl.bench_bindings/1"
+
+# Python benchmark name -> google-benchmark name in bench_sim
+NATIVE_NAMES = {
+    "replay_next": "BM_Native_ReplayNext",
+    "record_field_access": "BM_Native_RecordFieldAccess",
+    "bids_view": "BM_Native_BidsView",
+    "sim_step": "BM_Native_SimStep",
+    "place_limit": "BM_Native_PlaceLimit",
+    "cancel": "BM_Native_Cancel",
+    "fills_snapshot": "BM_Native_FillsSnapshot",
+}
+
+# Must match bench_sim.cpp so the two sides measure the same work
+MAX_ORDERS = 4096
+MAX_EVENTS = 1 << 16
+FILLS_FOR_SNAPSHOT = 256
+
+
+# =============================================================================
+# Timing
+# =============================================================================
+
+
+def _measure(
+    body: Callable[[int], int], *, min_time_s: float, repeats: int
+) -> Dict[str, float]:
+    """
+    body(n) runs exactly n operations and returns the timed nanoseconds (loops
+    with untimed setup exclude it themselves). Calibrates n to min_time_s and
+    keeps the best of `repeats` runs (least scheduler noise).
+    """
+    n = 1000
+    while True:
+        dt = body(n)
+        if dt >= min_time_s * 1e9 or n >= 1 << 24:
+            break
+        n *= 4
+
+    best = dt / n
+    for _ in range(repeats - 1):
+        best = min(best, body(n) / n)
+    return {"ns_per_op": best, "ops": float(n)}
+
+
+def _timed(loop: Callable[[int], None]) -> Callable[[int], int]:
+    def body(n: int) -> int:
+        t0 = time.perf_counter_ns()
+        loop(n)
+        return time.perf_counter_ns() - t0
+
+    return body
+
+
+# =============================================================================
+# Python (binding) loops
+# =============================================================================
+
+
+def _params_and_ledger(mrl):
+    p = mrl.sim.SimulatorParams()
+    p.max_orders = MAX_ORDERS
+    p.max_events = MAX_EVENTS
+    ledger = mrl.sim.Ledger()
+    ledger.cash_q = 10**18
+    ledger.position_qty_q = 10**12
+    return p, ledger
+
+
+def _next_wrap(rk):
+    r = rk.next()
+    if r is None:
+        rk.reset()
+        r = rk.next()
+    return r
+
+
+def python_suite(
+    snap: str, *, min_time_s: float, repeats: int
+) -> Dict[str, Dict[str, float]]:
+    import microstructure_rl._core as mrl  # local import to keep module load explicit
+
+    rk = mrl.md_l2.ReplayKernel(snap)
+    if rk.size() == 0:
+        raise RuntimeError(f"empty snap: {snap}")
+    out: Dict[str, Dict[str, float]] = {}
+
+    def replay_next(n: int) -> None:
+        for _ in range(n):
+            if rk.next() is None:
+                rk.reset()
+
+    rk.reset()
+    out["replay_next"] = _measure(
+        _timed(replay_next), min_time_s=min_time_s, repeats=repeats
+    )
+
+    rec = _next_wrap(rk)
+
+    def field_access(n: int) -> None:
+        for _ in range(n):
+            rec.ts_recv_ns
+            rec.best_bid_price_q
+            rec.best_ask_price_q
+
+    out["record_field_access"] = _measure(
+        _timed(field_access), min_time_s=min_time_s, repeats=repeats
+    )
+
+    def bids_view(n: int) -> None:
+        for _ in range(n):
+            rec.bids()
+
+    out["bids_view"] = _measure(
+        _timed(bids_view), min_time_s=min_time_s, repeats=repeats
+    )
+
+    params, ledger = _params_and_ledger(mrl)
+
+    ex = mrl.sim.MarketSimulator(params)
+    ex.reset(0, ledger)
+
+    def sim_step(n: int) -> None:
+        for _ in range(n):
+            r = rk.next()
+            if r is None:
+                rk.reset()
+                r = rk.next()
+            ex.step(r)
+
+    out["sim_step"] = _measure(_timed(sim_step), min_time_s=min_time_s, repeats=repeats)
+
+    # Passive bid one tick below the touch, so it rests without filling
+    req = mrl.sim.LimitOrderRequest()
+    req.side = mrl.sim.Side.Buy
+    req.price_q = max(int(rec.best_bid_price_q) - 1, 1)
+    req.qty_q = 1
+    batch = MAX_ORDERS - 1
+
+    def place_limit(n: int) -> int:
+        done = 0
+        elapsed = 0
+        while done < n:
+            ex.reset(0, ledger)
+            ex.step(rec)
+            k = min(batch, n - done)
+            t0 = time.perf_counter_ns()
+            for _ in range(k):
+                ex.place_limit(req)
+            elapsed += time.perf_counter_ns() - t0
+            done += k
+        return elapsed
+
+    out["place_limit"] = _measure(place_limit, min_time_s=min_time_s, repeats=repeats)
+
+    def cancel(n: int) -> int:
+        done = 0
+        elapsed = 0
+        while done < n:
+            ex.reset(0, ledger)
+            ex.step(rec)
+            ids = [ex.place_limit(req) for _ in range(min(batch, n - done))]
+            ex.step(rec)  # activate
+            t0 = time.perf_counter_ns()
+            for oid in ids:
+                ex.cancel(oid)
+            elapsed += time.perf_counter_ns() - t0
+            done += len(ids)
+        return elapsed
+
+    out["cancel"] = _measure(cancel, min_time_s=min_time_s, repeats=repeats)
+
+    # Marketable 1-lot buys at the touch (market orders are rejected by the engine)
+    ex.reset(0, ledger)
+    rk.reset()
+    r = _next_wrap(rk)
+    ex.step(r)
+    for _ in range(FILLS_FOR_SNAPSHOT):
+        take = mrl.sim.LimitOrderRequest()
+        take.side = mrl.sim.Side.Buy
+        take.price_q = int(r.best_ask_price_q)
+        take.qty_q = 1
+        ex.place_limit(take)
+        r = _next_wrap(rk)
+        ex.step(r)
+        r = _next_wrap(rk)
+        ex.step(r)
+
+    def fills_snapshot(n: int) -> None:
+        for _ in range(n):
+            ex.fills()
+
+    out["fills_snapshot"] = _measure(
+        _timed(fills_snapshot), min_time_s=min_time_s, repeats=repeats
+    )
+    out["fills_snapshot"]["n_fills"] = float(len(ex.fills()))
+    return out
+
+
+# =============================================================================
+# SnapReader numpy.memmap equivalents
+# =============================================================================
+
+
+def memmap_suite(
+    snap: str, *, min_time_s: float, repeats: int
+) -> Dict[str, Dict[str, float]]:
+    sys.path.insert(0, str(REPO_ROOT / "python"))
+    from md.snap_reader import SnapReader  # noqa: E402
+
+    recs = SnapReader(snap).records
+    size = len(recs)
+    out: Dict[str, Dict[str, float]] = {}
+
+    def replay_next(n: int) -> None:
+        i = 0
+        for _ in range(n):
+            recs[i]
+            i += 1
+            if i == size:
+                i = 0
+
+    out["replay_next"] = _measure(
+        _timed(replay_next), min_time_s=min_time_s, repeats=repeats
+    )
+
+    r0 = recs[0]
+
+    def field_access(n: int) -> None:
+        for _ in range(n):
+            r0["ts_recv_ns"]
+            r0["bids"][0]["price_q"]
+            r0["asks"][0]["price_q"]
+
+    out["record_field_access"] = _measure(
+        _timed(field_access), min_time_s=min_time_s, repeats=repeats
+    )
+
+    def bids_view(n: int) -> None:
+        for _ in range(n):
+            r0["bids"]
+
+    out["bids_view"] = _measure(
+        _timed(bids_view), min_time_s=min_time_s, repeats=repeats
+    )
+    return out
+
+
+# =============================================================================
+# Native (google-benchmark) baselines
+# =============================================================================
+
+
+def native_suite(snap: str, exe: Path, *, min_time_s: float) -> Dict[str, Dict[str, float]]:
+    env = dict(os.environ)
+    env["MSRL_BENCH_SNAP"] = snap
+    proc = subprocess.run(
+        [str(exe), "--benchmark_format=json", f"--benchmark_min_time={min_time_s}"],
+        check=True,
+        capture_output=True,
+        text=True,
+        env=env,
+    )
+    doc = json.loads(proc.stdout)
+    by_native = {v: k for k, v in NATIVE_NAMES.items()}
+    out: Dict[str, Dict[str, float]] = {}
+    for b in doc.get("benchmarks", []):
+        key = by_native.get(b.get("name", ""))
+        if key is None or b.get("error_occurred"):
+            continue
+        scale = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}.get(b.get("time_unit", "ns"), 1.0)
+        out[key] = {"ns_per_op": float(b["real_time"]) * scale, "ops": float(b["iterations"])}
+    return out
+
+
+# =============================================================================
+# Driver
+# =============================================================================
+
+
+def _git_sha() -> Optional[str]:
+    try:
+        return subprocess.run(
+            ["git", "rev-parse", "HEAD"],
+            cwd=REPO_ROOT,
+            check=True,
+            capture_output=True,
+            text=True,
+        ).stdout.strip()
+    except Exception:
+        return None
+
+
+def _package_version() -> Optional[str]:
+    try:
+        from importlib.metadata import version
+
+        return version("microstructure-rl")
+    except Exception:
+        return None
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description="Python binding-overhead micro-benchmarks")
+    ap.add_argument("--snap", required=True, help="Path to a .snap file")
+    ap.add_argument("--out", default=None, help="Write JSON here (default: stdout)")
+    ap.add_argument("--native-bench", default=None, help="Path to the bench_sim executable")
+    ap.add_argument("--no-memmap", action="store_true", help="Skip SnapReader comparisons")
+    ap.add_argument("--min-time", type=float, default=0.2, help="Seconds per measurement")
+    ap.add_argument("--repeats", type=int, default=3)
+    args = ap.parse_args()
+
+    py = python_suite(args.snap, min_time_s=args.min_time, repeats=args.repeats)
+    mm: Dict[str, Dict[str, float]] = {}
+    if not args.no_memmap:
+        mm = memmap_suite(args.snap, min_time_s=args.min_time, repeats=args.repeats)
+    nat: Dict[str, Dict[str, float]] = {}
+    if args.native_bench:
+        nat = native_suite(args.snap, Path(args.native_bench), min_time_s=args.min_time)
+
+    results: List[Dict[str, Any]] = []
+    for name, r in py.items():
+        row: Dict[str, Any] = {"name": name, "python_ns": r["ns_per_op"]}
+        if "n_fills" in r:
+            row["n_fills"] = int(r["n_fills"])
+        if name in nat:
+            row["native_ns"] = nat[name]["ns_per_op"]
+            row["overhead_ns"] = r["ns_per_op"] - nat[name]["ns_per_op"]
+        if name in mm:
+            row["memmap_ns"] = mm[name]["ns_per_op"]
+        results.append(row)
+
+    doc = {
+        "schema": SCHEMA,
+        "meta": {
+            "package_version": _package_version(),
+            "git_sha": _git_sha(),
+            "python": platform.python_version(),
+            "platform": platform.platform(),
+            "snap": str(Path(args.snap).resolve()),
+            "min_time_s": args.min_time,
+            "repeats": args.repeats,
+            "timestamp_utc": time.strftime("%Y-%m-%dT%H:%M:%SZ", time.gmtime()),
+        },
+        "results": results,
+    }
+    text = json.dumps(doc, indent=2, sort_keys=True)
+    if args.out:
+        Path(args.out).write_text(text + "\n", encoding="utf-8")
+    else:
+        print(text)
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
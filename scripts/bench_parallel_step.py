@@ -0,0 +1,150 @@
+"""
+Parallel environment-stepping benchmark for the `_core` bindings.
+
+Runs one MarketSimulator per Python thread over the same `.snap` file and reports
+aggregate records/second as the thread count grows. Two modes:
+
+  range : MarketSimulator.step_range(kernel, ...)  (GIL released for the whole run)
+  loop  : Python loop over ReplayKernel.next() + MarketSimulator.step(record)
+
+On regular CPython `range` should scale with cores and `loop` stays dispatch-bound
+(the per-call overhead runs under the GIL). On free-threaded CPython (3.13t) both
+modes scale. See docs/components/python_threading.md for the sharing rules.
+
+------------------------------------------------------------------------------
+Usage examples
+------------------------------------------------------------------------------
+From repo root:
+
+  python scripts\\bench_parallel_step.py --snap D:\\data\\BTCUSDT.snap
+  python scripts\\bench_parallel_step.py --snap <file> --threads 1 2 4 8 --mode loop
+  python scripts\\bench_parallel_step.py --snap <file> --numa   (thread i pinned to node i % nodes)
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import os
+import sys
+import sysconfig
+import threading
+import time
+from typing import Dict, List
+
+
+def _make_sim(mrl):
+    p = mrl.sim.SimulatorParams()
+    p.max_orders = 1024
+    p.max_events = 1 << 16
+    ledger = mrl.sim.Ledger()
+    ledger.cash_q = 10**15
+    ledger.position_qty_q = 10**12
+    ex = mrl.sim.MarketSimulator(p)
+    return ex, ledger
+
+
+def _pin(mrl, nodes, i: int) -> None:
+    if nodes:
+        mrl.md_l2.pin_current_thread(nodes[i % len(nodes)])
+
+
+def _worker_range(mrl, rk, n: int, barrier: threading.Barrier, out: List[int], i: int, nodes) -> None:
+    _pin(mrl, nodes, i)
+    ex, ledger = _make_sim(mrl)
+    ex.reset(int(rk.batch(0, 1).ts_recv_ns()[0]), ledger)
+    barrier.wait()
+    out[i] = int(ex.step_range(rk, 0, n))
+
+
+def _worker_loop(mrl, snap: str, n: int, barrier: threading.Barrier, out: List[int], i: int, nodes) -> None:
+    _pin(mrl, nodes, i)
+    # Cursor state is per-kernel: each thread owns its kernel over the shared mapping.
+    rk = mrl.md_l2.ReplayKernel(snap)
+    ex, ledger = _make_sim(mrl)
+    ex.reset(int(rk.batch(0, 1).ts_recv_ns()[0]), ledger)
+    barrier.wait()
+    steps = 0
+    while steps < n:
+        r = rk.next()
+        if r is None:
+            break
+        ex.step(r)
+        steps += 1
+    out[i] = steps
+
+
+def run(snap: str, threads: int, mode: str, records: int, numa: bool = False) -> Dict[str, object]:
+    import microstructure_rl._core as mrl  # local import to keep module load explicit
+
+    nodes = list(mrl.md_l2.numa_nodes()) if numa else []
+    rk = mrl.md_l2.ReplayKernel(snap)
+    n = min(records, int(rk.size())) if records > 0 else int(rk.size())
+
+    barrier = threading.Barrier(threads + 1)
+    out = [0] * threads
+    if mode == "range":
+        ts = [
+            threading.Thread(target=_worker_range, args=(mrl, rk, n, barrier, out, i, nodes))
+            for i in range(threads)
+        ]
+    else:
+        ts = [
+            threading.Thread(target=_worker_loop, args=(mrl, snap, n, barrier, out, i, nodes))
+            for i in range(threads)
+        ]
+    for t in ts:
+        t.start()
+    barrier.wait()
+    t0 = time.perf_counter()
+    for t in ts:
+        t.join()
+    dt = time.perf_counter() - t0
+
+    total = sum(out)
+    return {
+        "mode": mode,
+        "threads": threads,
+        "nodes": min(len(nodes), threads) if nodes else 0,
+        "records_per_thread": n,
+        "total_steps": total,
+        "seconds": dt,
+        "steps_per_sec": total / dt if dt > 0 else 0.0,
+    }
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description="Parallel MarketSimulator stepping from Python threads")
+    ap.add_argument("--snap", required=True, help="Path to a .snap file")
+    ap.add_argument("--threads", type=int, nargs="+", default=[1, 2, 4, os.cpu_count() or 1])
+    ap.add_argument("--mode", choices=["range", "loop", "both"], default="both")
+    ap.add_argument("--records", type=int, default=0, help="Records per thread (0 = whole file)")
+    ap.add_argument("--numa", action="store_true", help="Pin thread i to NUMA node i %% nodes")
+    ap.add_argument("--json", action="store_true", help="Emit one JSON object per run")
+    args = ap.parse_args()
+
+    gil_enabled = getattr(sys, "_is_gil_enabled", lambda: True)()
+    free_threaded_build = bool(sysconfig.get_config_var("Py_GIL_DISABLED"))
+    if not args.json:
+        print(f"python={sys.version.split()[0]} free_threaded_build={free_threaded_build} gil={gil_enabled}")
+
+    modes = ["range", "loop"] if args.mode == "both" else [args.mode]
+    for mode in modes:
+        base = None
+        for k in sorted(set(args.threads)):
+            res = run(args.snap, k, mode, args.records, args.numa)
+            base = base or res["steps_per_sec"]
+            res["speedup"] = res["steps_per_sec"] / base if base else 0.0
+            res["gil_enabled"] = gil_enabled
+            if args.json:
+                print(json.dumps(res, sort_keys=True))
+            else:
+                print(
+                    f"{mode:5s} threads={k:3d} nodes={res['nodes']}  steps/s={res['steps_per_sec']:>14,.0f}  "
+                    f"speedup={res['speedup']:.2f}x"
+                )
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
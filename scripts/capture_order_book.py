@@ -2,6 +2,10 @@
 Capture Binance partial book depth snapshots (top 20 levels) to hourly gzipped CSV + SHA256.
 
 Binance stream: <symbol>@depth20@100ms (top 20 levels, 100ms updates).
+
+Files are BGZF (blocked gzip): independent gzip members of <= 64 KiB of CSV each,
+so any gzip reader still works while the converter inflates blocks in parallel.
+A `<file>.gzi` block index (htslib layout) is written next to each file.
 """
 
 from __future__ import annotations
@@ -10,10 +14,11 @@ import argparse
 import asyncio
 import csv
 import datetime as dt
-import gzip
 import hashlib
 import signal
+import struct
 import time
+import zlib
 
 from dataclasses import dataclass
 from pathlib import Path
@@ -72,6 +77,78 @@ def build_header(depth: int) -> List[str]:
     return cols
 
 
+# BGZF: gzip header with FEXTRA holding a "BC" subfield = member size - 1
+BGZF_MAX_DATA = 0xFF00  # uncompressed bytes per block (as bgzip)
+BGZF_HEADER = b"\x1f\x8b\x08\x04\x00\x00\x00\x00\x00\xff\x06\x00BC\x02\x00"
+BGZF_EOF = BGZF_HEADER + b"\x1b\x00\x03\x00\x00\x00\x00\x00\x00\x00\x00\x00"
+
+
+def bgzf_block(data: bytes, level: int = 6) -> bytes:
+    c = zlib.compressobj(level, zlib.DEFLATED, -15)
+    payload = c.compress(data) + c.flush()
+    size = len(BGZF_HEADER) + 2 + len(payload) + 8
+    if size > 0x10000:
+        # Incompressible data: store it (deflate level 0 always fits)
+        return bgzf_block(data, level=0)
+    return (
+        BGZF_HEADER
+        + struct.pack("<H", size - 1)
+        + payload
+        + struct.pack("<II", zlib.crc32(data) & 0xFFFFFFFF, len(data))
+    )
+
+
+class BgzfTextWriter:
+    """
+    Text sink for csv.writer that writes BGZF.
+
+    Rows are buffered and emitted as full blocks; flush() also closes the
+    current (partial) block so everything written so far is on disk and
+    readable. close() adds the BGZF EOF marker. `index` holds
+    (compressed_offset, uncompressed_offset) for every block after the first.
+    """
+
+    def __init__(self, path: Path) -> None:
+        self.f = path.open("wb")
+        self.buf = bytearray()
+        self.coff = 0
+        self.uoff = 0
+        self.index: List[Tuple[int, int]] = []
+
+    def write(self, s: str) -> int:
+        self.buf += s.encode("utf-8")
+        while len(self.buf) >= BGZF_MAX_DATA:
+            self._emit(bytes(self.buf[:BGZF_MAX_DATA]))
+            del self.buf[:BGZF_MAX_DATA]
+        return len(s)
+
+    def _emit(self, data: bytes) -> None:
+        if self.coff:
+            self.index.append((self.coff, self.uoff))
+        block = bgzf_block(data)
+        self.f.write(block)
+        self.coff += len(block)
+        self.uoff += len(data)
+
+    def flush(self) -> None:
+        if self.buf:
+            self._emit(bytes(self.buf))
+            self.buf.clear()
+        self.f.flush()
+
+    def close(self) -> None:
+        self.flush()
+        self.f.write(BGZF_EOF)
+        self.f.close()
+
+    def write_index(self, path: Path) -> None:
+        """htslib .gzi: u64 count, then (compressed, uncompressed) u64 offset pairs."""
+        with path.open("wb") as f:
+            f.write(struct.pack("<Q", len(self.index)))
+            for coff, uoff in self.index:
+                f.write(struct.pack("<QQ", coff, uoff))
+
+
 @dataclass
 class RollingWriter:
     root: Path
@@ -82,7 +159,7 @@ class RollingWriter:
     cur_hour: Optional[dt.datetime] = None
     tmp_path: Optional[Path] = None
     final_path: Optional[Path] = None
-    gz: Optional[gzip.GzipFile] = None
+    gz: Optional[BgzfTextWriter] = None
     csvw: Optional[csv.writer] = None
     rows_written: int = 0
 
@@ -106,7 +183,7 @@ class RollingWriter:
         self.tmp_path = tmp
         self.final_path = final
 
-        self.gz = gzip.open(tmp, "wt", newline="", encoding="utf-8")
+        self.gz = BgzfTextWriter(tmp)
         self.csvw = csv.writer(self.gz)
         self.csvw.writerow(build_header(self.depth))
         self.rows_written = 0
@@ -129,13 +206,14 @@ class RollingWriter:
         if not (self.gz and self.tmp_path and self.final_path):
             return
 
-        self.gz.flush()
         self.gz.close()
+        gz = self.gz
         self.gz = None
         self.csvw = None
 
         # Atomic finalise
         atomic_rename(self.tmp_path, self.final_path)
+        gz.write_index(self.final_path.with_suffix(self.final_path.suffix + ".gzi"))
 
         # Write checksum file
         digest = sha256_file(self.final_path)